@@ -77,15 +77,44 @@ void destroy_pcep_versioning(struct pcep_versioning *versioning);
 /* Called before sending messages to encode the message to a byte buffer in
  * Network byte order. This function will also encode all the objects and their
  * TLVs in the message. The result will be stored in the encoded_message field
- * in the pcep_message. Implemented in pcep-messages-encoding.c */
-void pcep_encode_message(struct pcep_message *message, struct pcep_versioning *versioning);
+ * in the pcep_message. Returns false if the message cannot be encoded, in which
+ * case encoded_message is not set. Implemented in pcep-messages-encoding.c */
+bool pcep_encode_message(struct pcep_message *message, struct pcep_versioning *versioning);
+
+/* Return the exact number of bytes pcep_encode_message() will encode for
+ * the message, including the message header, objects, TLVs, and padding.
+ * Returns 0 if the message cannot be encoded. */
+uint16_t pcep_msg_encoded_size(struct pcep_message *message, struct pcep_versioning *versioning);
+
+/* Encode the message straight into the buf provided by the caller, which
+ * must have at least pcep_msg_encoded_size() bytes. The encoded_message
+ * field in the pcep_message is not set, but the encoded_object fields of
+ * its objects will point into buf. Returns the number of bytes encoded,
+ * or 0 if the message cannot be encoded or buf_length is too small. */
+uint16_t pcep_encode_message_to_buffer(struct pcep_message *message, struct pcep_versioning *versioning,
+                                       uint8_t *buf, uint16_t buf_length);
 
 /* Decode the message header and return the message length.
  * Returns < 0 for invalid message headers. */
-int16_t pcep_decode_validate_msg_header(uint8_t *msg_buf);
+int32_t pcep_decode_validate_msg_header(uint8_t *msg_buf);
 
 /* Decode the entire message */
 struct pcep_message *pcep_decode_message(uint8_t *message_buffer);
+/* Decode the entire message, allocating the message and all its objects,
+ * TLVs, and lists from a cached arena, which saves a malloc() and free()
+ * for each of them. The message is still freed with pcep_msg_free_message(),
+ * but its objects and TLVs cannot be freed or used after the message is. */
+struct pcep_message *pcep_decode_message_in_arena(uint8_t *message_buffer);
+
+/* Internal util functions implemented in pcep-messages-encoding.c, used
+ * by the decoders to allocate from the arena of the message being decoded,
+ * if any */
+void *pcep_decode_malloc(size_t size);
+void pcep_decode_free(void *ptr);
+double_linked_list *pcep_decode_dll_initialize();
+/* Returns NULL if the message is not decoded in an arena, the lists
+ * being decoded into a double_linked_list instead */
+small_vector *pcep_decode_small_vector_initialize();
 
 
 /*
@@ -94,6 +123,9 @@ struct pcep_message *pcep_decode_message(uint8_t *message_buffer);
 
 /* Implemented in pcep-objects-encoding.c */
 uint16_t pcep_encode_object(struct pcep_object_header* object_hdr, struct pcep_versioning *versioning, uint8_t *buf);
+/* Return the number of bytes pcep_encode_object() will encode for the object,
+ * including the object header and the TLVs */
+uint16_t pcep_object_encoded_size(struct pcep_object_header* object_hdr, struct pcep_versioning *versioning);
 
 /* Implemented in pcep-objects-encoding.c
  * Decode the object, including the TLVs (if any) and return the object.
@@ -115,6 +147,9 @@ uint16_t pcep_object_get_length(enum pcep_object_classes object_class, enum pcep
 
 /* Implemented in pcep-tlv-encoding.c */
 uint16_t pcep_encode_tlv(struct pcep_object_tlv_header *tlv_hdr, struct pcep_versioning *versioning, uint8_t *buf);
+/* Return the number of bytes pcep_encode_tlv() will encode for the TLV,
+ * including the TLV header and padding */
+uint16_t pcep_tlv_encoded_size(struct pcep_object_tlv_header *tlv_hdr, struct pcep_versioning *versioning);
 
 struct pcep_object_tlv_header *pcep_decode_tlv(uint8_t *obj_buf);
 
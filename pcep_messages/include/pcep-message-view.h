@@ -0,0 +1,134 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+/*
+ * Read-only view of a received PCEP message, used to access the objects,
+ * TLVs, and RO sub-objects directly from the received bytes, without
+ * decoding the entire message into allocated structs. The framing is
+ * validated once by pcep_message_view_init(), after which the iterators
+ * and field accessors only read the bytes they need. The message, or any
+ * of its objects or TLVs, can still be fully decoded on demand.
+ *
+ * The views point into the message buffer, which must not be freed or
+ * modified while they are used.
+ */
+
+#ifndef PCEP_MESSAGE_VIEW_H
+#define PCEP_MESSAGE_VIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h> // struct in_addr
+
+#include "pcep-messages.h"
+#include "pcep-objects.h"
+#include "pcep-tlvs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pcep_message_view
+{
+    uint8_t *buffer;
+    uint16_t length; /* Includes the message header */
+    enum pcep_message_types type;
+    uint16_t num_objects;
+};
+
+struct pcep_object_view
+{
+    uint8_t *buffer;
+    uint16_t length; /* Includes the object header */
+    enum pcep_object_classes object_class;
+    enum pcep_object_types object_type;
+    bool flag_p;
+    bool flag_i;
+};
+
+struct pcep_tlv_view
+{
+    uint8_t *buffer;
+    enum pcep_object_tlv_types type;
+    uint16_t length; /* The value length, without the TLV header and padding */
+    uint8_t *value;
+};
+
+struct pcep_ro_subobj_view
+{
+    uint8_t *buffer;
+    enum pcep_ro_subobj_types type;
+    uint8_t length; /* Includes the sub-object header */
+    bool flag_loose_hop;
+};
+
+/* Validate the message header and the framing of all the objects, TLVs, and
+ * RO sub-objects in the message_buffer, which must have at least
+ * buffer_length bytes. Returns true and initializes the view on success,
+ * false if the message is truncated or malformed. */
+bool pcep_message_view_init(struct pcep_message_view *view, uint8_t *message_buffer, uint32_t buffer_length);
+
+/* Object iterators: return true and set obj_view to the first or next object
+ * in the message, optionally of the given object_class, or false if there is
+ * none. The next functions continue from the object already in obj_view. */
+bool pcep_message_view_first_object(struct pcep_message_view *view, struct pcep_object_view *obj_view);
+bool pcep_message_view_next_object(struct pcep_message_view *view, struct pcep_object_view *obj_view);
+bool pcep_message_view_find_object(struct pcep_message_view *view, enum pcep_object_classes object_class, struct pcep_object_view *obj_view);
+bool pcep_message_view_find_next_object(struct pcep_message_view *view, enum pcep_object_classes object_class, struct pcep_object_view *obj_view);
+
+/* TLV iterators, same semantics as the object iterators */
+bool pcep_object_view_first_tlv(struct pcep_object_view *obj_view, struct pcep_tlv_view *tlv_view);
+bool pcep_object_view_next_tlv(struct pcep_object_view *obj_view, struct pcep_tlv_view *tlv_view);
+bool pcep_object_view_find_tlv(struct pcep_object_view *obj_view, enum pcep_object_tlv_types type, struct pcep_tlv_view *tlv_view);
+
+/* RO sub-object iterators, only for ERO, RRO, and IRO objects */
+bool pcep_object_view_first_ro_subobj(struct pcep_object_view *obj_view, struct pcep_ro_subobj_view *subobj_view);
+bool pcep_object_view_next_ro_subobj(struct pcep_object_view *obj_view, struct pcep_ro_subobj_view *subobj_view);
+
+/* Field accessors, decoded on demand from the object bytes. They return
+ * false if the object is not of the expected class. Any of the output
+ * pointers may be NULL if that field is not needed. */
+bool pcep_object_view_get_srp(struct pcep_object_view *obj_view, uint32_t *srp_id_number, bool *flag_lsp_remove);
+/* The LSP flags are returned as OBJECT_LSP_FLAG_* bits */
+bool pcep_object_view_get_lsp(struct pcep_object_view *obj_view, uint32_t *plsp_id,
+                              enum pcep_lsp_operational_status *operational_status, uint8_t *flags);
+bool pcep_ro_subobj_view_get_ipv4(struct pcep_ro_subobj_view *subobj_view, struct in_addr *ip_addr, uint8_t *prefix_length);
+/* Returns false if the sub-object is not an SR sub-object or has no SID */
+bool pcep_ro_subobj_view_get_sr_sid(struct pcep_ro_subobj_view *subobj_view, uint32_t *sid);
+
+/* Full decoding of the message, or of a single object or TLV. The returned
+ * structs are owned by the caller and freed just like the decoded ones:
+ * with pcep_msg_free_message(), pcep_obj_free_object(), and
+ * pcep_obj_free_tlv() respectively. */
+struct pcep_message *pcep_message_view_decode(struct pcep_message_view *view);
+struct pcep_object_header *pcep_object_view_decode(struct pcep_object_view *obj_view);
+struct pcep_object_tlv_header *pcep_tlv_view_decode(struct pcep_tlv_view *tlv_view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -33,6 +33,7 @@
 #include <netinet/in.h> /* struct in_addr */
 
 #include "pcep_utils_double_linked_list.h"
+#include "pcep_utils_small_vector.h"
 #include "pcep-objects.h"
 
 #ifdef __cplusplus
@@ -63,13 +64,21 @@ struct pcep_message_header
     enum pcep_message_types type;  /* Defines message type: OPEN/KEEPALIVE/PCREQ/PCREP/PCNOTF/ERROR/CLOSE */
 };
 
-/* The obj_list is a double_linked_list of struct pcep_object_header pointers. */
+/* The obj_list is a double_linked_list of struct pcep_object_header pointers.
+ * The messages decoded with pcep_decode_message_in_arena() instead have their
+ * objects in the obj_vector, and a NULL obj_list, the same being true for the
+ * TLVs and RO sub-objects of their objects. The pcep_msg_first_obj() and
+ * related functions in pcep-tools.h handle both forms. */
 struct pcep_message
 {
     struct pcep_message_header *msg_header;
     double_linked_list *obj_list;
+    small_vector *obj_vector;
     uint8_t *encoded_message;
     uint16_t encoded_message_length;
+    /* Only set for the messages decoded with pcep_decode_message_in_arena(),
+     * the message and all its objects and TLVs are allocated from it */
+    arena_handle *arena;
 };
 
 
@@ -33,6 +33,7 @@
 #include <stdint.h>
 
 #include "pcep_utils_double_linked_list.h"
+#include "pcep_utils_small_vector.h"
 #include "pcep-tlvs.h"
 
 #ifdef __cplusplus
@@ -120,6 +121,8 @@ struct pcep_object_header
     bool flag_p;   /* PCC Processing rule bit: When set, the object MUST be taken into account, when cleared the object is optional. */
     bool flag_i;   /* PCE Ignore bit: indicates to a PCC whether or not an optional object was processed */
     double_linked_list *tlv_list;
+    /* Set instead of the tlv_list for the objects decoded in an arena */
+    small_vector *tlv_vector;
     /* Pointer into encoded_message field from the pcep_message */
     uint8_t *encoded_object;
     uint16_t encoded_object_length;
@@ -576,6 +579,7 @@ struct pcep_object_ro
 {
     struct pcep_object_header header;
     double_linked_list *sub_objects; /* list of struct pcep_object_ro_subobj */
+    small_vector *sub_object_vector; /* set instead of the sub_objects for the objects decoded in an arena */
 };
 
 struct pcep_object_ro_subobj
@@ -36,9 +36,57 @@ extern "C" {
 #endif
 
 #define PCEP_MAX_SIZE 6000
+/* Max number of bytes read by each call to pcep_msg_reader_read() */
+#define PCEP_MSG_READER_DEFAULT_READ_BUDGET 65536
+
+/* Streaming reader used to reassemble the PCEP messages received on a socket,
+ * since a message may be split across several reads. The bytes of an
+ * incomplete message are kept in the buffer until the rest is received. */
+typedef struct pcep_msg_reader_
+{
+    uint8_t *buffer;
+    uint32_t buffer_size;
+    /* Number of bytes in the buffer not yet decoded */
+    uint32_t bytes_buffered;
+    /* Max number of bytes read by each call to pcep_msg_reader_read() */
+    uint32_t read_budget;
+    /* Decode the messages with pcep_decode_message_in_arena() */
+    bool decode_in_arena;
+    /* errno of a failure after messages were already decoded, reported
+     * by the next call to pcep_msg_reader_read() */
+    int pending_errno;
+
+} pcep_msg_reader;
+
+/* The objects of a message, the TLVs of an object, and the sub-objects of a RO
+ * object are either in a double_linked_list, or in a small_vector for the
+ * messages decoded with pcep_decode_message_in_arena(). The iterator functions
+ * below handle both, and are used like this:
+ *
+ *     pcep_list_iterator iter;
+ *     struct pcep_object_header *obj = pcep_msg_first_obj(msg, &iter);
+ *     for (; obj != NULL; obj = pcep_msg_next_obj(&iter)) { ... }
+ *
+ * The list must not be modified while it is iterated. */
+typedef struct pcep_list_iterator_
+{
+    double_linked_list_node *node;
+    small_vector *vector;
+    unsigned int index;
+
+} pcep_list_iterator;
 
 /* Returns a double linked list of PCEP messages */
 double_linked_list*             pcep_msg_read    (int sock_fd);
+pcep_msg_reader*                pcep_msg_reader_create();
+void                            pcep_msg_reader_destroy(pcep_msg_reader *reader);
+/* Read from sock_fd until there is nothing left to read or the read_budget is
+ * used, and append all the completely received messages to msg_list. Just like
+ * read(), returns the number of bytes read, 0 if the socket was closed, or -1
+ * with errno set on failure, which is EAGAIN if there was nothing to read.
+ * Messages are only appended to msg_list when the number of bytes read is
+ * returned, a failure after some were decoded is returned by the next call. */
+int                             pcep_msg_reader_read(pcep_msg_reader *reader, int sock_fd, double_linked_list *msg_list);
 /* Given a double linked list of PCEP messages, return the first node that has the same message type */
 struct pcep_message*            pcep_msg_get     (double_linked_list* msg_list, uint8_t type);
 /* Given a double linked list of PCEP messages, return the next node after current node that has the same message type */
@@ -47,6 +95,26 @@ struct pcep_object_header*      pcep_obj_get     (double_linked_list* list, uint
 struct pcep_object_header*      pcep_obj_get_next(double_linked_list *list, struct pcep_object_header* current, uint8_t object_class);
 struct pcep_object_tlv_header*  pcep_tlv_get     (double_linked_list* list, uint16_t type);
 struct pcep_object_tlv_header*  pcep_tlv_get_next(double_linked_list *list, struct pcep_object_tlv_header* current, uint16_t type);
+/* Accessors for either form of the message objects, object TLVs, and RO sub-objects */
+unsigned int                    pcep_msg_num_objs(struct pcep_message *msg);
+struct pcep_object_header*      pcep_msg_first_obj(struct pcep_message *msg, pcep_list_iterator *iter);
+struct pcep_object_header*      pcep_msg_next_obj(pcep_list_iterator *iter);
+/* Return the first object with the object_class, or NULL if there is none */
+struct pcep_object_header*      pcep_msg_get_obj(struct pcep_message *msg, uint8_t object_class);
+void                            pcep_msg_append_obj(struct pcep_message *msg, struct pcep_object_header *obj);
+unsigned int                    pcep_obj_num_tlvs(struct pcep_object_header *obj);
+struct pcep_object_tlv_header*  pcep_obj_first_tlv(struct pcep_object_header *obj, pcep_list_iterator *iter);
+struct pcep_object_tlv_header*  pcep_obj_next_tlv(pcep_list_iterator *iter);
+/* Return the first TLV with the type, or NULL if there is none */
+struct pcep_object_tlv_header*  pcep_obj_get_tlv(struct pcep_object_header *obj, uint16_t type);
+void                            pcep_obj_append_tlv(struct pcep_object_header *obj, struct pcep_object_tlv_header *tlv);
+/* Remove the TLV from the object and free it, unless the object
+ * TLVs are allocated from an arena. Returns false if not found. */
+bool                            pcep_obj_delete_tlv(struct pcep_object_header *obj, struct pcep_object_tlv_header *tlv);
+unsigned int                    pcep_obj_ro_num_subobjs(struct pcep_object_ro *ro);
+struct pcep_object_ro_subobj*   pcep_obj_ro_first_subobj(struct pcep_object_ro *ro, pcep_list_iterator *iter);
+struct pcep_object_ro_subobj*   pcep_obj_ro_next_subobj(pcep_list_iterator *iter);
+void                            pcep_obj_ro_append_subobj(struct pcep_object_ro *ro, struct pcep_object_ro_subobj *subobj);
 void                            pcep_obj_free_tlv(struct pcep_object_tlv_header *tlv);
 void                            pcep_obj_free_object(struct pcep_object_header *obj);
 void                            pcep_msg_free_message(struct pcep_message *message);
@@ -0,0 +1,492 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+/*
+ * Read-only view of a received PCEP message, accessed without decoding.
+ */
+
+#include <string.h>
+
+#include "pcep-encoding.h"
+#include "pcep-message-view.h"
+#include "pcep_utils_logging.h"
+
+/*
+ * Internal util functions
+ */
+
+static bool is_ro_object_class(enum pcep_object_classes object_class)
+{
+    return (object_class == PCEP_OBJ_CLASS_ERO ||
+            object_class == PCEP_OBJ_CLASS_RRO ||
+            object_class == PCEP_OBJ_CLASS_IRO);
+}
+
+static void fill_object_view(uint8_t *obj_buf, struct pcep_object_view *obj_view)
+{
+    obj_view->buffer = obj_buf;
+    obj_view->object_class = obj_buf[0];
+    obj_view->object_type = (obj_buf[1] >> 4) & 0x0f;
+    obj_view->flag_p = (obj_buf[1] & OBJECT_HEADER_FLAG_P);
+    obj_view->flag_i = (obj_buf[1] & OBJECT_HEADER_FLAG_I);
+    obj_view->length = ntohs(*((uint16_t *) (obj_buf + 2)));
+}
+
+static void fill_tlv_view(uint8_t *tlv_buf, struct pcep_tlv_view *tlv_view)
+{
+    tlv_view->buffer = tlv_buf;
+    tlv_view->type = ntohs(*((uint16_t *) tlv_buf));
+    tlv_view->length = ntohs(*((uint16_t *) (tlv_buf + 2)));
+    tlv_view->value = tlv_buf + TLV_HEADER_LENGTH;
+}
+
+static void fill_ro_subobj_view(uint8_t *subobj_buf, struct pcep_ro_subobj_view *subobj_view)
+{
+    subobj_view->buffer = subobj_buf;
+    subobj_view->flag_loose_hop = (subobj_buf[0] & 0x80);
+    subobj_view->type = (subobj_buf[0] & 0x7f);
+    subobj_view->length = subobj_buf[1];
+}
+
+/* The TLVs start after the fixed length part of the object, if the object
+ * can have TLVs at all. Returns 0 if it cannot. */
+static uint16_t get_tlv_offset(struct pcep_object_view *obj_view)
+{
+    if (is_ro_object_class(obj_view->object_class))
+    {
+        return 0;
+    }
+
+    return pcep_object_get_length(obj_view->object_class, obj_view->object_type);
+}
+
+static bool validate_object_framing(struct pcep_object_view *obj_view)
+{
+    uint16_t offset;
+
+    if (is_ro_object_class(obj_view->object_class))
+    {
+        offset = OBJECT_HEADER_LENGTH;
+        while (offset < obj_view->length)
+        {
+            uint16_t remaining = obj_view->length - offset;
+            if (remaining < OBJECT_RO_SUBOBJ_HEADER_LENGTH)
+            {
+                pcep_log(LOG_INFO, "Truncated RO sub-object in Object class [%d]", obj_view->object_class);
+                return false;
+            }
+
+            uint8_t subobj_length = obj_view->buffer[offset + 1];
+            if (subobj_length <= OBJECT_RO_SUBOBJ_HEADER_LENGTH || subobj_length > remaining)
+            {
+                pcep_log(LOG_INFO, "Invalid RO sub-object length [%d] in Object class [%d]",
+                         subobj_length, obj_view->object_class);
+                return false;
+            }
+
+            offset += subobj_length;
+        }
+
+        return true;
+    }
+
+    offset = get_tlv_offset(obj_view);
+    if (offset == 0)
+    {
+        return true;
+    }
+
+    if (obj_view->length < offset)
+    {
+        pcep_log(LOG_INFO, "Invalid length [%d] for Object class [%d]",
+                 obj_view->length, obj_view->object_class);
+        return false;
+    }
+
+    while (offset < obj_view->length)
+    {
+        uint16_t remaining = obj_view->length - offset;
+        if (remaining < TLV_HEADER_LENGTH)
+        {
+            pcep_log(LOG_INFO, "Truncated TLV in Object class [%d]", obj_view->object_class);
+            return false;
+        }
+
+        uint16_t tlv_length = ntohs(*((uint16_t *) (obj_view->buffer + offset + 2)));
+        if (TLV_HEADER_LENGTH + tlv_length > remaining)
+        {
+            pcep_log(LOG_INFO, "Invalid TLV length [%d] in Object class [%d]",
+                     tlv_length, obj_view->object_class);
+            return false;
+        }
+
+        offset += normalize_length(TLV_HEADER_LENGTH + tlv_length);
+    }
+
+    return true;
+}
+
+/*
+ * Message view functions
+ */
+
+bool pcep_message_view_init(struct pcep_message_view *view, uint8_t *message_buffer, uint32_t buffer_length)
+{
+    if (view == NULL || message_buffer == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot initialize message view with NULL parameters");
+        return false;
+    }
+
+    bzero(view, sizeof(struct pcep_message_view));
+
+    if (buffer_length < MESSAGE_HEADER_LENGTH)
+    {
+        pcep_log(LOG_INFO, "Truncated message header, buffer length [%d]", buffer_length);
+        return false;
+    }
+
+    int32_t msg_length = pcep_decode_validate_msg_header(message_buffer);
+    if (msg_length < 0 || (uint32_t) msg_length > buffer_length)
+    {
+        pcep_log(LOG_INFO, "Invalid message header, message length [%d] buffer length [%d]",
+                 msg_length, buffer_length);
+        return false;
+    }
+
+    uint16_t num_objects = 0;
+    uint16_t offset = MESSAGE_HEADER_LENGTH;
+    while (offset < msg_length)
+    {
+        uint16_t remaining = msg_length - offset;
+        if (remaining < OBJECT_HEADER_LENGTH)
+        {
+            pcep_log(LOG_INFO, "Truncated object header in message type [%d]", message_buffer[1]);
+            return false;
+        }
+
+        struct pcep_object_view obj_view;
+        fill_object_view(message_buffer + offset, &obj_view);
+        if (obj_view.length < OBJECT_HEADER_LENGTH || obj_view.length > remaining)
+        {
+            pcep_log(LOG_INFO, "Invalid object length [%d] for Object class [%d]",
+                     obj_view.length, obj_view.object_class);
+            return false;
+        }
+
+        if (validate_object_framing(&obj_view) == false)
+        {
+            return false;
+        }
+
+        num_objects++;
+        offset += obj_view.length;
+    }
+
+    view->buffer = message_buffer;
+    view->length = msg_length;
+    view->type = message_buffer[1];
+    view->num_objects = num_objects;
+
+    return true;
+}
+
+bool pcep_message_view_first_object(struct pcep_message_view *view, struct pcep_object_view *obj_view)
+{
+    if (view == NULL || obj_view == NULL || view->num_objects == 0)
+    {
+        return false;
+    }
+
+    fill_object_view(view->buffer + MESSAGE_HEADER_LENGTH, obj_view);
+
+    return true;
+}
+
+bool pcep_message_view_next_object(struct pcep_message_view *view, struct pcep_object_view *obj_view)
+{
+    if (view == NULL || obj_view == NULL)
+    {
+        return false;
+    }
+
+    uint8_t *next_obj_buf = obj_view->buffer + obj_view->length;
+    if (next_obj_buf >= view->buffer + view->length)
+    {
+        return false;
+    }
+
+    fill_object_view(next_obj_buf, obj_view);
+
+    return true;
+}
+
+bool pcep_message_view_find_object(struct pcep_message_view *view, enum pcep_object_classes object_class, struct pcep_object_view *obj_view)
+{
+    if (pcep_message_view_first_object(view, obj_view) == false)
+    {
+        return false;
+    }
+
+    if (obj_view->object_class == object_class)
+    {
+        return true;
+    }
+
+    return pcep_message_view_find_next_object(view, object_class, obj_view);
+}
+
+bool pcep_message_view_find_next_object(struct pcep_message_view *view, enum pcep_object_classes object_class, struct pcep_object_view *obj_view)
+{
+    while (pcep_message_view_next_object(view, obj_view) == true)
+    {
+        if (obj_view->object_class == object_class)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Object view functions
+ */
+
+bool pcep_object_view_first_tlv(struct pcep_object_view *obj_view, struct pcep_tlv_view *tlv_view)
+{
+    if (obj_view == NULL || tlv_view == NULL)
+    {
+        return false;
+    }
+
+    uint16_t tlv_offset = get_tlv_offset(obj_view);
+    if (tlv_offset == 0 || tlv_offset >= obj_view->length)
+    {
+        return false;
+    }
+
+    fill_tlv_view(obj_view->buffer + tlv_offset, tlv_view);
+
+    return true;
+}
+
+bool pcep_object_view_next_tlv(struct pcep_object_view *obj_view, struct pcep_tlv_view *tlv_view)
+{
+    if (obj_view == NULL || tlv_view == NULL)
+    {
+        return false;
+    }
+
+    uint8_t *next_tlv_buf = tlv_view->buffer + normalize_length(TLV_HEADER_LENGTH + tlv_view->length);
+    if (next_tlv_buf >= obj_view->buffer + obj_view->length)
+    {
+        return false;
+    }
+
+    fill_tlv_view(next_tlv_buf, tlv_view);
+
+    return true;
+}
+
+bool pcep_object_view_find_tlv(struct pcep_object_view *obj_view, enum pcep_object_tlv_types type, struct pcep_tlv_view *tlv_view)
+{
+    bool found = pcep_object_view_first_tlv(obj_view, tlv_view);
+    for (; found == true; found = pcep_object_view_next_tlv(obj_view, tlv_view))
+    {
+        if (tlv_view->type == type)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool pcep_object_view_first_ro_subobj(struct pcep_object_view *obj_view, struct pcep_ro_subobj_view *subobj_view)
+{
+    if (obj_view == NULL || subobj_view == NULL ||
+        is_ro_object_class(obj_view->object_class) == false ||
+        obj_view->length <= OBJECT_HEADER_LENGTH)
+    {
+        return false;
+    }
+
+    fill_ro_subobj_view(obj_view->buffer + OBJECT_HEADER_LENGTH, subobj_view);
+
+    return true;
+}
+
+bool pcep_object_view_next_ro_subobj(struct pcep_object_view *obj_view, struct pcep_ro_subobj_view *subobj_view)
+{
+    if (obj_view == NULL || subobj_view == NULL)
+    {
+        return false;
+    }
+
+    uint8_t *next_subobj_buf = subobj_view->buffer + subobj_view->length;
+    if (next_subobj_buf >= obj_view->buffer + obj_view->length)
+    {
+        return false;
+    }
+
+    fill_ro_subobj_view(next_subobj_buf, subobj_view);
+
+    return true;
+}
+
+bool pcep_object_view_get_srp(struct pcep_object_view *obj_view, uint32_t *srp_id_number, bool *flag_lsp_remove)
+{
+    if (obj_view == NULL || obj_view->object_class != PCEP_OBJ_CLASS_SRP ||
+        obj_view->length < LENGTH_3WORDS)
+    {
+        return false;
+    }
+
+    uint8_t *obj_body = obj_view->buffer + OBJECT_HEADER_LENGTH;
+    if (srp_id_number != NULL)
+    {
+        *srp_id_number = ntohl(*((uint32_t *) (obj_body + 4)));
+    }
+
+    if (flag_lsp_remove != NULL)
+    {
+        *flag_lsp_remove = (obj_body[3] & OBJECT_SRP_FLAG_R);
+    }
+
+    return true;
+}
+
+bool pcep_object_view_get_lsp(struct pcep_object_view *obj_view, uint32_t *plsp_id,
+                              enum pcep_lsp_operational_status *operational_status, uint8_t *flags)
+{
+    if (obj_view == NULL || obj_view->object_class != PCEP_OBJ_CLASS_LSP ||
+        obj_view->length < LENGTH_2WORDS)
+    {
+        return false;
+    }
+
+    uint8_t *obj_body = obj_view->buffer + OBJECT_HEADER_LENGTH;
+    if (plsp_id != NULL)
+    {
+        *plsp_id = ((ntohl(*((uint32_t *) obj_body)) >> 12) & MAX_PLSP_ID);
+    }
+
+    if (operational_status != NULL)
+    {
+        *operational_status = ((obj_body[3] >> 4) & MAX_LSP_STATUS);
+    }
+
+    if (flags != NULL)
+    {
+        *flags = (obj_body[3] & (OBJECT_LSP_FLAG_D | OBJECT_LSP_FLAG_S | OBJECT_LSP_FLAG_R |
+                                 OBJECT_LSP_FLAG_A | OBJECT_LSP_FLAG_C));
+    }
+
+    return true;
+}
+
+/*
+ * RO sub-object view functions
+ */
+
+bool pcep_ro_subobj_view_get_ipv4(struct pcep_ro_subobj_view *subobj_view, struct in_addr *ip_addr, uint8_t *prefix_length)
+{
+    if (subobj_view == NULL || subobj_view->type != RO_SUBOBJ_TYPE_IPV4 ||
+        subobj_view->length < LENGTH_2WORDS)
+    {
+        return false;
+    }
+
+    if (ip_addr != NULL)
+    {
+        ip_addr->s_addr = *((uint32_t *) (subobj_view->buffer + OBJECT_RO_SUBOBJ_HEADER_LENGTH));
+    }
+
+    if (prefix_length != NULL)
+    {
+        *prefix_length = subobj_view->buffer[6];
+    }
+
+    return true;
+}
+
+bool pcep_ro_subobj_view_get_sr_sid(struct pcep_ro_subobj_view *subobj_view, uint32_t *sid)
+{
+    if (subobj_view == NULL ||
+        (subobj_view->type != RO_SUBOBJ_TYPE_SR && subobj_view->type != RO_SUBOBJ_TYPE_SR_DRAFT07) ||
+        subobj_view->length < LENGTH_2WORDS)
+    {
+        return false;
+    }
+
+    /* The SID is absent if the S flag is set */
+    if (subobj_view->buffer[3] & OBJECT_SUBOBJ_SR_FLAG_S)
+    {
+        return false;
+    }
+
+    if (sid != NULL)
+    {
+        *sid = ntohl(*((uint32_t *) (subobj_view->buffer + 4)));
+    }
+
+    return true;
+}
+
+/*
+ * Full decoding functions
+ */
+
+struct pcep_message *pcep_message_view_decode(struct pcep_message_view *view)
+{
+    if (view == NULL || view->buffer == NULL)
+    {
+        return NULL;
+    }
+
+    return pcep_decode_message(view->buffer);
+}
+
+struct pcep_object_header *pcep_object_view_decode(struct pcep_object_view *obj_view)
+{
+    if (obj_view == NULL || obj_view->buffer == NULL)
+    {
+        return NULL;
+    }
+
+    return pcep_decode_object(obj_view->buffer);
+}
+
+struct pcep_object_tlv_header *pcep_tlv_view_decode(struct pcep_tlv_view *tlv_view)
+{
+    if (tlv_view == NULL || tlv_view->buffer == NULL)
+    {
+        return NULL;
+    }
+
+    return pcep_decode_tlv(tlv_view->buffer);
+}
@@ -72,51 +72,95 @@ static const int MANDATORY_MESSAGE_OBJECT_CLASSES[13][4] = {
  *    considered as reserved.  They MUST be set to zero on transmission
  *    and MUST be ignored on receipt.
  */
-void pcep_encode_message(struct pcep_message *message, struct pcep_versioning *versioning)
+/* Internal util function, encodes the message into buf, which must have
+ * message_length bytes, as returned by pcep_msg_encoded_size() */
+static uint16_t encode_message(struct pcep_message *message, struct pcep_versioning *versioning,
+                               uint8_t *buf, uint16_t message_length)
 {
-    if (message == NULL)
+    /* The encoders do not write the reserved fields and padding */
+    memset(buf, 0, message_length);
+
+    /* Write the message header, the entire length is already known */
+    buf[0] = (message->msg_header->pcep_version << 5) & 0xf0;
+    buf[1] = message->msg_header->type;
+    uint16_t *length_ptr = (uint16_t *) (buf + 2);
+    *length_ptr = htons(message_length);
+
+    /* Encode each of the objects */
+    uint16_t encoded_length = MESSAGE_HEADER_LENGTH;
+    pcep_list_iterator iter;
+    struct pcep_object_header *obj = pcep_msg_first_obj(message, &iter);
+    for (; obj != NULL; obj = pcep_msg_next_obj(&iter))
     {
-        return;
+        encoded_length += pcep_encode_object(obj, versioning, buf + encoded_length);
     }
 
-    if (message->msg_header == NULL)
+    if (encoded_length != message_length)
     {
-        return;
+        pcep_log(LOG_ERR, "Encoded message type [%d] length [%d] differs from its encoded size [%d]",
+                 message->msg_header->type, encoded_length, message_length);
     }
 
-    /* Internal buffer used for the entire message. Later, once the entire length
-     * is known, memory will be allocated and this buffer will be copied. */
-    uint8_t message_buffer[1024];
-    memset(message_buffer, 0, 1024);
+    return encoded_length;
+}
 
-    /* Write the message header. The message header length will be
-     * written when the entire length is known. */
-    uint16_t message_length = MESSAGE_HEADER_LENGTH;
-    message_buffer[0] = (message->msg_header->pcep_version << 5) & 0xf0;
-    message_buffer[1] = message->msg_header->type;
-    uint16_t *length_ptr = (uint16_t *) (message_buffer + 2);
+uint16_t pcep_msg_encoded_size(struct pcep_message *message, struct pcep_versioning *versioning)
+{
+    if (message == NULL || message->msg_header == NULL)
+    {
+        return 0;
+    }
 
-    if (message->obj_list == NULL)
+    uint32_t message_length = MESSAGE_HEADER_LENGTH;
+    pcep_list_iterator iter;
+    struct pcep_object_header *obj = pcep_msg_first_obj(message, &iter);
+    for (; obj != NULL; obj = pcep_msg_next_obj(&iter))
     {
-        *length_ptr = htons(message_length);
-        message->encoded_message = malloc(message_length);
-        memcpy(message->encoded_message, message_buffer, message_length);
-        message->encoded_message_length = message_length;
+        message_length += pcep_object_encoded_size(obj, versioning);
+    }
 
-        return;
+    if (message_length > UINT16_MAX)
+    {
+        pcep_log(LOG_WARNING, "Cannot encode message type [%d], its length [%u] exceeds the max PCEP message length",
+                 message->msg_header->type, message_length);
+        return 0;
     }
 
-    /* Encode each of the objects */
-    double_linked_list_node *node = message->obj_list->head;
-    for (; node != NULL; node = node->next_node)
+    return message_length;
+}
+
+bool pcep_encode_message(struct pcep_message *message, struct pcep_versioning *versioning)
+{
+    uint16_t message_length = pcep_msg_encoded_size(message, versioning);
+    if (message_length == 0)
     {
-        message_length += pcep_encode_object(node->data, versioning, message_buffer + message_length);
+        return false;
     }
 
-    *length_ptr = htons(message_length);
+    /* Encode straight into the exactly sized encoded_message, no need to copy it */
     message->encoded_message = malloc(message_length);
-    memcpy(message->encoded_message, message_buffer, message_length);
-    message->encoded_message_length = message_length;
+    message->encoded_message_length = encode_message(message, versioning, message->encoded_message, message_length);
+
+    return true;
+}
+
+uint16_t pcep_encode_message_to_buffer(struct pcep_message *message, struct pcep_versioning *versioning,
+                                       uint8_t *buf, uint16_t buf_length)
+{
+    uint16_t message_length = pcep_msg_encoded_size(message, versioning);
+    if (message_length == 0)
+    {
+        return 0;
+    }
+
+    if (buf == NULL || buf_length < message_length)
+    {
+        pcep_log(LOG_WARNING, "Cannot encode message type [%d] of length [%d] in a buffer of length [%d]",
+                 message->msg_header->type, message_length, buf_length);
+        return 0;
+    }
+
+    return encode_message(message, versioning, buf, message_length);
 }
 
 /*
@@ -180,7 +224,7 @@ static void pcep_decode_msg_header(uint8_t *msg_buf, uint8_t *msg_version, uint8
 }
 
 /* Decode the message header and return the message length */
-int16_t pcep_decode_validate_msg_header(uint8_t *msg_buf)
+int32_t pcep_decode_validate_msg_header(uint8_t *msg_buf)
 {
     uint8_t msg_version;
     uint8_t msg_flags;
@@ -189,7 +233,7 @@ int16_t pcep_decode_validate_msg_header(uint8_t *msg_buf)
 
     pcep_decode_msg_header(msg_buf, &msg_version, &msg_flags, &msg_type, &msg_length);
 
-    return((validate_msg_header(msg_version, msg_flags, msg_type, msg_length) == false) ? -1 : (int16_t) msg_length);
+    return((validate_msg_header(msg_version, msg_flags, msg_type, msg_length) == false) ? -1 : (int32_t) msg_length);
 }
 
 bool validate_message_objects(struct pcep_message *msg)
@@ -202,17 +246,16 @@ bool validate_message_objects(struct pcep_message *msg)
     }
 
     const int *object_classes = MANDATORY_MESSAGE_OBJECT_CLASSES[msg->msg_header->type];
-    double_linked_list_node *node;
+    pcep_list_iterator iter;
+    struct pcep_object_header *obj;
     int index;
-    for (node = (msg->obj_list == NULL ? NULL : msg->obj_list->head), index = 0;
+    for (obj = pcep_msg_first_obj(msg, &iter), index = 0;
          index < NUM_CHECKED_OBJECTS;
-         index++, (node = (node==NULL ? NULL : node->next_node)))
+         index++, (obj = (obj == NULL ? NULL : pcep_msg_next_obj(&iter))))
     {
-        struct pcep_object_header *obj = ((node == NULL) ? NULL : (struct pcep_object_header*) node->data);
-
         if (object_classes[index] == NO_OBJECT)
         {
-            if (node != NULL)
+            if (obj != NULL)
             {
                 pcep_log(LOG_INFO, "Rejecting received message: Unexpected object [%d] present",
                          obj->object_class);
@@ -221,7 +264,7 @@ bool validate_message_objects(struct pcep_message *msg)
         }
         else if (object_classes[index] != ANY_OBJECT)
         {
-            if (node == NULL)
+            if (obj == NULL)
             {
                 pcep_log(LOG_INFO, "Rejecting received message: Expecting object in position [%d], but none received",
                          index);
@@ -239,6 +282,48 @@ bool validate_message_objects(struct pcep_message *msg)
     return true;
 }
 
+/* Set while a message is decoded with pcep_decode_message_in_arena() */
+static __thread arena_handle *decode_arena_ = NULL;
+
+void *pcep_decode_malloc(size_t size)
+{
+    return (decode_arena_ == NULL) ? malloc(size) : arena_alloc(decode_arena_, size);
+}
+
+void pcep_decode_free(void *ptr)
+{
+    /* The arena memory is released with the arena */
+    if (decode_arena_ == NULL)
+    {
+        free(ptr);
+    }
+}
+
+double_linked_list *pcep_decode_dll_initialize()
+{
+    return (decode_arena_ == NULL) ? dll_initialize() : dll_initialize_in_arena(decode_arena_);
+}
+
+small_vector *pcep_decode_small_vector_initialize()
+{
+    return (decode_arena_ == NULL) ? NULL : small_vector_initialize_in_arena(decode_arena_);
+}
+
+struct pcep_message *pcep_decode_message_in_arena(uint8_t *msg_buf)
+{
+    decode_arena_ = arena_initialize_cached();
+    if (decode_arena_ == NULL)
+    {
+        return NULL;
+    }
+
+    /* If the message cant be decoded, the arena is destroyed with it */
+    struct pcep_message *msg = pcep_decode_message(msg_buf);
+    decode_arena_ = NULL;
+
+    return msg;
+}
+
 struct pcep_message *pcep_decode_message(uint8_t *msg_buf)
 {
     uint8_t msg_version;
@@ -248,22 +333,29 @@ struct pcep_message *pcep_decode_message(uint8_t *msg_buf)
 
     pcep_decode_msg_header(msg_buf, &msg_version, &msg_flags, &msg_type, &msg_length);
 
-    struct pcep_message *msg = malloc(sizeof(struct pcep_message));
+    struct pcep_message *msg = pcep_decode_malloc(sizeof(struct pcep_message));
     bzero(msg, sizeof(struct pcep_message));
+    msg->arena = decode_arena_;
 
-    msg->msg_header = malloc(sizeof(struct pcep_message_header));
+    msg->msg_header = pcep_decode_malloc(sizeof(struct pcep_message_header));
     msg->msg_header->pcep_version = msg_version;
     msg->msg_header->type = msg_type;
 
-    msg->obj_list = dll_initialize();
-    msg->encoded_message = malloc(msg_length);
+    msg->obj_vector = pcep_decode_small_vector_initialize();
+    if (msg->obj_vector == NULL)
+    {
+        msg->obj_list = dll_initialize();
+    }
+    msg->encoded_message = pcep_decode_malloc(msg_length);
     memcpy(msg->encoded_message, msg_buf, msg_length);
     msg->encoded_message_length = msg_length;
 
     uint16_t bytes_read = MESSAGE_HEADER_LENGTH;
     while ((msg_length - bytes_read) >= OBJECT_HEADER_LENGTH)
     {
-        struct pcep_object_header *obj_hdr = pcep_decode_object(msg_buf + bytes_read);
+        /* Decode the message copy, so the encoded_object of the objects
+         * stays valid as long as the message */
+        struct pcep_object_header *obj_hdr = pcep_decode_object(msg->encoded_message + bytes_read);
 
         if (obj_hdr == NULL)
         {
@@ -273,7 +365,7 @@ struct pcep_message *pcep_decode_message(uint8_t *msg_buf)
             return NULL;
         }
 
-        dll_append(msg->obj_list, obj_hdr);
+        pcep_msg_append_obj(msg, obj_hdr);
         bytes_read += obj_hdr->encoded_object_length;
     }
 
@@ -32,6 +32,7 @@
 
 #include "pcep-objects.h"
 #include "pcep-encoding.h"
+#include "pcep-tools.h"
 #include "pcep_utils_logging.h"
 
 void write_object_header(struct pcep_object_header *object_hdr, uint16_t object_length, uint8_t *buf);
@@ -220,11 +221,12 @@ uint16_t pcep_encode_object(struct pcep_object_header* object_hdr, struct pcep_v
     }
 
     uint16_t object_length = OBJECT_HEADER_LENGTH + obj_encoder(object_hdr, versioning, buf + OBJECT_HEADER_LENGTH);
-    double_linked_list_node *node = (object_hdr->tlv_list == NULL ? NULL : object_hdr->tlv_list->head);
-    for (; node != NULL; node = node->next_node)
+    pcep_list_iterator iter;
+    struct pcep_object_tlv_header *tlv = pcep_obj_first_tlv(object_hdr, &iter);
+    for (; tlv != NULL; tlv = pcep_obj_next_tlv(&iter))
     {
         /* Returns the length of the TLV, including the TLV header */
-        object_length += pcep_encode_tlv((struct pcep_object_tlv_header *) node->data, versioning, buf + object_length);
+        object_length += pcep_encode_tlv(tlv, versioning, buf + object_length);
     }
     object_length = normalize_length(object_length);
     write_object_header(object_hdr, object_length, buf);
@@ -234,6 +236,169 @@ uint16_t pcep_encode_object(struct pcep_object_header* object_hdr, struct pcep_v
     return object_length;
 }
 
+/*
+ * Encoded size functions
+ * - they must return exactly the number of bytes written by the
+ *   corresponding encoding functions, so the messages can be encoded
+ *   straight into an exactly sized buffer.
+ */
+
+/* Internal util function, mirrors pcep_encode_obj_ro() */
+static uint16_t pcep_obj_ro_encoded_body_size(struct pcep_object_ro *ro)
+{
+    uint16_t length = 0;
+    pcep_list_iterator iter;
+    struct pcep_object_ro_subobj *ro_subobj = pcep_obj_ro_first_subobj(ro, &iter);
+    for (; ro_subobj != NULL; ro_subobj = pcep_obj_ro_next_subobj(&iter))
+    {
+        length += OBJECT_RO_SUBOBJ_HEADER_LENGTH;
+
+        switch (ro_subobj->ro_subobj_type)
+        {
+        case RO_SUBOBJ_TYPE_IPV4:
+        case RO_SUBOBJ_TYPE_LABEL:
+            length += LENGTH_2WORDS - OBJECT_RO_SUBOBJ_HEADER_LENGTH;
+            break;
+
+        case RO_SUBOBJ_TYPE_IPV6:
+            length += LENGTH_5WORDS - OBJECT_RO_SUBOBJ_HEADER_LENGTH;
+            break;
+
+        case RO_SUBOBJ_TYPE_UNNUM:
+            length += LENGTH_3WORDS - OBJECT_RO_SUBOBJ_HEADER_LENGTH;
+            break;
+
+        case RO_SUBOBJ_TYPE_ASN:
+            length += LENGTH_1WORD - OBJECT_RO_SUBOBJ_HEADER_LENGTH;
+            break;
+
+        case RO_SUBOBJ_TYPE_SR:
+        {
+            struct pcep_ro_subobj_sr *sr_subobj = (struct pcep_ro_subobj_sr*) ro_subobj;
+            /* The NT and Flags, and the SID if present */
+            length += 2;
+            if (sr_subobj->flag_s == false)
+            {
+                length += LENGTH_1WORD;
+            }
+
+            if (sr_subobj->nai_list == NULL || sr_subobj->nai_list->head == NULL)
+            {
+                if (sr_subobj->nai_type == PCEP_SR_SUBOBJ_NAI_ABSENT)
+                {
+                    continue;
+                }
+
+                /* The encoder does not encode any sub-object in this case */
+                return 0;
+            }
+
+            switch (sr_subobj->nai_type)
+            {
+            case PCEP_SR_SUBOBJ_NAI_IPV4_NODE:
+                length += LENGTH_1WORD;
+                break;
+
+            case PCEP_SR_SUBOBJ_NAI_IPV6_NODE:
+            case PCEP_SR_SUBOBJ_NAI_UNNUMBERED_IPV4_ADJACENCY:
+                length += LENGTH_4WORDS;
+                break;
+
+            case PCEP_SR_SUBOBJ_NAI_IPV4_ADJACENCY:
+                length += LENGTH_2WORDS;
+                break;
+
+            case PCEP_SR_SUBOBJ_NAI_IPV6_ADJACENCY:
+                length += LENGTH_8WORDS;
+                break;
+
+            case PCEP_SR_SUBOBJ_NAI_LINK_LOCAL_IPV6_ADJACENCY:
+                length += LENGTH_10WORDS;
+                break;
+
+            default:
+                break;
+            }
+        }
+        break;
+
+        default:
+            break;
+        }
+    }
+
+    return length;
+}
+
+/* Internal util function, returns the object body length written by the
+ * object encoders, not including the object header and TLVs */
+static uint16_t pcep_object_encoded_body_size(struct pcep_object_header *object_hdr)
+{
+    switch (object_hdr->object_class)
+    {
+    case PCEP_OBJ_CLASS_ERO:
+    case PCEP_OBJ_CLASS_RRO:
+    case PCEP_OBJ_CLASS_IRO:
+        return pcep_obj_ro_encoded_body_size((struct pcep_object_ro *) object_hdr);
+
+    case PCEP_OBJ_CLASS_NOPATH:
+    case PCEP_OBJ_CLASS_INTER_LAYER:
+    case PCEP_OBJ_CLASS_REQ_ADAP_CAP:
+        return LENGTH_1WORD;
+
+    case PCEP_OBJ_CLASS_ENDPOINTS:
+        return (object_hdr->object_type == PCEP_OBJ_TYPE_ENDPOINT_IPV4) ? LENGTH_2WORDS : LENGTH_8WORDS;
+
+    case PCEP_OBJ_CLASS_ASSOCIATION:
+        return (object_hdr->object_type == PCEP_OBJ_TYPE_ASSOCIATION_IPV4) ? LENGTH_3WORDS : LENGTH_6WORDS;
+
+    case PCEP_OBJ_CLASS_SVEC:
+    {
+        struct pcep_object_svec *svec = (struct pcep_object_svec *) object_hdr;
+        return LENGTH_1WORD + (svec->request_id_list == NULL ?
+                0 : svec->request_id_list->num_entries * sizeof(uint32_t));
+    }
+
+    case PCEP_OBJ_CLASS_SWITCH_LAYER:
+    {
+        struct pcep_object_switch_layer *switch_layer = (struct pcep_object_switch_layer *) object_hdr;
+        uint16_t length = 0;
+        double_linked_list_node *node = switch_layer->switch_layer_rows->head;
+        for (; node != NULL && node->data != NULL; node = node->next_node)
+        {
+            length += LENGTH_1WORD;
+        }
+        return length;
+    }
+
+    default:
+        /* The rest of the objects have a fixed length, which includes the object header */
+        return pcep_object_get_length(object_hdr->object_class, object_hdr->object_type) - OBJECT_HEADER_LENGTH;
+    }
+}
+
+uint16_t pcep_object_encoded_size(struct pcep_object_header* object_hdr, struct pcep_versioning *versioning)
+{
+    initialize_object_coders();
+
+    if (object_hdr->object_class >= MAX_OBJECT_ENCODER_INDEX ||
+        object_encoders[object_hdr->object_class] == NULL)
+    {
+        /* Nothing is encoded for unknown objects */
+        return 0;
+    }
+
+    uint16_t object_length = OBJECT_HEADER_LENGTH + pcep_object_encoded_body_size(object_hdr);
+    pcep_list_iterator iter;
+    struct pcep_object_tlv_header *tlv = pcep_obj_first_tlv(object_hdr, &iter);
+    for (; tlv != NULL; tlv = pcep_obj_next_tlv(&iter))
+    {
+        object_length += pcep_tlv_encoded_size(tlv, versioning);
+    }
+
+    return normalize_length(object_length);
+}
+
 
 /* Object Header
  *
@@ -537,7 +702,7 @@ uint16_t pcep_encode_obj_server_ind(struct pcep_object_header *hdr, struct pcep_
 uint16_t pcep_encode_obj_ro(struct pcep_object_header *hdr, struct pcep_versioning *versioning, uint8_t *obj_body_buf)
 {
     struct pcep_object_ro *ro = (struct pcep_object_ro *) hdr;
-    if (ro == NULL || ro->sub_objects == NULL)
+    if (ro == NULL)
     {
         return 0;
     }
@@ -552,10 +717,10 @@ uint16_t pcep_encode_obj_ro(struct pcep_object_header *hdr, struct pcep_versioni
      */
 
     uint16_t index = 0;
-    double_linked_list_node *node = ro->sub_objects->head;
-    for (; node != NULL; node = node->next_node)
+    pcep_list_iterator iter;
+    struct pcep_object_ro_subobj *ro_subobj = pcep_obj_ro_first_subobj(ro, &iter);
+    for (; ro_subobj != NULL; ro_subobj = pcep_obj_ro_next_subobj(&iter))
     {
-        struct pcep_object_ro_subobj *ro_subobj = node->data;
         uint8_t ro_subobj_type =
                 (ro_subobj->ro_subobj_type == RO_SUBOBJ_TYPE_SR && versioning->draft_ietf_pce_segment_routing_07)
                 ? RO_SUBOBJ_TYPE_SR_DRAFT07 : ro_subobj->ro_subobj_type;
@@ -773,6 +938,11 @@ void pcep_decode_object_hdr(uint8_t *obj_buf, struct pcep_object_header *obj_hdr
 
 uint16_t pcep_object_get_length(enum pcep_object_classes object_class, enum pcep_object_types object_type)
 {
+    if (object_class >= sizeof(pcep_object_class_lengths))
+    {
+        return 0;
+    }
+
     uint8_t object_length = pcep_object_class_lengths[object_class];
     if (object_length == 0)
     {
@@ -842,7 +1012,11 @@ struct pcep_object_header *pcep_decode_object(uint8_t *obj_buf)
 
     if (pcep_object_has_tlvs(&object_hdr))
     {
-        object->tlv_list = dll_initialize();
+        object->tlv_vector = pcep_decode_small_vector_initialize();
+        if (object->tlv_vector == NULL)
+        {
+            object->tlv_list = dll_initialize();
+        }
         int num_iterations = 0;
         uint16_t tlv_index = pcep_object_get_length_by_hdr(&object_hdr);
         while((object->encoded_object_length - tlv_index) > 0 && num_iterations++ < MAX_ITERATIONS)
@@ -856,7 +1030,7 @@ struct pcep_object_header *pcep_decode_object(uint8_t *obj_buf)
 
             /* The TLV length does not include the TLV header */
             tlv_index += normalize_length(tlv->encoded_tlv_length + TLV_HEADER_LENGTH);
-            dll_append(object->tlv_list, tlv);
+            pcep_obj_append_tlv(object, tlv);
         }
     }
 
@@ -865,7 +1039,7 @@ struct pcep_object_header *pcep_decode_object(uint8_t *obj_buf)
 
 static struct pcep_object_header *common_object_create(struct pcep_object_header *hdr, uint16_t new_obj_length)
 {
-    struct pcep_object_header *new_object = malloc(new_obj_length);
+    struct pcep_object_header *new_object = pcep_decode_malloc(new_obj_length);
     memset(new_object, 0, new_obj_length);
     memcpy(new_object, hdr, sizeof(struct pcep_object_header));
 
@@ -1038,12 +1212,12 @@ struct pcep_object_header *pcep_decode_obj_svec(struct pcep_object_header *hdr,
 
     if (hdr->encoded_object_length > LENGTH_2WORDS)
     {
-        obj->request_id_list = dll_initialize();
+        obj->request_id_list = pcep_decode_dll_initialize();
         int index = 1;
         uint32_t *uint32_ptr = (uint32_t *) obj_buf;
         for (; index < ((hdr->encoded_object_length - LENGTH_2WORDS) / 4); index++)
         {
-            uint32_t *req_id_ptr = malloc(sizeof(uint32_t));
+            uint32_t *req_id_ptr = pcep_decode_malloc(sizeof(uint32_t));
             *req_id_ptr = uint32_ptr[index];
             dll_append(obj->request_id_list, req_id_ptr);
         }
@@ -1119,14 +1293,14 @@ struct pcep_object_header *pcep_decode_obj_switch_layer(struct pcep_object_heade
 {
     struct pcep_object_switch_layer *obj =
             (struct pcep_object_switch_layer *) common_object_create(hdr, sizeof(struct pcep_object_switch_layer));
-    obj->switch_layer_rows = dll_initialize();
+    obj->switch_layer_rows = pcep_decode_dll_initialize();
     int num_rows = ((hdr->encoded_object_length - 4) / 4);
     uint8_t buf_index = 0;
 
     int i = 0;
     for (; i < num_rows; i++)
     {
-        struct pcep_object_switch_layer_row *row = malloc(sizeof(struct pcep_object_switch_layer_row));
+        struct pcep_object_switch_layer_row *row = pcep_decode_malloc(sizeof(struct pcep_object_switch_layer_row));
         row->lsp_encoding_type = obj_buf[buf_index];
         row->switching_type = obj_buf[buf_index + 1];
         row->flag_i = (obj_buf[buf_index + 3] & OBJECT_SWITCH_LAYER_FLAG_I);
@@ -1176,7 +1350,11 @@ void decode_ipv6(uint32_t *src, struct in6_addr *dst_ipv6)
 struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, uint8_t *obj_buf)
 {
     struct pcep_object_ro *obj = (struct pcep_object_ro *) common_object_create(hdr, sizeof(struct pcep_object_ro));
-    obj->sub_objects = dll_initialize();
+    obj->sub_object_vector = pcep_decode_small_vector_initialize();
+    if (obj->sub_object_vector == NULL)
+    {
+        obj->sub_objects = dll_initialize();
+    }
 
     /* RO Subobject format
      *
@@ -1204,7 +1382,7 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
         {
             pcep_log(LOG_INFO, "Invalid ro subobj type [%d] length [%d]",
                      subobj_type, subobj_length);
-            free(obj);
+            pcep_decode_free(obj);
             return NULL;
         }
 
@@ -1212,7 +1390,7 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
         {
         case RO_SUBOBJ_TYPE_IPV4:
         {
-            struct pcep_ro_subobj_ipv4 *ipv4 = malloc(sizeof(struct pcep_ro_subobj_ipv4));
+            struct pcep_ro_subobj_ipv4 *ipv4 = pcep_decode_malloc(sizeof(struct pcep_ro_subobj_ipv4));
             ipv4->ro_subobj.flag_subobj_loose_hop = flag_l;
             ipv4->ro_subobj.ro_subobj_type = subobj_type;
             uint32_ptr = (uint32_t *) (obj_buf + read_count);
@@ -1221,13 +1399,13 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
             ipv4->prefix_length = obj_buf[read_count++];
             ipv4->flag_local_protection = (obj_buf[read_count++] & OBJECT_SUBOBJ_IP_FLAG_LOCAL_PROT);
 
-            dll_append(obj->sub_objects, ipv4);
+            pcep_obj_ro_append_subobj(obj, (struct pcep_object_ro_subobj *) ipv4);
         }
         break;
 
         case RO_SUBOBJ_TYPE_IPV6:
         {
-            struct pcep_ro_subobj_ipv6 *ipv6 = malloc(sizeof(struct pcep_ro_subobj_ipv6));
+            struct pcep_ro_subobj_ipv6 *ipv6 = pcep_decode_malloc(sizeof(struct pcep_ro_subobj_ipv6));
             ipv6->ro_subobj.flag_subobj_loose_hop = flag_l;
             ipv6->ro_subobj.ro_subobj_type = subobj_type;
             decode_ipv6((uint32_t *) obj_buf, &ipv6->ip_addr);
@@ -1235,13 +1413,13 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
             ipv6->prefix_length = obj_buf[read_count++];
             ipv6->flag_local_protection = (obj_buf[read_count++] & OBJECT_SUBOBJ_IP_FLAG_LOCAL_PROT);
 
-            dll_append(obj->sub_objects, ipv6);
+            pcep_obj_ro_append_subobj(obj, (struct pcep_object_ro_subobj *) ipv6);
         }
         break;
 
         case RO_SUBOBJ_TYPE_LABEL:
         {
-            struct pcep_ro_subobj_32label *label = malloc(sizeof(struct pcep_ro_subobj_32label));
+            struct pcep_ro_subobj_32label *label = pcep_decode_malloc(sizeof(struct pcep_ro_subobj_32label));
             label->ro_subobj.flag_subobj_loose_hop = flag_l;
             label->ro_subobj.ro_subobj_type = subobj_type;
             label->flag_global_label = (obj_buf[read_count++] & OBJECT_SUBOBJ_LABEL_FLAG_GLOGAL);
@@ -1249,13 +1427,13 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
             label->label = ntohl(obj_buf[read_count]);
             read_count += LENGTH_1WORD;
 
-            dll_append(obj->sub_objects, label);
+            pcep_obj_ro_append_subobj(obj, (struct pcep_object_ro_subobj *) label);
         }
         break;
 
         case RO_SUBOBJ_TYPE_UNNUM:
         {
-            struct pcep_ro_subobj_unnum *unum = malloc(sizeof(struct pcep_ro_subobj_unnum));
+            struct pcep_ro_subobj_unnum *unum = pcep_decode_malloc(sizeof(struct pcep_ro_subobj_unnum));
             unum->ro_subobj.flag_subobj_loose_hop = flag_l;
             unum->ro_subobj.ro_subobj_type = subobj_type;
             set_ro_subobj_fields((struct pcep_object_ro_subobj *) unum, flag_l, subobj_type);
@@ -1264,20 +1442,20 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
             unum->router_id.s_addr = uint32_ptr[1];
             read_count += 2;
 
-            dll_append(obj->sub_objects, unum);
+            pcep_obj_ro_append_subobj(obj, (struct pcep_object_ro_subobj *) unum);
         }
         break;
 
         case RO_SUBOBJ_TYPE_ASN:
         {
-            struct pcep_ro_subobj_asn *asn = malloc(sizeof(struct pcep_ro_subobj_asn));
+            struct pcep_ro_subobj_asn *asn = pcep_decode_malloc(sizeof(struct pcep_ro_subobj_asn));
             asn->ro_subobj.flag_subobj_loose_hop = flag_l;
             asn->ro_subobj.ro_subobj_type = subobj_type;
             uint16_t *uint16_ptr = (uint16_t *) (obj_buf + read_count);
             asn->asn = ntohs(*uint16_ptr);
             read_count += 2;
 
-            dll_append(obj->sub_objects, asn);
+            pcep_obj_ro_append_subobj(obj, (struct pcep_object_ro_subobj *) asn);
         }
         break;
 
@@ -1297,13 +1475,13 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
              * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
              */
 
-            struct pcep_ro_subobj_sr *sr_subobj = malloc(sizeof(struct pcep_ro_subobj_sr));
+            struct pcep_ro_subobj_sr *sr_subobj = pcep_decode_malloc(sizeof(struct pcep_ro_subobj_sr));
             sr_subobj->ro_subobj.flag_subobj_loose_hop = flag_l;
             /* Overwrite RO_SUBOBJ_TYPE_SR_DRAFT07 with RO_SUBOBJ_TYPE_SR */
             sr_subobj->ro_subobj.ro_subobj_type = RO_SUBOBJ_TYPE_SR;
-            dll_append(obj->sub_objects, sr_subobj);
+            pcep_obj_ro_append_subobj(obj, (struct pcep_object_ro_subobj *) sr_subobj);
 
-            sr_subobj->nai_list = dll_initialize();
+            sr_subobj->nai_list = pcep_decode_dll_initialize();
             sr_subobj->nai_type = ((obj_buf[read_count++] >> 4) & 0x0f);
             sr_subobj->flag_f = (obj_buf[read_count] & OBJECT_SUBOBJ_SR_FLAG_F);
             sr_subobj->flag_s = (obj_buf[read_count] & OBJECT_SUBOBJ_SR_FLAG_S);
@@ -1324,7 +1502,7 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
             {
             case PCEP_SR_SUBOBJ_NAI_IPV4_NODE:
             {
-                struct in_addr *ipv4 = malloc(sizeof(struct in_addr));
+                struct in_addr *ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = *uint32_ptr;
                 dll_append(sr_subobj->nai_list, ipv4);
                 read_count += LENGTH_1WORD;
@@ -1333,7 +1511,7 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
 
             case PCEP_SR_SUBOBJ_NAI_IPV6_NODE:
             {
-                struct in6_addr *ipv6 = malloc(sizeof(struct in6_addr));
+                struct in6_addr *ipv6 = pcep_decode_malloc(sizeof(struct in6_addr));
                 decode_ipv6(uint32_ptr, ipv6);
                 dll_append(sr_subobj->nai_list, ipv6);
                 read_count += LENGTH_4WORDS;
@@ -1342,19 +1520,19 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
 
             case PCEP_SR_SUBOBJ_NAI_UNNUMBERED_IPV4_ADJACENCY:
             {
-                struct in_addr *ipv4 = malloc(sizeof(struct in_addr));
+                struct in_addr *ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[0];
                 dll_append(sr_subobj->nai_list, ipv4);
 
-                ipv4 = malloc(sizeof(struct in_addr));
+                ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[1];
                 dll_append(sr_subobj->nai_list, ipv4);
 
-                ipv4 = malloc(sizeof(struct in_addr));
+                ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[2];
                 dll_append(sr_subobj->nai_list, ipv4);
 
-                ipv4 = malloc(sizeof(struct in_addr));
+                ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[3];
                 dll_append(sr_subobj->nai_list, ipv4);
 
@@ -1364,11 +1542,11 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
 
             case PCEP_SR_SUBOBJ_NAI_IPV4_ADJACENCY:
             {
-                struct in_addr *ipv4 = malloc(sizeof(struct in_addr));
+                struct in_addr *ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[0];
                 dll_append(sr_subobj->nai_list, ipv4);
 
-                ipv4 = malloc(sizeof(struct in_addr));
+                ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[1];
                 dll_append(sr_subobj->nai_list, ipv4);
 
@@ -1378,11 +1556,11 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
 
             case PCEP_SR_SUBOBJ_NAI_IPV6_ADJACENCY:
             {
-                struct in6_addr *ipv6 = malloc(sizeof(struct in6_addr));
+                struct in6_addr *ipv6 = pcep_decode_malloc(sizeof(struct in6_addr));
                 decode_ipv6(uint32_ptr, ipv6);
                 dll_append(sr_subobj->nai_list, ipv6);
 
-                ipv6 = malloc(sizeof(struct in6_addr));
+                ipv6 = pcep_decode_malloc(sizeof(struct in6_addr));
                 decode_ipv6(uint32_ptr + LENGTH_4WORDS, ipv6);
                 dll_append(sr_subobj->nai_list, ipv6);
 
@@ -1392,19 +1570,19 @@ struct pcep_object_header *pcep_decode_obj_ro(struct pcep_object_header *hdr, ui
 
             case PCEP_SR_SUBOBJ_NAI_LINK_LOCAL_IPV6_ADJACENCY:
             {
-                struct in6_addr *ipv6 = malloc(sizeof(struct in6_addr));
+                struct in6_addr *ipv6 = pcep_decode_malloc(sizeof(struct in6_addr));
                 decode_ipv6(uint32_ptr, ipv6);
                 dll_append(sr_subobj->nai_list, ipv6);
 
-                struct in_addr *ipv4 = malloc(sizeof(struct in_addr));
+                struct in_addr *ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[LENGTH_4WORDS];
                 dll_append(sr_subobj->nai_list, ipv4);
 
-                ipv6 = malloc(sizeof(struct in6_addr));
+                ipv6 = pcep_decode_malloc(sizeof(struct in6_addr));
                 decode_ipv6(uint32_ptr + LENGTH_5WORDS, ipv6);
                 dll_append(sr_subobj->nai_list, ipv6);
 
-                ipv4 = malloc(sizeof(struct in_addr));
+                ipv4 = pcep_decode_malloc(sizeof(struct in_addr));
                 ipv4->s_addr = uint32_ptr[LENGTH_9WORDS];
                 dll_append(sr_subobj->nai_list, ipv4);
 
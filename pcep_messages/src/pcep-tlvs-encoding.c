@@ -169,6 +169,111 @@ uint16_t pcep_encode_tlv(struct pcep_object_tlv_header* tlv_hdr, struct pcep_ver
     return normalize_length(tlv_length + TLV_HEADER_LENGTH);
 }
 
+/* Internal util function, returns the TLV body length written by the
+ * TLV encoders, not including the TLV header and padding */
+static uint16_t pcep_tlv_encoded_body_size(struct pcep_object_tlv_header *tlv_hdr, struct pcep_versioning *versioning)
+{
+    switch (tlv_hdr->type)
+    {
+    case PCEP_OBJ_TLV_TYPE_NO_PATH_VECTOR:
+    case PCEP_OBJ_TLV_TYPE_STATEFUL_PCE_CAPABILITY:
+    case PCEP_OBJ_TLV_TYPE_LSP_ERROR_CODE:
+    case PCEP_OBJ_TLV_TYPE_SR_PCE_CAPABILITY:
+    case PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE:
+        return LENGTH_1WORD;
+
+    case PCEP_OBJ_TLV_TYPE_LSP_DB_VERSION:
+    case PCEP_OBJ_TLV_TYPE_VENDOR_INFO:
+        return LENGTH_2WORDS;
+
+    case PCEP_OBJ_TLV_TYPE_IPV4_LSP_IDENTIFIERS:
+        return LENGTH_4WORDS;
+
+    case PCEP_OBJ_TLV_TYPE_IPV6_LSP_IDENTIFIERS:
+        return LENGTH_13WORDS;
+
+    case PCEP_OBJ_TLV_TYPE_SYMBOLIC_PATH_NAME:
+        return ((struct pcep_object_tlv_symbolic_path_name *) tlv_hdr)->symbolic_path_name_length;
+
+    case PCEP_OBJ_TLV_TYPE_RSVP_ERROR_SPEC:
+    {
+        struct pcep_object_tlv_rsvp_error_spec *rsvp_hdr = (struct pcep_object_tlv_rsvp_error_spec *) tlv_hdr;
+        if (rsvp_hdr->c_type == RSVP_ERROR_SPEC_IPV4_CTYPE)
+        {
+            return LENGTH_3WORDS;
+        }
+        else if (rsvp_hdr->c_type == RSVP_ERROR_SPEC_IPV6_CTYPE)
+        {
+            return LENGTH_6WORDS;
+        }
+
+        return 0;
+    }
+
+    case PCEP_OBJ_TLV_TYPE_SPEAKER_ENTITY_ID:
+    {
+        struct pcep_object_tlv_speaker_entity_identifier *speaker_id =
+                (struct pcep_object_tlv_speaker_entity_identifier *) tlv_hdr;
+        return (speaker_id->speaker_entity_id_list == NULL ?
+                0 : speaker_id->speaker_entity_id_list->num_entries * LENGTH_1WORD);
+    }
+
+    case PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE_CAPABILITY:
+    {
+        struct pcep_object_tlv_path_setup_type_capability *pst_cap =
+                (struct pcep_object_tlv_path_setup_type_capability *) tlv_hdr;
+        if (pst_cap->pst_list == NULL)
+        {
+            return 0;
+        }
+
+        uint16_t length = normalize_length(LENGTH_1WORD + pst_cap->pst_list->num_entries);
+        double_linked_list_node *node = (pst_cap->sub_tlv_list == NULL ? NULL : pst_cap->sub_tlv_list->head);
+        for (; node != NULL; node = node->next_node)
+        {
+            length += pcep_tlv_encoded_size((struct pcep_object_tlv_header *) node->data, versioning);
+        }
+
+        return length;
+    }
+
+    case PCEP_OBJ_TLV_TYPE_SRPOLICY_POL_ID:
+        return (((struct pcep_object_tlv_srpag_pol_id *) tlv_hdr)->is_ipv4 ? LENGTH_2WORDS : LENGTH_5WORDS);
+
+    case PCEP_OBJ_TLV_TYPE_SRPOLICY_POL_NAME:
+        return normalize_length(((struct pcep_object_tlv_srpag_pol_name *) tlv_hdr)->name_length);
+
+    case PCEP_OBJ_TLV_TYPE_SRPOLICY_CPATH_ID:
+    {
+        struct pcep_object_tlv_srpag_cp_id *cpath_id_tlv = (struct pcep_object_tlv_srpag_cp_id *) tlv_hdr;
+        return sizeof(cpath_id_tlv->proto) + sizeof(cpath_id_tlv->orig_asn) +
+               sizeof(cpath_id_tlv->orig_addres) + sizeof(cpath_id_tlv->discriminator);
+    }
+
+    case PCEP_OBJ_TLV_TYPE_SRPOLICY_CPATH_PREFERENCE:
+        return sizeof(((struct pcep_object_tlv_srpag_cp_pref *) tlv_hdr)->preference);
+
+    case PCEP_OBJ_TLV_TYPE_ARBITRARY:
+        return ((struct pcep_object_tlv_arbitrary *) tlv_hdr)->data_length;
+
+    default:
+        return 0;
+    }
+}
+
+uint16_t pcep_tlv_encoded_size(struct pcep_object_tlv_header *tlv_hdr, struct pcep_versioning *versioning)
+{
+    initialize_tlv_coders();
+
+    if (tlv_hdr->type >= MAX_TLV_ENCODER_INDEX || tlv_encoders[tlv_hdr->type] == NULL)
+    {
+        /* Nothing is encoded for unknown TLVs */
+        return 0;
+    }
+
+    return normalize_length(pcep_tlv_encoded_body_size(tlv_hdr, versioning) + TLV_HEADER_LENGTH);
+}
+
 /* TLV Header format
  *
  * 0                   1                   2                   3
@@ -521,7 +626,7 @@ struct pcep_object_tlv_header *pcep_decode_tlv(uint8_t *tlv_buf)
 
 static struct pcep_object_tlv_header *common_tlv_create(struct pcep_object_tlv_header *hdr, uint16_t new_tlv_length)
 {
-    struct pcep_object_tlv_header *new_tlv = malloc(new_tlv_length);
+    struct pcep_object_tlv_header *new_tlv = pcep_decode_malloc(new_tlv_length);
     memset(new_tlv, 0, new_tlv_length);
     memcpy(new_tlv, hdr, sizeof(struct pcep_object_tlv_header));
 
@@ -681,11 +786,11 @@ struct pcep_object_tlv_header *pcep_decode_tlv_speaker_entity_id(struct pcep_obj
     }
 
     uint32_t *uint32_ptr = (uint32_t *) tlv_body_buf;
-    tlv->speaker_entity_id_list = dll_initialize();
+    tlv->speaker_entity_id_list = pcep_decode_dll_initialize();
     int i;
     for (i = 0; i < num_entity_ids; i++)
     {
-        uint32_t *entity_id = malloc(sizeof(uint32_t));
+        uint32_t *entity_id = pcep_decode_malloc(sizeof(uint32_t));
         *entity_id = ntohl(uint32_ptr[i]);
         dll_append(tlv->speaker_entity_id_list, entity_id);
     }
@@ -728,10 +833,10 @@ struct pcep_object_tlv_header *pcep_decode_tlv_path_setup_type_capability(struct
     }
 
     int i;
-    tlv->pst_list = dll_initialize();
+    tlv->pst_list = pcep_decode_dll_initialize();
     for (i = 0; i < num_psts; i++)
     {
-        uint8_t *pst = malloc(sizeof(uint8_t));
+        uint8_t *pst = pcep_decode_malloc(sizeof(uint8_t));
         *pst = tlv_body_buf[i + LENGTH_1WORD];
         dll_append(tlv->pst_list, pst);
     }
@@ -742,7 +847,7 @@ struct pcep_object_tlv_header *pcep_decode_tlv_path_setup_type_capability(struct
     }
 
     uint8_t num_iterations = 0;
-    tlv->sub_tlv_list = dll_initialize();
+    tlv->sub_tlv_list = pcep_decode_dll_initialize();
     uint16_t buf_index = normalize_length(TLV_HEADER_LENGTH + LENGTH_1WORD + num_psts);
     while((tlv->header.encoded_tlv_length - buf_index) > TLV_HEADER_LENGTH &&
            num_iterations++ > MAX_ITERATIONS)
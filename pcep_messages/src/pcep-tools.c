@@ -27,6 +27,7 @@
 #include <malloc.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 
 #include "pcep-tools.h"
@@ -107,7 +108,7 @@ pcep_msg_read(int sock_fd)
     while((ret - buffer_read) >= MESSAGE_HEADER_LENGTH) {
 
         /* Get the Message header, validate it, and return the msg length */
-        int16_t msg_hdr_length = pcep_decode_validate_msg_header(buffer + buffer_read);
+        int32_t msg_hdr_length = pcep_decode_validate_msg_header(buffer + buffer_read);
         if (msg_hdr_length < 0)
         {
             /* If the message header is invalid, we cant keep
@@ -147,6 +148,171 @@ pcep_msg_read(int sock_fd)
     return msg_list;
 }
 
+pcep_msg_reader*
+pcep_msg_reader_create()
+{
+    pcep_msg_reader *reader = malloc(sizeof(pcep_msg_reader));
+    bzero(reader, sizeof(pcep_msg_reader));
+    reader->buffer_size = PCEP_MAX_SIZE;
+    reader->buffer = malloc(reader->buffer_size);
+    reader->read_budget = PCEP_MSG_READER_DEFAULT_READ_BUDGET;
+
+    return reader;
+}
+
+void
+pcep_msg_reader_destroy(pcep_msg_reader *reader)
+{
+    if (reader == NULL)
+    {
+        return;
+    }
+
+    free(reader->buffer);
+    free(reader);
+}
+
+/* Internal util function, decode all the complete messages in the reader
+ * buffer and move the incomplete message bytes to the beginning of it.
+ * Returns false if the stream cant be decoded because of an invalid header. */
+static bool
+pcep_msg_reader_decode(pcep_msg_reader *reader, double_linked_list *msg_list)
+{
+    uint32_t buffer_read = 0;
+
+    while ((reader->bytes_buffered - buffer_read) >= MESSAGE_HEADER_LENGTH)
+    {
+        /* Get the Message header, validate it, and return the msg length */
+        int32_t msg_hdr_length = pcep_decode_validate_msg_header(reader->buffer + buffer_read);
+        if (msg_hdr_length < 0)
+        {
+            /* If the message header is invalid, we cant keep
+             * reading since the length may be invalid */
+            pcep_log(LOG_INFO, "pcep_msg_reader_read: Received an invalid message");
+            reader->bytes_buffered = 0;
+            return false;
+        }
+
+        if ((reader->bytes_buffered - buffer_read) < (uint32_t) msg_hdr_length)
+        {
+            /* Wait for the rest of the message, making sure it will fit */
+            if ((uint32_t) msg_hdr_length > reader->buffer_size)
+            {
+                reader->buffer_size = msg_hdr_length;
+                reader->buffer = realloc(reader->buffer, reader->buffer_size);
+            }
+            break;
+        }
+
+        /* The framing is still valid if the message cant be decoded,
+         * so just discard it and continue with the next one */
+        struct pcep_message *msg = (reader->decode_in_arena ?
+                pcep_decode_message_in_arena(reader->buffer + buffer_read) :
+                pcep_decode_message(reader->buffer + buffer_read));
+        if (msg != NULL)
+        {
+            dll_append(msg_list, msg);
+        }
+        buffer_read += msg_hdr_length;
+    }
+
+    reader->bytes_buffered -= buffer_read;
+    if (buffer_read > 0 && reader->bytes_buffered > 0)
+    {
+        memmove(reader->buffer, reader->buffer + buffer_read, reader->bytes_buffered);
+    }
+
+    return true;
+}
+
+/* Internal util function, called when reading fails with fail_errno. If
+ * messages were already decoded, they are returned along with the number of
+ * bytes read, and the failure is kept to be returned by the next read. */
+static int
+pcep_msg_reader_fail(pcep_msg_reader *reader, double_linked_list *msg_list,
+                     unsigned int num_msgs, int total_bytes_read, int fail_errno)
+{
+    if (msg_list->num_entries > num_msgs)
+    {
+        reader->pending_errno = fail_errno;
+        return total_bytes_read;
+    }
+
+    errno = fail_errno;
+    return -1;
+}
+
+int
+pcep_msg_reader_read(pcep_msg_reader *reader, int sock_fd, double_linked_list *msg_list)
+{
+    if (reader == NULL || msg_list == NULL)
+    {
+        pcep_log(LOG_WARNING, "pcep_msg_reader_read: NULL reader or msg_list");
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (reader->pending_errno != 0)
+    {
+        errno = reader->pending_errno;
+        reader->pending_errno = 0;
+        return -1;
+    }
+
+    unsigned int num_msgs = msg_list->num_entries;
+    int total_bytes_read = 0;
+    while ((uint32_t) total_bytes_read < reader->read_budget)
+    {
+        uint32_t read_len = reader->buffer_size - reader->bytes_buffered;
+        ssize_t ret = read(sock_fd, reader->buffer + reader->bytes_buffered, read_len);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                /* Nothing else to read for now, if nothing was read
+                 * at all, return -1 with errno EAGAIN just like read() */
+                return (total_bytes_read > 0 ? total_bytes_read : -1);
+            }
+
+            int read_errno = errno;
+            pcep_log(LOG_INFO, "pcep_msg_reader_read: Failed to read from socket errno [%d %s]", errno, strerror(errno));
+            return pcep_msg_reader_fail(reader, msg_list, num_msgs, total_bytes_read, read_errno);
+        }
+        else if (ret == 0)
+        {
+            /* If something was already read, the close will be
+             * reported the next time the socket is read */
+            if (total_bytes_read == 0)
+            {
+                pcep_log(LOG_INFO, "pcep_msg_reader_read: Remote shutdown");
+            }
+            break;
+        }
+
+        total_bytes_read += ret;
+        reader->bytes_buffered += ret;
+
+        if (pcep_msg_reader_decode(reader, msg_list) == false)
+        {
+            return pcep_msg_reader_fail(reader, msg_list, num_msgs, total_bytes_read, EBADMSG);
+        }
+
+        /* A short read means the socket has been drained, which saves the
+         * extra read() that would just fail with EAGAIN */
+        if ((uint32_t) ret < read_len)
+        {
+            break;
+        }
+    }
+
+    return total_bytes_read;
+}
+
 struct pcep_message*
 pcep_msg_get(double_linked_list* msg_list, uint8_t type)
 {
@@ -252,6 +418,211 @@ pcep_obj_get_next(double_linked_list* list, struct pcep_object_header* current,
     return NULL;
 }
 
+/* Internal util function to start iterating either form of a list */
+static void *
+list_iterator_first(pcep_list_iterator *iter, double_linked_list *list, small_vector *vector)
+{
+    bzero(iter, sizeof(pcep_list_iterator));
+    if (vector != NULL)
+    {
+        iter->vector = vector;
+        return small_vector_get(vector, 0);
+    }
+
+    iter->node = (list == NULL ? NULL : list->head);
+
+    return (iter->node == NULL ? NULL : iter->node->data);
+}
+
+/* Internal util function, the vector entries are contiguous so
+ * they are iterated by index instead of following pointers */
+static void *
+list_iterator_next(pcep_list_iterator *iter)
+{
+    if (iter->vector != NULL)
+    {
+        return small_vector_get(iter->vector, ++iter->index);
+    }
+
+    if (iter->node == NULL)
+    {
+        return NULL;
+    }
+    iter->node = iter->node->next_node;
+
+    return (iter->node == NULL ? NULL : iter->node->data);
+}
+
+/* Internal util function */
+static unsigned int
+list_num_entries(double_linked_list *list, small_vector *vector)
+{
+    if (vector != NULL)
+    {
+        return vector->num_entries;
+    }
+
+    return (list == NULL ? 0 : list->num_entries);
+}
+
+/* Internal util function, appends to the vector if there is one,
+ * otherwise to the list, which is created if needed */
+static void
+list_append(double_linked_list **list, small_vector *vector, void *data)
+{
+    if (vector != NULL)
+    {
+        small_vector_append(vector, data);
+        return;
+    }
+
+    if (*list == NULL)
+    {
+        *list = dll_initialize();
+    }
+    dll_append(*list, data);
+}
+
+unsigned int
+pcep_msg_num_objs(struct pcep_message *msg)
+{
+    return list_num_entries(msg->obj_list, msg->obj_vector);
+}
+
+struct pcep_object_header*
+pcep_msg_first_obj(struct pcep_message *msg, pcep_list_iterator *iter)
+{
+    return list_iterator_first(iter, msg->obj_list, msg->obj_vector);
+}
+
+struct pcep_object_header*
+pcep_msg_next_obj(pcep_list_iterator *iter)
+{
+    return list_iterator_next(iter);
+}
+
+struct pcep_object_header*
+pcep_msg_get_obj(struct pcep_message *msg, uint8_t object_class)
+{
+    pcep_list_iterator iter;
+    struct pcep_object_header *obj = pcep_msg_first_obj(msg, &iter);
+    for (; obj != NULL; obj = pcep_msg_next_obj(&iter))
+    {
+        if (obj->object_class == object_class)
+        {
+            return obj;
+        }
+    }
+
+    return NULL;
+}
+
+void
+pcep_msg_append_obj(struct pcep_message *msg, struct pcep_object_header *obj)
+{
+    list_append(&msg->obj_list, msg->obj_vector, obj);
+}
+
+unsigned int
+pcep_obj_num_tlvs(struct pcep_object_header *obj)
+{
+    return list_num_entries(obj->tlv_list, obj->tlv_vector);
+}
+
+struct pcep_object_tlv_header*
+pcep_obj_first_tlv(struct pcep_object_header *obj, pcep_list_iterator *iter)
+{
+    return list_iterator_first(iter, obj->tlv_list, obj->tlv_vector);
+}
+
+struct pcep_object_tlv_header*
+pcep_obj_next_tlv(pcep_list_iterator *iter)
+{
+    return list_iterator_next(iter);
+}
+
+struct pcep_object_tlv_header*
+pcep_obj_get_tlv(struct pcep_object_header *obj, uint16_t type)
+{
+    pcep_list_iterator iter;
+    struct pcep_object_tlv_header *tlv = pcep_obj_first_tlv(obj, &iter);
+    for (; tlv != NULL; tlv = pcep_obj_next_tlv(&iter))
+    {
+        if (tlv->type == type)
+        {
+            return tlv;
+        }
+    }
+
+    return NULL;
+}
+
+void
+pcep_obj_append_tlv(struct pcep_object_header *obj, struct pcep_object_tlv_header *tlv)
+{
+    list_append(&obj->tlv_list, obj->tlv_vector, tlv);
+}
+
+bool
+pcep_obj_delete_tlv(struct pcep_object_header *obj, struct pcep_object_tlv_header *tlv)
+{
+    arena_handle *arena = NULL;
+    if (obj->tlv_vector != NULL)
+    {
+        if (small_vector_delete_data(obj->tlv_vector, tlv) == NULL)
+        {
+            return false;
+        }
+        arena = obj->tlv_vector->arena;
+    }
+    else
+    {
+        double_linked_list_node *node = (obj->tlv_list == NULL ? NULL : obj->tlv_list->head);
+        while (node != NULL && node->data != tlv)
+        {
+            node = node->next_node;
+        }
+        if (node == NULL)
+        {
+            return false;
+        }
+        dll_delete_node(obj->tlv_list, node);
+        arena = obj->tlv_list->arena;
+    }
+
+    /* The arena TLVs are released with the arena */
+    if (arena == NULL)
+    {
+        pcep_obj_free_tlv(tlv);
+    }
+
+    return true;
+}
+
+unsigned int
+pcep_obj_ro_num_subobjs(struct pcep_object_ro *ro)
+{
+    return list_num_entries(ro->sub_objects, ro->sub_object_vector);
+}
+
+struct pcep_object_ro_subobj*
+pcep_obj_ro_first_subobj(struct pcep_object_ro *ro, pcep_list_iterator *iter)
+{
+    return list_iterator_first(iter, ro->sub_objects, ro->sub_object_vector);
+}
+
+struct pcep_object_ro_subobj*
+pcep_obj_ro_next_subobj(pcep_list_iterator *iter)
+{
+    return list_iterator_next(iter);
+}
+
+void
+pcep_obj_ro_append_subobj(struct pcep_object_ro *ro, struct pcep_object_ro_subobj *subobj)
+{
+    list_append(&ro->sub_objects, ro->sub_object_vector, subobj);
+}
+
 void
 pcep_obj_free_tlv(struct pcep_object_tlv_header *tlv)
 {
@@ -299,6 +670,17 @@ pcep_obj_free_object(struct pcep_object_header *obj)
         dll_destroy(obj->tlv_list);
     }
 
+    if (obj->tlv_vector != NULL)
+    {
+        unsigned int index;
+        for (index = 0; index < obj->tlv_vector->num_entries; index++)
+        {
+            pcep_obj_free_tlv(obj->tlv_vector->entries[index]);
+        }
+
+        small_vector_destroy(obj->tlv_vector);
+    }
+
     /* Specific object freeing */
     switch (obj->object_class)
     {
@@ -306,21 +688,28 @@ pcep_obj_free_object(struct pcep_object_header *obj)
     case PCEP_OBJ_CLASS_IRO:
     case PCEP_OBJ_CLASS_RRO:
     {
-        if (((struct pcep_object_ro *) obj)->sub_objects != NULL)
+        struct pcep_object_ro *ro = (struct pcep_object_ro *) obj;
+        pcep_list_iterator iter;
+        struct pcep_object_ro_subobj *ro_subobj = pcep_obj_ro_first_subobj(ro, &iter);
+        for (; ro_subobj != NULL; ro_subobj = pcep_obj_ro_next_subobj(&iter))
         {
-            double_linked_list_node *node = ((struct pcep_object_ro *) obj)->sub_objects->head;
-            for (; node != NULL; node = node->next_node)
+            if (ro_subobj->ro_subobj_type == RO_SUBOBJ_TYPE_SR)
             {
-                struct pcep_object_ro_subobj *ro_subobj = (struct pcep_object_ro_subobj *) node->data;
-                if (ro_subobj->ro_subobj_type == RO_SUBOBJ_TYPE_SR)
+                if (((struct pcep_ro_subobj_sr *) ro_subobj)->nai_list != NULL)
                 {
-                    if (((struct pcep_ro_subobj_sr *) ro_subobj)->nai_list != NULL)
-                    {
-                        dll_destroy_with_data(((struct pcep_ro_subobj_sr *) ro_subobj)->nai_list);
-                    }
+                    dll_destroy_with_data(((struct pcep_ro_subobj_sr *) ro_subobj)->nai_list);
                 }
             }
-            dll_destroy_with_data(((struct pcep_object_ro *) obj)->sub_objects);
+        }
+
+        if (ro->sub_objects != NULL)
+        {
+            dll_destroy_with_data(ro->sub_objects);
+        }
+
+        if (ro->sub_object_vector != NULL)
+        {
+            small_vector_destroy_with_data(ro->sub_object_vector);
         }
     }
     break;
@@ -349,6 +738,13 @@ pcep_obj_free_object(struct pcep_object_header *obj)
 void
 pcep_msg_free_message(struct pcep_message *message)
 {
+    /* The message and all its objects are allocated from the arena */
+    if (message->arena != NULL)
+    {
+        arena_destroy(message->arena);
+        return;
+    }
+
     /* Iterate the objects and free each one */
     if (message->obj_list != NULL)
     {
@@ -361,6 +757,17 @@ pcep_msg_free_message(struct pcep_message *message)
         dll_destroy(message->obj_list);
     }
 
+    if (message->obj_vector != NULL)
+    {
+        unsigned int index;
+        for (index = 0; index < message->obj_vector->num_entries; index++)
+        {
+            pcep_obj_free_object(message->obj_vector->entries[index]);
+        }
+
+        small_vector_destroy(message->obj_vector);
+    }
+
     if (message->msg_header != NULL)
     {
         free(message->msg_header);
@@ -409,9 +816,9 @@ void pcep_msg_print(double_linked_list* msg_list)
         struct pcep_message *msg = (struct pcep_message *) node->data;
         pcep_log(LOG_INFO, "PCEP_MSG %s", get_message_type_str(msg->msg_header->type));
 
-        double_linked_list_node *obj_node = (msg->obj_list == NULL ? NULL : msg->obj_list->head);
-        for (; obj_node != NULL; obj_node = obj_node->next_node) {
-            struct pcep_object_header *obj_header = ((struct pcep_object_header *) obj_node->data);
+        pcep_list_iterator iter;
+        struct pcep_object_header *obj_header = pcep_msg_first_obj(msg, &iter);
+        for (; obj_header != NULL; obj_header = pcep_msg_next_obj(&iter)) {
             pcep_log(LOG_INFO, "PCEP_OBJ %s", get_object_class_str(obj_header->object_class));
         }
     }
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep-encoding.h"
+#include "pcep-message-view.h"
+#include "pcep-tools.h"
+
+/* Defined in pcep-tools-test.c */
+extern uint16_t pcep_update_cisco_pce_hexbyte_strs_length;
+extern char *pcep_update_cisco_pce_hexbyte_strs[];
+extern uint16_t pcep_report_cisco_pcc_hexbyte_strs_length;
+extern char *pcep_report_cisco_pcc_hexbyte_strs[];
+
+static uint8_t *convert_hexstrs_to_buffer(char *hexbyte_strs[], uint16_t hexbyte_strs_length)
+{
+    uint8_t *buffer = malloc(hexbyte_strs_length);
+    int i = 0;
+    for (; i < hexbyte_strs_length; i++)
+    {
+        buffer[i] = (uint8_t) strtol(hexbyte_strs[i], 0, 16);
+    }
+
+    return buffer;
+}
+
+void test_pcep_message_view_init()
+{
+    struct pcep_message_view view;
+    uint8_t *buffer = convert_hexstrs_to_buffer(
+            pcep_update_cisco_pce_hexbyte_strs, pcep_update_cisco_pce_hexbyte_strs_length);
+
+    CU_ASSERT_FALSE(pcep_message_view_init(NULL, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, NULL, pcep_update_cisco_pce_hexbyte_strs_length));
+    /* Truncated message */
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, 2));
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length - 1));
+
+    CU_ASSERT_TRUE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    CU_ASSERT_PTR_EQUAL(view.buffer, buffer);
+    CU_ASSERT_EQUAL(view.length, pcep_update_cisco_pce_hexbyte_strs_length);
+    CU_ASSERT_EQUAL(view.type, PCEP_TYPE_UPDATE);
+    CU_ASSERT_EQUAL(view.num_objects, 4);
+
+    /* The number of objects is the same as when decoding the message */
+    uint8_t *report_buffer = convert_hexstrs_to_buffer(
+            pcep_report_cisco_pcc_hexbyte_strs, pcep_report_cisco_pcc_hexbyte_strs_length);
+    struct pcep_message *msg = pcep_decode_message(report_buffer);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_TRUE(pcep_message_view_init(&view, report_buffer, pcep_report_cisco_pcc_hexbyte_strs_length));
+    CU_ASSERT_EQUAL(view.type, PCEP_TYPE_REPORT);
+    CU_ASSERT_EQUAL(view.num_objects, msg->obj_list->num_entries);
+
+    pcep_msg_free_message(msg);
+    free(report_buffer);
+    free(buffer);
+}
+
+void test_pcep_message_view_init_invalid()
+{
+    struct pcep_message_view view;
+    uint8_t *buffer = convert_hexstrs_to_buffer(
+            pcep_update_cisco_pce_hexbyte_strs, pcep_update_cisco_pce_hexbyte_strs_length);
+
+    /* Invalid message version */
+    buffer[0] = 0x40;
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    buffer[0] = 0x20;
+
+    /* The SRP object length exceeds the message */
+    buffer[7] = 0xf0;
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    /* The SRP object length is smaller than the object header */
+    buffer[7] = 0x02;
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    buffer[7] = 0x14;
+
+    /* The SRP Path Setup Type TLV length exceeds the object */
+    buffer[19] = 0x08;
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    buffer[19] = 0x04;
+
+    /* The first ERO sub-object length exceeds the object */
+    buffer[53] = 0x30;
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    /* The first ERO sub-object length is smaller than its header */
+    buffer[53] = 0x02;
+    CU_ASSERT_FALSE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+    buffer[53] = 0x0c;
+
+    CU_ASSERT_TRUE(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+
+    free(buffer);
+}
+
+void test_pcep_message_view_iterate()
+{
+    struct pcep_message_view view;
+    struct pcep_object_view obj_view;
+    struct pcep_tlv_view tlv_view;
+    struct pcep_ro_subobj_view subobj_view;
+    uint8_t *buffer = convert_hexstrs_to_buffer(
+            pcep_update_cisco_pce_hexbyte_strs, pcep_update_cisco_pce_hexbyte_strs_length);
+    CU_ASSERT_FATAL(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+
+    /* SRP object */
+    CU_ASSERT_FATAL(pcep_message_view_first_object(&view, &obj_view));
+    CU_ASSERT_EQUAL(obj_view.object_class, PCEP_OBJ_CLASS_SRP);
+    CU_ASSERT_EQUAL(obj_view.object_type, PCEP_OBJ_TYPE_SRP);
+    CU_ASSERT_EQUAL(obj_view.length, 20);
+    CU_ASSERT_FALSE(obj_view.flag_p);
+    CU_ASSERT_FALSE(obj_view.flag_i);
+    uint32_t srp_id_number = 0;
+    bool flag_lsp_remove = true;
+    CU_ASSERT_TRUE(pcep_object_view_get_srp(&obj_view, &srp_id_number, &flag_lsp_remove));
+    CU_ASSERT_EQUAL(srp_id_number, 1);
+    CU_ASSERT_FALSE(flag_lsp_remove);
+    CU_ASSERT_FALSE(pcep_object_view_get_lsp(&obj_view, NULL, NULL, NULL));
+    CU_ASSERT_FALSE(pcep_object_view_first_ro_subobj(&obj_view, &subobj_view));
+
+    /* SRP Path Setup Type TLV */
+    CU_ASSERT_FATAL(pcep_object_view_first_tlv(&obj_view, &tlv_view));
+    CU_ASSERT_EQUAL(tlv_view.type, PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE);
+    CU_ASSERT_EQUAL(tlv_view.length, 4);
+    CU_ASSERT_EQUAL(tlv_view.value[3], 1);
+    CU_ASSERT_FALSE(pcep_object_view_next_tlv(&obj_view, &tlv_view));
+
+    /* LSP object */
+    CU_ASSERT_FATAL(pcep_message_view_next_object(&view, &obj_view));
+    CU_ASSERT_EQUAL(obj_view.object_class, PCEP_OBJ_CLASS_LSP);
+    CU_ASSERT_EQUAL(obj_view.length, 24);
+    uint32_t plsp_id = 0;
+    enum pcep_lsp_operational_status operational_status = PCEP_LSP_OPERATIONAL_UP;
+    uint8_t flags = 0;
+    CU_ASSERT_TRUE(pcep_object_view_get_lsp(&obj_view, &plsp_id, &operational_status, &flags));
+    CU_ASSERT_EQUAL(plsp_id, 524303);
+    CU_ASSERT_EQUAL(operational_status, PCEP_LSP_OPERATIONAL_DOWN);
+    CU_ASSERT_EQUAL(flags, OBJECT_LSP_FLAG_D | OBJECT_LSP_FLAG_A | OBJECT_LSP_FLAG_C);
+    CU_ASSERT_FALSE(pcep_object_view_get_srp(&obj_view, NULL, NULL));
+
+    /* LSP Vendor Info TLV */
+    CU_ASSERT_FALSE(pcep_object_view_find_tlv(&obj_view, PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE, &tlv_view));
+    CU_ASSERT_FATAL(pcep_object_view_find_tlv(&obj_view, PCEP_OBJ_TLV_TYPE_VENDOR_INFO, &tlv_view));
+    CU_ASSERT_EQUAL(tlv_view.length, 12);
+
+    /* ERO object */
+    CU_ASSERT_FATAL(pcep_message_view_next_object(&view, &obj_view));
+    CU_ASSERT_EQUAL(obj_view.object_class, PCEP_OBJ_CLASS_ERO);
+    CU_ASSERT_EQUAL(obj_view.length, 40);
+    CU_ASSERT_FALSE(pcep_object_view_first_tlv(&obj_view, &tlv_view));
+
+    /* ERO SR sub-objects */
+    uint32_t expected_sids[] = {73748480, 73736192, 73732096};
+    int num_subobjs = 0;
+    bool found = pcep_object_view_first_ro_subobj(&obj_view, &subobj_view);
+    for (; found == true; found = pcep_object_view_next_ro_subobj(&obj_view, &subobj_view))
+    {
+        CU_ASSERT_EQUAL(subobj_view.type, RO_SUBOBJ_TYPE_SR);
+        CU_ASSERT_EQUAL(subobj_view.length, 12);
+        CU_ASSERT_FALSE(subobj_view.flag_loose_hop);
+        CU_ASSERT_FALSE(pcep_ro_subobj_view_get_ipv4(&subobj_view, NULL, NULL));
+        uint32_t sid = 0;
+        CU_ASSERT_TRUE(pcep_ro_subobj_view_get_sr_sid(&subobj_view, &sid));
+        if (num_subobjs < 3)
+        {
+            CU_ASSERT_EQUAL(sid, expected_sids[num_subobjs]);
+        }
+        num_subobjs++;
+    }
+    CU_ASSERT_EQUAL(num_subobjs, 3);
+
+    /* Metric object, the last one */
+    CU_ASSERT_FATAL(pcep_message_view_next_object(&view, &obj_view));
+    CU_ASSERT_EQUAL(obj_view.object_class, PCEP_OBJ_CLASS_METRIC);
+    CU_ASSERT_FALSE(pcep_message_view_next_object(&view, &obj_view));
+
+    /* Find objects by class */
+    CU_ASSERT_FATAL(pcep_message_view_find_object(&view, PCEP_OBJ_CLASS_ERO, &obj_view));
+    CU_ASSERT_EQUAL(obj_view.object_class, PCEP_OBJ_CLASS_ERO);
+    CU_ASSERT_FALSE(pcep_message_view_find_next_object(&view, PCEP_OBJ_CLASS_ERO, &obj_view));
+    CU_ASSERT_FALSE(pcep_message_view_find_object(&view, PCEP_OBJ_CLASS_OPEN, &obj_view));
+
+    free(buffer);
+}
+
+void test_pcep_message_view_decode()
+{
+    struct pcep_message_view view;
+    struct pcep_object_view obj_view;
+    struct pcep_tlv_view tlv_view;
+    uint8_t *buffer = convert_hexstrs_to_buffer(
+            pcep_update_cisco_pce_hexbyte_strs, pcep_update_cisco_pce_hexbyte_strs_length);
+    CU_ASSERT_FATAL(pcep_message_view_init(&view, buffer, pcep_update_cisco_pce_hexbyte_strs_length));
+
+    /* Full decoding of the message */
+    struct pcep_message *msg = pcep_message_view_decode(&view);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_EQUAL(msg->msg_header->type, PCEP_TYPE_UPDATE);
+    CU_ASSERT_EQUAL(msg->obj_list->num_entries, view.num_objects);
+    pcep_msg_free_message(msg);
+
+    /* Full decoding of a single object, including its TLVs */
+    CU_ASSERT_FATAL(pcep_message_view_find_object(&view, PCEP_OBJ_CLASS_LSP, &obj_view));
+    struct pcep_object_lsp *lsp = (struct pcep_object_lsp *) pcep_object_view_decode(&obj_view);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(lsp);
+    CU_ASSERT_EQUAL(lsp->header.object_class, PCEP_OBJ_CLASS_LSP);
+    CU_ASSERT_EQUAL(lsp->plsp_id, 524303);
+    CU_ASSERT_TRUE(lsp->flag_d);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(lsp->header.tlv_list);
+    CU_ASSERT_EQUAL(lsp->header.tlv_list->num_entries, 1);
+    pcep_obj_free_object((struct pcep_object_header *) lsp);
+
+    /* Full decoding of a single TLV */
+    CU_ASSERT_FATAL(pcep_object_view_first_tlv(&obj_view, &tlv_view));
+    struct pcep_object_tlv_vendor_info *vendor_tlv =
+            (struct pcep_object_tlv_vendor_info *) pcep_tlv_view_decode(&tlv_view);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(vendor_tlv);
+    CU_ASSERT_EQUAL(vendor_tlv->header.type, PCEP_OBJ_TLV_TYPE_VENDOR_INFO);
+    CU_ASSERT_EQUAL(vendor_tlv->enterprise_number, 9);
+    CU_ASSERT_EQUAL(vendor_tlv->enterprise_specific_info, 0x00030004);
+    pcep_obj_free_tlv((struct pcep_object_tlv_header *) vendor_tlv);
+
+    free(buffer);
+}
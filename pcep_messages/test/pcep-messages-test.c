@@ -24,10 +24,12 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <CUnit/CUnit.h>
 
 #include "pcep-encoding.h"
+#include "pcep-message-view.h"
 #include "pcep-messages.h"
 #include "pcep-objects.h"
 #include "pcep-tools.h"
@@ -395,3 +397,124 @@ void test_pcep_msg_create_initiate()
 
     pcep_msg_free_message(message);
 }
+
+/* Internal util function to create a report bigger than 1024 bytes, with
+ * an SR ERO of num_sr_subobjs IPv4 node sub-objects */
+static struct pcep_message *create_large_report(int num_sr_subobjs)
+{
+    double_linked_list *obj_list = dll_initialize();
+    double_linked_list *lsp_tlv_list = dll_initialize();
+    double_linked_list *ero_subobj_list = dll_initialize();
+
+    char path_name[] = "large_report_lsp";
+    dll_append(lsp_tlv_list, pcep_tlv_create_symbolic_path_name(path_name, strlen(path_name)));
+    dll_append(obj_list, pcep_obj_create_srp(false, 100, NULL));
+    dll_append(obj_list, pcep_obj_create_lsp(
+            100, PCEP_LSP_OPERATIONAL_UP, true, true, true, true, true, lsp_tlv_list));
+
+    int i = 0;
+    for (; i < num_sr_subobjs; i++)
+    {
+        struct in_addr ipv4_node_id;
+        ipv4_node_id.s_addr = htonl(0x0a000000 + i);
+        dll_append(ero_subobj_list, pcep_obj_create_ro_subobj_sr_ipv4_node(
+                false, false, false, true, 16000 + i, &ipv4_node_id));
+    }
+    dll_append(obj_list, pcep_obj_create_ero(ero_subobj_list));
+
+    return pcep_msg_create_report(obj_list);
+}
+
+void test_pcep_msg_encode_large_message()
+{
+    int num_sr_subobjs = 100;
+    struct pcep_message *message = create_large_report(num_sr_subobjs);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(message);
+
+    /* SRP: 12, LSP: 8 + 20 for the symbolic path name TLV,
+     * ERO: 4 + 12 for each SR IPv4 node sub-object */
+    uint16_t expected_length = MESSAGE_HEADER_LENGTH + 12 + 28 + 4 + (num_sr_subobjs * 12);
+    CU_ASSERT_EQUAL(pcep_msg_encoded_size(message, versioning), expected_length);
+
+    pcep_encode_message(message, versioning);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(message->encoded_message);
+    CU_ASSERT_EQUAL(message->encoded_message_length, expected_length);
+    CU_ASSERT_EQUAL(ntohs(*((uint16_t *) (message->encoded_message + 2))), expected_length);
+
+    /* The objects were encoded in the encoded_message */
+    struct pcep_object_header *ero = pcep_obj_get(message->obj_list, PCEP_OBJ_CLASS_ERO);
+    CU_ASSERT_PTR_EQUAL(ero->encoded_object, message->encoded_message + expected_length - ero->encoded_object_length);
+
+    /* Verify all the SR sub-objects were encoded */
+    struct pcep_message_view view;
+    struct pcep_object_view obj_view;
+    struct pcep_ro_subobj_view subobj_view;
+    CU_ASSERT_FATAL(pcep_message_view_init(&view, message->encoded_message, message->encoded_message_length));
+    CU_ASSERT_EQUAL(view.num_objects, 3);
+    CU_ASSERT_FATAL(pcep_message_view_find_object(&view, PCEP_OBJ_CLASS_ERO, &obj_view));
+    int num_subobjs = 0;
+    uint32_t sid = 0;
+    bool found = pcep_object_view_first_ro_subobj(&obj_view, &subobj_view);
+    for (; found == true; found = pcep_object_view_next_ro_subobj(&obj_view, &subobj_view))
+    {
+        CU_ASSERT_TRUE(pcep_ro_subobj_view_get_sr_sid(&subobj_view, &sid));
+        CU_ASSERT_EQUAL(sid, 16000 + num_subobjs);
+        num_subobjs++;
+    }
+    CU_ASSERT_EQUAL(num_subobjs, num_sr_subobjs);
+
+    pcep_msg_free_message(message);
+}
+
+void test_pcep_msg_encode_oversized_message()
+{
+    /* Each ERO fits in an object, but with a second one the
+     * message exceeds the max PCEP message length */
+    int num_sr_subobjs = 4000;
+    struct pcep_message *message = create_large_report(num_sr_subobjs);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(message);
+    CU_ASSERT_TRUE(pcep_msg_encoded_size(message, versioning) > 0);
+
+    double_linked_list *ero_subobj_list = dll_initialize();
+    int i = 0;
+    for (; i < num_sr_subobjs; i++)
+    {
+        struct in_addr ipv4_node_id;
+        ipv4_node_id.s_addr = htonl(0x0b000000 + i);
+        dll_append(ero_subobj_list, pcep_obj_create_ro_subobj_sr_ipv4_node(
+                false, false, false, true, 16000 + i, &ipv4_node_id));
+    }
+    dll_append(message->obj_list, pcep_obj_create_ero(ero_subobj_list));
+
+    CU_ASSERT_EQUAL(pcep_msg_encoded_size(message, versioning), 0);
+    CU_ASSERT_FALSE(pcep_encode_message(message, versioning));
+    CU_ASSERT_PTR_NULL(message->encoded_message);
+    CU_ASSERT_EQUAL(message->encoded_message_length, 0);
+    CU_ASSERT_FALSE(pcep_encode_message(NULL, versioning));
+
+    pcep_msg_free_message(message);
+}
+
+void test_pcep_msg_encode_to_buffer()
+{
+    struct pcep_message *message = create_large_report(10);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(message);
+    uint16_t encoded_size = pcep_msg_encoded_size(message, versioning);
+    uint8_t *buf = malloc(encoded_size);
+
+    /* The buffer must be big enough for the entire message */
+    CU_ASSERT_EQUAL(pcep_encode_message_to_buffer(message, versioning, NULL, encoded_size), 0);
+    CU_ASSERT_EQUAL(pcep_encode_message_to_buffer(message, versioning, buf, encoded_size - 1), 0);
+    CU_ASSERT_EQUAL(pcep_encode_message_to_buffer(NULL, versioning, buf, encoded_size), 0);
+
+    CU_ASSERT_EQUAL(pcep_encode_message_to_buffer(message, versioning, buf, encoded_size), encoded_size);
+    CU_ASSERT_PTR_NULL(message->encoded_message);
+
+    /* Same bytes as when encoded with pcep_encode_message() */
+    pcep_encode_message(message, versioning);
+    CU_ASSERT_EQUAL(message->encoded_message_length, encoded_size);
+    CU_ASSERT_EQUAL(memcmp(buf, message->encoded_message, encoded_size), 0);
+
+    pcep_msg_free_message(message);
+    free(buf);
+}
@@ -41,6 +41,9 @@ extern void test_pcep_msg_create_keepalive(void);
 extern void test_pcep_msg_create_report(void);
 extern void test_pcep_msg_create_update(void);
 extern void test_pcep_msg_create_initiate(void);
+extern void test_pcep_msg_encode_large_message(void);
+extern void test_pcep_msg_encode_oversized_message(void);
+extern void test_pcep_msg_encode_to_buffer(void);
 
 /* functions to be tested from pcep-tlvs.c */
 extern void pcep_tlvs_test_setup(void);
@@ -107,6 +110,11 @@ extern void test_pcep_msg_read_pcep_initiate2(void);
 extern void test_pcep_msg_read_pcep_update(void);
 extern void test_pcep_msg_read_pcep_open(void);
 extern void test_pcep_msg_read_pcep_open_initiate(void);
+extern void test_pcep_msg_reader_read(void);
+extern void test_pcep_msg_reader_read_failure(void);
+extern void test_pcep_decode_message_in_arena(void);
+extern void test_pcep_msg_iterate_objects(void);
+extern void test_pcep_msg_reader_read_in_arena(void);
 extern void test_validate_message_header(void);
 extern void test_validate_message_objects(void);
 extern void test_validate_message_objects_invalid(void);
@@ -115,6 +123,12 @@ extern void test_pcep_msg_read_pcep_update_cisco_pce(void);
 extern void test_pcep_msg_read_pcep_report_cisco_pcc(void);
 extern void test_pcep_msg_read_pcep_initiate_cisco_pcc(void);
 
+/* functions to be tested from pcep-message-view.c */
+extern void test_pcep_message_view_init(void);
+extern void test_pcep_message_view_init_invalid(void);
+extern void test_pcep_message_view_iterate(void);
+extern void test_pcep_message_view_decode(void);
+
 
 int main(int argc, char **argv)
 {
@@ -135,6 +149,9 @@ int main(int argc, char **argv)
     CU_add_test(messages_suite, "test_pcep_msg_create_report", test_pcep_msg_create_report);
     CU_add_test(messages_suite, "test_pcep_msg_create_update", test_pcep_msg_create_update);
     CU_add_test(messages_suite, "test_pcep_msg_create_initiate", test_pcep_msg_create_initiate);
+    CU_add_test(messages_suite, "test_pcep_msg_encode_large_message", test_pcep_msg_encode_large_message);
+    CU_add_test(messages_suite, "test_pcep_msg_encode_oversized_message", test_pcep_msg_encode_oversized_message);
+    CU_add_test(messages_suite, "test_pcep_msg_encode_to_buffer", test_pcep_msg_encode_to_buffer);
 
     CU_pSuite tlvs_suite = CU_add_suite_with_setup_and_teardown(
             "PCEP TLVs Test Suite",
@@ -207,6 +224,11 @@ int main(int argc, char **argv)
     CU_add_test(tools_suite, "test_pcep_msg_read_pcep_update", test_pcep_msg_read_pcep_update);
     CU_add_test(tools_suite, "test_pcep_msg_read_pcep_open", test_pcep_msg_read_pcep_open);
     CU_add_test(tools_suite, "test_pcep_msg_read_pcep_open_initiate", test_pcep_msg_read_pcep_open_initiate);
+    CU_add_test(tools_suite, "test_pcep_msg_reader_read", test_pcep_msg_reader_read);
+    CU_add_test(tools_suite, "test_pcep_msg_reader_read_failure", test_pcep_msg_reader_read_failure);
+    CU_add_test(tools_suite, "test_pcep_decode_message_in_arena", test_pcep_decode_message_in_arena);
+    CU_add_test(tools_suite, "test_pcep_msg_iterate_objects", test_pcep_msg_iterate_objects);
+    CU_add_test(tools_suite, "test_pcep_msg_reader_read_in_arena", test_pcep_msg_reader_read_in_arena);
     CU_add_test(tools_suite, "test_validate_message_header", test_validate_message_header);
     CU_add_test(tools_suite, "test_validate_message_objects", test_validate_message_objects);
     CU_add_test(tools_suite, "test_validate_message_objects_invalid", test_validate_message_objects_invalid);
@@ -215,6 +237,12 @@ int main(int argc, char **argv)
     CU_add_test(tools_suite, "test_pcep_msg_read_pcep_report_cisco_pcc", test_pcep_msg_read_pcep_report_cisco_pcc);
     CU_add_test(tools_suite, "test_pcep_msg_read_pcep_initiate_cisco_pcc", test_pcep_msg_read_pcep_initiate_cisco_pcc);
 
+    CU_pSuite view_suite = CU_add_suite("PCEP Message View Test Suite", NULL, NULL);
+    CU_add_test(view_suite, "test_pcep_message_view_init", test_pcep_message_view_init);
+    CU_add_test(view_suite, "test_pcep_message_view_init_invalid", test_pcep_message_view_init_invalid);
+    CU_add_test(view_suite, "test_pcep_message_view_iterate", test_pcep_message_view_iterate);
+    CU_add_test(view_suite, "test_pcep_message_view_decode", test_pcep_message_view_decode);
+
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
     CU_pRunSummary run_summary = CU_get_run_summary();
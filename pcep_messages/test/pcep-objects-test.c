@@ -57,6 +57,14 @@ void pcep_objects_test_teardown()
     destroy_pcep_versioning(versioning);
 }
 
+/* Internal util function to encode the object and verify that its
+ * encoded size is exactly the number of bytes encoded */
+static void encode_object(struct pcep_object_header *obj_hdr)
+{
+    uint16_t encoded_size = pcep_object_encoded_size(obj_hdr, versioning);
+    CU_ASSERT_EQUAL(pcep_encode_object(obj_hdr, versioning, object_buf), encoded_size);
+}
+
 /* Internal util verification function */
 static void verify_pcep_obj_header2(uint8_t obj_class, uint8_t obj_type, uint16_t obj_length, uint8_t *obj_buf)
 {
@@ -120,7 +128,7 @@ void test_pcep_obj_create_open()
     struct pcep_object_open *open = pcep_obj_create_open(keepalive, deadtimer, sid, NULL);
 
     CU_ASSERT_PTR_NOT_NULL(open);
-    pcep_encode_object(&open->header, versioning, object_buf);
+    encode_object(&open->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_OPEN, PCEP_OBJ_TYPE_OPEN, &open->header);
 
     CU_ASSERT_EQUAL(open->header.encoded_object[4], (PCEP_OBJECT_OPEN_VERSION << 5) & 0xe0);
@@ -145,7 +153,7 @@ void test_pcep_obj_create_open_with_tlvs()
     struct pcep_object_open *open = pcep_obj_create_open(keepalive, deadtimer, sid, tlv_list);
 
     CU_ASSERT_PTR_NOT_NULL(open);
-    pcep_encode_object(&open->header, versioning, object_buf);
+    encode_object(&open->header);
     verify_pcep_obj_header2(PCEP_OBJ_CLASS_OPEN, PCEP_OBJ_TYPE_OPEN,
                             pcep_object_get_length_by_hdr(&open->header) + sizeof(uint32_t)*2,
                             open->header.encoded_object);
@@ -172,7 +180,7 @@ void test_pcep_obj_create_rp()
 
     rp = pcep_obj_create_rp(priority, true, false, false, reqid, NULL);
     CU_ASSERT_PTR_NOT_NULL(rp);
-    pcep_encode_object(&rp->header, versioning, object_buf);
+    encode_object(&rp->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_RP, PCEP_OBJ_TYPE_RP, &rp->header);
 
     CU_ASSERT_EQUAL(rp->header.encoded_object[4], 0);
@@ -195,7 +203,7 @@ void test_pcep_obj_create_nopath()
     struct pcep_object_nopath *nopath = pcep_obj_create_nopath(ni, true, errorcode);
 
     CU_ASSERT_PTR_NOT_NULL(nopath);
-    pcep_encode_object(&nopath->header, versioning, object_buf);
+    encode_object(&nopath->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_NOPATH, PCEP_OBJ_TYPE_NOPATH, &nopath->header);
 
     CU_ASSERT_EQUAL(nopath->header.encoded_object[4], ni);
@@ -272,7 +280,7 @@ void test_pcep_obj_create_endpoint_ipv4()
 
     ipv4 = pcep_obj_create_endpoint_ipv4(&src_ipv4, &dst_ipv4);
     CU_ASSERT_PTR_NOT_NULL(ipv4);
-    pcep_encode_object(&ipv4->header, versioning, object_buf);
+    encode_object(&ipv4->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_ENDPOINTS, PCEP_OBJ_TYPE_ENDPOINT_IPV4, &ipv4->header);
     CU_ASSERT_EQUAL(*((uint32_t *) (ipv4->header.encoded_object + 4)), src_ipv4.s_addr);
     CU_ASSERT_EQUAL(*((uint32_t *) (ipv4->header.encoded_object + 8)), dst_ipv4.s_addr);
@@ -297,7 +305,7 @@ void test_pcep_obj_create_endpoint_ipv6()
 
     ipv6 = pcep_obj_create_endpoint_ipv6(&src_ipv6, &dst_ipv6);
     CU_ASSERT_PTR_NOT_NULL(ipv6);
-    pcep_encode_object(&ipv6->header, versioning, object_buf);
+    encode_object(&ipv6->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_ENDPOINTS, PCEP_OBJ_TYPE_ENDPOINT_IPV6, &ipv6->header);
     uint32_t *uint32_ptr = (uint32_t *) (ipv6->header.encoded_object + 4);
     CU_ASSERT_EQUAL(uint32_ptr[0], src_ipv6.__in6_u.__u6_addr32[0]);
@@ -322,7 +330,7 @@ void test_pcep_obj_create_bandwidth()
     struct pcep_object_bandwidth *bw = pcep_obj_create_bandwidth(bandwidth);
 
     CU_ASSERT_PTR_NOT_NULL(bw);
-    pcep_encode_object(&bw->header, versioning, object_buf);
+    encode_object(&bw->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_BANDWIDTH, PCEP_OBJ_TYPE_BANDWIDTH_REQ, &bw->header);
     CU_ASSERT_EQUAL(bw->header.encoded_object[4], 0x3f);
     CU_ASSERT_EQUAL(bw->header.encoded_object[5], 0xe6);
@@ -346,7 +354,7 @@ void test_pcep_obj_create_metric()
     struct pcep_object_metric *metric = pcep_obj_create_metric(type, true, true, value);
 
     CU_ASSERT_PTR_NOT_NULL(metric);
-    pcep_encode_object(&metric->header, versioning, object_buf);
+    encode_object(&metric->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_METRIC, PCEP_OBJ_TYPE_METRIC, &metric->header);
     CU_ASSERT_EQUAL(metric->header.encoded_object[4], 0);
     CU_ASSERT_EQUAL(metric->header.encoded_object[5], 0);
@@ -373,7 +381,7 @@ void test_pcep_obj_create_lspa()
     struct pcep_object_lspa *lspa = pcep_obj_create_lspa(exclude_any, include_any, include_all, prio, hold_prio, true);
 
     CU_ASSERT_PTR_NOT_NULL(lspa);
-    pcep_encode_object(&lspa->header, versioning, object_buf);
+    encode_object(&lspa->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_LSPA, PCEP_OBJ_TYPE_LSPA, &lspa->header);
     uint32_t *uint32_ptr = (uint32_t *) (lspa->header.encoded_object + 4);
     CU_ASSERT_EQUAL(uint32_ptr[0], htonl(exclude_any));
@@ -399,7 +407,7 @@ void test_pcep_obj_create_svec()
 
     svec = pcep_obj_create_svec(true, true, true, id_list);
     CU_ASSERT_PTR_NOT_NULL(svec);
-    pcep_encode_object(&svec->header, versioning, object_buf);
+    encode_object(&svec->header);
     verify_pcep_obj_header2(PCEP_OBJ_CLASS_SVEC, PCEP_OBJ_TYPE_SVEC,
             (OBJECT_HEADER_LENGTH + sizeof(uint32_t) * 2),
             svec->header.encoded_object);
@@ -422,7 +430,7 @@ void test_pcep_obj_create_error()
     struct pcep_object_error *error = pcep_obj_create_error(error_type, error_value);
 
     CU_ASSERT_PTR_NOT_NULL(error);
-    pcep_encode_object(&error->header, versioning, object_buf);
+    encode_object(&error->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_ERROR, PCEP_OBJ_TYPE_ERROR, &error->header);
     CU_ASSERT_EQUAL(error->header.encoded_object[4], 0);
     CU_ASSERT_EQUAL(error->header.encoded_object[5], 0);
@@ -439,7 +447,7 @@ void test_pcep_obj_create_close()
     struct pcep_object_close *close = pcep_obj_create_close(reason);
 
     CU_ASSERT_PTR_NOT_NULL(close);
-    pcep_encode_object(&close->header, versioning, object_buf);
+    encode_object(&close->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_CLOSE, PCEP_OBJ_TYPE_CLOSE, &close->header);
     CU_ASSERT_EQUAL(close->header.encoded_object[4], 0);
     CU_ASSERT_EQUAL(close->header.encoded_object[5], 0);
@@ -456,7 +464,7 @@ void test_pcep_obj_create_srp()
     struct pcep_object_srp *srp = pcep_obj_create_srp(lsp_remove, srp_id_number, NULL);
 
     CU_ASSERT_PTR_NOT_NULL(srp);
-    pcep_encode_object(&srp->header, versioning, object_buf);
+    encode_object(&srp->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_SRP, PCEP_OBJ_TYPE_SRP, &srp->header);
     CU_ASSERT_EQUAL(srp->header.encoded_object[4], 0);
     CU_ASSERT_EQUAL(srp->header.encoded_object[5], 0);
@@ -489,7 +497,7 @@ void test_pcep_obj_create_lsp()
     lsp = pcep_obj_create_lsp(plsp_id, status, c_flag, a_flag, r_flag, s_flag, d_flag, NULL);
 
     CU_ASSERT_PTR_NOT_NULL(lsp);
-    pcep_encode_object(&lsp->header, versioning, object_buf);
+    encode_object(&lsp->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_LSP, PCEP_OBJ_TYPE_LSP, &lsp->header);
     CU_ASSERT_EQUAL((ntohl(*((uint32_t *) (lsp->header.encoded_object + 4))) >> 12) & 0x000fffff, plsp_id);
     CU_ASSERT_EQUAL((lsp->header.encoded_object[7] >> 4) & 0x07, status);
@@ -511,7 +519,7 @@ void test_pcep_obj_create_vendor_info()
             pcep_obj_create_vendor_info (enterprise_number, enterprise_specific_info);
 
     CU_ASSERT_PTR_NOT_NULL(obj);
-    pcep_encode_object(&obj->header, versioning, object_buf);
+    encode_object(&obj->header);
     verify_pcep_obj_header(PCEP_OBJ_CLASS_VENDOR_INFO, PCEP_OBJ_TYPE_VENDOR_INFO, &obj->header);
     uint32_t *uint32_ptr = (uint32_t *) (obj->header.encoded_object + 4);
     CU_ASSERT_EQUAL(uint32_ptr[0], htonl(enterprise_number));
@@ -531,14 +539,14 @@ static void test_pcep_obj_create_object_common(ro_func func_to_test, uint8_t obj
 
     struct pcep_object_ro *ero = func_to_test(NULL);
     CU_ASSERT_PTR_NOT_NULL(ero);
-    pcep_encode_object(&ero->header, versioning, object_buf);
+    encode_object(&ero->header);
     verify_pcep_obj_header2(object_class, object_type, OBJECT_HEADER_LENGTH, ero->header.encoded_object);
     pcep_obj_free_object((struct pcep_object_header *) ero);
 
     reset_objects_buffer();
     ero = func_to_test(ero_list);
     CU_ASSERT_PTR_NOT_NULL(ero);
-    pcep_encode_object(&ero->header, versioning, object_buf);
+    encode_object(&ero->header);
     verify_pcep_obj_header2(object_class, object_type, OBJECT_HEADER_LENGTH, ero->header.encoded_object);
     pcep_obj_free_object((struct pcep_object_header *) ero);
 
@@ -548,7 +556,7 @@ static void test_pcep_obj_create_object_common(ro_func func_to_test, uint8_t obj
     dll_append(ero_list, ro_subobj);
     ero = func_to_test(ero_list);
     CU_ASSERT_PTR_NOT_NULL(ero);
-    pcep_encode_object(&ero->header, versioning, object_buf);
+    encode_object(&ero->header);
     /* 4 bytes for obj header +
      * 2 bytes for ro_subobj header +
      * 2 bytes for lable c-type and flags +
@@ -583,7 +591,7 @@ static struct pcep_object_ro *encode_ro_subobj(struct pcep_object_ro_subobj *sr)
     double_linked_list *sr_subobj_list = dll_initialize();
     dll_append(sr_subobj_list, sr);
     struct pcep_object_ro *ro = pcep_obj_create_ero(sr_subobj_list);
-    pcep_encode_object(&ro->header, versioning, object_buf);
+    encode_object(&ro->header);
 
     return ro;
 }
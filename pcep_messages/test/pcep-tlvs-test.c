@@ -58,13 +58,21 @@ void pcep_tlvs_test_teardown()
     destroy_pcep_versioning(versioning);
 }
 
+/* Internal util function to encode the TLV and verify that its
+ * encoded size is exactly the number of bytes encoded */
+static void encode_tlv(struct pcep_object_tlv_header *tlv_hdr)
+{
+    uint16_t encoded_size = pcep_tlv_encoded_size(tlv_hdr, versioning);
+    CU_ASSERT_EQUAL(pcep_encode_tlv(tlv_hdr, versioning, tlv_buf), encoded_size);
+}
+
 void test_pcep_tlv_create_stateful_pce_capability()
 {
     struct pcep_object_tlv_stateful_pce_capability *tlv =
             pcep_tlv_create_stateful_pce_capability(true, true, true, true, true, true);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_STATEFUL_PCE_CAPABILITY);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t));
     CU_ASSERT_TRUE(tlv->flag_u_lsp_update_capability);
@@ -95,7 +103,7 @@ void test_pcep_tlv_create_speaker_entity_id()
     tlv = pcep_tlv_create_speaker_entity_id(list);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_SPEAKER_ENTITY_ID);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t));
     CU_ASSERT_PTR_NOT_NULL(tlv->speaker_entity_id_list);
@@ -113,7 +121,7 @@ void test_pcep_tlv_create_lsp_db_version()
             pcep_tlv_create_lsp_db_version(lsp_db_version);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_LSP_DB_VERSION);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint64_t));
     CU_ASSERT_EQUAL(tlv->lsp_db_version, lsp_db_version);
@@ -128,7 +136,7 @@ void test_pcep_tlv_create_path_setup_type()
 
     struct pcep_object_tlv_path_setup_type *tlv = pcep_tlv_create_path_setup_type(pst);
     CU_ASSERT_PTR_NOT_NULL(tlv);
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t));
     CU_ASSERT_EQUAL(tlv->path_setup_type, pst);
@@ -174,7 +182,7 @@ void test_pcep_tlv_create_path_setup_type_capability()
     tlv = pcep_tlv_create_path_setup_type_capability(pst_list, sub_tlv_list);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE_CAPABILITY);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t) * 2);
     CU_ASSERT_PTR_NOT_NULL(tlv->pst_list);
@@ -197,7 +205,7 @@ void test_pcep_tlv_create_path_setup_type_capability()
     tlv = pcep_tlv_create_path_setup_type_capability(pst_list, sub_tlv_list);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_PATH_SETUP_TYPE_CAPABILITY);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length,
             sizeof(uint32_t) * 2 + TLV_HEADER_LENGTH + sub_tlv->encoded_tlv_length);
@@ -224,7 +232,7 @@ void test_pcep_tlv_create_sr_pce_capability()
     struct pcep_object_tlv_sr_pce_capability *tlv = pcep_tlv_create_sr_pce_capability(true, true, 8);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_SR_PCE_CAPABILITY);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t));
     uint16_t *uint16_ptr = (uint16_t *) tlv->header.encoded_tlv;
@@ -245,7 +253,7 @@ void test_pcep_tlv_create_symbolic_path_name()
             pcep_tlv_create_symbolic_path_name(path_name, path_name_length);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_SYMBOLIC_PATH_NAME);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, path_name_length);
     /* Test the padding is correct */
@@ -261,7 +269,7 @@ void test_pcep_tlv_create_symbolic_path_name()
     reset_tlv_buffer();
     tlv = pcep_tlv_create_symbolic_path_name(path_name, 3);
     CU_ASSERT_PTR_NOT_NULL(tlv);
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_SYMBOLIC_PATH_NAME);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, 3);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv[4], 'S');
@@ -299,7 +307,7 @@ void test_pcep_tlv_create_ipv4_lsp_identifiers()
             &sender_ip, &endpoint_ip, lsp_id, tunnel_id, &extended_tunnel_id);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_IPV4_LSP_IDENTIFIERS);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t) * 4);
     uint32_t *uint32_ptr = (uint32_t *)tlv->header.encoded_tlv;
@@ -314,7 +322,7 @@ void test_pcep_tlv_create_ipv4_lsp_identifiers()
             &sender_ip, &endpoint_ip, lsp_id, tunnel_id, NULL);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_IPV4_LSP_IDENTIFIERS);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t) * 4);
     uint32_ptr = (uint32_t *)tlv->header.encoded_tlv;
@@ -356,7 +364,7 @@ void test_pcep_tlv_create_ipv6_lsp_identifiers()
             &sender_ip, &endpoint_ip, lsp_id, tunnel_id, (struct in6_addr *) &extended_tunnel_id);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_IPV6_LSP_IDENTIFIERS);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, 52);
     uint32_t *uint32_ptr = (uint32_t *)tlv->header.encoded_tlv;
@@ -373,7 +381,7 @@ void test_pcep_tlv_create_srpag_pol_id_ipv4()
     struct pcep_object_tlv_srpag_pol_id *tlv = pcep_tlv_create_srpag_pol_id_ipv4(color, (void*)&src);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, (PCEP_OBJ_TLV_TYPE_SRPOLICY_POL_ID));
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, (8/*draft-barth-pce-segment-routing-policy-cp-04#5.1*/));
     CU_ASSERT_EQUAL(tlv->color, (color));
@@ -399,7 +407,7 @@ void test_pcep_tlv_create_srpag_pol_id_ipv6()
 
     struct pcep_object_tlv_srpag_pol_id *tlv = pcep_tlv_create_srpag_pol_id_ipv6(color, &src);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, (PCEP_OBJ_TLV_TYPE_SRPOLICY_POL_ID));
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, (20/*draft-barth-pce-segment-routing-policy-cp-04#5.1*/));
     CU_ASSERT_EQUAL(tlv->color, (color));
@@ -422,7 +430,7 @@ void test_pcep_tlv_create_srpag_pol_name()
     struct pcep_object_tlv_srpag_pol_name *tlv = pcep_tlv_create_srpag_pol_name(pol_name, strlen(pol_name));
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, (PCEP_OBJ_TLV_TYPE_SRPOLICY_POL_NAME));
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, (normalize_length(strlen(pol_name))));
     CU_ASSERT_EQUAL(0, strcmp(pol_name, (char*)tlv->name));
@@ -443,7 +451,7 @@ void test_pcep_tlv_create_srpag_cp_id()
 
     struct pcep_object_tlv_srpag_cp_id *tlv = pcep_tlv_create_srpag_cp_id(proto_origin, ASN, &with_mapped_ipv4, discriminator);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, (PCEP_OBJ_TLV_TYPE_SRPOLICY_CPATH_ID));
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, (sizeof(proto_origin)+sizeof(ASN)+sizeof(with_mapped_ipv4)+sizeof(discriminator)));
     CU_ASSERT_EQUAL(tlv->proto, (proto_origin));
@@ -467,7 +475,7 @@ void test_pcep_tlv_create_srpag_cp_pref()
     struct pcep_object_tlv_srpag_cp_pref	 *tlv = pcep_tlv_create_srpag_cp_pref(preference_default);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, (PCEP_OBJ_TLV_TYPE_SRPOLICY_CPATH_PREFERENCE));
     printf(" encoded length vs sizeof pref (%d) vs (%ld)\n",tlv->header.encoded_tlv_length, sizeof(preference_default) );
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(preference_default));
@@ -490,7 +498,7 @@ void test_pcep_tlv_create_lsp_error_code()
             pcep_tlv_create_lsp_error_code(PCEP_TLV_LSP_ERROR_CODE_RSVP_SIGNALING_ERROR);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_LSP_ERROR_CODE);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, sizeof(uint32_t));
     uint32_t *uint32_ptr = (uint32_t *)tlv->header.encoded_tlv;
@@ -513,7 +521,7 @@ void test_pcep_tlv_create_rsvp_ipv4_error_spec()
     tlv = pcep_tlv_create_rsvp_ipv4_error_spec(&error_node_ip, error_code, error_value);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_RSVP_ERROR_SPEC);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, 12);
 
@@ -534,7 +542,7 @@ void test_pcep_tlv_create_rsvp_ipv6_error_spec()
     tlv = pcep_tlv_create_rsvp_ipv6_error_spec(&error_node_ip, error_code, error_value);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_RSVP_ERROR_SPEC);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, 24);
 
@@ -550,7 +558,7 @@ void test_pcep_tlv_create_nopath_vector()
             pcep_tlv_create_vendor_info(enterprise_number, enterprise_specific_info);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, PCEP_OBJ_TLV_TYPE_VENDOR_INFO);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, 8);
     uint32_t *uint32_ptr = (uint32_t *) tlv->header.encoded_tlv;
@@ -569,7 +577,7 @@ void test_pcep_tlv_create_arbitrary()
             pcep_tlv_create_tlv_arbitrary(data, data_length, tlv_id_unknown);
     CU_ASSERT_PTR_NOT_NULL(tlv);
 
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, tlv_id_unknown);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, data_length);
     /* Test the padding is correct */
@@ -584,7 +592,7 @@ void test_pcep_tlv_create_arbitrary()
     reset_tlv_buffer();
     tlv = pcep_tlv_create_tlv_arbitrary(data, 3, tlv_id_unknown);
     CU_ASSERT_PTR_NOT_NULL(tlv);
-    pcep_encode_tlv(&tlv->header, versioning, tlv_buf);
+    encode_tlv(&tlv->header);
     CU_ASSERT_EQUAL(tlv->header.type, tlv_id_unknown);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv_length, 3);
     CU_ASSERT_EQUAL(tlv->header.encoded_tlv[4], 'S');
@@ -23,9 +23,12 @@
  */
 
 
+#include <errno.h>
+#include <fcntl.h>
 #include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <CUnit/CUnit.h>
@@ -872,6 +875,349 @@ void test_pcep_msg_read_pcep_initiate_cisco_pcc()
     close(fd);
 }
 
+/* Internal util function, write the hexbyte strs to the fd */
+static void write_hexstrs(int fd, char *hexbyte_strs[], uint16_t hexbyte_strs_length)
+{
+    int i = 0;
+    for (; i < hexbyte_strs_length; i++)
+    {
+        uint8_t byte = (uint8_t) strtol(hexbyte_strs[i], 0, 16);
+        write(fd, (char *) &byte, 1);
+    }
+}
+
+void test_pcep_msg_reader_read()
+{
+    /* The reader expects a non-blocking socket, since it reads until EAGAIN */
+    int pipe_fds[2];
+    CU_ASSERT_EQUAL(pipe(pipe_fds), 0);
+    fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+    pcep_msg_reader *reader = pcep_msg_reader_create();
+    double_linked_list *msg_list = dll_initialize();
+
+    /* A complete Open message followed by the beginning of an Initiate */
+    write_hexstrs(pipe_fds[1], pcep_open_odl_hexbyte_strs, pcep_open_hexbyte_strs_length);
+    write_hexstrs(pipe_fds[1], pcep_initiate_hexbyte_strs, 10);
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), pcep_open_hexbyte_strs_length + 10);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 1);
+    CU_ASSERT_EQUAL(((struct pcep_message *) msg_list->head->data)->msg_header->type, PCEP_TYPE_OPEN);
+    CU_ASSERT_EQUAL(reader->bytes_buffered, 10);
+    pcep_msg_free_message_list(msg_list);
+
+    /* The rest of the Initiate message */
+    msg_list = dll_initialize();
+    write_hexstrs(pipe_fds[1], pcep_initiate_hexbyte_strs + 10, pcep_initiate_hexbyte_strs_length - 10);
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), pcep_initiate_hexbyte_strs_length - 10);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 1);
+    struct pcep_message *msg = (struct pcep_message *) msg_list->head->data;
+    CU_ASSERT_EQUAL(msg->msg_header->type, PCEP_TYPE_INITIATE);
+    CU_ASSERT_EQUAL(msg->encoded_message_length, pcep_initiate_hexbyte_strs_length);
+    CU_ASSERT_EQUAL(msg->obj_list->num_entries, 4);
+    CU_ASSERT_EQUAL(reader->bytes_buffered, 0);
+    pcep_msg_free_message_list(msg_list);
+
+    /* A Report message bigger than PCEP_MAX_SIZE, with an ERO of 1000
+     * IPv4 subobjects, is received across several reads */
+    uint16_t num_subobjs = 1000;
+    uint16_t ero_length = 4 + (num_subobjs * 8);
+    uint16_t report_length = 4 + 12 + 8 + ero_length;
+    uint8_t *report = malloc(report_length);
+    uint8_t report_hdr[] = {0x20, 0x0a, report_length >> 8, report_length & 0xff,
+                            /* SRP */ 0x21, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+                            /* LSP */ 0x20, 0x10, 0x00, 0x08, 0x00, 0x00, 0x10, 0x09,
+                            /* ERO */ 0x07, 0x10, ero_length >> 8, ero_length & 0xff};
+    uint8_t ero_subobj[] = {0x01, 0x08, 0x0a, 0x00, 0x00, 0x01, 0x20, 0x00};
+    memcpy(report, report_hdr, sizeof(report_hdr));
+    int i;
+    for (i = 0; i < num_subobjs; i++)
+    {
+        memcpy(report + sizeof(report_hdr) + (i * 8), ero_subobj, 8);
+    }
+    CU_ASSERT_TRUE(report_length > PCEP_MAX_SIZE);
+
+    msg_list = dll_initialize();
+    write(pipe_fds[1], report, 4096);
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), 4096);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 0);
+    write(pipe_fds[1], report + 4096, report_length - 4096);
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), report_length - 4096);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 1);
+    if (msg_list->num_entries == 1)
+    {
+        msg = (struct pcep_message *) msg_list->head->data;
+        CU_ASSERT_EQUAL(msg->msg_header->type, PCEP_TYPE_REPORT);
+        CU_ASSERT_EQUAL(msg->encoded_message_length, report_length);
+        struct pcep_object_header *ero = pcep_obj_get(msg->obj_list, PCEP_OBJ_CLASS_ERO);
+        CU_ASSERT_PTR_NOT_NULL(ero);
+    }
+    pcep_msg_free_message_list(msg_list);
+
+    /* Nothing to read */
+    msg_list = dll_initialize();
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), -1);
+    CU_ASSERT_EQUAL(errno, EAGAIN);
+
+    /* The socket is closed */
+    close(pipe_fds[1]);
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), 0);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 0);
+    dll_destroy(msg_list);
+
+    free(report);
+    pcep_msg_reader_destroy(reader);
+    close(pipe_fds[0]);
+}
+
+void test_pcep_msg_reader_read_failure()
+{
+    int pipe_fds[2];
+    CU_ASSERT_EQUAL(pipe(pipe_fds), 0);
+    fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+    pcep_msg_reader *reader = pcep_msg_reader_create();
+    double_linked_list *msg_list = dll_initialize();
+
+    /* A complete Open message followed by an invalid message header, the
+     * Open is returned, and the failure is returned by the next read */
+    uint8_t invalid_hdr[] = {0xe0, 0x01, 0x00, 0x04};
+    write_hexstrs(pipe_fds[1], pcep_open_odl_hexbyte_strs, pcep_open_hexbyte_strs_length);
+    write(pipe_fds[1], invalid_hdr, sizeof(invalid_hdr));
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list),
+                    pcep_open_hexbyte_strs_length + sizeof(invalid_hdr));
+    CU_ASSERT_EQUAL(msg_list->num_entries, 1);
+    CU_ASSERT_EQUAL(reader->pending_errno, EBADMSG);
+    pcep_msg_free_message_list(msg_list);
+
+    msg_list = dll_initialize();
+    errno = 0;
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), -1);
+    CU_ASSERT_EQUAL(errno, EBADMSG);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 0);
+    CU_ASSERT_EQUAL(reader->pending_errno, 0);
+
+    /* Without any message decoded, the failure is returned right away */
+    write(pipe_fds[1], invalid_hdr, sizeof(invalid_hdr));
+    errno = 0;
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list), -1);
+    CU_ASSERT_EQUAL(errno, EBADMSG);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 0);
+    CU_ASSERT_EQUAL(reader->pending_errno, 0);
+    dll_destroy(msg_list);
+
+    pcep_msg_reader_destroy(reader);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+/* Internal util function, convert the hexbyte strs to a byte buffer */
+static uint8_t *convert_hexstrs_to_buffer(char *hexbyte_strs[], uint16_t hexbyte_strs_length)
+{
+    uint8_t *buffer = malloc(hexbyte_strs_length);
+    int i = 0;
+    for (; i < hexbyte_strs_length; i++)
+    {
+        buffer[i] = (uint8_t) strtol(hexbyte_strs[i], 0, 16);
+    }
+
+    return buffer;
+}
+
+void test_pcep_decode_message_in_arena()
+{
+    uint8_t *buffer = convert_hexstrs_to_buffer(
+            pcep_report_cisco_pcc_hexbyte_strs, pcep_report_cisco_pcc_hexbyte_strs_length);
+
+    /* The message decoded in an arena is the same as the one decoded with malloc */
+    struct pcep_message *msg = pcep_decode_message(buffer);
+    struct pcep_message *arena_msg = pcep_decode_message_in_arena(buffer);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_msg);
+    CU_ASSERT_PTR_NULL(msg->arena);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_msg->arena);
+    CU_ASSERT_EQUAL(arena_msg->msg_header->type, PCEP_TYPE_REPORT);
+    CU_ASSERT_EQUAL(arena_msg->encoded_message_length, msg->encoded_message_length);
+    CU_ASSERT_EQUAL(memcmp(arena_msg->encoded_message, buffer, msg->encoded_message_length), 0);
+    /* The objects, TLVs, and sub-objects are decoded into small_vectors */
+    CU_ASSERT_PTR_NULL(arena_msg->obj_list);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_msg->obj_vector);
+    CU_ASSERT_EQUAL(arena_msg->obj_vector->num_entries, msg->obj_list->num_entries);
+    CU_ASSERT_PTR_EQUAL(arena_msg->obj_vector->arena, arena_msg->arena);
+
+    struct pcep_object_lsp *lsp =
+            (struct pcep_object_lsp *) pcep_obj_get(msg->obj_list, PCEP_OBJ_CLASS_LSP);
+    struct pcep_object_lsp *arena_lsp =
+            (struct pcep_object_lsp *) pcep_msg_get_obj(arena_msg, PCEP_OBJ_CLASS_LSP);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_lsp);
+    CU_ASSERT_EQUAL(arena_lsp->plsp_id, lsp->plsp_id);
+    CU_ASSERT_PTR_NULL(arena_lsp->header.tlv_list);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_lsp->header.tlv_vector);
+    CU_ASSERT_EQUAL(arena_lsp->header.tlv_vector->num_entries, lsp->header.tlv_list->num_entries);
+    struct pcep_object_ro *arena_ero =
+            (struct pcep_object_ro *) pcep_msg_get_obj(arena_msg, PCEP_OBJ_CLASS_ERO);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_ero);
+    CU_ASSERT_PTR_NULL(arena_ero->sub_objects);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_ero->sub_object_vector);
+    CU_ASSERT_PTR_EQUAL(arena_ero->sub_object_vector->arena, arena_msg->arena);
+
+    /* The whole message fits in the first chunk of the arena */
+    CU_ASSERT_EQUAL(arena_msg->arena->num_chunks, 1);
+
+    pcep_msg_free_message(msg);
+    pcep_msg_free_message(arena_msg);
+
+    /* An invalid message releases its arena */
+    buffer[4] = 0;
+    CU_ASSERT_PTR_NULL(pcep_decode_message_in_arena(buffer));
+
+    free(buffer);
+}
+
+void test_pcep_msg_iterate_objects()
+{
+    uint8_t *buffer = convert_hexstrs_to_buffer(
+            pcep_update_cisco_pce_hexbyte_strs, pcep_update_cisco_pce_hexbyte_strs_length);
+
+    /* The double_linked_list and small_vector forms are iterated the same */
+    struct pcep_message *msg = pcep_decode_message(buffer);
+    struct pcep_message *arena_msg = pcep_decode_message_in_arena(buffer);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(msg);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_msg);
+    CU_ASSERT_EQUAL(pcep_msg_num_objs(msg), msg->obj_list->num_entries);
+    CU_ASSERT_EQUAL(pcep_msg_num_objs(arena_msg), pcep_msg_num_objs(msg));
+
+    int num_objs = 0;
+    int num_tlvs = 0;
+    int num_subobjs = 0;
+    pcep_list_iterator iter, arena_iter;
+    struct pcep_object_header *obj = pcep_msg_first_obj(msg, &iter);
+    struct pcep_object_header *arena_obj = pcep_msg_first_obj(arena_msg, &arena_iter);
+    for (; obj != NULL && arena_obj != NULL;
+         obj = pcep_msg_next_obj(&iter), arena_obj = pcep_msg_next_obj(&arena_iter))
+    {
+        num_objs++;
+        CU_ASSERT_EQUAL(arena_obj->object_class, obj->object_class);
+        CU_ASSERT_EQUAL(pcep_obj_num_tlvs(arena_obj), pcep_obj_num_tlvs(obj));
+
+        pcep_list_iterator tlv_iter, arena_tlv_iter;
+        struct pcep_object_tlv_header *tlv = pcep_obj_first_tlv(obj, &tlv_iter);
+        struct pcep_object_tlv_header *arena_tlv = pcep_obj_first_tlv(arena_obj, &arena_tlv_iter);
+        for (; tlv != NULL && arena_tlv != NULL;
+             tlv = pcep_obj_next_tlv(&tlv_iter), arena_tlv = pcep_obj_next_tlv(&arena_tlv_iter))
+        {
+            num_tlvs++;
+            CU_ASSERT_EQUAL(arena_tlv->type, tlv->type);
+        }
+        CU_ASSERT_PTR_NULL(tlv);
+        CU_ASSERT_PTR_NULL(arena_tlv);
+
+        if (obj->object_class == PCEP_OBJ_CLASS_ERO)
+        {
+            CU_ASSERT_EQUAL(pcep_obj_ro_num_subobjs((struct pcep_object_ro *) arena_obj),
+                            pcep_obj_ro_num_subobjs((struct pcep_object_ro *) obj));
+            pcep_list_iterator subobj_iter, arena_subobj_iter;
+            struct pcep_object_ro_subobj *subobj =
+                    pcep_obj_ro_first_subobj((struct pcep_object_ro *) obj, &subobj_iter);
+            struct pcep_object_ro_subobj *arena_subobj =
+                    pcep_obj_ro_first_subobj((struct pcep_object_ro *) arena_obj, &arena_subobj_iter);
+            for (; subobj != NULL && arena_subobj != NULL;
+                 subobj = pcep_obj_ro_next_subobj(&subobj_iter),
+                 arena_subobj = pcep_obj_ro_next_subobj(&arena_subobj_iter))
+            {
+                num_subobjs++;
+                CU_ASSERT_EQUAL(arena_subobj->ro_subobj_type, subobj->ro_subobj_type);
+            }
+            CU_ASSERT_PTR_NULL(subobj);
+            CU_ASSERT_PTR_NULL(arena_subobj);
+        }
+    }
+    CU_ASSERT_PTR_NULL(obj);
+    CU_ASSERT_PTR_NULL(arena_obj);
+    CU_ASSERT_EQUAL(num_objs, msg->obj_list->num_entries);
+    CU_ASSERT_TRUE(num_tlvs > 0);
+    CU_ASSERT_TRUE(num_subobjs > 0);
+
+    /* Both forms are encoded the same */
+    struct pcep_versioning *versioning = create_default_pcep_versioning();
+    uint16_t length = pcep_msg_encoded_size(msg, versioning);
+    CU_ASSERT_EQUAL(pcep_msg_encoded_size(arena_msg, versioning), length);
+    uint8_t *encoded_buffer = malloc(length);
+    uint8_t *arena_encoded_buffer = malloc(length);
+    CU_ASSERT_EQUAL(pcep_encode_message_to_buffer(msg, versioning, encoded_buffer, length), length);
+    CU_ASSERT_EQUAL(pcep_encode_message_to_buffer(arena_msg, versioning, arena_encoded_buffer, length), length);
+    CU_ASSERT_EQUAL(memcmp(encoded_buffer, arena_encoded_buffer, length), 0);
+    free(encoded_buffer);
+    free(arena_encoded_buffer);
+    destroy_pcep_versioning(versioning);
+
+    /* Get and delete a TLV from either form */
+    struct pcep_object_header *lsp = pcep_msg_get_obj(msg, PCEP_OBJ_CLASS_LSP);
+    struct pcep_object_header *arena_lsp = pcep_msg_get_obj(arena_msg, PCEP_OBJ_CLASS_LSP);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(lsp);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_lsp);
+    CU_ASSERT_PTR_NULL(pcep_msg_get_obj(msg, PCEP_OBJ_CLASS_OPEN));
+    CU_ASSERT_PTR_NULL(pcep_obj_get_tlv(lsp, PCEP_OBJ_TLV_TYPE_NO_PATH_VECTOR));
+    unsigned int num_lsp_tlvs = pcep_obj_num_tlvs(lsp);
+    struct pcep_object_tlv_header *tlv = pcep_obj_get_tlv(lsp, PCEP_OBJ_TLV_TYPE_VENDOR_INFO);
+    struct pcep_object_tlv_header *arena_tlv = pcep_obj_get_tlv(arena_lsp, PCEP_OBJ_TLV_TYPE_VENDOR_INFO);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(tlv);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena_tlv);
+    CU_ASSERT_TRUE(pcep_obj_delete_tlv(lsp, tlv));
+    CU_ASSERT_TRUE(pcep_obj_delete_tlv(arena_lsp, arena_tlv));
+    CU_ASSERT_FALSE(pcep_obj_delete_tlv(arena_lsp, arena_tlv));
+    CU_ASSERT_EQUAL(pcep_obj_num_tlvs(lsp), num_lsp_tlvs - 1);
+    CU_ASSERT_EQUAL(pcep_obj_num_tlvs(arena_lsp), num_lsp_tlvs - 1);
+    CU_ASSERT_PTR_NULL(pcep_obj_get_tlv(lsp, PCEP_OBJ_TLV_TYPE_VENDOR_INFO));
+    CU_ASSERT_PTR_NULL(pcep_obj_get_tlv(arena_lsp, PCEP_OBJ_TLV_TYPE_VENDOR_INFO));
+
+    /* Appending to either form */
+    pcep_msg_append_obj(msg, (struct pcep_object_header *) pcep_obj_create_close(PCEP_CLOSE_REASON_NO));
+    pcep_msg_append_obj(arena_msg, (struct pcep_object_header *) pcep_obj_create_close(PCEP_CLOSE_REASON_NO));
+    CU_ASSERT_EQUAL(pcep_msg_num_objs(msg), num_objs + 1);
+    CU_ASSERT_EQUAL(pcep_msg_num_objs(arena_msg), num_objs + 1);
+    CU_ASSERT_PTR_NOT_NULL(pcep_msg_get_obj(msg, PCEP_OBJ_CLASS_CLOSE));
+    /* The arena message cannot free an object that was not allocated from
+     * its arena, so take it back */
+    struct pcep_object_header *close_obj = pcep_msg_get_obj(arena_msg, PCEP_OBJ_CLASS_CLOSE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(close_obj);
+    small_vector_delete_data(arena_msg->obj_vector, close_obj);
+    pcep_obj_free_object(close_obj);
+
+    pcep_msg_free_message(msg);
+    pcep_msg_free_message(arena_msg);
+    free(buffer);
+}
+
+void test_pcep_msg_reader_read_in_arena()
+{
+    int pipe_fds[2];
+    CU_ASSERT_EQUAL(pipe(pipe_fds), 0);
+    fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+    pcep_msg_reader *reader = pcep_msg_reader_create();
+    CU_ASSERT_FALSE(reader->decode_in_arena);
+    reader->decode_in_arena = true;
+    double_linked_list *msg_list = dll_initialize();
+
+    write_hexstrs(pipe_fds[1], pcep_open_odl_hexbyte_strs, pcep_open_hexbyte_strs_length);
+    write_hexstrs(pipe_fds[1], pcep_initiate_hexbyte_strs, pcep_initiate_hexbyte_strs_length);
+    CU_ASSERT_EQUAL(pcep_msg_reader_read(reader, pipe_fds[0], msg_list),
+                    pcep_open_hexbyte_strs_length + pcep_initiate_hexbyte_strs_length);
+    CU_ASSERT_EQUAL(msg_list->num_entries, 2);
+    if (msg_list->num_entries == 2)
+    {
+        struct pcep_message *msg = (struct pcep_message *) msg_list->head->data;
+        CU_ASSERT_EQUAL(msg->msg_header->type, PCEP_TYPE_OPEN);
+        CU_ASSERT_PTR_NOT_NULL(msg->arena);
+        msg = (struct pcep_message *) msg_list->tail->data;
+        CU_ASSERT_EQUAL(msg->msg_header->type, PCEP_TYPE_INITIATE);
+        CU_ASSERT_PTR_NOT_NULL(msg->arena);
+        CU_ASSERT_EQUAL(pcep_msg_num_objs(msg), 4);
+    }
+    pcep_msg_free_message_list(msg_list);
+
+    pcep_msg_reader_destroy(reader);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
 void test_validate_message_header()
 {
     uint8_t pcep_message_invalid_version[] = {0x40, 0x01, 0x04, 0x00};
@@ -904,6 +1250,7 @@ void test_validate_message_header()
 struct pcep_message *create_message(uint8_t msg_type, uint8_t obj1_class, uint8_t obj2_class, uint8_t obj3_class, uint8_t obj4_class)
 {
     struct pcep_message *msg = malloc(sizeof(struct pcep_message));
+    bzero(msg, sizeof(struct pcep_message));
     msg->obj_list = dll_initialize();
     msg->msg_header = malloc(sizeof(struct pcep_message_header));
     msg->msg_header->type = msg_type;
@@ -914,6 +1261,7 @@ struct pcep_message *create_message(uint8_t msg_type, uint8_t obj1_class, uint8_
         struct pcep_object_header *obj_hdr = malloc(sizeof(struct pcep_object_header));
         obj_hdr->object_class = obj1_class;
         obj_hdr->tlv_list = NULL;
+        obj_hdr->tlv_vector = NULL;
         dll_append(msg->obj_list, obj_hdr);
     }
 
@@ -922,6 +1270,7 @@ struct pcep_message *create_message(uint8_t msg_type, uint8_t obj1_class, uint8_
         struct pcep_object_header *obj_hdr = malloc(sizeof(struct pcep_object_header));
         obj_hdr->object_class = obj2_class;
         obj_hdr->tlv_list = NULL;
+        obj_hdr->tlv_vector = NULL;
         dll_append(msg->obj_list, obj_hdr);
     }
 
@@ -930,6 +1279,7 @@ struct pcep_message *create_message(uint8_t msg_type, uint8_t obj1_class, uint8_
         struct pcep_object_header *obj_hdr = malloc(sizeof(struct pcep_object_header));
         obj_hdr->object_class = obj3_class;
         obj_hdr->tlv_list = NULL;
+        obj_hdr->tlv_vector = NULL;
         dll_append(msg->obj_list, obj_hdr);
     }
 
@@ -938,6 +1288,7 @@ struct pcep_message *create_message(uint8_t msg_type, uint8_t obj1_class, uint8_
         struct pcep_object_header *obj_hdr = malloc(sizeof(struct pcep_object_header));
         obj_hdr->object_class = obj4_class;
         obj_hdr->tlv_list = NULL;
+        obj_hdr->tlv_vector = NULL;
         dll_append(msg->obj_list, obj_hdr);
     }
 
@@ -41,6 +41,7 @@
 #define DEFAULT_CONFIG_MAX_UNKNOWN_REQUESTS 5
 #define DEFAULT_CONFIG_MAX_UNKNOWN_MESSAGES 5
 #define DEFAULT_TCP_CONNECT_TIMEOUT_MILLIS 250
+#define DEFAULT_CONFIG_TIMER_JITTER_PERCENT 10
 
 /* Acceptable MIN and MAX values used in deciding if the PCEP
  * Open received from a PCE should be accepted or rejected. */
@@ -55,10 +56,19 @@
  */
 
 bool initialize_pcc();
+bool initialize_pcc_with_config(pcep_session_logic_config *session_logic_config);
 /* this function is blocking */
 bool initialize_pcc_wait_for_completion();
 bool destroy_pcc();
 
+/* Start a PCC engine independent of the one started by initialize_pcc(),
+ * with its own session logic, timers, event queue, and socket_comm reactors,
+ * configured with the configs, which may be NULL. The sessions and
+ * events of the engine are handled with the _in_engine functions. */
+pcep_engine *initialize_pcc_engine(pcep_session_logic_config *session_logic_config,
+                                   pcep_socket_comm_config *socket_comm_config);
+bool destroy_pcc_engine(pcep_engine *engine);
+
 
 /*
  * PCEP session functions
@@ -72,12 +82,53 @@ void destroy_pcep_configuration(pcep_configuration *config);
  * If src_ip is not set, INADDR_ANY will be used. */
 pcep_session *connect_pce(pcep_configuration *config, struct in_addr *pce_ip);
 pcep_session *connect_pce_ipv6(pcep_configuration *config, struct in6_addr *pce_ip);
+pcep_session *connect_pce_in_engine(pcep_engine *engine, pcep_configuration *config, struct in_addr *pce_ip);
+pcep_session *connect_pce_ipv6_in_engine(pcep_engine *engine, pcep_configuration *config, struct in6_addr *pce_ip);
+
+/* Start connecting to several PCEs at once, without waiting for each TCP
+ * connect to complete. The sessions are stored in the sessions array, which
+ * must have num_pce_ips entries, with a NULL entry for each connect that could
+ * not be started. Returns the number of sessions started. For each session,
+ * either a PCC_CONNECTED_TO_PCE or a PCC_CONNECTION_FAILURE event will be
+ * queued, and a failed session should be destroyed with destroy_pcep_session(). */
+int connect_pce_many(pcep_configuration *config, struct in_addr *pce_ips,
+                     int num_pce_ips, pcep_session **sessions);
+int connect_pce_many_ipv6(pcep_configuration *config, struct in6_addr *pce_ips,
+                          int num_pce_ips, pcep_session **sessions);
+int connect_pce_many_in_engine(pcep_engine *engine, pcep_configuration *config,
+                               struct in_addr *pce_ips, int num_pce_ips, pcep_session **sessions);
+int connect_pce_many_ipv6_in_engine(pcep_engine *engine, pcep_configuration *config,
+                                    struct in6_addr *pce_ips, int num_pce_ips, pcep_session **sessions);
 void disconnect_pce(pcep_session *session);
+/* The message is sent with the priority from get_message_send_priority() */
 void send_message(pcep_session *session, struct pcep_message *msg, bool free_after_send);
+/* Send the message with a specific priority, for example to send a
+ * message before the bulk messages already queued on the session */
+void send_message_with_priority(pcep_session *session, struct pcep_message *msg,
+                                bool free_after_send, pcep_socket_comm_priority priority);
+/* Send the same message to several sessions. The message is only encoded
+ * once per message versioning used by the sessions, and the encoded message
+ * is shared by the send queues of the sessions, being freed once it has been
+ * written to all of them. NULL sessions, and the sessions that are not
+ * connected or whose socket is closed, are skipped. The message is always
+ * freed. Returns the number of sessions the message was queued to. */
+int send_message_multi(pcep_session *sessions[], int num_sessions, struct pcep_message *msg);
 
 void dump_pcep_session_counters(pcep_session *session);
 void reset_pcep_session_counters(pcep_session *session);
 
+/* The hit and miss counters of the pools the PCEPlib allocates its events,
+ * queue nodes, and queued messages from */
+typedef struct pcep_pcc_pool_counters_
+{
+    pcep_session_logic_pool_counters session_logic_pools;
+    object_pool_counters queue_node_pool;
+    object_pool_counters socket_comm_queued_message_pool;
+
+} pcep_pcc_pool_counters;
+
+bool get_pcc_pool_counters(pcep_pcc_pool_counters *counters);
+
 /*
  * Event Queue functions
  */
@@ -91,6 +142,11 @@ uint32_t event_queue_num_events_available();
 /* Return the next event on the queue, NULL if empty */
 struct pcep_event *event_queue_get_event();
 
+/* Same as the above functions, for the event queue of the engine */
+bool event_queue_is_empty_in_engine(pcep_engine *engine);
+uint32_t event_queue_num_events_available_in_engine(pcep_engine *engine);
+struct pcep_event *event_queue_get_event_in_engine(pcep_engine *engine);
+
 /* Free the PCEP Event resources, including the PCEP message */
 void destroy_pcep_event(struct pcep_event *event);
 
@@ -52,12 +52,15 @@ const char PCC_RCVD_MAX_INVALID_MSGS_STR[] = "PCC_RCVD_MAX_INVALID_MSGS";
 const char PCC_RCVD_MAX_UNKOWN_MSGS_STR[] = "PCC_RCVD_MAX_UNKOWN_MSGS";
 const char UNKNOWN_EVENT_STR[] = "UNKNOWN Event Type";
 
-/* Session Logic Handle managed in pcep_session_logic.c */
-extern pcep_event_queue *session_logic_event_queue_;
-
 bool initialize_pcc()
 {
-    if (!run_session_logic())
+    return initialize_pcc_with_config(NULL);
+}
+
+
+bool initialize_pcc_with_config(pcep_session_logic_config *session_logic_config)
+{
+    if (!run_session_logic_with_config(session_logic_config))
     {
         pcep_log(LOG_ERR, "Error initializing PCC session logic.");
         return false;
@@ -86,6 +89,31 @@ bool destroy_pcc()
 }
 
 
+pcep_engine *initialize_pcc_engine(pcep_session_logic_config *session_logic_config,
+                                   pcep_socket_comm_config *socket_comm_config)
+{
+    pcep_engine *engine = run_session_logic_engine(session_logic_config, socket_comm_config);
+    if (engine == NULL)
+    {
+        pcep_log(LOG_ERR, "Error initializing PCC session logic engine.");
+    }
+
+    return engine;
+}
+
+
+bool destroy_pcc_engine(pcep_engine *engine)
+{
+    if (!stop_session_logic_engine(engine))
+    {
+        pcep_log(LOG_WARNING, "Error stopping PCC session logic engine.");
+        return false;
+    }
+
+    return true;
+}
+
+
 pcep_configuration *create_default_pcep_configuration()
 {
     pcep_configuration *config = malloc(sizeof(pcep_configuration));
@@ -98,10 +126,12 @@ pcep_configuration *create_default_pcep_configuration()
     config->max_dead_timer_seconds = DEFAULT_MAX_CONFIG_DEAD_TIMER;
 
     config->request_time_seconds = DEFAULT_CONFIG_REQUEST_TIME;
+    config->timer_jitter_percent = DEFAULT_CONFIG_TIMER_JITTER_PERCENT;
     config->max_unknown_messages = DEFAULT_CONFIG_MAX_UNKNOWN_MESSAGES;
     config->max_unknown_requests = DEFAULT_CONFIG_MAX_UNKNOWN_REQUESTS;
 
     config->socket_connect_timeout_millis = DEFAULT_TCP_CONNECT_TIMEOUT_MILLIS;
+    config->decode_messages_in_arena = false;
     config->support_stateful_pce_lsp_update = true;
     config->support_pce_lsp_instantiation = true;
     config->support_include_db_version = true;
@@ -137,6 +167,76 @@ pcep_session *connect_pce_ipv6(pcep_configuration *config, struct in6_addr *pce_
     return create_pcep_session_ipv6(config, pce_ip);
 }
 
+pcep_session *connect_pce_in_engine(pcep_engine *engine, pcep_configuration *config, struct in_addr *pce_ip)
+{
+    return create_pcep_session_in_engine(engine, config, pce_ip);
+}
+
+pcep_session *connect_pce_ipv6_in_engine(pcep_engine *engine, pcep_configuration *config, struct in6_addr *pce_ip)
+{
+    return create_pcep_session_ipv6_in_engine(engine, config, pce_ip);
+}
+
+int connect_pce_many(pcep_configuration *config, struct in_addr *pce_ips,
+                     int num_pce_ips, pcep_session **sessions)
+{
+    return connect_pce_many_in_engine(get_default_session_logic_engine(),
+            config, pce_ips, num_pce_ips, sessions);
+}
+
+int connect_pce_many_ipv6(pcep_configuration *config, struct in6_addr *pce_ips,
+                          int num_pce_ips, pcep_session **sessions)
+{
+    return connect_pce_many_ipv6_in_engine(get_default_session_logic_engine(),
+            config, pce_ips, num_pce_ips, sessions);
+}
+
+int connect_pce_many_in_engine(pcep_engine *engine, pcep_configuration *config,
+                               struct in_addr *pce_ips, int num_pce_ips, pcep_session **sessions)
+{
+    if (pce_ips == NULL || sessions == NULL)
+    {
+        pcep_log(LOG_WARNING, "connect_pce_many NULL pce_ips or sessions");
+        return 0;
+    }
+
+    int num_started = 0;
+    int i;
+    for (i = 0; i < num_pce_ips; i++)
+    {
+        sessions[i] = create_pcep_session_async_in_engine(engine, config, &pce_ips[i]);
+        if (sessions[i] != NULL)
+        {
+            num_started++;
+        }
+    }
+
+    return num_started;
+}
+
+int connect_pce_many_ipv6_in_engine(pcep_engine *engine, pcep_configuration *config,
+                                    struct in6_addr *pce_ips, int num_pce_ips, pcep_session **sessions)
+{
+    if (pce_ips == NULL || sessions == NULL)
+    {
+        pcep_log(LOG_WARNING, "connect_pce_many_ipv6 NULL pce_ips or sessions");
+        return 0;
+    }
+
+    int num_started = 0;
+    int i;
+    for (i = 0; i < num_pce_ips; i++)
+    {
+        sessions[i] = create_pcep_session_ipv6_async_in_engine(engine, config, &pce_ips[i]);
+        if (sessions[i] != NULL)
+        {
+            num_started++;
+        }
+    }
+
+    return num_started;
+}
+
 void disconnect_pce(pcep_session *session)
 {
     /* This will cause the session to be destroyed AFTER the close message is sent */
@@ -148,9 +248,25 @@ void disconnect_pce(pcep_session *session)
 
 void send_message(pcep_session *session, struct pcep_message *msg, bool free_after_send)
 {
-    pcep_encode_message(msg, session->pcc_config.pcep_msg_versioning);
-    socket_comm_session_send_message(session->socket_comm_session,
-            (char *) msg->encoded_message, msg->encoded_message_length, free_after_send);
+    send_message_with_priority(session, msg, free_after_send, get_message_send_priority(msg));
+}
+
+void send_message_with_priority(pcep_session *session, struct pcep_message *msg,
+                                bool free_after_send, pcep_socket_comm_priority priority)
+{
+    if (pcep_encode_message(msg, session->pcc_config.pcep_msg_versioning) == false)
+    {
+        pcep_log(LOG_WARNING, "Cannot send message type [%d] on session_id [%d], it cannot be encoded",
+                 msg->msg_header->type, session->session_id);
+        if (free_after_send == true)
+        {
+            pcep_msg_free_message(msg);
+        }
+        return;
+    }
+
+    socket_comm_session_send_message_with_priority(session->socket_comm_session,
+            (char *) msg->encoded_message, msg->encoded_message_length, free_after_send, priority);
 
     increment_message_tx_counters(session, msg);
 
@@ -163,53 +279,146 @@ void send_message(pcep_session *session, struct pcep_message *msg, bool free_aft
     }
 }
 
+int send_message_multi(pcep_session *sessions[], int num_sessions, struct pcep_message *msg)
+{
+    if (sessions == NULL || num_sessions <= 0 || msg == NULL)
+    {
+        pcep_log(LOG_WARNING, "send_message_multi NULL or empty parameters.");
+        if (msg != NULL)
+        {
+            pcep_msg_free_message(msg);
+        }
+        return 0;
+    }
+
+    /* The encoding only depends on the message versioning, so the message
+     * is encoded once for each different versioning used by the sessions,
+     * currently indexed by draft_ietf_pce_segment_routing_07 */
+    pcep_socket_comm_shared_message *shared_messages[2] = { NULL, NULL };
+    pcep_socket_comm_priority priority = get_message_send_priority(msg);
+    int num_sent = 0;
+
+    int i;
+    for (i = 0; i < num_sessions; i++)
+    {
+        pcep_session *session = sessions[i];
+        if (session == NULL || session->socket_comm_session == NULL)
+        {
+            continue;
+        }
+
+        int versioning = session->pcc_config.pcep_msg_versioning->draft_ietf_pce_segment_routing_07 ? 1 : 0;
+        if (shared_messages[versioning] == NULL)
+        {
+            if (pcep_encode_message(msg, session->pcc_config.pcep_msg_versioning) == false)
+            {
+                pcep_log(LOG_WARNING, "send_message_multi cannot send message type [%d], it cannot be encoded",
+                         msg->msg_header->type);
+                continue;
+            }
+
+            shared_messages[versioning] = socket_comm_shared_message_create(
+                    (char *) msg->encoded_message, msg->encoded_message_length);
+            if (shared_messages[versioning] == NULL)
+            {
+                continue;
+            }
+
+            /* The shared message now owns the encoded_message */
+            msg->encoded_message = NULL;
+        }
+
+        /* The message is dropped if the session socket is closed */
+        if (socket_comm_session_send_shared_message(session->socket_comm_session,
+                                                    shared_messages[versioning], priority))
+        {
+            increment_message_tx_counters(session, msg);
+            num_sent++;
+        }
+    }
+
+    /* Release the references taken when the shared messages were created,
+     * the send queues hold their own references until they are written */
+    for (i = 0; i < 2; i++)
+    {
+        if (shared_messages[i] != NULL)
+        {
+            socket_comm_shared_message_unref(shared_messages[i]);
+        }
+    }
+    pcep_msg_free_message(msg);
+
+    return num_sent;
+}
+
 /* Returns true if the queue is empty, false otherwise */
 bool event_queue_is_empty()
 {
-    if (session_logic_event_queue_ == NULL)
+    return event_queue_is_empty_in_engine(get_default_session_logic_engine());
+}
+
+
+/* Return the number of events on the queue, 0 if empty */
+uint32_t event_queue_num_events_available()
+{
+    return event_queue_num_events_available_in_engine(get_default_session_logic_engine());
+}
+
+
+/* Return the next event on the queue, NULL if empty */
+struct pcep_event *event_queue_get_event()
+{
+    return event_queue_get_event_in_engine(get_default_session_logic_engine());
+}
+
+
+bool event_queue_is_empty_in_engine(pcep_engine *engine)
+{
+    pcep_event_queue *event_queue = get_session_logic_engine_event_queue(engine);
+    if (event_queue == NULL)
     {
         pcep_log(LOG_WARNING, "event_queue_is_empty Session Logic is not initialized yet");
         return false;
     }
 
-    pthread_mutex_lock(&session_logic_event_queue_->event_queue_mutex);
-    bool is_empty = (session_logic_event_queue_->event_queue->num_entries == 0);
-    pthread_mutex_unlock(&session_logic_event_queue_->event_queue_mutex);
+    pthread_mutex_lock(&event_queue->event_queue_mutex);
+    bool is_empty = (event_queue->event_queue->num_entries == 0);
+    pthread_mutex_unlock(&event_queue->event_queue_mutex);
 
     return is_empty;
 }
 
 
-/* Return the number of events on the queue, 0 if empty */
-uint32_t event_queue_num_events_available()
+uint32_t event_queue_num_events_available_in_engine(pcep_engine *engine)
 {
-    if (session_logic_event_queue_ == NULL)
+    pcep_event_queue *event_queue = get_session_logic_engine_event_queue(engine);
+    if (event_queue == NULL)
     {
         pcep_log(LOG_WARNING, "event_queue_num_events_available Session Logic is not initialized yet");
         return 0;
     }
 
-    pthread_mutex_lock(&session_logic_event_queue_->event_queue_mutex);
-    uint32_t num_events =  session_logic_event_queue_->event_queue->num_entries;
-    pthread_mutex_unlock(&session_logic_event_queue_->event_queue_mutex);
+    pthread_mutex_lock(&event_queue->event_queue_mutex);
+    uint32_t num_events =  event_queue->event_queue->num_entries;
+    pthread_mutex_unlock(&event_queue->event_queue_mutex);
 
     return num_events;
 }
 
 
-/* Return the next event on the queue, NULL if empty */
-struct pcep_event *event_queue_get_event()
+struct pcep_event *event_queue_get_event_in_engine(pcep_engine *engine)
 {
-    if (session_logic_event_queue_ == NULL)
+    pcep_event_queue *event_queue = get_session_logic_engine_event_queue(engine);
+    if (event_queue == NULL)
     {
         pcep_log(LOG_WARNING, "event_queue_get_event Session Logic is not initialized yet");
         return NULL;
     }
 
-    pthread_mutex_lock(&session_logic_event_queue_->event_queue_mutex);
+    pthread_mutex_lock(&event_queue->event_queue_mutex);
     struct pcep_event *event =
-            (struct pcep_event *) queue_dequeue(session_logic_event_queue_->event_queue);
-    pthread_mutex_unlock(&session_logic_event_queue_->event_queue_mutex);
+            (struct pcep_event *) queue_dequeue(event_queue->event_queue);
+    pthread_mutex_unlock(&event_queue->event_queue_mutex);
 
     return event;
 }
@@ -229,7 +438,7 @@ void destroy_pcep_event(struct pcep_event *event)
         pcep_msg_free_message(event->message);
     }
 
-    free(event);
+    free_pcep_event(event);
 }
 
 const char *get_event_type_str(int event_type)
@@ -298,3 +507,15 @@ void reset_pcep_session_counters(pcep_session *session)
     reset_group_counters(session->pcep_session_counters);
 }
 
+bool get_pcc_pool_counters(pcep_pcc_pool_counters *counters)
+{
+    if (counters == NULL)
+    {
+        pcep_log(LOG_WARNING, "get_pcc_pool_counters cannot get the counters with a NULL counters");
+        return false;
+    }
+
+    return (get_session_logic_pool_counters(&counters->session_logic_pools) &&
+            queue_get_node_pool_counters(&counters->queue_node_pool) &&
+            socket_comm_get_queued_message_pool_counters(&counters->socket_comm_queued_message_pool));
+}
@@ -33,7 +33,6 @@
 #include "pcep_pcc_api.h"
 #include "pcep_socket_comm_mock.h"
 
-extern pcep_event_queue *session_logic_event_queue_;
 extern const char MESSAGE_RECEIVED_STR[];
 extern const char UNKNOWN_EVENT_STR[];
 
@@ -49,6 +48,7 @@ void pcep_pcc_api_test_setup()
 
 void pcep_pcc_api_test_teardown()
 {
+    destroy_pcc();
     teardown_mock_socket_comm_info();
 }
 
@@ -66,6 +66,7 @@ void test_initialize_pcc()
 
 void test_connect_pce()
 {
+    CU_ASSERT_TRUE(initialize_pcc());
     pcep_configuration *config = create_default_pcep_configuration();
     struct hostent *host_info = gethostbyname("localhost");
     struct in_addr dest_address;
@@ -93,6 +94,7 @@ void test_connect_pce()
 
 void test_connect_pce_ipv6()
 {
+    CU_ASSERT_TRUE(initialize_pcc());
     pcep_configuration *config = create_default_pcep_configuration();
     struct in6_addr dest_address;
     dest_address.__in6_u.__u6_addr32[0] = 0;
@@ -123,6 +125,7 @@ void test_connect_pce_ipv6()
 
 void test_connect_pce_with_src_ip()
 {
+    CU_ASSERT_TRUE(initialize_pcc());
     pcep_configuration *config = create_default_pcep_configuration();
     struct hostent *host_info = gethostbyname("localhost");
     struct in_addr dest_address;
@@ -147,8 +150,39 @@ void test_connect_pce_with_src_ip()
     free(encoded_msg);
 }
 
+void test_connect_pce_many()
+{
+    CU_ASSERT_TRUE(initialize_pcc());
+    pcep_configuration *config = create_default_pcep_configuration();
+    struct in_addr dest_addresses[3];
+    inet_pton(AF_INET, "127.0.0.1", &dest_addresses[0]);
+    inet_pton(AF_INET, "127.0.0.2", &dest_addresses[1]);
+    inet_pton(AF_INET, "127.0.0.3", &dest_addresses[2]);
+    mock_socket_comm_info *mock_info = get_mock_socket_comm_info();
+    mock_info->send_message_save_message = true;
+    pcep_session *sessions[3];
+
+    CU_ASSERT_EQUAL(connect_pce_many(config, NULL, 3, sessions), 0);
+    CU_ASSERT_EQUAL(connect_pce_many(config, dest_addresses, 3, sessions), 3);
+
+    /* The sessions are connecting, so no Open has been sent yet */
+    CU_ASSERT_EQUAL(mock_info->socket_comm_session_connect_tcp_async_times_called, 3);
+    CU_ASSERT_EQUAL(mock_info->socket_comm_session_connect_tcp_times_called, 0);
+    CU_ASSERT_EQUAL(mock_info->sent_message_list->num_entries, 0);
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        CU_ASSERT_PTR_NOT_NULL(sessions[i]);
+        CU_ASSERT_EQUAL(sessions[i]->session_state, SESSION_STATE_TCP_CONNECTING);
+        destroy_pcep_session(sessions[i]);
+    }
+
+    destroy_pcep_configuration(config);
+}
+
 void test_disconnect_pce()
 {
+    CU_ASSERT_TRUE(initialize_pcc());
     pcep_configuration *config = create_default_pcep_configuration();
     struct hostent *host_info = gethostbyname("localhost");
     struct in_addr dest_address;
@@ -183,9 +217,32 @@ void test_disconnect_pce()
     free(encoded_msg);
 }
 
+void test_disconnect_pce_socket_closed()
+{
+    CU_ASSERT_TRUE(initialize_pcc());
+    pcep_configuration *config = create_default_pcep_configuration();
+    struct hostent *host_info = gethostbyname("localhost");
+    struct in_addr dest_address;
+    memcpy(&dest_address, host_info->h_addr, host_info->h_length);
+
+    pcep_session *session = connect_pce(config, &dest_address);
+    verify_socket_comm_times_called(0, 0, 1, 1, 0, 0, 0);
+
+    /* The PCE closed the socket, which the session worker closes */
+    socket_comm_session_close_tcp(session->socket_comm_session);
+
+    /* The close message cant be written, so the message_sent_handler is
+     * never called, and the session is destroyed right away */
+    disconnect_pce(session);
+    verify_socket_comm_times_called(0, 1, 1, 2, 1, 1, 0);
+
+    destroy_pcep_configuration(config);
+}
+
 
 void test_send_message()
 {
+    CU_ASSERT_TRUE(initialize_pcc());
     pcep_configuration *config = create_default_pcep_configuration();
     struct hostent *host_info = gethostbyname("localhost");
     struct in_addr dest_address;
@@ -197,12 +254,131 @@ void test_send_message()
     send_message(session, msg, false);
 
     verify_socket_comm_times_called(0, 0, 1, 2, 0, 0, 0);
+    CU_ASSERT_EQUAL(get_mock_socket_comm_info()->last_sent_message_priority, SOCKET_COMM_PRIORITY_CONTROL);
+    pcep_msg_free_message(msg);
+
+    /* The default priority of the message type can be overridden */
+    msg = pcep_msg_create_keepalive();
+    send_message_with_priority(session, msg, false, SOCKET_COMM_PRIORITY_BULK);
+    verify_socket_comm_times_called(0, 0, 1, 3, 0, 0, 0);
+    CU_ASSERT_EQUAL(get_mock_socket_comm_info()->last_sent_message_priority, SOCKET_COMM_PRIORITY_BULK);
 
     pcep_msg_free_message(msg);
     destroy_pcep_session(session);
     destroy_pcep_configuration(config);
 }
 
+/* Internal util function to create a report bigger than the max PCEP
+ * message length, with 2 EROs of 5000 IPv4 sub-objects each */
+static struct pcep_message *create_oversized_report()
+{
+    double_linked_list *obj_list = dll_initialize();
+    int i, j;
+    for (i = 0; i < 2; i++)
+    {
+        double_linked_list *ero_subobj_list = dll_initialize();
+        for (j = 0; j < 5000; j++)
+        {
+            struct in_addr ipv4_addr;
+            ipv4_addr.s_addr = htonl(0x0a000000 + j);
+            dll_append(ero_subobj_list, pcep_obj_create_ro_subobj_ipv4(false, &ipv4_addr, 32, false));
+        }
+        dll_append(obj_list, pcep_obj_create_ero(ero_subobj_list));
+    }
+
+    return pcep_msg_create_report(obj_list);
+}
+
+void test_send_message_oversized()
+{
+    CU_ASSERT_TRUE(initialize_pcc());
+    pcep_configuration *config = create_default_pcep_configuration();
+    struct hostent *host_info = gethostbyname("localhost");
+    struct in_addr dest_address;
+    memcpy(&dest_address, host_info->h_addr, host_info->h_length);
+    pcep_session *session = connect_pce(config, &dest_address);
+    verify_socket_comm_times_called(0, 0, 1, 1, 0, 0, 0);
+
+    /* The message cannot be encoded, so nothing is sent */
+    struct pcep_message *msg = create_oversized_report();
+    send_message(session, msg, false);
+    verify_socket_comm_times_called(0, 0, 1, 1, 0, 0, 0);
+    CU_ASSERT_PTR_NULL(msg->encoded_message);
+    pcep_msg_free_message(msg);
+
+    /* The message is still freed if requested */
+    send_message(session, create_oversized_report(), true);
+    verify_socket_comm_times_called(0, 0, 1, 1, 0, 0, 0);
+
+    pcep_session *sessions[1] = { session };
+    CU_ASSERT_EQUAL(send_message_multi(sessions, 1, create_oversized_report()), 0);
+    verify_socket_comm_times_called(0, 0, 1, 1, 0, 0, 0);
+
+    destroy_pcep_session(session);
+    destroy_pcep_configuration(config);
+}
+
+void test_send_message_multi()
+{
+    CU_ASSERT_TRUE(initialize_pcc());
+    pcep_configuration *config = create_default_pcep_configuration();
+    struct hostent *host_info = gethostbyname("localhost");
+    struct in_addr dest_address;
+    memcpy(&dest_address, host_info->h_addr, host_info->h_length);
+    mock_socket_comm_info *mock_info = get_mock_socket_comm_info();
+
+    pcep_session *sessions[4];
+    sessions[0] = connect_pce(config, &dest_address);
+    sessions[1] = NULL;
+    sessions[2] = connect_pce(config, &dest_address);
+    sessions[3] = connect_pce(config, &dest_address);
+    /* Use a different message versioning for one of the sessions */
+    sessions[2]->pcc_config.pcep_msg_versioning->draft_ietf_pce_segment_routing_07 =
+            !sessions[2]->pcc_config.pcep_msg_versioning->draft_ietf_pce_segment_routing_07;
+    verify_socket_comm_times_called(0, 0, 3, 3, 0, 0, 0);
+
+    /* The message is always freed, even if it could not be sent */
+    CU_ASSERT_EQUAL(send_message_multi(NULL, 4, pcep_msg_create_keepalive()), 0);
+    CU_ASSERT_EQUAL(send_message_multi(sessions, 0, pcep_msg_create_keepalive()), 0);
+    CU_ASSERT_EQUAL(send_message_multi(sessions, 4, NULL), 0);
+    verify_socket_comm_times_called(0, 0, 3, 3, 0, 0, 0);
+
+    /* The NULL session is skipped */
+    mock_info->send_message_save_message = true;
+    CU_ASSERT_EQUAL(send_message_multi(sessions, 4, pcep_msg_create_keepalive()), 3);
+    verify_socket_comm_times_called(0, 0, 3, 6, 0, 0, 0);
+    CU_ASSERT_EQUAL(mock_info->last_sent_message_priority, SOCKET_COMM_PRIORITY_CONTROL);
+    CU_ASSERT_EQUAL(mock_info->sent_message_list->num_entries, 3);
+
+    uint8_t *encoded_msg;
+    while ((encoded_msg = dll_delete_first_node(mock_info->sent_message_list)) != NULL)
+    {
+        struct pcep_message *msg = pcep_decode_message(encoded_msg);
+        CU_ASSERT_PTR_NOT_NULL(msg);
+        if (msg != NULL)
+        {
+            CU_ASSERT_EQUAL(msg->msg_header->type, PCEP_TYPE_KEEPALIVE);
+            pcep_msg_free_message(msg);
+        }
+        free(encoded_msg);
+    }
+
+    /* The sessions that are not connected or whose socket is closed are not counted */
+    pcep_socket_comm_session *socket_comm_session = sessions[0]->socket_comm_session;
+    sessions[0]->socket_comm_session = NULL;
+    sessions[3]->socket_comm_session->closed = true;
+    CU_ASSERT_EQUAL(send_message_multi(sessions, 4, pcep_msg_create_keepalive()), 1);
+    verify_socket_comm_times_called(0, 0, 3, 8, 0, 0, 0);
+    CU_ASSERT_EQUAL(mock_info->sent_message_list->num_entries, 1);
+    free(dll_delete_first_node(mock_info->sent_message_list));
+    sessions[0]->socket_comm_session = socket_comm_session;
+
+    destroy_pcep_session(sessions[0]);
+    destroy_pcep_session(sessions[2]);
+    destroy_pcep_session(sessions[3]);
+    destroy_pcep_configuration(config);
+}
+
 void test_event_queue()
 {
     /* This initializes the event_queue */
@@ -217,9 +393,10 @@ void test_event_queue()
     /* Create an empty event and put it on the queue */
     pcep_event *event = malloc(sizeof(pcep_event));
     bzero(event, sizeof(pcep_event));
-    pthread_mutex_lock(&session_logic_event_queue_->event_queue_mutex);
-    queue_enqueue(session_logic_event_queue_->event_queue, event);
-    pthread_mutex_unlock(&session_logic_event_queue_->event_queue_mutex);
+    pcep_event_queue *event_queue = get_session_logic_engine_event_queue(get_default_session_logic_engine());
+    pthread_mutex_lock(&event_queue->event_queue_mutex);
+    queue_enqueue(event_queue->event_queue, event);
+    pthread_mutex_unlock(&event_queue->event_queue_mutex);
 
     /* Verify correct behavior when there is an entry in the queue */
     CU_ASSERT_FALSE(event_queue_is_empty());
@@ -232,6 +409,68 @@ void test_event_queue()
     CU_ASSERT_TRUE(destroy_pcc());
 }
 
+void test_pcc_engines()
+{
+    CU_ASSERT_FALSE(destroy_pcc_engine(NULL));
+    CU_ASSERT_PTR_NULL(event_queue_get_event_in_engine(NULL));
+
+    /* The engines are independent of the one started by initialize_pcc() */
+    CU_ASSERT_TRUE(initialize_pcc());
+    pcep_engine *engine = initialize_pcc_engine(NULL, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(engine);
+
+    pcep_configuration *config = create_default_pcep_configuration();
+    struct in_addr dest_addresses[2];
+    inet_pton(AF_INET, "127.0.0.1", &dest_addresses[0]);
+    inet_pton(AF_INET, "127.0.0.2", &dest_addresses[1]);
+    pcep_session *session = connect_pce_in_engine(engine, config, &dest_addresses[0]);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(session);
+    CU_ASSERT_PTR_EQUAL(session->engine, engine);
+    pcep_session *sessions[2];
+    CU_ASSERT_EQUAL(connect_pce_many_in_engine(engine, config, dest_addresses, 2, sessions), 2);
+    CU_ASSERT_PTR_EQUAL(sessions[1]->engine, engine);
+
+    /* An event on the engine event queue is not seen on the default one */
+    pcep_event *event = malloc(sizeof(pcep_event));
+    bzero(event, sizeof(pcep_event));
+    pcep_event_queue *event_queue = get_session_logic_engine_event_queue(engine);
+    pthread_mutex_lock(&event_queue->event_queue_mutex);
+    queue_enqueue(event_queue->event_queue, event);
+    pthread_mutex_unlock(&event_queue->event_queue_mutex);
+    CU_ASSERT_TRUE(event_queue_is_empty());
+    CU_ASSERT_FALSE(event_queue_is_empty_in_engine(engine));
+    CU_ASSERT_EQUAL(event_queue_num_events_available_in_engine(engine), 1);
+    CU_ASSERT_PTR_EQUAL(event_queue_get_event_in_engine(engine), event);
+    destroy_pcep_event(event);
+
+    destroy_pcep_session(session);
+    destroy_pcep_session(sessions[0]);
+    destroy_pcep_session(sessions[1]);
+    destroy_pcep_configuration(config);
+    CU_ASSERT_TRUE(destroy_pcc_engine(engine));
+    CU_ASSERT_TRUE(destroy_pcc());
+}
+
+void test_pool_counters()
+{
+    CU_ASSERT_FALSE(get_pcc_pool_counters(NULL));
+
+    pcep_pcc_pool_counters counters_before;
+    CU_ASSERT_TRUE(get_pcc_pool_counters(&counters_before));
+
+    /* A destroyed event is returned to the pcep_event pool */
+    pcep_event *event = malloc(sizeof(pcep_event));
+    bzero(event, sizeof(pcep_event));
+    destroy_pcep_event(event);
+
+    pcep_pcc_pool_counters counters_after;
+    CU_ASSERT_TRUE(get_pcc_pool_counters(&counters_after));
+    CU_ASSERT_EQUAL(counters_after.session_logic_pools.pcep_event_pool.num_free_pooled,
+                    counters_before.session_logic_pools.pcep_event_pool.num_free_pooled + 1);
+    CU_ASSERT_EQUAL(counters_after.session_logic_pools.pcep_event_pool.num_free_objects,
+                    counters_before.session_logic_pools.pcep_event_pool.num_free_objects + 1);
+}
+
 void test_get_event_type_str()
 {
     CU_ASSERT_EQUAL(strcmp(get_event_type_str(MESSAGE_RECEIVED), MESSAGE_RECEIVED_STR), 0);
@@ -34,9 +34,15 @@ extern void test_initialize_pcc();
 extern void test_connect_pce();
 extern void test_connect_pce_ipv6();
 extern void test_connect_pce_with_src_ip();
+extern void test_connect_pce_many();
 extern void test_disconnect_pce();
+extern void test_disconnect_pce_socket_closed();
 extern void test_send_message();
+extern void test_send_message_oversized();
+extern void test_send_message_multi();
 extern void test_event_queue();
+extern void test_pcc_engines();
+extern void test_pool_counters();
 extern void test_get_event_type_str();
 
 int main(int argc, char **argv)
@@ -56,9 +62,15 @@ int main(int argc, char **argv)
     CU_add_test(test_pcc_api_suite, "test_connect_pce", test_connect_pce);
     CU_add_test(test_pcc_api_suite, "test_connect_pce_ipv6", test_connect_pce_ipv6);
     CU_add_test(test_pcc_api_suite, "test_connect_pce_with_src_ip", test_connect_pce_with_src_ip);
+    CU_add_test(test_pcc_api_suite, "test_connect_pce_many", test_connect_pce_many);
     CU_add_test(test_pcc_api_suite, "test_disconnect_pce", test_disconnect_pce);
+    CU_add_test(test_pcc_api_suite, "test_disconnect_pce_socket_closed", test_disconnect_pce_socket_closed);
     CU_add_test(test_pcc_api_suite, "test_send_message", test_send_message);
+    CU_add_test(test_pcc_api_suite, "test_send_message_oversized", test_send_message_oversized);
+    CU_add_test(test_pcc_api_suite, "test_send_message_multi", test_send_message_multi);
     CU_add_test(test_pcc_api_suite, "test_event_queue", test_event_queue);
+    CU_add_test(test_pcc_api_suite, "test_pcc_engines", test_pcc_engines);
+    CU_add_test(test_pcc_api_suite, "test_pool_counters", test_pool_counters);
     CU_add_test(test_pcc_api_suite, "test_get_event_type_str", test_get_event_type_str);
 
     /*
@@ -35,6 +35,20 @@
 #include "pcep_utils_queue.h"
 
 #define PCEP_TCP_PORT 4189
+/* Max number of session logic worker threads */
+#define MAX_SESSION_LOGIC_WORKERS 64
+
+/* A zeroed pcep_session_logic_config uses 1 session logic worker thread */
+typedef struct pcep_session_logic_config_
+{
+    /* Number of session logic worker threads the sessions are partitioned
+     * across, each with its own event queue and mutex, 0 is the same as 1.
+     * The events of a session are always handled in order, and an idle
+     * worker steals sessions from a worker with queued events. */
+    int num_worker_threads;
+
+} pcep_session_logic_config;
+
 
 typedef struct pcep_configuration_
 {
@@ -53,6 +67,11 @@ typedef struct pcep_configuration_
     int min_dead_timer_seconds;
     int max_dead_timer_seconds;
 
+    /* Up to this percentage of the keep alive and open wait timers is
+     * randomly subtracted from them, so the timers of sessions created
+     * together do not keep expiring together. 0 disables the jitter. */
+    int timer_jitter_percent;
+
     /* If more than this many unknown messages/requests are received
      * per minute, then the session will be closed. */
     int max_unknown_messages;
@@ -62,6 +81,14 @@ typedef struct pcep_configuration_
      * PCE TCP socket before failing, in milliseconds. */
     uint32_t socket_connect_timeout_millis;
 
+    /* Decode each received message in an arena, which saves allocating
+     * and freeing each of its objects and TLVs separately, refer to
+     * pcep_decode_message_in_arena(). The objects and TLVs of the received
+     * messages cannot then be freed, or used after the message is freed, and
+     * they are in small_vectors instead of double_linked_lists, refer to
+     * pcep_msg_first_obj() to iterate them. */
+    bool decode_messages_in_arena;
+
     /* Set if the PCE/PCC will support stateful PCE LSP Updates
      * according to RCF8231, section 7.1.1, defaults to true.
      * Will cause an additional TLV to be sent from the PCC in
@@ -127,11 +154,18 @@ typedef enum pcep_session_state_
     SESSION_STATE_PCEP_CONNECTING = 2,
     SESSION_STATE_PCEP_CONNECTED = 3,
     SESSION_STATE_WAIT_PCREQ = 4,
-    SESSION_STATE_IDLE = 5  /* Only used in conjunction with SESSION_STATE_WAIT_PCREQ */
+    SESSION_STATE_IDLE = 5,  /* Only used in conjunction with SESSION_STATE_WAIT_PCREQ */
+    SESSION_STATE_TCP_CONNECTING = 6  /* Only used with the asynchronous TCP connect */
 
 } pcep_session_state;
 
 
+/* A session logic instance: the session logic thread, the event queue,
+ * the timers, and the socket_comm reactors. The functions without a
+ * pcep_engine parameter use the default engine, started with run_session_logic() */
+typedef struct pcep_engine_ pcep_engine;
+
+
 typedef struct pcep_session_
 {
     int session_id;
@@ -140,6 +174,11 @@ typedef struct pcep_session_
     int timer_id_pc_req_wait;
     int timer_id_dead_timer;
     int timer_id_keep_alive;
+    /* CLOCK_MONOTONIC millis of the last message sent and received. The
+     * keep alive and dead timers are not reset for each message, instead
+     * these are checked when the timers expire, to re-arm them if needed */
+    time_t time_last_msg_sent_millis;
+    time_t time_last_msg_received_millis;
     bool pce_open_received;
     bool pce_open_rejected;
     bool pce_open_accepted;
@@ -152,11 +191,19 @@ typedef struct pcep_session_
     /* set this flag when finalizing the session */
     bool destroy_session_after_write;
     pcep_socket_comm_session *socket_comm_session;
+    /* Reassembles the PCEP messages received on the socket_comm_session,
+     * created when the first message is ready to be read */
+    pcep_msg_reader *msg_reader;
     /* Configuration sent from the PCC to the PCE */
     pcep_configuration pcc_config;
     /* Configuration received from the PCE, to be used in the PCC */
     pcep_configuration pce_config;
     struct counters_group *pcep_session_counters;
+    /* The engine the session was created in */
+    pcep_engine *engine;
+    /* The session logic worker handling the session events, which may
+     * change when the session is stolen by an idle worker */
+    struct pcep_session_logic_worker_ *session_logic_worker;
 
 } pcep_session;
 
@@ -197,17 +244,64 @@ typedef struct pcep_event_queue
 } pcep_event_queue;
 
 
+/* The pcep_event's and the internal session events are allocated from
+ * pools shared by all the engines, these are their hit and miss counters */
+typedef struct pcep_session_logic_pool_counters_
+{
+    object_pool_counters session_event_pool;
+    object_pool_counters pcep_event_pool;
+
+} pcep_session_logic_pool_counters;
+
+
 bool run_session_logic();
+bool run_session_logic_with_config(pcep_session_logic_config *session_logic_config);
 
 bool run_session_logic_wait_for_completion();
 
 bool stop_session_logic();
 
+/* Start another session logic engine, independent of the default engine.
+ * Its sessions use their own socket_comm reactors, configured with the
+ * socket_comm_config. Either config may be NULL to use a single thread. */
+pcep_engine *run_session_logic_engine(pcep_session_logic_config *session_logic_config,
+                                      pcep_socket_comm_config *socket_comm_config);
+bool stop_session_logic_engine(pcep_engine *engine);
+
+/* Returns the pcep_event to its pool, the event message is not freed */
+void free_pcep_event(pcep_event *event);
+bool get_session_logic_pool_counters(pcep_session_logic_pool_counters *counters);
+
+/* Returns NULL if run_session_logic() has not been called */
+pcep_engine *get_default_session_logic_engine();
+pcep_event_queue *get_session_logic_engine_event_queue(pcep_engine *engine);
+
 /* Uses the standard PCEP TCP dest port = 4189 and an ephemeral src port.
  * To use a specific dest or src port, set them other than 0 in the pcep_configuration. */
 pcep_session *create_pcep_session(pcep_configuration *config, struct in_addr *pce_ip);
 pcep_session *create_pcep_session_ipv6(pcep_configuration *config, struct in6_addr *pce_ip);
 
+/* Same as create_pcep_session(), but without waiting for the TCP connect to
+ * complete. The session is returned in the SESSION_STATE_TCP_CONNECTING state,
+ * and the PCEP Open is sent once the connect completes. If the connect fails
+ * or times-out, a PCC_CONNECTION_FAILURE event is queued for the session. */
+pcep_session *create_pcep_session_async(pcep_configuration *config, struct in_addr *pce_ip);
+pcep_session *create_pcep_session_ipv6_async(pcep_configuration *config, struct in6_addr *pce_ip);
+
+/* Same as the above functions, creating the session in the engine */
+pcep_session *create_pcep_session_in_engine(pcep_engine *engine,
+                                            pcep_configuration *config,
+                                            struct in_addr *pce_ip);
+pcep_session *create_pcep_session_ipv6_in_engine(pcep_engine *engine,
+                                                 pcep_configuration *config,
+                                                 struct in6_addr *pce_ip);
+pcep_session *create_pcep_session_async_in_engine(pcep_engine *engine,
+                                                  pcep_configuration *config,
+                                                  struct in_addr *pce_ip);
+pcep_session *create_pcep_session_ipv6_async_in_engine(pcep_engine *engine,
+                                                       pcep_configuration *config,
+                                                       struct in6_addr *pce_ip);
+
 /* Send a PCEP close for this pcep_session */
 void close_pcep_session(pcep_session *session);
 void close_pcep_session_with_reason(pcep_session *session, enum pcep_close_reason);
@@ -223,4 +317,9 @@ void pcep_session_cancel_timers(pcep_session *session);
  * are incremented internally. */
 void increment_message_tx_counters(pcep_session *session, struct pcep_message *message);
 
+/* Returns SOCKET_COMM_PRIORITY_CONTROL for the Open, Keepalive, Error and
+ * Close messages, so they are not queued behind bulk messages like PCRpts,
+ * and SOCKET_COMM_PRIORITY_BULK for the rest. */
+pcep_socket_comm_priority get_message_send_priority(struct pcep_message *message);
+
 #endif /* INCLUDE_PCEPSESSIONLOGIC_H_ */
@@ -44,9 +44,9 @@
  * public API function implementations for the session_logic
  */
 
-pcep_session_logic_handle *session_logic_handle_ = NULL;
-pcep_event_queue *session_logic_event_queue_ = NULL;
-int session_id_ = 0;
+/* The engine used by the functions without a pcep_engine
+ * parameter, started by run_session_logic() */
+pcep_engine *default_engine_ = NULL;
 
 void send_pcep_open(pcep_session *session); /* forward decl */
 
@@ -62,52 +62,167 @@ int session_id_compare_function(void *list_entry, void *new_entry)
 }
 
 
-bool run_session_logic()
+/* Internal util function, the default engine uses the socket_comm_loop
+ * reactors, the other engines create their own socket_comm reactors */
+static pcep_engine *start_session_logic_engine(pcep_session_logic_config *session_logic_config,
+                                               pcep_socket_comm_config *socket_comm_config,
+                                               bool is_default_engine)
 {
-    if (session_logic_handle_ != NULL)
+    int num_workers = (session_logic_config == NULL) ? 1 : session_logic_config->num_worker_threads;
+    if (num_workers < 1)
     {
-        pcep_log(LOG_WARNING, "Session Logic is already initialized.");
-        return false;
+        num_workers = 1;
+    }
+    else if (num_workers > MAX_SESSION_LOGIC_WORKERS)
+    {
+        pcep_log(LOG_ERR, "Cannot initialize [%d] session_logic workers, the max is [%d]",
+                num_workers, MAX_SESSION_LOGIC_WORKERS);
+        return NULL;
     }
 
-    session_logic_handle_ = malloc(sizeof(pcep_session_logic_handle));
-    bzero(session_logic_handle_, sizeof(pcep_session_logic_handle));
+    pcep_engine *engine = malloc(sizeof(pcep_engine));
+    bzero(engine, sizeof(pcep_engine));
 
-    session_logic_handle_->active = true;
-    session_logic_handle_->session_logic_condition = false;
-    session_logic_handle_->session_list = ordered_list_initialize(session_id_compare_function);
-    session_logic_handle_->session_event_queue = queue_initialize();
+    pcep_session_logic_handle *session_logic_handle = malloc(sizeof(pcep_session_logic_handle));
+    bzero(session_logic_handle, sizeof(pcep_session_logic_handle));
+    engine->session_logic_handle = session_logic_handle;
+
+    session_logic_handle->active = true;
+    session_logic_handle->session_list = ordered_list_initialize(session_id_compare_function);
+    session_logic_handle->num_workers = num_workers;
+    session_logic_handle->workers = malloc(sizeof(pcep_session_logic_worker) * num_workers);
+    bzero(session_logic_handle->workers, sizeof(pcep_session_logic_worker) * num_workers);
+
+    int i;
+    for (i = 0; i < num_workers; i++)
+    {
+        pcep_session_logic_worker *worker = &session_logic_handle->workers[i];
+        worker->worker_index = i;
+        worker->session_logic_handle = session_logic_handle;
+        worker->session_logic_condition = false;
+        mpsc_queue_initialize(&worker->event_inbox);
+        pthread_cond_init(&(worker->session_logic_cond_var), NULL);
+
+        if (pthread_mutex_init(&(worker->session_logic_mutex), NULL) != 0)
+        {
+            pcep_log(LOG_ERR, "Cannot initialize session_logic mutex.");
+            return NULL;
+        }
+    }
 
     /* Initialize the event queue */
-    session_logic_event_queue_ = malloc(sizeof(pcep_event_queue));
-    session_logic_event_queue_->event_queue = queue_initialize();
-    if (pthread_mutex_init(&(session_logic_event_queue_->event_queue_mutex), NULL) != 0)
+    engine->event_queue = malloc(sizeof(pcep_event_queue));
+    engine->event_queue->event_queue = queue_initialize();
+    if (pthread_mutex_init(&(engine->event_queue->event_queue_mutex), NULL) != 0)
     {
         pcep_log(LOG_ERR, "Cannot initialize session_logic event queue mutex.");
-        return false;
+        return NULL;
     }
 
-    if (!initialize_timers(session_logic_timer_expire_handler))
+    engine->timers_context = create_timers_context(session_logic_timer_expire_batch_handler, engine);
+    if (engine->timers_context == NULL)
     {
         pcep_log(LOG_ERR, "Cannot initialize session_logic timers.");
-        return false;
+        return NULL;
     }
 
-    pthread_cond_init(&(session_logic_handle_->session_logic_cond_var), NULL);
+    if (is_default_engine == false)
+    {
+        pcep_socket_comm_config default_socket_comm_config;
+        bzero(&default_socket_comm_config, sizeof(pcep_socket_comm_config));
+        engine->socket_comm_reactors = create_socket_comm_reactors(
+                (socket_comm_config == NULL) ? &default_socket_comm_config : socket_comm_config);
+        if (engine->socket_comm_reactors == NULL)
+        {
+            pcep_log(LOG_ERR, "Cannot initialize session_logic socket_comm reactors.");
+            return NULL;
+        }
+    }
 
-    if (pthread_mutex_init(&(session_logic_handle_->session_logic_mutex), NULL) != 0)
+    for (i = 0; i < num_workers; i++)
     {
-        pcep_log(LOG_ERR, "Cannot initialize session_logic mutex.");
-        return false;
+        pcep_session_logic_worker *worker = &session_logic_handle->workers[i];
+        if(pthread_create(&(worker->session_logic_thread), NULL, session_logic_loop, worker))
+        {
+            pcep_log(LOG_ERR, "Cannot initialize session_logic thread.");
+            return NULL;
+        }
+    }
+
+    return engine;
+}
+
+
+/* Internal util function, stop the engine threads and free the engine */
+static void stop_session_logic_engine_threads(pcep_engine *engine)
+{
+    pcep_session_logic_handle *session_logic_handle = engine->session_logic_handle;
+    session_logic_handle->active = false;
+    destroy_timers_context(engine->timers_context);
+
+    int i;
+    for (i = 0; i < session_logic_handle->num_workers; i++)
+    {
+        pcep_session_logic_worker *worker = &session_logic_handle->workers[i];
+        pthread_mutex_lock(&(worker->session_logic_mutex));
+        worker->session_logic_condition = true;
+        pthread_cond_signal(&(worker->session_logic_cond_var));
+        pthread_mutex_unlock(&(worker->session_logic_mutex));
+    }
+
+    /* The workers may steal from each other until they all stop */
+    for (i = 0; i < session_logic_handle->num_workers; i++)
+    {
+        pthread_join(session_logic_handle->workers[i].session_logic_thread, NULL);
+    }
+
+    for (i = 0; i < session_logic_handle->num_workers; i++)
+    {
+        pcep_session_logic_worker *worker = &session_logic_handle->workers[i];
+        pthread_mutex_destroy(&(worker->session_logic_mutex));
+        pthread_cond_destroy(&(worker->session_logic_cond_var));
+        destroy_session_logic_worker_events(worker);
     }
+    free(session_logic_handle->workers);
+    ordered_list_destroy(session_logic_handle->session_list);
+
+    /* destroy the event_queue */
+    pthread_mutex_destroy(&(engine->event_queue->event_queue_mutex));
+    queue_destroy(engine->event_queue->event_queue);
+    free(engine->event_queue);
 
-    if(pthread_create(&(session_logic_handle_->session_logic_thread), NULL, session_logic_loop, session_logic_handle_))
+    /* Explicitly stop the socket comm reactors used by the pcep_sessions */
+    if (engine->socket_comm_reactors != NULL)
     {
-        pcep_log(LOG_ERR, "Cannot initialize session_logic thread.");
+        destroy_socket_comm_reactors(engine->socket_comm_reactors);
+    }
+    else
+    {
+        destroy_socket_comm_loop();
+    }
+
+    free(session_logic_handle);
+    free(engine);
+}
+
+
+bool run_session_logic()
+{
+    return run_session_logic_with_config(NULL);
+}
+
+
+bool run_session_logic_with_config(pcep_session_logic_config *session_logic_config)
+{
+    if (default_engine_ != NULL)
+    {
+        pcep_log(LOG_WARNING, "Session Logic is already initialized.");
         return false;
     }
 
-    return true;
+    default_engine_ = start_session_logic_engine(session_logic_config, NULL, true);
+
+    return (default_engine_ != NULL);
 }
 
 
@@ -118,8 +233,13 @@ bool run_session_logic_wait_for_completion()
         return false;
     }
 
-    /* Blocking call, waits for session logic thread to complete */
-    pthread_join(session_logic_handle_->session_logic_thread, NULL);
+    /* Blocking call, waits for the session logic threads to complete */
+    pcep_session_logic_handle *session_logic_handle = default_engine_->session_logic_handle;
+    int i;
+    for (i = 0; i < session_logic_handle->num_workers; i++)
+    {
+        pthread_join(session_logic_handle->workers[i].session_logic_thread, NULL);
+    }
 
     return true;
 }
@@ -127,40 +247,70 @@ bool run_session_logic_wait_for_completion()
 
 bool stop_session_logic()
 {
-    if (session_logic_handle_ == NULL)
+    if (default_engine_ == NULL)
     {
         pcep_log(LOG_WARNING, "Session logic already stopped");
         return false;
     }
 
-    session_logic_handle_->active = false;
-    teardown_timers();
+    stop_session_logic_engine_threads(default_engine_);
+    default_engine_ = NULL;
+
+    return true;
+}
+
 
-    pthread_mutex_lock(&(session_logic_handle_->session_logic_mutex));
-    session_logic_handle_->session_logic_condition = true;
-    pthread_cond_signal(&(session_logic_handle_->session_logic_cond_var));
-    pthread_mutex_unlock(&(session_logic_handle_->session_logic_mutex));
-    pthread_join(session_logic_handle_->session_logic_thread, NULL);
+pcep_engine *run_session_logic_engine(pcep_session_logic_config *session_logic_config,
+                                      pcep_socket_comm_config *socket_comm_config)
+{
+    return start_session_logic_engine(session_logic_config, socket_comm_config, false);
+}
 
-    pthread_mutex_destroy(&(session_logic_handle_->session_logic_mutex));
-    ordered_list_destroy(session_logic_handle_->session_list);
-    queue_destroy(session_logic_handle_->session_event_queue);
 
-    /* destroy the event_queue */
-    pthread_mutex_destroy(&(session_logic_event_queue_->event_queue_mutex));
-    queue_destroy(session_logic_event_queue_->event_queue);
-    free(session_logic_event_queue_);
+bool stop_session_logic_engine(pcep_engine *engine)
+{
+    if (engine == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot stop a NULL session logic engine");
+        return false;
+    }
 
-    /* Explicitly stop the socket comm loop started by the pcep_sessions */
-    destroy_socket_comm_loop();
+    if (engine == default_engine_)
+    {
+        return stop_session_logic();
+    }
 
-    free(session_logic_handle_);
-    session_logic_handle_ = NULL;
+    stop_session_logic_engine_threads(engine);
 
     return true;
 }
 
 
+pcep_engine *get_default_session_logic_engine()
+{
+    return default_engine_;
+}
+
+
+pcep_event_queue *get_session_logic_engine_event_queue(pcep_engine *engine)
+{
+    return (engine == NULL) ? NULL : engine->event_queue;
+}
+
+
+bool get_session_logic_pool_counters(pcep_session_logic_pool_counters *counters)
+{
+    if (counters == NULL)
+    {
+        pcep_log(LOG_WARNING, "get_session_logic_pool_counters cannot get the counters with a NULL counters");
+        return false;
+    }
+
+    return (get_session_event_pool_counters(&counters->session_event_pool) &&
+            get_pcep_event_pool_counters(&counters->pcep_event_pool));
+}
+
+
 void close_pcep_session(pcep_session *session)
 {
     close_pcep_session_with_reason(session, PCEP_CLOSE_REASON_NO);
@@ -173,9 +323,19 @@ void close_pcep_session_with_reason(pcep_session *session, enum pcep_close_reaso
     pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic send pcep_close message for session_id [%d]",
            time(NULL), pthread_self(), session->session_id);
 
-    session_send_message(session, close_msg);
-    socket_comm_session_close_tcp_after_write(session->socket_comm_session);
+    /* The session may be destroyed by the socket_comm_loop as soon as the
+     * close message is written, so it cant be accessed after closing */
     session->session_state = SESSION_STATE_INITIALIZED;
+    session_send_message(session, close_msg);
+    if (!socket_comm_session_close_tcp_after_write(session->socket_comm_session))
+    {
+        /* The socket is not connected or was already closed, so the
+         * message_sent_handler wont be called to destroy the session */
+        if (__atomic_exchange_n(&session->destroy_session_after_write, false, __ATOMIC_SEQ_CST))
+        {
+            destroy_pcep_session(session);
+        }
+    }
 }
 
 
@@ -189,6 +349,12 @@ void destroy_pcep_session(pcep_session *session)
 
     pcep_session_cancel_timers(session);
 
+    pcep_session_logic_worker *worker = __atomic_load_n(&session->session_logic_worker, __ATOMIC_ACQUIRE);
+    if (worker != NULL)
+    {
+        __atomic_fetch_sub(&worker->num_sessions, 1, __ATOMIC_RELAXED);
+    }
+
     delete_counters_group(session->pcep_session_counters);
 
     queue_destroy_with_data(session->num_unknown_messages_time_queue);
@@ -196,6 +362,7 @@ void destroy_pcep_session(pcep_session *session)
     pcep_log(LOG_INFO, "[%ld-%ld] pcep_session [%d] destroyed", time(NULL), pthread_self(), session->session_id);
 
     socket_comm_session_teardown(session->socket_comm_session);
+    pcep_msg_reader_destroy(session->msg_reader);
 
     if (session->pcc_config.pcep_msg_versioning != NULL)
     {
@@ -219,39 +386,72 @@ void pcep_session_cancel_timers(pcep_session *session)
 
     if (session->timer_id_dead_timer != TIMER_ID_NOT_SET)
     {
-        cancel_timer(session->timer_id_dead_timer);
+        timers_context_cancel_timer(session->engine->timers_context, session->timer_id_dead_timer);
     }
 
     if (session->timer_id_keep_alive != TIMER_ID_NOT_SET)
     {
-        cancel_timer(session->timer_id_keep_alive);
+        timers_context_cancel_timer(session->engine->timers_context, session->timer_id_keep_alive);
     }
 
     if (session->timer_id_open_keep_wait != TIMER_ID_NOT_SET)
     {
-        cancel_timer(session->timer_id_open_keep_wait);
+        timers_context_cancel_timer(session->engine->timers_context, session->timer_id_open_keep_wait);
     }
 
     if (session->timer_id_pc_req_wait != TIMER_ID_NOT_SET)
     {
-        cancel_timer(session->timer_id_pc_req_wait);
+        timers_context_cancel_timer(session->engine->timers_context, session->timer_id_pc_req_wait);
     }
 }
 
-/* Internal util function */
-static int get_next_session_id()
+uint32_t get_timer_jitter_millis(pcep_configuration *config, int timer_seconds)
+{
+    if (config->timer_jitter_percent <= 0 || timer_seconds <= 0)
+    {
+        return 0;
+    }
+
+    int jitter_percent = (config->timer_jitter_percent > 100) ? 100 : config->timer_jitter_percent;
+
+    return (((uint32_t) timer_seconds) * 1000 * jitter_percent) / 100;
+}
+
+/* Internal util function, the session_ids are only unique within each engine */
+static int get_next_session_id(pcep_engine *engine)
+{
+    return (int) (__atomic_fetch_add(&engine->next_session_id, 1, __ATOMIC_RELAXED) & INT_MAX);
+}
+
+/* Internal util function, the new sessions are assigned to the worker
+ * with the fewest sessions, the idle workers balance the rest */
+static pcep_session_logic_worker *assign_session_logic_worker(pcep_engine *engine)
 {
-    if (session_id_ == INT_MAX)
+    pcep_session_logic_handle *session_logic_handle = engine->session_logic_handle;
+    pcep_session_logic_worker *worker = &session_logic_handle->workers[0];
+    int i;
+    for (i = 1; i < session_logic_handle->num_workers; i++)
     {
-        session_id_ = 0;
+        if (__atomic_load_n(&session_logic_handle->workers[i].num_sessions, __ATOMIC_RELAXED) <
+                __atomic_load_n(&worker->num_sessions, __ATOMIC_RELAXED))
+        {
+            worker = &session_logic_handle->workers[i];
+        }
     }
+    __atomic_fetch_add(&worker->num_sessions, 1, __ATOMIC_RELAXED);
 
-    return session_id_++;
+    return worker;
 }
 
 /* Internal util function */
-static pcep_session *create_pcep_session_pre_setup(pcep_configuration *config)
+static pcep_session *create_pcep_session_pre_setup(pcep_engine *engine, pcep_configuration *config)
 {
+    if (engine == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot create pcep session, the session logic is not running");
+        return NULL;
+    }
+
     if (config == NULL)
     {
         pcep_log(LOG_WARNING, "Cannot create pcep session with NULL config");
@@ -260,7 +460,9 @@ static pcep_session *create_pcep_session_pre_setup(pcep_configuration *config)
 
     pcep_session *session = malloc(sizeof(pcep_session));
     memset(session, 0, sizeof(pcep_session));
-    session->session_id = get_next_session_id();
+    session->engine = engine;
+    session->session_id = get_next_session_id(engine);
+    session->session_logic_worker = assign_session_logic_worker(engine);
     session->session_state = SESSION_STATE_INITIALIZED;
     session->timer_id_open_keep_wait = TIMER_ID_NOT_SET;
     session->timer_id_pc_req_wait = TIMER_ID_NOT_SET;
@@ -289,9 +491,46 @@ static pcep_session *create_pcep_session_pre_setup(pcep_configuration *config)
     return session;
 }
 
+/* Send the PCEP Open once the TCP connection is established, also
+ * called from pcep_session_logic_states.c for the asynchronous connect */
+void start_pcep_session_open(pcep_session *session)
+{
+    session->time_connected = time(NULL);
+
+    /* The PCE reply may be handled as soon as the open message is written,
+     * so the session state must be set before sending it */
+    session->session_state = SESSION_STATE_PCEP_CONNECTING;
+    session->timer_id_open_keep_wait = timers_context_create_timer(
+            session->engine->timers_context,
+            session->pcc_config.keep_alive_seconds * 1000,
+            get_timer_jitter_millis(&session->pcc_config, session->pcc_config.keep_alive_seconds),
+            session);
+    //session->session_state = SESSION_STATE_OPENED;
+
+    send_pcep_open(session);
+}
+
 /* Internal util function */
-static bool create_pcep_session_post_setup(pcep_session *session)
+static bool create_pcep_session_post_setup(pcep_session *session, bool connect_async)
 {
+    if (connect_async)
+    {
+        /* The session state must be set before starting the connect,
+         * since it may complete before this function returns */
+        create_session_counters(session);
+        session->session_state = SESSION_STATE_TCP_CONNECTING;
+        if (!socket_comm_session_connect_tcp_async(
+                session->socket_comm_session, session_logic_connect_complete_notifier))
+        {
+            pcep_log(LOG_WARNING, "Cannot start TCP socket connect.");
+            destroy_pcep_session(session);
+
+            return false;
+        }
+
+        return true;
+    }
+
     if (!socket_comm_session_connect_tcp(session->socket_comm_session))
     {
         pcep_log(LOG_WARNING, "Cannot establish TCP socket.");
@@ -300,19 +539,17 @@ static bool create_pcep_session_post_setup(pcep_session *session)
         return false;
     }
 
-    session->time_connected = time(NULL);
     create_session_counters(session);
-
-    send_pcep_open(session);
-
-    session->session_state = SESSION_STATE_PCEP_CONNECTING;
-    session->timer_id_open_keep_wait = create_timer(session->pcc_config.keep_alive_seconds, session);
-    //session->session_state = SESSION_STATE_OPENED;
+    start_pcep_session_open(session);
 
     return true;
 }
 
-pcep_session *create_pcep_session(pcep_configuration *config, struct in_addr *pce_ip)
+/* Internal util function */
+static pcep_session *create_pcep_session_with_connect(pcep_engine *engine,
+                                                      pcep_configuration *config,
+                                                      struct in_addr *pce_ip,
+                                                      bool connect_async)
 {
     if (pce_ip == NULL)
     {
@@ -320,23 +557,42 @@ pcep_session *create_pcep_session(pcep_configuration *config, struct in_addr *pc
         return NULL;
     }
 
-    pcep_session *session = create_pcep_session_pre_setup(config);
+    pcep_session *session = create_pcep_session_pre_setup(engine, config);
     if (session == NULL)
     {
         return NULL;
     }
 
-    session->socket_comm_session = socket_comm_session_initialize_with_src(
-            NULL,
-            session_logic_msg_ready_handler,
-            session_logic_message_sent_handler,
-            session_logic_conn_except_notifier,
-            &(config->src_ip.src_ipv4),
-            ((config->src_pcep_port == 0) ? PCEP_TCP_PORT : config->src_pcep_port),
-            pce_ip,
-            ((config->dst_pcep_port == 0) ? PCEP_TCP_PORT : config->dst_pcep_port),
-            config->socket_connect_timeout_millis,
-            session);
+    /* The default engine sessions use the socket_comm_loop reactors */
+    if (engine->socket_comm_reactors == NULL)
+    {
+        session->socket_comm_session = socket_comm_session_initialize_with_src(
+                NULL,
+                session_logic_msg_ready_handler,
+                session_logic_message_sent_handler,
+                session_logic_conn_except_notifier,
+                &(config->src_ip.src_ipv4),
+                ((config->src_pcep_port == 0) ? PCEP_TCP_PORT : config->src_pcep_port),
+                pce_ip,
+                ((config->dst_pcep_port == 0) ? PCEP_TCP_PORT : config->dst_pcep_port),
+                config->socket_connect_timeout_millis,
+                session);
+    }
+    else
+    {
+        session->socket_comm_session = socket_comm_session_initialize_with_reactors(
+                engine->socket_comm_reactors,
+                NULL,
+                session_logic_msg_ready_handler,
+                session_logic_message_sent_handler,
+                session_logic_conn_except_notifier,
+                &(config->src_ip.src_ipv4),
+                ((config->src_pcep_port == 0) ? PCEP_TCP_PORT : config->src_pcep_port),
+                pce_ip,
+                ((config->dst_pcep_port == 0) ? PCEP_TCP_PORT : config->dst_pcep_port),
+                config->socket_connect_timeout_millis,
+                session);
+    }
     if (session->socket_comm_session == NULL)
     {
         pcep_log(LOG_WARNING, "Cannot establish socket_comm_session.");
@@ -345,7 +601,7 @@ pcep_session *create_pcep_session(pcep_configuration *config, struct in_addr *pc
         return NULL;
     }
 
-    if (create_pcep_session_post_setup(session) == false)
+    if (create_pcep_session_post_setup(session, connect_async) == false)
     {
         return NULL;
     }
@@ -353,7 +609,11 @@ pcep_session *create_pcep_session(pcep_configuration *config, struct in_addr *pc
     return session;
 }
 
-pcep_session *create_pcep_session_ipv6(pcep_configuration *config, struct in6_addr *pce_ip)
+/* Internal util function */
+static pcep_session *create_pcep_session_ipv6_with_connect(pcep_engine *engine,
+                                                           pcep_configuration *config,
+                                                           struct in6_addr *pce_ip,
+                                                           bool connect_async)
 {
     if (pce_ip == NULL)
     {
@@ -361,23 +621,42 @@ pcep_session *create_pcep_session_ipv6(pcep_configuration *config, struct in6_ad
         return NULL;
     }
 
-    pcep_session *session = create_pcep_session_pre_setup(config);
+    pcep_session *session = create_pcep_session_pre_setup(engine, config);
     if (session == NULL)
     {
         return NULL;
     }
 
-    session->socket_comm_session = socket_comm_session_initialize_with_src_ipv6(
-            NULL,
-            session_logic_msg_ready_handler,
-            session_logic_message_sent_handler,
-            session_logic_conn_except_notifier,
-            &(config->src_ip.src_ipv6),
-            ((config->src_pcep_port == 0) ? PCEP_TCP_PORT : config->src_pcep_port),
-            pce_ip,
-            ((config->dst_pcep_port == 0) ? PCEP_TCP_PORT : config->dst_pcep_port),
-            config->socket_connect_timeout_millis,
-            session);
+    /* The default engine sessions use the socket_comm_loop reactors */
+    if (engine->socket_comm_reactors == NULL)
+    {
+        session->socket_comm_session = socket_comm_session_initialize_with_src_ipv6(
+                NULL,
+                session_logic_msg_ready_handler,
+                session_logic_message_sent_handler,
+                session_logic_conn_except_notifier,
+                &(config->src_ip.src_ipv6),
+                ((config->src_pcep_port == 0) ? PCEP_TCP_PORT : config->src_pcep_port),
+                pce_ip,
+                ((config->dst_pcep_port == 0) ? PCEP_TCP_PORT : config->dst_pcep_port),
+                config->socket_connect_timeout_millis,
+                session);
+    }
+    else
+    {
+        session->socket_comm_session = socket_comm_session_initialize_with_reactors_ipv6(
+                engine->socket_comm_reactors,
+                NULL,
+                session_logic_msg_ready_handler,
+                session_logic_message_sent_handler,
+                session_logic_conn_except_notifier,
+                &(config->src_ip.src_ipv6),
+                ((config->src_pcep_port == 0) ? PCEP_TCP_PORT : config->src_pcep_port),
+                pce_ip,
+                ((config->dst_pcep_port == 0) ? PCEP_TCP_PORT : config->dst_pcep_port),
+                config->socket_connect_timeout_millis,
+                session);
+    }
     if (session->socket_comm_session == NULL)
     {
         pcep_log(LOG_WARNING, "Cannot establish ipv6 socket_comm_session.");
@@ -386,7 +665,7 @@ pcep_session *create_pcep_session_ipv6(pcep_configuration *config, struct in6_ad
         return NULL;
     }
 
-    if (create_pcep_session_post_setup(session) == false)
+    if (create_pcep_session_post_setup(session, connect_async) == false)
     {
         return NULL;
     }
@@ -394,17 +673,88 @@ pcep_session *create_pcep_session_ipv6(pcep_configuration *config, struct in6_ad
     return session;
 }
 
+pcep_session *create_pcep_session(pcep_configuration *config, struct in_addr *pce_ip)
+{
+    return create_pcep_session_with_connect(default_engine_, config, pce_ip, false);
+}
+
+pcep_session *create_pcep_session_ipv6(pcep_configuration *config, struct in6_addr *pce_ip)
+{
+    return create_pcep_session_ipv6_with_connect(default_engine_, config, pce_ip, false);
+}
+
+pcep_session *create_pcep_session_async(pcep_configuration *config, struct in_addr *pce_ip)
+{
+    return create_pcep_session_with_connect(default_engine_, config, pce_ip, true);
+}
+
+pcep_session *create_pcep_session_ipv6_async(pcep_configuration *config, struct in6_addr *pce_ip)
+{
+    return create_pcep_session_ipv6_with_connect(default_engine_, config, pce_ip, true);
+}
+
+pcep_session *create_pcep_session_in_engine(pcep_engine *engine,
+                                            pcep_configuration *config,
+                                            struct in_addr *pce_ip)
+{
+    return create_pcep_session_with_connect(engine, config, pce_ip, false);
+}
+
+pcep_session *create_pcep_session_ipv6_in_engine(pcep_engine *engine,
+                                                 pcep_configuration *config,
+                                                 struct in6_addr *pce_ip)
+{
+    return create_pcep_session_ipv6_with_connect(engine, config, pce_ip, false);
+}
+
+pcep_session *create_pcep_session_async_in_engine(pcep_engine *engine,
+                                                  pcep_configuration *config,
+                                                  struct in_addr *pce_ip)
+{
+    return create_pcep_session_with_connect(engine, config, pce_ip, true);
+}
+
+pcep_session *create_pcep_session_ipv6_async_in_engine(pcep_engine *engine,
+                                                       pcep_configuration *config,
+                                                       struct in6_addr *pce_ip)
+{
+    return create_pcep_session_ipv6_with_connect(engine, config, pce_ip, true);
+}
+
+
+pcep_socket_comm_priority get_message_send_priority(struct pcep_message *message)
+{
+    switch (message->msg_header->type)
+    {
+    case PCEP_TYPE_OPEN:
+    case PCEP_TYPE_KEEPALIVE:
+    case PCEP_TYPE_ERROR:
+    case PCEP_TYPE_CLOSE:
+        return SOCKET_COMM_PRIORITY_CONTROL;
+
+    default:
+        return SOCKET_COMM_PRIORITY_BULK;
+    }
+}
+
 
 void session_send_message(pcep_session *session, struct pcep_message *message)
 {
-    pcep_encode_message(message, session->pcc_config.pcep_msg_versioning);
-    socket_comm_session_send_message(
+    if (pcep_encode_message(message, session->pcc_config.pcep_msg_versioning) == false)
+    {
+        pcep_log(LOG_WARNING, "Cannot send message type [%d] on session_id [%d], it cannot be encoded",
+                 message->msg_header->type, session->session_id);
+        pcep_msg_free_message(message);
+        return;
+    }
+
+    increment_message_tx_counters(session, message);
+    socket_comm_session_send_message_with_priority(
             session->socket_comm_session,
             (char *) message->encoded_message,
             message->encoded_message_length,
-            true);
-
-    increment_message_tx_counters(session, message);
+            true,
+            get_message_send_priority(message));
 
     /* The message->encoded_message will be freed in
      * socket_comm_session_send_message() once sent.
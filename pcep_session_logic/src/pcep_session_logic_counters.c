@@ -276,11 +276,10 @@ void increment_message_counters(pcep_session *session, struct pcep_message *mess
     increment_counter(session->pcep_session_counters, counter_subgroup_id_msg, message->msg_header->type);
 
     /* Iterate the objects */
-    double_linked_list_node *obj_node =
-            (message->obj_list == NULL ? NULL : message->obj_list->head);
-    for (; obj_node != NULL; obj_node = obj_node->next_node)
+    pcep_list_iterator obj_iter;
+    struct pcep_object_header *obj = pcep_msg_first_obj(message, &obj_iter);
+    for (; obj != NULL; obj = pcep_msg_next_obj(&obj_iter))
     {
-        struct pcep_object_header *obj = (struct pcep_object_header *) obj_node->data;
 
         /* Handle class: PCEP_OBJ_CLASS_ENDPOINTS,
          *        type:  PCEP_OBJ_TYPE_ENDPOINT_IPV4 or PCEP_OBJ_TYPE_ENDPOINT_IPV6 */
@@ -297,11 +296,10 @@ void increment_message_counters(pcep_session *session, struct pcep_message *mess
         {
             struct pcep_object_ro *ro_obj = (struct pcep_object_ro *) obj;
 
-            double_linked_list_node *ro_subobj_node =
-                    (ro_obj->sub_objects == NULL ? NULL : ro_obj->sub_objects->head);
-            for (; ro_subobj_node != NULL; ro_subobj_node = ro_subobj_node->next_node)
+            pcep_list_iterator ro_subobj_iter;
+            struct pcep_object_ro_subobj *ro_subobj = pcep_obj_ro_first_subobj(ro_obj, &ro_subobj_iter);
+            for (; ro_subobj != NULL; ro_subobj = pcep_obj_ro_next_subobj(&ro_subobj_iter))
             {
-                struct pcep_object_ro_subobj *ro_subobj = (struct pcep_object_ro_subobj *) ro_subobj_node->data;
                 increment_counter(session->pcep_session_counters,
                         counter_subgroup_id_subobj, ro_subobj->ro_subobj_type);
 
@@ -316,11 +314,10 @@ void increment_message_counters(pcep_session *session, struct pcep_message *mess
         }
 
         /* Iterate the TLVs */
-        double_linked_list_node *tlv_node =
-                (obj->tlv_list == NULL ? NULL : obj->tlv_list->head);
-        for (; tlv_node != NULL; tlv_node = tlv_node->next_node)
+        pcep_list_iterator tlv_iter;
+        struct pcep_object_tlv_header *tlv = pcep_obj_first_tlv(obj, &tlv_iter);
+        for (; tlv != NULL; tlv = pcep_obj_next_tlv(&tlv_iter))
         {
-            struct pcep_object_tlv_header *tlv = (struct pcep_object_tlv_header *) tlv_node->data;
             increment_counter(session->pcep_session_counters, counter_subgroup_id_tlv, tlv->type);
         }
     }
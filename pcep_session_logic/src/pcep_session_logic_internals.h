@@ -35,38 +35,104 @@
 #include <stdbool.h>
 
 #include "pcep-tools.h"
+#include "pcep_timers.h"
 
 #include "pcep_utils_double_linked_list.h"
+#include "pcep_utils_mpsc_queue.h"
+#include "pcep_utils_object_pool.h"
 #include "pcep_utils_ordered_list.h"
 #include "pcep_utils_queue.h"
 
 
-typedef struct pcep_session_logic_handle_
+/* When a worker has more than this many queued events, an idle
+ * worker is woken up to steal sessions from it */
+#define SESSION_LOGIC_WORKER_BUSY_EVENTS 8
+
+struct pcep_session_logic_handle_;
+struct pcep_session_event_;
+
+/* Each session is handled by one worker at a time, so its events are
+ * handled in order. The session_logic_worker of a pcep_session is only
+ * changed with both the old and the new worker mutex locked.
+ * The socket_comm and timers threads enqueue the session events on the
+ * worker event_inbox without locking, the worker drains them in a batch
+ * to its pending events, and handles them with its mutex locked. */
+typedef struct pcep_session_logic_worker_
 {
     pthread_t session_logic_thread;
     pthread_mutex_t session_logic_mutex;
     pthread_cond_t session_logic_cond_var;
     bool session_logic_condition;
+    /* Atomically updated, set while the worker waits on the cond_var, so
+     * the producers only lock the mutex to wake up a sleeping worker */
+    bool sleeping;
+
+    /* Internal timers and socket events of the worker sessions */
+    mpsc_queue_handle event_inbox;
+    /* Atomically updated, the producers currently enqueuing on the inbox,
+     * counted in the entry of the enqueue_epoch they started in. A stealing
+     * worker flips the enqueue_epoch and only waits for the previous one. */
+    int num_enqueuers[2];
+    int enqueue_epoch;
+    /* The events drained from the inbox, only used with the mutex locked */
+    struct pcep_session_event_ *pending_events_head;
+    struct pcep_session_event_ *pending_events_tail;
+    /* Atomically updated, the inbox and pending events */
+    int num_queued_events;
+    /* Atomically updated, used to assign new sessions */
+    int num_sessions;
+    int worker_index;
+    struct pcep_session_logic_handle_ *session_logic_handle;
+
+} pcep_session_logic_worker;
+
+
+typedef struct pcep_session_logic_handle_
+{
     bool active;
 
     ordered_list_handle *session_list;
-    /* Internal timers and socket events */
-    queue_handle *session_event_queue;
+    pcep_session_logic_worker *workers;
+    int num_workers;
 
 } pcep_session_logic_handle;
 
 
+/* Everything used by a session logic instance, so several independent
+ * instances can run in the same process */
+struct pcep_engine_
+{
+    pcep_session_logic_handle *session_logic_handle;
+    /* Events for the PCC, read with the pcep_pcc event_queue functions */
+    pcep_event_queue *event_queue;
+    struct pcep_timers_context_ *timers_context;
+    /* NULL for the default engine, which uses the socket_comm_loop */
+    struct pcep_socket_comm_reactors_ *socket_comm_reactors;
+    uint32_t next_session_id;
+
+};
+
+
 /* Used internally for Session events: message received, timer expired,
  * or socket closed */
 typedef struct pcep_session_event_
 {
+    /* Must be first, the events are enqueued as mpsc_queue_node's */
+    mpsc_queue_node queue_node;
     pcep_session *session;
     int expired_timer_id;
     double_linked_list *received_msg_list;
     bool socket_closed;
+    bool tcp_connect_completed;
+    bool tcp_connected;
 
 } pcep_session_event;
 
+/* The session events and pcep_event pools keep at most this many free
+ * objects per shard */
+#define SESSION_EVENT_POOL_MAX_FREE_EVENTS 1024
+#define PCEP_EVENT_POOL_MAX_FREE_EVENTS 1024
+
 /* Event Counters counter-id definitions */
 typedef enum pcep_session_counters_event_counter_ids
 {
@@ -82,16 +148,30 @@ typedef enum pcep_session_counters_event_counter_ids
 } pcep_session_counters_event_counter_ids;
 
 /* functions implemented in pcep_session_logic_loop.c */
+/* The data is the pcep_session_logic_worker */
 void *session_logic_loop(void *data);
+bool steal_session_logic_events(pcep_session_logic_worker *idle_worker);
+/* Must be called with the worker mutex locked, returns NULL if there are no events */
+pcep_session_event *dequeue_session_logic_event(pcep_session_logic_worker *worker);
+/* The session events are allocated from a pool */
+void free_session_event(pcep_session_event *event);
+bool get_session_event_pool_counters(object_pool_counters *counters);
+/* Frees the events left on a stopped worker */
+void destroy_session_logic_worker_events(pcep_session_logic_worker *worker);
 int session_logic_msg_ready_handler(void *data, int socket_fd);
-void session_logic_message_sent_handler(void *data, int socket_fd);
+void session_logic_message_sent_handler(void *data, int socket_fd, bool socket_closed);
 void session_logic_conn_except_notifier(void *data, int socket_fd);
+void session_logic_connect_complete_notifier(void *data, int socket_fd, bool connected);
 void session_logic_timer_expire_handler(void *data, int timer_id);
+/* The handler_data is the pcep_engine of the timers context */
+void session_logic_timer_expire_batch_handler(void *handler_data, pcep_expired_timer *expired_timers, int num_expired_timers);
 
 void handle_timer_event(pcep_session_event *event);
 void handle_socket_comm_event(pcep_session_event *event);
+void handle_tcp_connect_event(pcep_session_event *event);
 void session_send_message(pcep_session *session, struct pcep_message *message);
 /* defined in pcep_session_logic_states.c */
+bool get_pcep_event_pool_counters(object_pool_counters *counters);
 void send_pcep_error(pcep_session *session,
                      enum pcep_error_type error_type,
                      enum pcep_error_value error_value);
@@ -103,5 +183,9 @@ void increment_message_rx_counters(pcep_session *session, struct pcep_message *m
 
 /* defined in pcep_session_logic.c, also used in pcep_session_logic_states.c */
 struct pcep_message *create_pcep_open(pcep_session *session);
+void start_pcep_session_open(pcep_session *session);
+/* Returns the jitter in millis to apply to a timer of timer_seconds,
+ * according to the config timer_jitter_percent */
+uint32_t get_timer_jitter_millis(pcep_configuration *config, int timer_seconds);
 
 #endif /* SRC_PCEPSESSIONLOGICINTERNALS_H_ */
@@ -23,38 +23,363 @@
  */
 
 
+#include <errno.h>
 #include <malloc.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "pcep_session_logic.h"
 #include "pcep_session_logic_internals.h"
 #include "pcep_timers.h"
 #include "pcep_utils_logging.h"
 
-/* global var needed for callback handlers */
-extern pcep_session_logic_handle *session_logic_handle_;
+/* The session events of all the engines are allocated from this pool,
+ * since they are allocated by the socket_comm and timers threads and
+ * freed by the session logic workers */
+static object_pool_handle *session_event_pool_ = NULL;
+static pthread_once_t session_event_pool_once_ = PTHREAD_ONCE_INIT;
+
+/* internal util function, called once to create the session_event_pool_ */
+static void initialize_session_event_pool()
+{
+    session_event_pool_ = object_pool_initialize(
+            sizeof(pcep_session_event), SESSION_EVENT_POOL_MAX_FREE_EVENTS);
+}
+
+
+void free_session_event(pcep_session_event *event)
+{
+    pthread_once(&session_event_pool_once_, initialize_session_event_pool);
+    object_pool_free(session_event_pool_, event);
+}
+
+
+bool get_session_event_pool_counters(object_pool_counters *counters)
+{
+    pthread_once(&session_event_pool_once_, initialize_session_event_pool);
+    return object_pool_get_counters(session_event_pool_, counters);
+}
+
 
 /* internal util function to create session_event's */
 static pcep_session_event *create_session_event(pcep_session *session)
 {
-    pcep_session_event *event = malloc(sizeof(pcep_session_event));
+    pthread_once(&session_event_pool_once_, initialize_session_event_pool);
+    pcep_session_event *event = object_pool_alloc(session_event_pool_);
     event->session = session;
     event->expired_timer_id = TIMER_ID_NOT_SET;
     event->received_msg_list = NULL;
     event->socket_closed = false;
+    event->tcp_connect_completed = false;
+    event->tcp_connected = false;
 
     return event;
 }
 
 
+/* internal util function to wake up a worker waiting for events, the
+ * mutex is only locked if the worker is sleeping */
+static void wakeup_session_logic_worker(pcep_session_logic_worker *worker)
+{
+    if (__atomic_exchange_n(&worker->sleeping, false, __ATOMIC_SEQ_CST) == false)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(worker->session_logic_mutex));
+    worker->session_logic_condition = true;
+    pthread_cond_signal(&(worker->session_logic_cond_var));
+    pthread_mutex_unlock(&(worker->session_logic_mutex));
+}
+
+
+/* internal util function, called after an event is enqueued on the busy_worker:
+ * wake up an idle worker to steal sessions from it */
+static void wakeup_idle_session_logic_worker(pcep_session_logic_worker *busy_worker)
+{
+    if (__atomic_load_n(&busy_worker->num_queued_events, __ATOMIC_RELAXED) <= SESSION_LOGIC_WORKER_BUSY_EVENTS)
+    {
+        return;
+    }
+
+    pcep_session_logic_handle *session_logic_handle = busy_worker->session_logic_handle;
+    int i;
+    for (i = 0; i < session_logic_handle->num_workers; i++)
+    {
+        pcep_session_logic_worker *worker = &session_logic_handle->workers[i];
+        if (worker != busy_worker && __atomic_load_n(&worker->sleeping, __ATOMIC_RELAXED))
+        {
+            wakeup_session_logic_worker(worker);
+            return;
+        }
+    }
+}
+
+
+/* internal util function, count the producer as enqueuing on the worker in
+ * its current enqueue_epoch, which is returned. The epoch is checked again
+ * after counting, so once a stealing worker flips the epoch, the producers
+ * can no longer be counted in the previous one. */
+static int enter_session_logic_worker(pcep_session_logic_worker *worker)
+{
+    for (;;)
+    {
+        int epoch = __atomic_load_n(&worker->enqueue_epoch, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&worker->num_enqueuers[epoch], 1, __ATOMIC_SEQ_CST);
+        if (epoch == __atomic_load_n(&worker->enqueue_epoch, __ATOMIC_SEQ_CST))
+        {
+            return epoch;
+        }
+        __atomic_fetch_sub(&worker->num_enqueuers[epoch], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+
+/* internal util function to enqueue an event on its session worker without
+ * locking, can be called from any thread. The session may be stolen while
+ * enqueuing, so the producer is counted in the num_enqueuers of the worker
+ * before checking the session is still on it: a stealing worker waits for
+ * the producers counted before it stole the session to be done before moving
+ * the events, so none of them are left behind. */
+static void enqueue_session_event(pcep_session_event *event)
+{
+    pcep_session *session = event->session;
+    pcep_session_logic_worker *worker = __atomic_load_n(&session->session_logic_worker, __ATOMIC_SEQ_CST);
+    int epoch = enter_session_logic_worker(worker);
+    while (worker != __atomic_load_n(&session->session_logic_worker, __ATOMIC_SEQ_CST))
+    {
+        __atomic_fetch_sub(&worker->num_enqueuers[epoch], 1, __ATOMIC_SEQ_CST);
+        worker = __atomic_load_n(&session->session_logic_worker, __ATOMIC_SEQ_CST);
+        epoch = enter_session_logic_worker(worker);
+    }
+
+    __atomic_fetch_add(&worker->num_queued_events, 1, __ATOMIC_RELAXED);
+    mpsc_queue_enqueue(&worker->event_inbox, &event->queue_node);
+    __atomic_fetch_sub(&worker->num_enqueuers[epoch], 1, __ATOMIC_SEQ_CST);
+
+    wakeup_session_logic_worker(worker);
+    wakeup_idle_session_logic_worker(worker);
+}
+
+
+/* internal util function to append an event to the worker pending events */
+static void append_pending_session_event(pcep_session_logic_worker *worker, pcep_session_event *event)
+{
+    event->queue_node.next_node = NULL;
+    if (worker->pending_events_tail == NULL)
+    {
+        worker->pending_events_head = event;
+    }
+    else
+    {
+        worker->pending_events_tail->queue_node.next_node = &event->queue_node;
+    }
+    worker->pending_events_tail = event;
+}
+
+
+/* internal util function to move all the inbox events to the pending
+ * events in one batch, called with the worker mutex locked, which makes
+ * the mutex holder the single consumer of the inbox */
+static void drain_session_event_inbox(pcep_session_logic_worker *worker)
+{
+    mpsc_queue_node *node;
+    while ((node = mpsc_queue_dequeue(&worker->event_inbox)) != NULL)
+    {
+        append_pending_session_event(worker, (pcep_session_event *) node);
+    }
+}
+
+
+/* internal util function, drains the worker inbox at least up to the
+ * last_node, waiting for the producers still linking the nodes before it.
+ * They never block while linking, so the wait is short. */
+static void drain_session_event_inbox_through(pcep_session_logic_worker *worker, mpsc_queue_node *last_node)
+{
+    bool last_node_drained = (last_node == NULL);
+    mpsc_queue_node *node;
+    for (;;)
+    {
+        node = mpsc_queue_dequeue(&worker->event_inbox);
+        if (node == NULL)
+        {
+            if (last_node_drained)
+            {
+                return;
+            }
+
+            sched_yield();
+            continue;
+        }
+
+        append_pending_session_event(worker, (pcep_session_event *) node);
+        if (node == last_node)
+        {
+            last_node_drained = true;
+        }
+    }
+}
+
+
+pcep_session_event *dequeue_session_logic_event(pcep_session_logic_worker *worker)
+{
+    if (worker->pending_events_head == NULL)
+    {
+        drain_session_event_inbox(worker);
+        if (worker->pending_events_head == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    pcep_session_event *event = worker->pending_events_head;
+    worker->pending_events_head = (pcep_session_event *) event->queue_node.next_node;
+    if (worker->pending_events_head == NULL)
+    {
+        worker->pending_events_tail = NULL;
+    }
+    __atomic_fetch_sub(&worker->num_queued_events, 1, __ATOMIC_RELAXED);
+
+    return event;
+}
+
+
+void destroy_session_logic_worker_events(pcep_session_logic_worker *worker)
+{
+    pcep_session_event *event;
+    while ((event = dequeue_session_logic_event(worker)) != NULL)
+    {
+        if (event->received_msg_list != NULL)
+        {
+            pcep_msg_free_message_list(event->received_msg_list);
+        }
+        free_session_event(event);
+    }
+}
+
+
+/* Move the queued events of one session from the worker with the most
+ * queued events to the idle_worker, along with the session itself, so
+ * its next events are also handled by the idle_worker. Both workers are
+ * locked in worker_index order, so workers stealing from each other can
+ * not deadlock. Returns true if a session was stolen. */
+bool steal_session_logic_events(pcep_session_logic_worker *idle_worker)
+{
+    pcep_session_logic_handle *session_logic_handle = idle_worker->session_logic_handle;
+    pcep_session_logic_worker *busy_worker = NULL;
+    int max_events = 1;
+    int i;
+    for (i = 0; i < session_logic_handle->num_workers; i++)
+    {
+        pcep_session_logic_worker *worker = &session_logic_handle->workers[i];
+        int num_events = __atomic_load_n(&worker->num_queued_events, __ATOMIC_RELAXED);
+        if (worker != idle_worker && num_events > max_events)
+        {
+            busy_worker = worker;
+            max_events = num_events;
+        }
+    }
+
+    if (busy_worker == NULL)
+    {
+        return false;
+    }
+
+    pcep_session_logic_worker *first_worker =
+            (idle_worker->worker_index < busy_worker->worker_index) ? idle_worker : busy_worker;
+    pcep_session_logic_worker *second_worker =
+            (first_worker == idle_worker) ? busy_worker : idle_worker;
+    pthread_mutex_lock(&(first_worker->session_logic_mutex));
+    pthread_mutex_lock(&(second_worker->session_logic_mutex));
+
+    /* Steal the session of the next event, unless the busy_worker only
+     * has events of that session. The busy_worker is not handling any
+     * event while its mutex is locked, so the event order is kept. */
+    drain_session_event_inbox(busy_worker);
+    pcep_session *stolen_session = NULL;
+    pcep_session_event *event;
+    for (event = busy_worker->pending_events_head; event != NULL;
+         event = (pcep_session_event *) event->queue_node.next_node)
+    {
+        if (stolen_session == NULL)
+        {
+            stolen_session = event->session;
+        }
+        else if (event->session != stolen_session)
+        {
+            break;
+        }
+    }
+
+    bool stolen = (event != NULL);
+    if (stolen)
+    {
+        /* Events enqueued from now on go to the idle_worker, wait for the
+         * ones being enqueued on the busy_worker to move them too. Flipping
+         * the enqueue_epoch bounds the wait: the producers that start
+         * enqueuing on the busy_worker from now on are counted in the new
+         * epoch, so only the few already enqueuing are waited for, and
+         * they never block while counted. The busy_worker mutex is held, so
+         * no other worker flips the epoch meanwhile. */
+        __atomic_store_n(&stolen_session->session_logic_worker, idle_worker, __ATOMIC_SEQ_CST);
+        int prev_epoch = __atomic_load_n(&busy_worker->enqueue_epoch, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&busy_worker->enqueue_epoch, 1 - prev_epoch, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&busy_worker->num_enqueuers[prev_epoch], __ATOMIC_SEQ_CST) > 0)
+        {
+            sched_yield();
+        }
+
+        /* The drain stops at a node whose producer has not linked it yet,
+         * which may be a producer of the new epoch with nodes of the prev
+         * epoch already enqueued after it, so drain through the last node
+         * enqueued by now, which is after all the prev epoch nodes. */
+        drain_session_event_inbox_through(busy_worker, mpsc_queue_get_last_node(&busy_worker->event_inbox));
+
+        event = busy_worker->pending_events_head;
+        busy_worker->pending_events_head = NULL;
+        busy_worker->pending_events_tail = NULL;
+        int num_stolen_events = 0;
+        while (event != NULL)
+        {
+            pcep_session_event *next_event = (pcep_session_event *) event->queue_node.next_node;
+            if (event->session == stolen_session)
+            {
+                append_pending_session_event(idle_worker, event);
+                num_stolen_events++;
+            }
+            else
+            {
+                append_pending_session_event(busy_worker, event);
+            }
+            event = next_event;
+        }
+
+        __atomic_fetch_sub(&busy_worker->num_queued_events, num_stolen_events, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&idle_worker->num_queued_events, num_stolen_events, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&busy_worker->num_sessions, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&idle_worker->num_sessions, 1, __ATOMIC_RELAXED);
+        pcep_log(LOG_INFO, "[%ld-%ld] session_logic worker [%d] stole session_id [%d] with [%d] events from worker [%d]",
+                time(NULL), pthread_self(), idle_worker->worker_index,
+                stolen_session->session_id, num_stolen_events, busy_worker->worker_index);
+    }
+
+    pthread_mutex_unlock(&(second_worker->session_logic_mutex));
+    pthread_mutex_unlock(&(first_worker->session_logic_mutex));
+
+    return stolen;
+}
+
+
 /* A function pointer to this function is passed to pcep_socket_comm
  * for each pcep_session creation, so it will be called whenever
  * messages are ready to be read. This function will be called
  * by the socket_comm thread.
- * This function will decode the read PCEP message and give it
- * to the session_logic_loop so it can be handled by the session_logic
+ * This function will read, frame and decode the PCEP messages without
+ * locking the session logic, and only hand the decoded message list
+ * to the session worker, so it can be handled by the session_logic
  * state machine. */
 int session_logic_msg_ready_handler(void *data, int socket_fd)
 {
@@ -64,50 +389,78 @@ int session_logic_msg_ready_handler(void *data, int socket_fd)
         return -1;
     }
 
-    if (session_logic_handle_->active == false)
+    pcep_session *session = (pcep_session *) data;
+    pcep_session_logic_handle *session_logic_handle = session->engine->session_logic_handle;
+    if (session_logic_handle->active == false)
     {
         pcep_log(LOG_WARNING, "Received a message ready notification while the session logic is not active");
         return -1;
     }
 
-    pcep_session *session = (pcep_session *) data;
+    if (session->msg_reader == NULL)
+    {
+        session->msg_reader = pcep_msg_reader_create();
+        session->msg_reader->decode_in_arena = session->pcc_config.decode_messages_in_arena;
+    }
 
-    pthread_mutex_lock(&(session_logic_handle_->session_logic_mutex));
-    session_logic_handle_->session_logic_condition = true;
+    /* Read everything available on the socket, which may only be part of
+     * a message, in which case the rest will be read on the next call */
+    int session_id = session->session_id;
+    double_linked_list *msg_list = dll_initialize();
+    int bytes_read = pcep_msg_reader_read(session->msg_reader, socket_fd, msg_list);
 
-    /* This event will ultimately be handled by handle_socket_comm_event()
-     * in pcep_session_logic_states.c */
-    pcep_session_event *rcvd_msg_event = create_session_event(session);
+    if (bytes_read > 0 && msg_list->num_entries > 0)
+    {
+        /* Just logging the first of potentially several messages received */
+        struct pcep_message *msg = ((struct pcep_message *) msg_list->head->data);
+        pcep_log(LOG_INFO, "[%ld-%ld] session_logic_msg_ready_handler received [%d] messages, first of type [%d] len [%d] on session_id [%d]",
+                time(NULL), pthread_self(), msg_list->num_entries, msg->msg_header->type,
+                msg->encoded_message_length, session->session_id);
+
+        /* If the reader failed after decoding the messages, read again to
+         * get the failure now, since the socket may not be readable again.
+         * The session is not used once the event is enqueued. */
+        double_linked_list *rcvd_msg_list = msg_list;
+        bool read_failed = (session->msg_reader->pending_errno != 0);
+        if (read_failed)
+        {
+            msg_list = dll_initialize();
+            bytes_read = pcep_msg_reader_read(session->msg_reader, socket_fd, msg_list);
+        }
 
-    int msg_length = 0;
-    double_linked_list *msg_list = pcep_msg_read(socket_fd);
+        /* This event will ultimately be handled by handle_socket_comm_event()
+         * in pcep_session_logic_states.c */
+        int read_errno = errno;
+        pcep_session_event *rcvd_msg_event = create_session_event(session);
+        rcvd_msg_event->received_msg_list = rcvd_msg_list;
+        enqueue_session_event(rcvd_msg_event);
+
+        if (read_failed == false)
+        {
+            return bytes_read;
+        }
+        errno = read_errno;
+    }
 
-    if (msg_list == NULL || msg_list->num_entries == 0)
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
     {
-        pcep_log(LOG_INFO, "PCEP connection closed for pcep_session [%d]", session->session_id);
+        /* Nothing to read, errno is left as EAGAIN for the caller */
         dll_destroy(msg_list);
-        rcvd_msg_event->socket_closed = true;
-        socket_comm_session_teardown(session->socket_comm_session);
-        pcep_session_cancel_timers(session);
-        session->socket_comm_session = NULL;
-        session->session_state = SESSION_STATE_INITIALIZED;
+        return -1;
     }
-    else
-    {
-        /* Just logging the first of potentially several messages received */
-        struct pcep_message *msg = ((struct pcep_message *) msg_list->head->data);
-        pcep_log(LOG_INFO, "[%ld-%ld] session_logic_msg_ready_handler received message of type [%d] len [%d] on session_id [%d]",
-                time(NULL), pthread_self(), msg->msg_header->type, msg->encoded_message_length, session->session_id);
 
-        rcvd_msg_event->received_msg_list = msg_list;
-        msg_length = msg->encoded_message_length;
+    if (bytes_read > 0)
+    {
+        /* Only part of a message was received, wait for the rest */
+        dll_destroy(msg_list);
+        return bytes_read;
     }
 
-    queue_enqueue(session_logic_handle_->session_event_queue, rcvd_msg_event);
-    pthread_cond_signal(&(session_logic_handle_->session_logic_cond_var));
-    pthread_mutex_unlock(&(session_logic_handle_->session_logic_mutex));
-
-    return msg_length;
+    /* The socket_comm_loop stops reading the socket and calls the
+     * session_logic_conn_except_notifier, whose event tears it down */
+    pcep_log(LOG_INFO, "PCEP connection closed for pcep_session [%d]", session_id);
+    pcep_msg_free_message_list(msg_list);
+    return 0;
 }
 
 
@@ -115,7 +468,7 @@ int session_logic_msg_ready_handler(void *data, int socket_fd)
  * so it will be called when a message is sent. This is useful since
  * message sending is asynchronous, and there are times that actions
  * need to be performed only after a message has been sent. */
-void session_logic_message_sent_handler(void *data, int socket_fd)
+void session_logic_message_sent_handler(void *data, int socket_fd, bool socket_closed)
 {
     if (data == NULL)
     {
@@ -126,27 +479,31 @@ void session_logic_message_sent_handler(void *data, int socket_fd)
     pcep_session *session = (pcep_session *) data;
     if (session->destroy_session_after_write == true)
     {
-        /* Do not call destroy until all of the queued messages are written */
-        if (session->socket_comm_session->message_queue->num_entries == 0)
+        /* Do not call destroy until all of the queued messages are written
+         * and the socket has been closed. The flag is cleared so the session
+         * is only destroyed once, even if close_pcep_session() also found the
+         * socket closed. The socket_comm_session is not accessed here. */
+        if (socket_closed &&
+                __atomic_exchange_n(&session->destroy_session_after_write, false, __ATOMIC_SEQ_CST))
         {
             destroy_pcep_session(session);
         }
     }
     else
     {
-        /* Reset the keep alive timer for every message sent on
-         * the session, only if the session is not destroyed */
+        /* The keep alive timer is not reset for every message sent on the
+         * session, when it expires it is re-armed if a message was sent
+         * since it was set, only if the session is not destroyed */
+        session->time_last_msg_sent_millis = get_timers_monotonic_millis();
         if (session->timer_id_keep_alive == TIMER_ID_NOT_SET)
         {
             pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic set keep alive timer [%d secs] for session_id [%d]",
                     time(NULL), pthread_self(), session->pce_config.keep_alive_seconds, session->session_id);
-            session->timer_id_keep_alive = create_timer(session->pce_config.keep_alive_seconds, session);
-        }
-        else
-        {
-            pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic reset keep alive timer [%d secs] for session_id [%d]",
-                    time(NULL), pthread_self(), session->pce_config.keep_alive_seconds, session->session_id);
-            reset_timer(session->timer_id_keep_alive);
+            session->timer_id_keep_alive = timers_context_create_timer(
+                    session->engine->timers_context,
+                    session->pce_config.keep_alive_seconds * 1000,
+                    get_timer_jitter_millis(&session->pce_config, session->pce_config.keep_alive_seconds),
+                    session);
         }
     }
 
@@ -164,24 +521,50 @@ void session_logic_conn_except_notifier(void *data, int socket_fd)
         return;
     }
 
-    if (session_logic_handle_->active == false)
+    pcep_session *session = (pcep_session *) data;
+    pcep_session_logic_handle *session_logic_handle = session->engine->session_logic_handle;
+    if (session_logic_handle->active == false)
     {
         pcep_log(LOG_WARNING, "Received a connection exception notification while the session logic is not active");
         return;
     }
 
-    pcep_session *session = (pcep_session *) data;
     pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic session_logic_conn_except_notifier socket closed [%d], session_id [%d]",
             time(NULL), pthread_self(), socket_fd, session->session_id);
 
-    pthread_mutex_lock(&(session_logic_handle_->session_logic_mutex));
     pcep_session_event *socket_event = create_session_event(session);
     socket_event->socket_closed = true;
-    queue_enqueue(session_logic_handle_->session_event_queue, socket_event);
-    session_logic_handle_->session_logic_condition = true;
+    enqueue_session_event(socket_event);
+}
+
 
-    pthread_cond_signal(&(session_logic_handle_->session_logic_cond_var));
-    pthread_mutex_unlock(&(session_logic_handle_->session_logic_mutex));
+/* A function pointer to this function is passed to pcep_socket_comm
+ * for the sessions created with an asynchronous TCP connect, so it will
+ * be called when the connect completes or fails. This function will be
+ * called by the socket_comm thread. */
+void session_logic_connect_complete_notifier(void *data, int socket_fd, bool connected)
+{
+    if (data == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot handle connect_complete with NULL data");
+        return;
+    }
+
+    pcep_session *session = (pcep_session *) data;
+    pcep_session_logic_handle *session_logic_handle = session->engine->session_logic_handle;
+    if (session_logic_handle->active == false)
+    {
+        pcep_log(LOG_WARNING, "Received a connect complete notification while the session logic is not active");
+        return;
+    }
+
+    pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic session_logic_connect_complete_notifier socket [%d] connected [%d], session_id [%d]",
+            time(NULL), pthread_self(), socket_fd, connected, session->session_id);
+
+    pcep_session_event *connect_event = create_session_event(session);
+    connect_event->tcp_connect_completed = true;
+    connect_event->tcp_connected = connected;
+    enqueue_session_event(connect_event);
 }
 
 
@@ -199,27 +582,54 @@ void session_logic_timer_expire_handler(void *data, int timer_id)
         return;
     }
 
-    if (session_logic_handle_->active == false)
+    pcep_expired_timer expired_timer;
+    expired_timer.data = data;
+    expired_timer.timer_id = timer_id;
+
+    session_logic_timer_expire_batch_handler(((pcep_session *) data)->engine, &expired_timer, 1);
+}
+
+
+/* A function pointer to this function was passed to pcep_timers,
+ * so it will be called from the timers thread with all the timers
+ * that expired together. The events are enqueued without locking the
+ * session workers.
+ * The handler_data is the pcep_engine that created the timers context. */
+void session_logic_timer_expire_batch_handler(void *handler_data, pcep_expired_timer *expired_timers, int num_expired_timers)
+{
+    if (handler_data == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot handle timers with a NULL engine");
+        return;
+    }
+
+    pcep_session_logic_handle *session_logic_handle = ((pcep_engine *) handler_data)->session_logic_handle;
+    if (session_logic_handle->active == false)
     {
         pcep_log(LOG_WARNING, "Received a timer expiration while the session logic is not active");
         return;
     }
 
-    pcep_log(LOG_INFO, "[%ld-%ld] timer expired handler timer_id [%d]", time(NULL), pthread_self(), timer_id);
-    pcep_session_event *expired_timer_event = create_session_event((pcep_session *) data);
-    expired_timer_event->expired_timer_id = timer_id;
-
-    pthread_mutex_lock(&(session_logic_handle_->session_logic_mutex));
-    session_logic_handle_->session_logic_condition = true;
-    queue_enqueue(session_logic_handle_->session_event_queue, expired_timer_event);
+    int i;
+    for (i = 0; i < num_expired_timers; i++)
+    {
+        if (expired_timers[i].data == NULL)
+        {
+            pcep_log(LOG_WARNING, "Cannot handle timer with NULL data");
+            continue;
+        }
 
-    pthread_cond_signal(&(session_logic_handle_->session_logic_cond_var));
-    pthread_mutex_unlock(&(session_logic_handle_->session_logic_mutex));
+        pcep_log(LOG_INFO, "[%ld-%ld] timer expired handler timer_id [%d]",
+                time(NULL), pthread_self(), expired_timers[i].timer_id);
+        pcep_session_event *expired_timer_event = create_session_event((pcep_session *) expired_timers[i].data);
+        expired_timer_event->expired_timer_id = expired_timers[i].timer_id;
+        enqueue_session_event(expired_timer_event);
+    }
 }
 
 
 /*
- * session_logic event loop
+ * session_logic event loop, one per session logic worker
  * this function is called upon thread creation from pcep_session_logic.c
  */
 void *session_logic_loop(void *data)
@@ -231,47 +641,72 @@ void *session_logic_loop(void *data)
         return NULL;
     }
 
-    pcep_log(LOG_NOTICE, "[%ld-%ld] Starting session_logic_loop thread", time(NULL), pthread_self());
+    pcep_session_logic_worker *worker = (pcep_session_logic_worker *) data;
+    pcep_session_logic_handle *session_logic_handle = worker->session_logic_handle;
 
-    pcep_session_logic_handle *session_logic_handle = (pcep_session_logic_handle *) data;
+    pcep_log(LOG_NOTICE, "[%ld-%ld] Starting session_logic_loop thread for worker [%d]",
+            time(NULL), pthread_self(), worker->worker_index);
 
     while (session_logic_handle->active)
     {
-        pthread_mutex_lock(&(session_logic_handle->session_logic_mutex));
-
-        /* this internal loop helps avoid spurious interrupts */
-        while (!session_logic_handle->session_logic_condition)
+        /* The events are handled one at a time, unlocking the mutex in
+         * between, so an idle worker can steal sessions from this one */
+        pthread_mutex_lock(&(worker->session_logic_mutex));
+        pcep_session_event *event = dequeue_session_logic_event(worker);
+        if (event == NULL)
         {
-            pthread_cond_wait(&(session_logic_handle->session_logic_cond_var),
-                              &(session_logic_handle->session_logic_mutex));
-        }
+            pthread_mutex_unlock(&(worker->session_logic_mutex));
 
-        pcep_session_event *event = queue_dequeue(session_logic_handle->session_event_queue);
-        while (event != NULL)
-        {
-            if (event->expired_timer_id != TIMER_ID_NOT_SET)
+            /* Nothing left to handle, help the busy workers */
+            if (session_logic_handle->num_workers > 1 && session_logic_handle->active &&
+                    steal_session_logic_events(worker))
             {
-                handle_timer_event(event);
+                continue;
             }
 
-            if (event->received_msg_list != NULL)
+            /* The sleeping flag is set before checking the inbox, and the
+             * producers check it after enqueuing, so no wakeup is missed */
+            pthread_mutex_lock(&(worker->session_logic_mutex));
+            __atomic_store_n(&worker->sleeping, true, __ATOMIC_SEQ_CST);
+
+            /* this internal loop helps avoid spurious interrupts */
+            while (!worker->session_logic_condition &&
+                    mpsc_queue_is_empty(&worker->event_inbox))
             {
-                handle_socket_comm_event(event);
+                pthread_cond_wait(&(worker->session_logic_cond_var),
+                                  &(worker->session_logic_mutex));
             }
+            __atomic_store_n(&worker->sleeping, false, __ATOMIC_SEQ_CST);
+            worker->session_logic_condition = false;
+            pthread_mutex_unlock(&(worker->session_logic_mutex));
+            continue;
+        }
+
+        if (event->expired_timer_id != TIMER_ID_NOT_SET)
+        {
+            handle_timer_event(event);
+        }
 
-            /* TODO use this as the API to create sessions, etc
-            handle_nbi(session_logic_handle);
-             */
+        if (event->received_msg_list != NULL || event->socket_closed)
+        {
+            handle_socket_comm_event(event);
+        }
 
-            free(event);
-            event = queue_dequeue(session_logic_handle->session_event_queue);
+        if (event->tcp_connect_completed)
+        {
+            handle_tcp_connect_event(event);
         }
 
-        session_logic_handle->session_logic_condition = false;
-        pthread_mutex_unlock(&(session_logic_handle->session_logic_mutex));
+        /* TODO use this as the API to create sessions, etc
+        handle_nbi(session_logic_handle);
+         */
+
+        free_session_event(event);
+        pthread_mutex_unlock(&(worker->session_logic_mutex));
     }
 
-    pcep_log(LOG_NOTICE, "[%ld-%ld] Finished session_logic_loop thread", time(NULL), pthread_self());
+    pcep_log(LOG_NOTICE, "[%ld-%ld] Finished session_logic_loop thread for worker [%d]",
+            time(NULL), pthread_self(), worker->worker_index);
 
     return NULL;
 }
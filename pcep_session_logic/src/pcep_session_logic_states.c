@@ -35,10 +35,6 @@
 #include "pcep_timers.h"
 #include "pcep_utils_logging.h"
 
-
-/* Session Logic Handle managed in pcep_session_logic.c */
-extern pcep_event_queue *session_logic_event_queue_;
-
 /*
  * util functions called by the state handling below
  */
@@ -85,21 +81,59 @@ void send_pcep_error(pcep_session *session, enum pcep_error_type error_type, enu
 
 void reset_dead_timer(pcep_session *session)
 {
+    /* The dead timer is only created here, when it expires it is
+     * re-armed if a message was received since it was set */
+    session->time_last_msg_received_millis = get_timers_monotonic_millis();
     if (session->timer_id_dead_timer == TIMER_ID_NOT_SET)
     {
         pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic set dead timer [%d secs] for session_id [%d]",
                 time(NULL), pthread_self(), session->pce_config.dead_timer_seconds, session->session_id);
-        session->timer_id_dead_timer = create_timer(session->pce_config.dead_timer_seconds, session);
-    }
-    else
-    {
-        pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic reset dead timer [%d secs] for session_id [%d]",
-                time(NULL), pthread_self(), session->pce_config.dead_timer_seconds, session->session_id);
-        reset_timer(session->timer_id_dead_timer);
+        session->timer_id_dead_timer = timers_context_create_timer(
+                session->engine->timers_context, session->pce_config.dead_timer_seconds * 1000, 0, session);
     }
 }
 
 
+/* Internal util function, returns the millis remaining until a timer of
+ * timer_seconds set when the last_time message was sent or received should
+ * expire, or 0 if it has already expired */
+static time_t get_remaining_timer_millis(int timer_seconds, time_t last_time_millis)
+{
+    time_t elapsed_millis = get_timers_monotonic_millis() - last_time_millis;
+    time_t timer_millis = ((time_t) timer_seconds) * 1000;
+
+    return (elapsed_millis < timer_millis) ? (timer_millis - elapsed_millis) : 0;
+}
+
+
+/* The pcep_event's of all the engines are allocated from this pool,
+ * since they are allocated by the session logic workers and freed by
+ * the PCC threads reading the event queue */
+static object_pool_handle *pcep_event_pool_ = NULL;
+static pthread_once_t pcep_event_pool_once_ = PTHREAD_ONCE_INIT;
+
+/* Internal util function, called once to create the pcep_event_pool_ */
+static void initialize_pcep_event_pool()
+{
+    pcep_event_pool_ = object_pool_initialize(
+            sizeof(pcep_event), PCEP_EVENT_POOL_MAX_FREE_EVENTS);
+}
+
+
+void free_pcep_event(pcep_event *event)
+{
+    pthread_once(&pcep_event_pool_once_, initialize_pcep_event_pool);
+    object_pool_free(pcep_event_pool_, event);
+}
+
+
+bool get_pcep_event_pool_counters(object_pool_counters *counters)
+{
+    pthread_once(&pcep_event_pool_once_, initialize_pcep_event_pool);
+    return object_pool_get_counters(pcep_event_pool_, counters);
+}
+
+
 void enqueue_event(pcep_session *session, pcep_event_type event_type, struct pcep_message *message)
 {
     if (event_type == MESSAGE_RECEIVED && message == NULL)
@@ -108,7 +142,8 @@ void enqueue_event(pcep_session *session, pcep_event_type event_type, struct pce
         return;
     }
 
-    pcep_event *event = malloc(sizeof(pcep_event));
+    pthread_once(&pcep_event_pool_once_, initialize_pcep_event_pool);
+    pcep_event *event = object_pool_alloc(pcep_event_pool_);
     bzero(event, sizeof(pcep_event));
 
     event->session = session;
@@ -116,9 +151,10 @@ void enqueue_event(pcep_session *session, pcep_event_type event_type, struct pce
     event->event_time = time(NULL);
     event->message = message;
 
-    pthread_mutex_lock(&session_logic_event_queue_->event_queue_mutex);
-    queue_enqueue(session_logic_event_queue_->event_queue, event);
-    pthread_mutex_unlock(&session_logic_event_queue_->event_queue_mutex);
+    pcep_event_queue *event_queue = session->engine->event_queue;
+    pthread_mutex_lock(&event_queue->event_queue_mutex);
+    queue_enqueue(event_queue->event_queue, event);
+    pthread_mutex_unlock(&event_queue->event_queue_mutex);
 }
 
 /* Verify the received PCEP Open object parameters are acceptable. If not,
@@ -169,12 +205,12 @@ bool verify_pcep_open_object(pcep_session *session, struct pcep_object_open *ope
         return retval;
     }
 
-    double_linked_list_node *tlv_node = open_object->header.tlv_list->head;
-    while (tlv_node != NULL)
+    /* The TLVs cant be deleted while they are iterated */
+    struct pcep_object_tlv_header *lsp_db_version_tlv = NULL;
+    pcep_list_iterator tlv_iter;
+    struct pcep_object_tlv_header *tlv = pcep_obj_first_tlv(&open_object->header, &tlv_iter);
+    for (; tlv != NULL; tlv = pcep_obj_next_tlv(&tlv_iter))
     {
-        struct pcep_object_tlv_header *tlv = tlv_node->data;
-        tlv_node = tlv_node->next_node;
-
         /* Supported Open Object TLVs */
         switch (tlv->type)
         {
@@ -243,13 +279,18 @@ bool verify_pcep_open_object(pcep_session *session, struct pcep_object_open *ope
             if (session->pce_config.support_include_db_version == false)
             {
                 pcep_log(LOG_INFO, "Rejecting unsupported Open LSP DB VERSION TLV");
-                /* Remove this TLV from the list */
-                dll_delete_node(open_object->header.tlv_list, tlv_node);
+                lsp_db_version_tlv = tlv;
                 retval = false;
             }
         }
     }
 
+    /* Remove this TLV from the list */
+    if (lsp_db_version_tlv != NULL)
+    {
+        pcep_obj_delete_tlv(&open_object->header, lsp_db_version_tlv);
+    }
+
     return retval;
 }
 
@@ -278,7 +319,7 @@ bool handle_pcep_open(pcep_session *session, struct pcep_message *open_msg)
     }
 
     struct pcep_object_open *open_object =
-            (struct pcep_object_open *) pcep_obj_get(open_msg->obj_list, PCEP_OBJ_CLASS_OPEN);
+            (struct pcep_object_open *) pcep_msg_get_obj(open_msg, PCEP_OBJ_CLASS_OPEN);
     if (open_object == NULL)
     {
         pcep_log(LOG_INFO, "Received OPEN message with no OPEN object, replying with error");
@@ -287,7 +328,7 @@ bool handle_pcep_open(pcep_session *session, struct pcep_message *open_msg)
     }
 
     /* Check for additional Open Msg objects */
-    if (open_msg->obj_list->num_entries > 1)
+    if (pcep_msg_num_objs(open_msg) > 1)
     {
         pcep_log(LOG_INFO, "Found additional unsupported objects in the Open message, replying with error");
         send_pcep_error(session, PCEP_ERRT_SESSION_FAILURE, PCEP_ERRV_RECVD_INVALID_OPEN_MSG);
@@ -317,9 +358,22 @@ bool handle_pcep_open(pcep_session *session, struct pcep_message *open_msg)
             /* Clone the object here, since the encapsulating message will
              * be deleted in handle_socket_comm_event() most likely before
              * this error message is sent */
-            struct pcep_object_open *cloned_open_object = malloc(sizeof(struct pcep_object_open));
-            memcpy(cloned_open_object, open_object, sizeof(struct pcep_object_open));
-            open_object->header.tlv_list = NULL;
+            struct pcep_object_open *cloned_open_object;
+            if (open_msg->arena == NULL)
+            {
+                cloned_open_object = malloc(sizeof(struct pcep_object_open));
+                memcpy(cloned_open_object, open_object, sizeof(struct pcep_object_open));
+                open_object->header.tlv_list = NULL;
+            }
+            else
+            {
+                /* The TLVs of a message decoded in an arena are released
+                 * with it, so decode the object again outside of the arena,
+                 * and correct it the same way */
+                cloned_open_object = (struct pcep_object_open *)
+                        pcep_decode_object(open_object->header.encoded_object);
+                verify_pcep_open_object(session, cloned_open_object);
+            }
             cloned_open_object->header.encoded_object = NULL;
             cloned_open_object->header.encoded_object_length = 0;
             send_pcep_error_with_object(session, PCEP_ERRT_SESSION_FAILURE,
@@ -345,7 +399,7 @@ void send_reconciled_pcep_open(pcep_session *session, struct pcep_message *error
     struct pcep_message *open_msg = create_pcep_open(session);
 
     struct pcep_object_open *error_open_obj =
-            (struct pcep_object_open *) pcep_obj_get(error_msg->obj_list, PCEP_OBJ_CLASS_OPEN);
+            (struct pcep_object_open *) pcep_msg_get_obj(error_msg, PCEP_OBJ_CLASS_OPEN);
     if (error_open_obj == NULL)
     {
         /* Nothing to reconcile, send the same Open message again */
@@ -355,7 +409,7 @@ void send_reconciled_pcep_open(pcep_session *session, struct pcep_message *error
     }
 
     struct pcep_object_open *open_obj =
-            (struct pcep_object_open *) pcep_obj_get(open_msg->obj_list, PCEP_OBJ_CLASS_OPEN);
+            (struct pcep_object_open *) pcep_msg_get_obj(open_msg, PCEP_OBJ_CLASS_OPEN);
     if (error_open_obj->open_deadtimer >= session->pce_config.min_dead_timer_seconds &&
         error_open_obj->open_deadtimer <= session->pce_config.max_dead_timer_seconds)
     {
@@ -387,7 +441,7 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
     /* Update Message validation and errors according to:
      * https://tools.ietf.org/html/rfc8231#section-6.2 */
 
-    if (upd_msg->obj_list == NULL)
+    if (pcep_msg_num_objs(upd_msg) == 0)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: Message has no objects");
         send_pcep_error(session, PCEP_ERRT_MANDATORY_OBJECT_MISSING,
@@ -396,7 +450,7 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
     }
 
     /* Verify the mandatory objects are present */
-    struct pcep_object_header *obj = pcep_obj_get(upd_msg->obj_list, PCEP_OBJ_CLASS_SRP);
+    struct pcep_object_header *obj = pcep_msg_get_obj(upd_msg, PCEP_OBJ_CLASS_SRP);
     if (obj == NULL)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: Missing SRP object");
@@ -405,7 +459,7 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
         return false;
     }
 
-    obj = pcep_obj_get(upd_msg->obj_list, PCEP_OBJ_CLASS_LSP);
+    obj = pcep_msg_get_obj(upd_msg, PCEP_OBJ_CLASS_LSP);
     if (obj == NULL)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: Missing LSP object");
@@ -414,7 +468,7 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
         return false;
     }
 
-    obj = pcep_obj_get(upd_msg->obj_list, PCEP_OBJ_CLASS_ERO);
+    obj = pcep_msg_get_obj(upd_msg, PCEP_OBJ_CLASS_ERO);
     if (obj == NULL)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: Missing ERO object");
@@ -424,8 +478,8 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
     }
 
     /* Verify the objects are are in the correct order */
-    double_linked_list_node *node = upd_msg->obj_list->head;
-    struct pcep_object_srp *srp_object = (struct pcep_object_srp *) node->data;
+    pcep_list_iterator iter;
+    struct pcep_object_srp *srp_object = (struct pcep_object_srp *) pcep_msg_first_obj(upd_msg, &iter);
     if (srp_object->header.object_class != PCEP_OBJ_CLASS_SRP)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: First object must be an SRP, found [%d]",
@@ -435,8 +489,7 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
         return false;
     }
 
-    node = node->next_node;
-    struct pcep_object_lsp *lsp_object = (struct pcep_object_lsp *) node->data;
+    struct pcep_object_lsp *lsp_object = (struct pcep_object_lsp *) pcep_msg_next_obj(&iter);
     if (lsp_object->header.object_class != PCEP_OBJ_CLASS_LSP)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: Second object must be an LSP, found [%d]",
@@ -446,8 +499,7 @@ bool handle_pcep_update(pcep_session *session, struct pcep_message *upd_msg)
         return false;
     }
 
-    node = node->next_node;
-    struct pcep_object_ro *ero_object = node->data;
+    struct pcep_object_ro *ero_object = (struct pcep_object_ro *) pcep_msg_next_obj(&iter);
     if (ero_object->header.object_class != PCEP_OBJ_CLASS_ERO)
     {
         pcep_log(LOG_INFO, "Invalid PcUpd message: Third object must be an ERO, found [%d]",
@@ -465,7 +517,7 @@ bool handle_pcep_initiate(pcep_session *session, struct pcep_message *init_msg)
     /* Instantiate Message validation and errors according to:
      * https://tools.ietf.org/html/rfc8281#section-5 */
 
-    if (init_msg->obj_list == NULL)
+    if (pcep_msg_num_objs(init_msg) == 0)
     {
         pcep_log(LOG_INFO, "Invalid PcInitiate message: Message has no objects");
         send_pcep_error(session, PCEP_ERRT_MANDATORY_OBJECT_MISSING,
@@ -474,7 +526,7 @@ bool handle_pcep_initiate(pcep_session *session, struct pcep_message *init_msg)
     }
 
     /* Verify the mandatory objects are present */
-    struct pcep_object_header *obj = pcep_obj_get(init_msg->obj_list, PCEP_OBJ_CLASS_SRP);
+    struct pcep_object_header *obj = pcep_msg_get_obj(init_msg, PCEP_OBJ_CLASS_SRP);
     if (obj == NULL)
     {
         pcep_log(LOG_INFO, "Invalid PcInitiate message: Missing SRP object");
@@ -483,7 +535,7 @@ bool handle_pcep_initiate(pcep_session *session, struct pcep_message *init_msg)
         return false;
     }
 
-    obj = pcep_obj_get(init_msg->obj_list, PCEP_OBJ_CLASS_LSP);
+    obj = pcep_msg_get_obj(init_msg, PCEP_OBJ_CLASS_LSP);
     if (obj == NULL)
     {
         pcep_log(LOG_INFO, "Invalid PcInitiate message: Missing LSP object");
@@ -493,8 +545,8 @@ bool handle_pcep_initiate(pcep_session *session, struct pcep_message *init_msg)
     }
 
     /* Verify the objects are are in the correct order */
-    double_linked_list_node *node = init_msg->obj_list->head;
-    struct pcep_object_srp *srp_object = (struct pcep_object_srp *) node->data;
+    pcep_list_iterator iter;
+    struct pcep_object_srp *srp_object = (struct pcep_object_srp *) pcep_msg_first_obj(init_msg, &iter);
     if (srp_object->header.object_class != PCEP_OBJ_CLASS_SRP)
     {
         pcep_log(LOG_INFO, "Invalid PcInitiate message: First object must be an SRP, found [%d]",
@@ -504,8 +556,7 @@ bool handle_pcep_initiate(pcep_session *session, struct pcep_message *init_msg)
         return false;
     }
 
-    node = node->next_node;
-    struct pcep_object_lsp *lsp_object = (struct pcep_object_lsp *) node->data;
+    struct pcep_object_lsp *lsp_object = (struct pcep_object_lsp *) pcep_msg_next_obj(&iter);
     if (lsp_object->header.object_class != PCEP_OBJ_CLASS_LSP)
     {
         pcep_log(LOG_INFO, "Invalid PcInitiate message: Second object must be an LSP, found [%d]",
@@ -580,6 +631,16 @@ void handle_timer_event(pcep_session_event *event)
      */
     if (event->expired_timer_id == session->timer_id_dead_timer)
     {
+        /* Messages were received after the timer was set */
+        time_t remaining_millis = get_remaining_timer_millis(
+                session->pce_config.dead_timer_seconds, session->time_last_msg_received_millis);
+        if (remaining_millis > 0)
+        {
+            session->timer_id_dead_timer = timers_context_create_timer(
+                    session->engine->timers_context, remaining_millis, 0, session);
+            return;
+        }
+
         session->timer_id_dead_timer = TIMER_ID_NOT_SET;
         increment_event_counters(session, PCEP_EVENT_COUNTER_ID_TIMER_DEADTIMER);
         close_pcep_session_with_reason(session, PCEP_CLOSE_REASON_DEADTIMER);
@@ -588,6 +649,19 @@ void handle_timer_event(pcep_session_event *event)
     }
     else if(event->expired_timer_id == session->timer_id_keep_alive)
     {
+        /* Messages were sent after the timer was set. The Keep Alive is
+         * sent anyway if the remaining time is within the jitter */
+        uint32_t jitter_millis = get_timer_jitter_millis(
+                &session->pce_config, session->pce_config.keep_alive_seconds);
+        time_t remaining_millis = get_remaining_timer_millis(
+                session->pce_config.keep_alive_seconds, session->time_last_msg_sent_millis);
+        if (remaining_millis > jitter_millis)
+        {
+            session->timer_id_keep_alive = timers_context_create_timer(
+                    session->engine->timers_context, remaining_millis, jitter_millis, session);
+            return;
+        }
+
         session->timer_id_keep_alive = TIMER_ID_NOT_SET;
         increment_event_counters(session, PCEP_EVENT_COUNTER_ID_TIMER_KEEPALIVE);
         send_keep_alive(session);
@@ -635,6 +709,41 @@ void handle_timer_event(pcep_session_event *event)
 }
 
 
+/* State machine handling for the asynchronous TCP connect completion.
+ * This event was created in session_logic_connect_complete_notifier() in
+ * pcep_session_logic_loop.c */
+void handle_tcp_connect_event(pcep_session_event *event)
+{
+    if (event == NULL)
+    {
+        pcep_log(LOG_INFO, "handle_tcp_connect_event NULL event");
+        return;
+    }
+
+    pcep_session *session = event->session;
+
+    pcep_log(LOG_INFO, "[%ld-%ld] pcep_session_logic handle_tcp_connect_event: session_id [%d] connected [%d]",
+            time(NULL), pthread_self(), session->session_id, event->tcp_connected);
+
+    if (session->session_state != SESSION_STATE_TCP_CONNECTING)
+    {
+        pcep_log(LOG_INFO, "handle_tcp_connect_event unrecognized state transition, state [%d] session_id [%d]",
+                session->session_state, session->session_id);
+        return;
+    }
+
+    if (event->tcp_connected == false)
+    {
+        pcep_log(LOG_INFO, "handle_tcp_connect_event TCP connect failed for session [%d]", session->session_id);
+        session->session_state = SESSION_STATE_INITIALIZED;
+        enqueue_event(session, PCC_CONNECTION_FAILURE, NULL);
+        return;
+    }
+
+    start_pcep_session_open(session);
+}
+
+
 /* State machine handling for received messages.
  * This event was created in session_logic_msg_ready_handler() in
  * pcep_session_logic_loop.c */
@@ -660,7 +769,14 @@ void handle_socket_comm_event(pcep_session_event *event)
     if (event->socket_closed)
     {
         pcep_log(LOG_INFO, "handle_socket_comm_event socket closed for session [%d]", session->session_id);
+        /* The socket_comm_loop stopped reading the socket before notifying
+         * it was closed. The socket_comm_session is only closed, since the
+         * application threads may still use it, it is torn down along with
+         * the session by destroy_pcep_session() */
         socket_comm_session_close_tcp(session->socket_comm_session);
+        pcep_session_cancel_timers(session);
+        pcep_msg_reader_destroy(session->msg_reader);
+        session->msg_reader = NULL;
         enqueue_event(session, PCE_CLOSED_SOCKET, NULL);
         if (session->session_state == SESSION_STATE_PCEP_CONNECTING)
         {
@@ -717,7 +833,7 @@ void handle_socket_comm_event(pcep_session_event *event)
             if (session->session_state == SESSION_STATE_PCEP_CONNECTING)
             {
                 /* PCC Open Message Accepted */
-                cancel_timer(session->timer_id_open_keep_wait);
+                timers_context_cancel_timer(session->engine->timers_context, session->timer_id_open_keep_wait);
                 session->timer_id_open_keep_wait = TIMER_ID_NOT_SET;
                 session->pcc_open_accepted = true;
                 session->pcc_open_rejected = false;
@@ -736,7 +852,7 @@ void handle_socket_comm_event(pcep_session_event *event)
             if (session->session_state == SESSION_STATE_WAIT_PCREQ)
             {
                 session->session_state = SESSION_STATE_IDLE;
-                cancel_timer(session->timer_id_pc_req_wait);
+                timers_context_cancel_timer(session->engine->timers_context, session->timer_id_pc_req_wait);
                 session->timer_id_pc_req_wait = TIMER_ID_NOT_SET;
                 enqueue_event(session, MESSAGE_RECEIVED, msg);
                 message_enqueued = true;
@@ -37,35 +37,53 @@
 #include "pcep_utils_ordered_list.h"
 
 
-extern pcep_session_logic_handle *session_logic_handle_;
 extern int session_id_compare_function(void *list_entry, void *new_entry);
 
+static pcep_engine engine;
+static pcep_session_logic_worker *worker;
+
 /*
  * Test case setup and teardown called before AND after each test.
  */
 
 void pcep_session_logic_loop_test_setup()
 {
-    /* We need to setup the session_logic_handle_ without starting the thread */
-    session_logic_handle_ = malloc(sizeof(pcep_session_logic_handle));
-    bzero(session_logic_handle_, sizeof(pcep_session_logic_handle));
-    session_logic_handle_->active = true;
-    session_logic_handle_->session_logic_condition = false;
-    session_logic_handle_->session_list = ordered_list_initialize(session_id_compare_function);
-    session_logic_handle_->session_event_queue = queue_initialize();
-    pthread_cond_init(&(session_logic_handle_->session_logic_cond_var), NULL);
-    pthread_mutex_init(&(session_logic_handle_->session_logic_mutex), NULL);
+    /* We need to setup the engine session_logic_handle without starting the threads */
+    bzero(&engine, sizeof(pcep_engine));
+    pcep_session_logic_handle *session_logic_handle = malloc(sizeof(pcep_session_logic_handle));
+    bzero(session_logic_handle, sizeof(pcep_session_logic_handle));
+    session_logic_handle->active = true;
+    session_logic_handle->session_list = ordered_list_initialize(session_id_compare_function);
+    session_logic_handle->num_workers = 2;
+    session_logic_handle->workers = malloc(sizeof(pcep_session_logic_worker) * 2);
+    bzero(session_logic_handle->workers, sizeof(pcep_session_logic_worker) * 2);
+    int i;
+    for (i = 0; i < 2; i++)
+    {
+        session_logic_handle->workers[i].worker_index = i;
+        session_logic_handle->workers[i].session_logic_handle = session_logic_handle;
+        mpsc_queue_initialize(&(session_logic_handle->workers[i].event_inbox));
+        pthread_cond_init(&(session_logic_handle->workers[i].session_logic_cond_var), NULL);
+        pthread_mutex_init(&(session_logic_handle->workers[i].session_logic_mutex), NULL);
+    }
+    engine.session_logic_handle = session_logic_handle;
+    worker = &session_logic_handle->workers[0];
 }
 
 
 void pcep_session_logic_loop_test_teardown()
 {
-    ordered_list_destroy(session_logic_handle_->session_list);
-    queue_destroy(session_logic_handle_->session_event_queue);
-    pthread_mutex_unlock(&(session_logic_handle_->session_logic_mutex));
-    pthread_mutex_destroy(&(session_logic_handle_->session_logic_mutex));
-    free(session_logic_handle_);
-    session_logic_handle_ = NULL;
+    pcep_session_logic_handle *session_logic_handle = engine.session_logic_handle;
+    int i;
+    for (i = 0; i < 2; i++)
+    {
+        destroy_session_logic_worker_events(&session_logic_handle->workers[i]);
+        pthread_mutex_destroy(&(session_logic_handle->workers[i].session_logic_mutex));
+    }
+    ordered_list_destroy(session_logic_handle->session_list);
+    free(session_logic_handle->workers);
+    free(session_logic_handle);
+    bzero(&engine, sizeof(pcep_engine));
 }
 
 
@@ -82,9 +100,9 @@ void test_session_logic_loop_null_data()
 
 void test_session_logic_loop_inactive()
 {
-    session_logic_handle_->active = false;
+    engine.session_logic_handle->active = false;
 
-    session_logic_loop(session_logic_handle_);
+    session_logic_loop(worker);
 }
 
 
@@ -93,18 +111,16 @@ void test_session_logic_msg_ready_handler()
     /* Just testing that it does not core dump */
     CU_ASSERT_EQUAL(session_logic_msg_ready_handler(NULL, 0), -1);
 
-    /* Read from an empty file should return 0, thus session_logic_msg_ready_handler returns -1 */
+    /* Read from an empty file should return 0, the socket_comm_loop then
+     * calls the conn_except_notifier, so no event is created here */
     int fd = fileno(tmpfile());
     pcep_session session;
     bzero(&session, sizeof(pcep_session));
     session.session_id = 100;
+    session.engine = &engine;
+    session.session_logic_worker = worker;
     CU_ASSERT_EQUAL(session_logic_msg_ready_handler(&session, fd), 0);
-    CU_ASSERT_EQUAL(session_logic_handle_->session_event_queue->num_entries, 1);
-    pcep_session_event *socket_event =
-            (pcep_session_event *) queue_dequeue(session_logic_handle_->session_event_queue);
-    CU_ASSERT_PTR_NOT_NULL(socket_event);
-    CU_ASSERT_TRUE(socket_event->socket_closed);
-    free(socket_event);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 0);
 
     /* A pcep_session_event should be created */
     struct pcep_versioning *versioning = create_default_pcep_versioning();
@@ -113,17 +129,52 @@ void test_session_logic_msg_ready_handler()
     write(fd, (char *) keep_alive_msg->encoded_message, keep_alive_msg->encoded_message_length);
     lseek(fd, 0, SEEK_SET);
     CU_ASSERT_EQUAL(session_logic_msg_ready_handler(&session, fd), keep_alive_msg->encoded_message_length);
-    CU_ASSERT_EQUAL(session_logic_handle_->session_event_queue->num_entries, 1);
-    socket_event = (pcep_session_event *) queue_dequeue(session_logic_handle_->session_event_queue);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
+    pcep_session_event *socket_event = dequeue_session_logic_event(worker);
     CU_ASSERT_PTR_NOT_NULL(socket_event);
     CU_ASSERT_FALSE(socket_event->socket_closed);
     CU_ASSERT_PTR_EQUAL(socket_event->session, &session);
     CU_ASSERT_EQUAL(socket_event->expired_timer_id, TIMER_ID_NOT_SET);
     CU_ASSERT_PTR_NOT_NULL(socket_event->received_msg_list);
     pcep_msg_free_message_list(socket_event->received_msg_list);
+    free(socket_event);
+
+    /* Only part of a message is available, so no event should be created
+     * until the rest is read, even if its read with a separate call */
+    int pipe_fds[2];
+    CU_ASSERT_EQUAL(pipe(pipe_fds), 0);
+    write(pipe_fds[1], (char *) keep_alive_msg->encoded_message, 2);
+    CU_ASSERT_EQUAL(session_logic_msg_ready_handler(&session, pipe_fds[0]), 2);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 0);
+    write(pipe_fds[1], (char *) keep_alive_msg->encoded_message + 2, keep_alive_msg->encoded_message_length - 2);
+    CU_ASSERT_EQUAL(session_logic_msg_ready_handler(&session, pipe_fds[0]), keep_alive_msg->encoded_message_length - 2);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
+    socket_event = dequeue_session_logic_event(worker);
+    CU_ASSERT_PTR_NOT_NULL(socket_event);
+    CU_ASSERT_PTR_NOT_NULL(socket_event->received_msg_list);
+    CU_ASSERT_EQUAL(socket_event->received_msg_list->num_entries, 1);
+    pcep_msg_free_message_list(socket_event->received_msg_list);
+    free(socket_event);
+
+    /* A message followed by an invalid message header, the message event
+     * is created, and the failure is returned so the socket is closed */
+    uint8_t invalid_hdr[] = {0xe0, 0x01, 0x00, 0x04};
+    write(pipe_fds[1], (char *) keep_alive_msg->encoded_message, keep_alive_msg->encoded_message_length);
+    write(pipe_fds[1], (char *) invalid_hdr, sizeof(invalid_hdr));
+    CU_ASSERT_EQUAL(session_logic_msg_ready_handler(&session, pipe_fds[0]), 0);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
+    socket_event = dequeue_session_logic_event(worker);
+    CU_ASSERT_PTR_NOT_NULL(socket_event);
+    CU_ASSERT_PTR_NOT_NULL(socket_event->received_msg_list);
+    CU_ASSERT_EQUAL(socket_event->received_msg_list->num_entries, 1);
+    pcep_msg_free_message_list(socket_event->received_msg_list);
+    free(socket_event);
+
     pcep_msg_free_message(keep_alive_msg);
     destroy_pcep_versioning(versioning);
-    free(socket_event);
+    pcep_msg_reader_destroy(session.msg_reader);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
     close(fd);
 }
 
@@ -137,10 +188,12 @@ void test_session_logic_conn_except_notifier()
     pcep_session session;
     bzero(&session, sizeof(pcep_session));
     session.session_id = 100;
+    session.engine = &engine;
+    session.session_logic_worker = worker;
     session_logic_conn_except_notifier(&session, 10);
-    CU_ASSERT_EQUAL(session_logic_handle_->session_event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
     pcep_session_event *socket_event =
-            (pcep_session_event *) queue_dequeue(session_logic_handle_->session_event_queue);
+            dequeue_session_logic_event(worker);
     CU_ASSERT_PTR_NOT_NULL_FATAL(socket_event);
     CU_ASSERT_TRUE(socket_event->socket_closed);
     CU_ASSERT_PTR_EQUAL(socket_event->session, &session);
@@ -160,10 +213,17 @@ void test_session_logic_timer_expire_handler()
     pcep_session session;
     bzero(&session, sizeof(pcep_session));
     session.session_id = 100;
+    session.engine = &engine;
+    session.session_logic_worker = worker;
+
+    /* Only a sleeping worker is woken up */
+    worker->sleeping = true;
     session_logic_timer_expire_handler(&session, 42);
-    CU_ASSERT_EQUAL(session_logic_handle_->session_event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
+    CU_ASSERT_FALSE(worker->sleeping);
+    CU_ASSERT_TRUE(worker->session_logic_condition);
     pcep_session_event *socket_event =
-            (pcep_session_event *) queue_dequeue(session_logic_handle_->session_event_queue);
+            dequeue_session_logic_event(worker);
     CU_ASSERT_PTR_NOT_NULL_FATAL(socket_event);
     CU_ASSERT_FALSE(socket_event->socket_closed);
     CU_ASSERT_PTR_EQUAL(socket_event->session, &session);
@@ -172,3 +232,83 @@ void test_session_logic_timer_expire_handler()
 
     free(socket_event);
 }
+
+
+void test_session_logic_timer_expire_batch_handler()
+{
+    pcep_session session1;
+    pcep_session session2;
+    bzero(&session1, sizeof(pcep_session));
+    bzero(&session2, sizeof(pcep_session));
+    session1.engine = &engine;
+    session2.engine = &engine;
+    session1.session_logic_worker = worker;
+    session2.session_logic_worker = worker;
+
+    /* The entry with NULL data is skipped, the rest are enqueued in order */
+    pcep_expired_timer expired_timers[3] = {
+            { &session1, 42 }, { NULL, 43 }, { &session2, 44 } };
+    session_logic_timer_expire_batch_handler(NULL, expired_timers, 3);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 0);
+    session_logic_timer_expire_batch_handler(&engine, expired_timers, 3);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 2);
+    CU_ASSERT_FALSE(mpsc_queue_is_empty(&worker->event_inbox));
+
+    pcep_session_event *timer_event = dequeue_session_logic_event(worker);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(timer_event);
+    CU_ASSERT_PTR_EQUAL(timer_event->session, &session1);
+    CU_ASSERT_EQUAL(timer_event->expired_timer_id, 42);
+    free(timer_event);
+
+    timer_event = dequeue_session_logic_event(worker);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(timer_event);
+    CU_ASSERT_PTR_EQUAL(timer_event->session, &session2);
+    CU_ASSERT_EQUAL(timer_event->expired_timer_id, 44);
+    free(timer_event);
+}
+
+
+void test_steal_session_logic_events()
+{
+    pcep_session_logic_worker *idle_worker = &engine.session_logic_handle->workers[1];
+    pcep_session session1;
+    pcep_session session2;
+    bzero(&session1, sizeof(pcep_session));
+    bzero(&session2, sizeof(pcep_session));
+    session1.engine = &engine;
+    session2.engine = &engine;
+    session1.session_logic_worker = worker;
+    session2.session_logic_worker = worker;
+    worker->num_sessions = 2;
+
+    /* Nothing to steal with only 1 event, or only events of 1 session */
+    CU_ASSERT_FALSE(steal_session_logic_events(idle_worker));
+    pcep_expired_timer expired_timers[3] = {
+            { &session1, 42 }, { &session1, 43 }, { &session2, 44 } };
+    session_logic_timer_expire_batch_handler(&engine, expired_timers, 2);
+    CU_ASSERT_FALSE(steal_session_logic_events(idle_worker));
+    CU_ASSERT_PTR_EQUAL(session1.session_logic_worker, worker);
+
+    /* The session of the next event is stolen, with all of its events in order */
+    session_logic_timer_expire_batch_handler(&engine, &expired_timers[2], 1);
+    CU_ASSERT_TRUE(steal_session_logic_events(idle_worker));
+    CU_ASSERT_PTR_EQUAL(session1.session_logic_worker, idle_worker);
+    CU_ASSERT_PTR_EQUAL(session2.session_logic_worker, worker);
+    CU_ASSERT_EQUAL(worker->num_sessions, 1);
+    CU_ASSERT_EQUAL(idle_worker->num_sessions, 1);
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&worker->event_inbox));
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
+    CU_ASSERT_EQUAL(idle_worker->num_queued_events, 2);
+
+    pcep_session_event *timer_event = dequeue_session_logic_event(idle_worker);
+    CU_ASSERT_EQUAL(timer_event->expired_timer_id, 42);
+    free(timer_event);
+    timer_event = dequeue_session_logic_event(idle_worker);
+    CU_ASSERT_EQUAL(timer_event->expired_timer_id, 43);
+    free(timer_event);
+
+    /* The next events of the stolen session go to its new worker */
+    session_logic_timer_expire_handler(&session1, 45);
+    CU_ASSERT_EQUAL(idle_worker->num_queued_events, 1);
+    CU_ASSERT_EQUAL(worker->num_queued_events, 1);
+}
@@ -37,10 +37,10 @@
 #include "pcep-objects.h"
 #include "pcep-tools.h"
 
-/* Functions being tested */
-extern pcep_session_logic_handle *session_logic_handle_;
-extern pcep_event_queue *session_logic_event_queue_;
+/* Defined in pcep_session_logic_states.c */
+extern void reset_dead_timer(pcep_session *session);
 
+static pcep_engine engine;
 static pcep_session_event event;
 static pcep_session session;
 /* A message list is a dll of struct pcep_messages_list_node items */
@@ -57,14 +57,17 @@ void destroy_message_for_test();
 
 void pcep_session_logic_states_test_setup()
 {
-    session_logic_handle_ = malloc(sizeof(pcep_session_logic_handle));
-    bzero(session_logic_handle_, sizeof(pcep_session_logic_handle));
+    /* Setup the engine without starting the session logic thread */
+    bzero(&engine, sizeof(pcep_engine));
+    engine.session_logic_handle = malloc(sizeof(pcep_session_logic_handle));
+    bzero(engine.session_logic_handle, sizeof(pcep_session_logic_handle));
 
-    session_logic_event_queue_ = malloc(sizeof(pcep_event_queue));
-    bzero(session_logic_event_queue_, sizeof(pcep_event_queue));
-    session_logic_event_queue_->event_queue = queue_initialize();
+    engine.event_queue = malloc(sizeof(pcep_event_queue));
+    bzero(engine.event_queue, sizeof(pcep_event_queue));
+    engine.event_queue->event_queue = queue_initialize();
 
     bzero(&session, sizeof(pcep_session));
+    session.engine = &engine;
     session.pcc_config.keep_alive_seconds = 5;
     session.pcc_config.min_keep_alive_seconds = 1;
     session.pcc_config.max_keep_alive_seconds = 10;
@@ -88,11 +91,10 @@ void pcep_session_logic_states_test_setup()
 void pcep_session_logic_states_test_teardown()
 {
     destroy_message_for_test();
-    free(session_logic_handle_);
-    queue_destroy(session_logic_event_queue_->event_queue);
-    free(session_logic_event_queue_);
-    session_logic_handle_ = NULL;
-    session_logic_event_queue_ = NULL;
+    free(engine.session_logic_handle);
+    queue_destroy(engine.event_queue->event_queue);
+    free(engine.event_queue);
+    bzero(&engine, sizeof(pcep_engine));
     queue_destroy_with_data(session.num_unknown_messages_time_queue);
     teardown_mock_socket_comm_info();
 }
@@ -147,9 +149,9 @@ void test_handle_timer_event_dead_timer()
 
     CU_ASSERT_EQUAL(session.timer_id_dead_timer, TIMER_ID_NOT_SET);
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
 
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCE_DEAD_TIMER_EXPIRED, e->event_type);
     free(e);
 
@@ -168,6 +170,74 @@ void test_handle_timer_event_keep_alive()
 
     CU_ASSERT_EQUAL(session.timer_id_keep_alive, TIMER_ID_NOT_SET);
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
+    /* The Keep Alive should not be queued behind bulk messages */
+    CU_ASSERT_EQUAL(get_mock_socket_comm_info()->last_sent_message_priority, SOCKET_COMM_PRIORITY_CONTROL);
+}
+
+
+void test_handle_timer_event_keep_alive_jitter()
+{
+    /* 50% jitter of the 5 second Keep Alive */
+    session.pce_config.timer_jitter_percent = 50;
+    CU_ASSERT_EQUAL(get_timer_jitter_millis(&session.pce_config, 5), 2500);
+
+    /* A message was sent 3 seconds ago, the 2 seconds remaining are
+     * within the jitter, so the Keep Alive is sent instead of re-armed */
+    session.time_last_msg_sent_millis = get_timers_monotonic_millis() - 3000;
+    event.expired_timer_id = session.timer_id_keep_alive = 200;
+
+    handle_timer_event(&event);
+
+    CU_ASSERT_EQUAL(session.timer_id_keep_alive, TIMER_ID_NOT_SET);
+    verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
+
+    /* The jitter is limited to the whole timer */
+    session.pce_config.timer_jitter_percent = 150;
+    CU_ASSERT_EQUAL(get_timer_jitter_millis(&session.pce_config, 5), 5000);
+    session.pce_config.timer_jitter_percent = 0;
+    CU_ASSERT_EQUAL(get_timer_jitter_millis(&session.pce_config, 5), 0);
+}
+
+
+static void test_timers_context_expire_handler(void *handler_data, pcep_expired_timer *expired_timers, int num_expired_timers)
+{
+}
+
+
+void test_handle_timer_event_rearm()
+{
+    engine.timers_context = create_timers_context(test_timers_context_expire_handler, &engine);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(engine.timers_context);
+
+    /* Messages were sent and received after the timers were set, so the
+     * timers should be re-armed instead of sending a Keep Alive or
+     * closing the session */
+    session.session_state = SESSION_STATE_PCEP_CONNECTED;
+    session.time_last_msg_sent_millis = get_timers_monotonic_millis() - 1000;
+    session.time_last_msg_received_millis = get_timers_monotonic_millis() - 1000;
+
+    event.expired_timer_id = session.timer_id_keep_alive = 200;
+    handle_timer_event(&event);
+    CU_ASSERT_NOT_EQUAL(session.timer_id_keep_alive, TIMER_ID_NOT_SET);
+    CU_ASSERT_NOT_EQUAL(session.timer_id_keep_alive, 200);
+
+    event.expired_timer_id = session.timer_id_dead_timer = 100;
+    handle_timer_event(&event);
+    CU_ASSERT_NOT_EQUAL(session.timer_id_dead_timer, TIMER_ID_NOT_SET);
+    CU_ASSERT_NOT_EQUAL(session.timer_id_dead_timer, 100);
+
+    CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTED);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
+    verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
+
+    /* A received message does not reset the dead timer, it only records the time */
+    int timer_id_dead_timer = session.timer_id_dead_timer;
+    session.time_last_msg_received_millis = 0;
+    reset_dead_timer(&session);
+    CU_ASSERT_EQUAL(session.timer_id_dead_timer, timer_id_dead_timer);
+    CU_ASSERT_TRUE(session.time_last_msg_received_millis > 0);
+
+    CU_ASSERT_TRUE(destroy_timers_context(engine.timers_context));
 }
 
 
@@ -180,10 +250,10 @@ void test_handle_timer_event_open_keep_wait()
 
     CU_ASSERT_EQUAL(session.timer_id_open_keep_wait, TIMER_ID_NOT_SET);
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 1, 0, 0);
 
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCE_OPEN_KEEP_WAIT_TIMER_EXPIRED, e->event_type);
     free(e);
 
@@ -208,10 +278,10 @@ void test_handle_timer_event_pc_req_wait()
 
     CU_ASSERT_EQUAL(session.timer_id_pc_req_wait, TIMER_ID_NOT_SET);
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 1, 1, 0, 0);
 
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCE_OPEN_KEEP_WAIT_TIMER_EXPIRED, e->event_type);
     free(e);
 
@@ -246,10 +316,10 @@ void test_handle_socket_comm_event_close()
     handle_socket_comm_event(&event);
 
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 1, 0);
 
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCE_CLOSED_SOCKET, e->event_type);
     free(e);
 }
@@ -276,8 +346,8 @@ void test_handle_socket_comm_event_open()
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTING);
     /* A keep alive response should be sent, accepting the Open */
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_OPEN, e->message->msg_header->type);
     free(e);
@@ -303,12 +373,12 @@ void test_handle_socket_comm_event_open()
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTED);
     /* A keep alive response should be sent, accepting the Open */
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 2);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 2);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_OPEN, e->message->msg_header->type);
     free(e);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_CONNECTED_TO_PCE, e->event_type);
     free(e);
     destroy_message_for_test();
@@ -323,7 +393,7 @@ void test_handle_socket_comm_event_open()
 
     handle_socket_comm_event(&event);
 
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
     /* What gets saved in the mock is the msg byte buffer. The msg struct was deleted
      * when it was sent. Instead of inspecting the msg byte buffer, lets just decode it. */
@@ -344,6 +414,63 @@ void test_handle_socket_comm_event_open()
 }
 
 
+void test_handle_socket_comm_event_open_in_arena()
+{
+    /* An unacceptable Open with TLVs, decoded in an arena */
+    double_linked_list *tlv_list = dll_initialize();
+    dll_append(tlv_list, pcep_tlv_create_stateful_pce_capability(true, false, false, false, false, false));
+    dll_append(tlv_list, pcep_tlv_create_lsp_db_version(1));
+    struct pcep_message *open_msg = pcep_msg_create_open_with_tlvs(
+            1, session.pcc_config.max_dead_timer_seconds + 1, 1, tlv_list);
+    struct pcep_versioning *versioning = create_default_pcep_versioning();
+    pcep_encode_message(open_msg, versioning);
+    message = pcep_decode_message_in_arena(open_msg->encoded_message);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(message);
+    CU_ASSERT_PTR_NOT_NULL(message->arena);
+    pcep_msg_free_message(open_msg);
+    destroy_pcep_versioning(versioning);
+
+    /* The message is freed when the event is handled */
+    free_msg_list = false;
+    msg_enqueued = false;
+    msg_list = dll_initialize();
+    dll_append(msg_list, message);
+    event.received_msg_list = msg_list;
+    reset_mock_socket_comm_info();
+    mock_socket_comm_info *mock_info = get_mock_socket_comm_info();
+    mock_info->send_message_save_message = true;
+    session.pce_open_received = false;
+    session.pce_open_rejected = false;
+    session.session_state = SESSION_STATE_PCEP_CONNECTING;
+
+    handle_socket_comm_event(&event);
+
+    CU_ASSERT_TRUE(session.pce_open_rejected);
+    verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
+    CU_ASSERT_EQUAL(PCC_RCVD_INVALID_OPEN, e->event_type);
+    free(e);
+
+    /* The corrected Open is sent back after the arena was released,
+     * without the unsupported LSP DB VERSION TLV */
+    uint8_t *encoded_msg = dll_delete_first_node(mock_info->sent_message_list);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(encoded_msg);
+    struct pcep_message *error_msg = pcep_decode_message(encoded_msg);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(error_msg);
+    CU_ASSERT_EQUAL(PCEP_TYPE_ERROR, error_msg->msg_header->type);
+    struct pcep_object_open *open_object =
+            (struct pcep_object_open *) pcep_obj_get(error_msg->obj_list, PCEP_OBJ_CLASS_OPEN);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(open_object);
+    CU_ASSERT_EQUAL(open_object->open_deadtimer, session.pcc_config.max_dead_timer_seconds);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(open_object->header.tlv_list);
+    CU_ASSERT_EQUAL(open_object->header.tlv_list->num_entries, 1);
+    CU_ASSERT_PTR_NOT_NULL(pcep_obj_get_tlv(&open_object->header, PCEP_OBJ_TLV_TYPE_STATEFUL_PCE_CAPABILITY));
+    pcep_msg_free_message(error_msg);
+    free(encoded_msg);
+}
+
+
 void test_handle_socket_comm_event_keep_alive()
 {
     /* Test when a Keep Alive is received, but the PCE Open has not been accepted yet */
@@ -363,7 +490,7 @@ void test_handle_socket_comm_event_keep_alive()
     CU_ASSERT_EQUAL(session.timer_id_open_keep_wait, TIMER_ID_NOT_SET);
     CU_ASSERT_EQUAL(session.timer_id_dead_timer, 100);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
 
     /* Test when a Keep Alive is received, and the PCE Open has been accepted */
     create_message_for_test(PCEP_TYPE_KEEPALIVE, false, false);
@@ -384,7 +511,7 @@ void test_handle_socket_comm_event_keep_alive()
 
     /* The session is considered connected, when both the
      * PCE and PCC Open messages have been accepted */
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_CONNECTED_TO_PCE, e->event_type);
     free(e);
 }
@@ -401,9 +528,9 @@ void test_handle_socket_comm_event_pcrep()
 
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_IDLE);
     CU_ASSERT_EQUAL(session.timer_id_pc_req_wait, TIMER_ID_NOT_SET);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     free(e);
 }
@@ -418,7 +545,7 @@ void test_handle_socket_comm_event_pcreq()
     handle_socket_comm_event(&event);
 
     /* The PCC does not support receiving PcReq messages, so an error should be sent */
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
     uint8_t *encoded_msg = dll_delete_first_node(mock_info->sent_message_list);
     CU_ASSERT_PTR_NOT_NULL(encoded_msg);
@@ -446,7 +573,7 @@ void test_handle_socket_comm_event_report()
     handle_socket_comm_event(&event);
 
     /* The PCC does not support receiving Report messages, so an error should be sent */
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
     uint8_t *encoded_msg = dll_delete_first_node(mock_info->sent_message_list);
     CU_ASSERT_PTR_NOT_NULL(encoded_msg);
@@ -484,9 +611,9 @@ void test_handle_socket_comm_event_update()
 
     handle_socket_comm_event(&event);
 
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_UPDATE, e->message->msg_header->type);
     free(e);
@@ -506,9 +633,9 @@ void test_handle_socket_comm_event_initiate()
 
     handle_socket_comm_event(&event);
 
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_INITIATE, e->message->msg_header->type);
     free(e);
@@ -520,9 +647,9 @@ void test_handle_socket_comm_event_notify()
     create_message_for_test(PCEP_TYPE_PCNOTF, false, true);
     handle_socket_comm_event(&event);
 
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_PCNOTF, e->message->msg_header->type);
     free(e);
@@ -534,9 +661,9 @@ void test_handle_socket_comm_event_error()
     create_message_for_test(PCEP_TYPE_ERROR, false, true);
     handle_socket_comm_event(&event);
 
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_ERROR, e->message->msg_header->type);
     free(e);
@@ -553,7 +680,7 @@ void test_handle_socket_comm_event_unknown_msg()
 
     /* Sending an unsupported message type, so an error should be sent,
      * but the connection should remain open, since max_unknown_messages = 2 */
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
     uint8_t *encoded_msg = dll_delete_first_node(mock_info->sent_message_list);
     CU_ASSERT_PTR_NOT_NULL(encoded_msg);
@@ -580,7 +707,7 @@ void test_handle_socket_comm_event_unknown_msg()
 
     handle_socket_comm_event(&event);
 
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
     verify_socket_comm_times_called(0, 0, 0, 2, 1, 0, 0);
 
     /* Verify the error message */
@@ -641,8 +768,8 @@ void test_connection_failure(void)
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTING);
     /* An error response should be sent, rejecting the Open */
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 1);
-    pcep_event *e = queue_dequeue(session_logic_event_queue_->event_queue);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_RCVD_INVALID_OPEN, e->event_type);
     free(e);
     destroy_message_for_test();
@@ -663,11 +790,11 @@ void test_connection_failure(void)
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
     /* An error response should be sent, rejecting the Open */
     verify_socket_comm_times_called(0, 0, 0, 1, 1, 0, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 2);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 2);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_RCVD_INVALID_OPEN, e->event_type);
     free(e);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_CONNECTION_FAILURE, e->event_type);
     free(e);
 
@@ -692,12 +819,12 @@ void test_connection_failure(void)
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTING);
     /* Another Open should be sent */
     verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 2);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 2);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(MESSAGE_RECEIVED, e->event_type);
     CU_ASSERT_EQUAL(PCEP_TYPE_ERROR, e->message->msg_header->type);
     free(e);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_SENT_INVALID_OPEN, e->event_type);
     free(e);
     destroy_message_for_test();
@@ -714,11 +841,47 @@ void test_connection_failure(void)
     CU_ASSERT_FALSE(session.pcc_open_accepted);
     CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
     verify_socket_comm_times_called(0, 0, 0, 0, 0, 1, 0);
-    CU_ASSERT_EQUAL(session_logic_event_queue_->event_queue->num_entries, 2);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 2);
+    e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCE_CLOSED_SOCKET, e->event_type);
     free(e);
-    e = queue_dequeue(session_logic_event_queue_->event_queue);
+    e = queue_dequeue(engine.event_queue->event_queue);
+    CU_ASSERT_EQUAL(PCC_CONNECTION_FAILURE, e->event_type);
+    free(e);
+}
+
+
+void test_handle_tcp_connect_event(void)
+{
+    /* The asynchronous connect completed, so the PCC Open is sent */
+    session.session_state = SESSION_STATE_TCP_CONNECTING;
+    event.tcp_connect_completed = true;
+    event.tcp_connected = true;
+
+    handle_tcp_connect_event(&event);
+
+    CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTING);
+    verify_socket_comm_times_called(0, 0, 0, 1, 0, 0, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
+
+    /* The connect completion is ignored if the session is not connecting */
+    reset_mock_socket_comm_info();
+    handle_tcp_connect_event(&event);
+    CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_PCEP_CONNECTING);
+    verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 0);
+
+    /* The asynchronous connect failed */
+    reset_mock_socket_comm_info();
+    session.session_state = SESSION_STATE_TCP_CONNECTING;
+    event.tcp_connected = false;
+
+    handle_tcp_connect_event(&event);
+
+    CU_ASSERT_EQUAL(session.session_state, SESSION_STATE_INITIALIZED);
+    verify_socket_comm_times_called(0, 0, 0, 0, 0, 0, 0);
+    CU_ASSERT_EQUAL(engine.event_queue->event_queue->num_entries, 1);
+    pcep_event *e = queue_dequeue(engine.event_queue->event_queue);
     CU_ASSERT_EQUAL(PCC_CONNECTION_FAILURE, e->event_type);
     free(e);
 }
@@ -67,6 +67,86 @@ void test_run_session_logic_twice()
 }
 
 
+void test_run_session_logic_engines()
+{
+    pcep_configuration config;
+    struct in_addr pce_ip;
+
+    CU_ASSERT_FALSE(stop_session_logic_engine(NULL));
+    CU_ASSERT_PTR_NULL(get_default_session_logic_engine());
+    CU_ASSERT_PTR_NULL(get_session_logic_engine_event_queue(NULL));
+
+    /* The engines are independent of each other, and of the default engine */
+    pcep_engine *engine1 = run_session_logic_engine(NULL, NULL);
+    pcep_engine *engine2 = run_session_logic_engine(NULL, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(engine1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(engine2);
+    CU_ASSERT_PTR_NULL(get_default_session_logic_engine());
+    CU_ASSERT_PTR_NOT_NULL(get_session_logic_engine_event_queue(engine1));
+    CU_ASSERT_NOT_EQUAL(get_session_logic_engine_event_queue(engine1),
+                        get_session_logic_engine_event_queue(engine2));
+
+    bzero(&config, sizeof(pcep_configuration));
+    config.keep_alive_seconds = 5;
+    config.dead_timer_seconds = 5;
+    inet_pton(AF_INET, "127.0.0.1", &(pce_ip));
+    CU_ASSERT_PTR_NULL(create_pcep_session(&config, &pce_ip));
+    CU_ASSERT_PTR_NULL(create_pcep_session_in_engine(NULL, &config, &pce_ip));
+
+    /* The session_ids are only unique within each engine */
+    pcep_session *session1 = create_pcep_session_in_engine(engine1, &config, &pce_ip);
+    pcep_session *session2 = create_pcep_session_in_engine(engine2, &config, &pce_ip);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(session1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(session2);
+    CU_ASSERT_PTR_EQUAL(session1->engine, engine1);
+    CU_ASSERT_PTR_EQUAL(session2->engine, engine2);
+    CU_ASSERT_EQUAL(session1->session_id, session2->session_id);
+
+    destroy_pcep_session(session1);
+    destroy_pcep_session(session2);
+    CU_ASSERT_TRUE(stop_session_logic_engine(engine1));
+    CU_ASSERT_TRUE(stop_session_logic_engine(engine2));
+}
+
+
+void test_run_session_logic_workers()
+{
+    pcep_session_logic_config session_logic_config;
+    bzero(&session_logic_config, sizeof(pcep_session_logic_config));
+    session_logic_config.num_worker_threads = MAX_SESSION_LOGIC_WORKERS + 1;
+    CU_ASSERT_FALSE(run_session_logic_with_config(&session_logic_config));
+
+    session_logic_config.num_worker_threads = 3;
+    CU_ASSERT_TRUE(run_session_logic_with_config(&session_logic_config));
+
+    /* The sessions are assigned to the worker with the fewest sessions */
+    pcep_configuration config;
+    bzero(&config, sizeof(pcep_configuration));
+    config.keep_alive_seconds = 5;
+    config.dead_timer_seconds = 5;
+    struct in_addr pce_ip;
+    inet_pton(AF_INET, "127.0.0.1", &(pce_ip));
+    pcep_session *sessions[4];
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        sessions[i] = create_pcep_session(&config, &pce_ip);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(sessions[i]);
+        CU_ASSERT_PTR_NOT_NULL(sessions[i]->session_logic_worker);
+    }
+    CU_ASSERT_NOT_EQUAL(sessions[0]->session_logic_worker, sessions[1]->session_logic_worker);
+    CU_ASSERT_NOT_EQUAL(sessions[1]->session_logic_worker, sessions[2]->session_logic_worker);
+    CU_ASSERT_NOT_EQUAL(sessions[0]->session_logic_worker, sessions[2]->session_logic_worker);
+    CU_ASSERT_EQUAL(sessions[0]->session_logic_worker, sessions[3]->session_logic_worker);
+
+    for (i = 0; i < 4; i++)
+    {
+        destroy_pcep_session(sessions[i]);
+    }
+    CU_ASSERT_TRUE(stop_session_logic());
+}
+
+
 void test_session_logic_without_run()
 {
     /* Verify the functions that depend on run_session_logic() being called */
@@ -91,6 +171,7 @@ void test_create_destroy_pcep_session()
     pcep_configuration config;
     struct in_addr pce_ip;
 
+    CU_ASSERT_TRUE(run_session_logic());
     bzero(&config, sizeof(pcep_configuration));
     config.keep_alive_seconds = 5;
     config.dead_timer_seconds = 5;
@@ -124,6 +205,7 @@ void test_create_destroy_pcep_session_ipv6()
     pcep_configuration config;
     struct in6_addr pce_ip;
 
+    CU_ASSERT_TRUE(run_session_logic());
     bzero(&config, sizeof(pcep_configuration));
     config.keep_alive_seconds = 5;
     config.dead_timer_seconds = 5;
@@ -153,6 +235,34 @@ void test_create_destroy_pcep_session_ipv6()
 }
 
 
+void test_create_destroy_pcep_session_async()
+{
+    pcep_session *session;
+    pcep_configuration config;
+    struct in_addr pce_ip;
+
+    CU_ASSERT_TRUE(run_session_logic());
+    bzero(&config, sizeof(pcep_configuration));
+    config.keep_alive_seconds = 5;
+    config.dead_timer_seconds = 5;
+    config.request_time_seconds = 5;
+    config.max_unknown_messages = 5;
+    config.max_unknown_requests = 5;
+    inet_pton(AF_INET, "127.0.0.1", &(pce_ip));
+
+    /* The Open is not sent until the TCP connect completes */
+    mock_socket_comm_info *mock_info = get_mock_socket_comm_info();
+    session = create_pcep_session_async(&config, &pce_ip);
+    CU_ASSERT_PTR_NOT_NULL(session);
+    CU_ASSERT_EQUAL(session->session_state, SESSION_STATE_TCP_CONNECTING);
+    CU_ASSERT_EQUAL(mock_info->socket_comm_session_connect_tcp_async_times_called, 1);
+    CU_ASSERT_PTR_NOT_NULL(mock_info->connect_complete_notifier);
+    CU_ASSERT_EQUAL(mock_info->socket_comm_session_connect_tcp_times_called, 0);
+    CU_ASSERT_EQUAL(mock_info->socket_comm_session_send_message_times_called, 0);
+    destroy_pcep_session(session);
+}
+
+
 void test_create_pcep_session_open_tlvs()
 {
     pcep_session *session;
@@ -160,7 +270,10 @@ void test_create_pcep_session_open_tlvs()
     struct pcep_message* open_msg;
     struct pcep_object_header *open_obj;
     pcep_configuration config;
+    CU_ASSERT_TRUE(run_session_logic());
     bzero(&config, sizeof(pcep_configuration));
+    /* So the open keep wait timer does not expire during the test */
+    config.keep_alive_seconds = 5;
     config.pcep_msg_versioning = create_default_pcep_versioning();
     inet_pton(AF_INET, "127.0.0.1", &(pce_ip));
 
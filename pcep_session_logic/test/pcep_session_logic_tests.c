@@ -32,10 +32,13 @@ extern void pcep_session_logic_test_setup(void);
 extern void pcep_session_logic_test_teardown(void);
 extern void test_run_stop_session_logic(void);
 extern void test_run_session_logic_twice(void);
+extern void test_run_session_logic_engines(void);
+extern void test_run_session_logic_workers(void);
 extern void test_session_logic_without_run(void);
 extern void test_create_pcep_session_null_params(void);
 extern void test_create_destroy_pcep_session(void);
 extern void test_create_destroy_pcep_session_ipv6(void);
+extern void test_create_destroy_pcep_session_async(void);
 extern void test_create_pcep_session_open_tlvs(void);
 extern void test_destroy_pcep_session_null_session(void);
 
@@ -47,17 +50,22 @@ extern void test_session_logic_loop_inactive(void);
 extern void test_session_logic_msg_ready_handler(void);
 extern void test_session_logic_conn_except_notifier(void);
 extern void test_session_logic_timer_expire_handler(void);
+extern void test_session_logic_timer_expire_batch_handler(void);
+extern void test_steal_session_logic_events(void);
 
 /* Test functions defined in pcep_session_logic_states_test.c */
 extern void pcep_session_logic_states_test_setup(void);
 extern void pcep_session_logic_states_test_teardown(void);
 extern void test_handle_timer_event_dead_timer(void);
 extern void test_handle_timer_event_keep_alive(void);
+extern void test_handle_timer_event_keep_alive_jitter(void);
+extern void test_handle_timer_event_rearm(void);
 extern void test_handle_timer_event_open_keep_wait(void);
 extern void test_handle_timer_event_pc_req_wait(void);
 extern void test_handle_socket_comm_event_null_params(void);
 extern void test_handle_socket_comm_event_close(void);
 extern void test_handle_socket_comm_event_open(void);
+extern void test_handle_socket_comm_event_open_in_arena(void);
 extern void test_handle_socket_comm_event_keep_alive(void);
 extern void test_handle_socket_comm_event_pcrep(void);
 extern void test_handle_socket_comm_event_pcreq(void);
@@ -68,6 +76,7 @@ extern void test_handle_socket_comm_event_notify(void);
 extern void test_handle_socket_comm_event_error(void);
 extern void test_handle_socket_comm_event_unknown_msg(void);
 extern void test_connection_failure(void);
+extern void test_handle_tcp_connect_event(void);
 
 
 int main(int argc, char **argv)
@@ -89,6 +98,12 @@ int main(int argc, char **argv)
     CU_add_test(test_session_logic_suite,
                 "test_run_session_logic_twice",
                 test_run_session_logic_twice);
+    CU_add_test(test_session_logic_suite,
+                "test_run_session_logic_engines",
+                test_run_session_logic_engines);
+    CU_add_test(test_session_logic_suite,
+                "test_run_session_logic_workers",
+                test_run_session_logic_workers);
     CU_add_test(test_session_logic_suite,
                 "test_session_logic_without_run",
                 test_session_logic_without_run);
@@ -101,6 +116,9 @@ int main(int argc, char **argv)
     CU_add_test(test_session_logic_suite,
                 "test_create_destroy_pcep_session_ipv6",
                 test_create_destroy_pcep_session_ipv6);
+    CU_add_test(test_session_logic_suite,
+                "test_create_destroy_pcep_session_async",
+                test_create_destroy_pcep_session_async);
     CU_add_test(test_session_logic_suite,
                 "test_create_pcep_session_open_tlvs",
                 test_create_pcep_session_open_tlvs);
@@ -129,6 +147,12 @@ int main(int argc, char **argv)
     CU_add_test(test_session_logic_loop_suite,
                 "test_session_logic_timer_expire_handler",
                 test_session_logic_timer_expire_handler);
+    CU_add_test(test_session_logic_loop_suite,
+                "test_session_logic_timer_expire_batch_handler",
+                test_session_logic_timer_expire_batch_handler);
+    CU_add_test(test_session_logic_loop_suite,
+                "test_steal_session_logic_events",
+                test_steal_session_logic_events);
 
     CU_pSuite test_session_logic_states_suite = CU_add_suite_with_setup_and_teardown(
             "PCEP Session Logic States Test Suite",
@@ -142,6 +166,12 @@ int main(int argc, char **argv)
     CU_add_test(test_session_logic_states_suite,
                 "test_handle_timer_event_keep_alive",
                 test_handle_timer_event_keep_alive);
+    CU_add_test(test_session_logic_states_suite,
+                "test_handle_timer_event_keep_alive_jitter",
+                test_handle_timer_event_keep_alive_jitter);
+    CU_add_test(test_session_logic_states_suite,
+                "test_handle_timer_event_rearm",
+                test_handle_timer_event_rearm);
     CU_add_test(test_session_logic_states_suite,
                 "test_handle_timer_event_open_keep_wait",
                 test_handle_timer_event_open_keep_wait);
@@ -157,6 +187,9 @@ int main(int argc, char **argv)
     CU_add_test(test_session_logic_states_suite,
                 "test_handle_socket_comm_event_open",
                 test_handle_socket_comm_event_open);
+    CU_add_test(test_session_logic_states_suite,
+                "test_handle_socket_comm_event_open_in_arena",
+                test_handle_socket_comm_event_open_in_arena);
     CU_add_test(test_session_logic_states_suite,
                 "test_handle_socket_comm_event_keep_alive",
                 test_handle_socket_comm_event_keep_alive);
@@ -187,6 +220,9 @@ int main(int argc, char **argv)
     CU_add_test(test_session_logic_states_suite,
                 "test_connection_failure",
                 test_connection_failure);
+    CU_add_test(test_session_logic_states_suite,
+                "test_handle_tcp_connect_event",
+                test_handle_tcp_connect_event);
 
     /*
      * Run the tests and cleanup.
@@ -33,9 +33,78 @@
 #include <arpa/inet.h>  // sockaddr_in
 #include <stdbool.h>
 
+#include "pcep_utils_object_pool.h"
 #include "pcep_utils_queue.h"
 
 #define MAX_RECVD_MSG_SIZE 2048
+/* Default max number of bytes of queued messages written with each writev() */
+#define DEFAULT_MAX_WRITE_BATCH_BYTES 65536
+/* Max number of socket_comm reactor threads */
+#define MAX_SOCKET_COMM_REACTORS 64
+
+/* How the sessions are assigned to the socket_comm reactor threads */
+typedef enum pcep_socket_comm_assign_policy_
+{
+    /* Spread the sessions by a hash of their session_data */
+    SOCKET_COMM_ASSIGN_HASH = 0,
+    /* Assign each session to the reactor with the fewest active sessions */
+    SOCKET_COMM_ASSIGN_LEAST_LOADED = 1
+
+} pcep_socket_comm_assign_policy;
+
+/* The I/O backend used by the socket_comm reactor threads */
+typedef enum pcep_socket_comm_backend_
+{
+    /* epoll, or select if built with PCEP_SOCKET_COMM_USE_SELECT */
+    SOCKET_COMM_BACKEND_DEFAULT = 0,
+    /* io_uring if supported by the kernel, else the default backend */
+    SOCKET_COMM_BACKEND_IO_URING = 1
+
+} pcep_socket_comm_backend;
+
+/* A zeroed pcep_socket_comm_config uses 1 reactor thread, which
+ * is not pinned, with the default backend */
+typedef struct pcep_socket_comm_config_
+{
+    /* Number of socket_comm reactor threads, each with its own
+     * poller and mutex, 0 is the same as 1 */
+    int num_reactor_threads;
+    pcep_socket_comm_assign_policy assign_policy;
+    /* If set, each reactor thread is pinned to its reactor_cpus entry */
+    bool pin_reactor_threads;
+    int reactor_cpus[MAX_SOCKET_COMM_REACTORS];
+    pcep_socket_comm_backend backend;
+
+} pcep_socket_comm_config;
+
+/* The queued messages are written in priority order, the control messages
+ * like Keepalives and Closes are written before the queued bulk messages,
+ * but never before a message that has already been partially written. */
+typedef enum pcep_socket_comm_priority_
+{
+    SOCKET_COMM_PRIORITY_CONTROL = 0,
+    SOCKET_COMM_PRIORITY_BULK = 1
+
+} pcep_socket_comm_priority;
+
+/* An encoded message that can be queued to several sessions, so the same
+ * message only has to be encoded and stored once to be sent to all of them.
+ * Each session it is queued to holds a reference, released once the message
+ * is written or the session is torn down. The message is freed along with
+ * the last reference. */
+typedef struct pcep_socket_comm_shared_message_
+{
+    char *unmarshalled_message;
+    unsigned int msg_length;
+    int ref_count;
+
+} pcep_socket_comm_shared_message;
+
+struct pcep_socket_comm_handle_;
+/* A set of socket_comm reactor threads, created with create_socket_comm_reactors().
+ * The socket_comm_session_initialize() functions without a socket_comm reactors
+ * parameter use the reactors started by initialize_socket_comm_loop_with_config(). */
+struct pcep_socket_comm_reactors_;
 
 /*
  * A socket_comm_session can be initialized with 1 of 2 types of mutually exclusive
@@ -53,10 +122,17 @@ typedef void (*message_received_handler)(void *session_data, char *message_data,
 /* message ready received handler that should read the message on socket_fd
  * and return the number of bytes read */
 typedef int (*message_ready_to_read_handler)(void *session_data, int socket_fd);
-/* callback handler called when a messages is sent */
-typedef void (*message_sent_notifier)(void *session_data, int socket_fd);
+/* callback handler called when a messages is sent, socket_closed is set if the
+ * socket was closed after writing all the queued messages, as requested with
+ * socket_comm_session_close_tcp_after_write(). The socket_comm_session may be
+ * torn down by another thread while this is called, so the handler should
+ * not access it. */
+typedef void (*message_sent_notifier)(void *session_data, int socket_fd, bool socket_closed);
 /* callback handler called when the socket is closed */
 typedef void (*connection_except_notifier)(void *session_data, int socket_fd);
+/* callback handler called when an asynchronous TCP connect completes,
+ * connected is false if the connect failed or timed-out */
+typedef void (*connection_complete_notifier)(void *session_data, int socket_fd, bool connected);
 
 typedef struct pcep_socket_comm_session_
 {
@@ -80,6 +156,49 @@ typedef struct pcep_socket_comm_session_
     char received_message[MAX_RECVD_MSG_SIZE];
     int received_bytes;
     bool close_after_write;
+    /* Set once the socket is closed, either locally or by the peer, the
+     * messages sent after that are dropped instead of being queued */
+    bool closed;
+    /* Set while the socket_comm_loop is waiting for the socket to be readable or writable */
+    bool read_interest;
+    bool write_interest;
+    /* The reactor this session is assigned to, and the key that
+     * identifies the session in that reactor registry */
+    struct pcep_socket_comm_handle_ *socket_comm_handle;
+    uint64_t registry_key;
+    /* Intrusive list links, only used by the select() and io_uring socket_comm_loop */
+    struct pcep_socket_comm_session_ *read_list_prev;
+    struct pcep_socket_comm_session_ *read_list_next;
+    struct pcep_socket_comm_session_ *write_list_prev;
+    struct pcep_socket_comm_session_ *write_list_next;
+    /* The queued messages are written in batches of at most this many bytes,
+     * initialized to DEFAULT_MAX_WRITE_BATCH_BYTES */
+    unsigned int max_write_batch_bytes;
+    /* Number of bytes of the message at the head of the message_queue
+     * already written, when the socket could only take part of it */
+    unsigned int flushed_bytes;
+    /* Counters to check how many messages are written per syscall */
+    uint64_t num_write_syscalls;
+    uint64_t num_messages_written;
+    /* Number of writes the socket could not completely take, and the
+     * number of queued bytes not yet written */
+    uint64_t num_partial_writes;
+    uint64_t num_bytes_pending;
+    /* Only used by the io_uring backend: set while the session is in the
+     * socket_comm_handle read_list or write_list waiting to be submitted,
+     * and the batch of messages being written while write_in_flight */
+    bool read_submit_pending;
+    bool write_submit_pending;
+    bool write_in_flight;
+    struct iovec *write_iov;
+    int write_iov_count;
+    /* Set while an asynchronous TCP connect is waiting for the socket to be
+     * writable, the connect fails if it does not complete by the deadline */
+    connection_complete_notifier connect_complete_notifier;
+    bool connect_in_progress;
+    uint64_t connect_deadline_millis;
+    struct pcep_socket_comm_session_ *connect_list_prev;
+    struct pcep_socket_comm_session_ *connect_list_next;
 
 } pcep_socket_comm_session;
 
@@ -134,26 +253,104 @@ socket_comm_session_initialize_with_src_ipv6(message_received_handler msg_rcv_ha
                             uint32_t connect_timeout_millis,
                             void *session_data);
 
+/* Same as socket_comm_session_initialize_with_src(), with the session assigned
+ * to one of the socket_comm_reactors instead of the default reactors */
+pcep_socket_comm_session *
+socket_comm_session_initialize_with_reactors(struct pcep_socket_comm_reactors_ *socket_comm_reactors,
+                            message_received_handler msg_rcv_handler,
+                            message_ready_to_read_handler msg_ready_handler,
+                            message_sent_notifier msg_sent_notifier,
+                            connection_except_notifier notifier,
+                            struct in_addr *src_ip,
+                            short src_port,
+                            struct in_addr *dst_ip,
+                            short dst_port,
+                            uint32_t connect_timeout_millis,
+                            void *session_data);
+
+pcep_socket_comm_session *
+socket_comm_session_initialize_with_reactors_ipv6(struct pcep_socket_comm_reactors_ *socket_comm_reactors,
+                            message_received_handler msg_rcv_handler,
+                            message_ready_to_read_handler msg_ready_handler,
+                            message_sent_notifier msg_sent_notifier,
+                            connection_except_notifier notifier,
+                            struct in6_addr *src_ip,
+                            short src_port,
+                            struct in6_addr *dst_ip,
+                            short dst_port,
+                            uint32_t connect_timeout_millis,
+                            void *session_data);
+
 bool socket_comm_session_teardown(pcep_socket_comm_session *socket_comm_session);
 
 bool socket_comm_session_connect_tcp(pcep_socket_comm_session *socket_comm_session);
 
+/* Start the TCP connect without blocking, the socket_comm_loop will call the
+ * notifier once the connect completes, fails, or the connect_timeout_millis
+ * expires. Returns false, without calling the notifier, if the connect could
+ * not be started. */
+bool socket_comm_session_connect_tcp_async(pcep_socket_comm_session *socket_comm_session,
+                                           connection_complete_notifier notifier);
+
 /* Immediately close the TCP connection, irregardless if there are pending
  * messages to be sent. */
 bool socket_comm_session_close_tcp(pcep_socket_comm_session *socket_comm_session);
 
 /* Sets a flag to close the TCP connection either after all the pending messages
  * are written, or if there are no pending messages, the next time the socket is
- * checked to be writeable. */
+ * checked to be writeable. Returns false if the socket is already closed, in
+ * which case the message_sent_notifier will not be called. */
 bool socket_comm_session_close_tcp_after_write(pcep_socket_comm_session *socket_comm_session);
 
-void socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_session,
+/* The message is queued with SOCKET_COMM_PRIORITY_BULK. Returns false if the
+ * message could not be queued, because the socket_comm_session is NULL or its
+ * socket is closed, in which case it is freed if free_after_send is set. */
+bool socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_session,
                                   char *unmarshalled_message,
                                   unsigned int msg_length,
                                   bool free_after_send);
 
+bool socket_comm_session_send_message_with_priority(pcep_socket_comm_session *socket_comm_session,
+                                                    char *unmarshalled_message,
+                                                    unsigned int msg_length,
+                                                    bool free_after_send,
+                                                    pcep_socket_comm_priority priority);
+
+/* Takes ownership of the unmarshalled_message, which will be freed with the
+ * shared message. The shared message is returned with 1 reference, owned by
+ * the caller, which must release it with socket_comm_shared_message_unref()
+ * once it has been queued to all the sessions. */
+pcep_socket_comm_shared_message *socket_comm_shared_message_create(char *unmarshalled_message,
+                                                                   unsigned int msg_length);
+void socket_comm_shared_message_ref(pcep_socket_comm_shared_message *shared_message);
+void socket_comm_shared_message_unref(pcep_socket_comm_shared_message *shared_message);
+
+/* Queue the shared message, taking a reference on it, which is released
+ * once the message is written or the session is torn down. Returns false,
+ * without taking a reference, if the message could not be queued. */
+bool socket_comm_session_send_shared_message(pcep_socket_comm_session *socket_comm_session,
+                                             pcep_socket_comm_shared_message *shared_message,
+                                             pcep_socket_comm_priority priority);
+
+/* the socket comm loop is started internally by socket_comm_session_initialize()
+ * with 1 reactor thread. To use more reactor threads, this must be called
+ * before any session is initialized. */
+bool initialize_socket_comm_loop_with_config(pcep_socket_comm_config *config);
+
 /* the socket comm loop is started internally by socket_comm_session_initialize()
  * but needs to be explicitly stopped with this call. */
 bool destroy_socket_comm_loop();
 
+/* Start a set of socket_comm reactor threads, independent of the default
+ * reactors and of any other set of reactors. Returns NULL on error. */
+struct pcep_socket_comm_reactors_ *create_socket_comm_reactors(pcep_socket_comm_config *config);
+
+/* Stop the socket_comm reactor threads, the sessions assigned to
+ * them should have already been torn down. */
+bool destroy_socket_comm_reactors(struct pcep_socket_comm_reactors_ *socket_comm_reactors);
+
+/* The messages queued to be sent are allocated from a pool shared by all
+ * the sessions, these are its hit and miss counters */
+bool socket_comm_get_queued_message_pool_counters(object_pool_counters *counters);
+
 #endif /* INCLUDE_PCEPSOCKETCOMM_H_ */
@@ -33,6 +33,7 @@
 
 #include <stdbool.h>
 
+#include "pcep_socket_comm.h"
 #include "pcep_utils_double_linked_list.h"
 
 typedef struct mock_socket_comm_info_
@@ -41,6 +42,7 @@ typedef struct mock_socket_comm_info_
     int socket_comm_session_initialize_src_times_called;
     int socket_comm_session_teardown_times_called;
     int socket_comm_session_connect_tcp_times_called;
+    int socket_comm_session_connect_tcp_async_times_called;
     int socket_comm_session_send_message_times_called;
     int socket_comm_session_close_tcp_after_write_times_called;
     int socket_comm_session_close_tcp_times_called;
@@ -52,6 +54,11 @@ typedef struct mock_socket_comm_info_
     /* Used to access messages sent with socket_comm_session_send_message() */
     bool send_message_save_message;
     double_linked_list *sent_message_list;
+    pcep_socket_comm_priority last_sent_message_priority;
+
+    /* The notifier passed to socket_comm_session_connect_tcp_async(), which
+     * the tests call to simulate the connect completing or failing */
+    connection_complete_notifier connect_complete_notifier;
 
 } mock_socket_comm_info;
 
@@ -28,10 +28,15 @@
  */
 
 
+/* Needed for pthread_setaffinity_np() */
+#define _GNU_SOURCE
+
 #include <errno.h>
 #include <fcntl.h>
 #include <malloc.h>
 #include <netdb.h> // gethostbyname
+#include <pthread.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <string.h>
 #include <strings.h>
@@ -44,73 +49,222 @@
 #include "pcep_socket_comm.h"
 #include "pcep_socket_comm_internals.h"
 #include "pcep_utils_logging.h"
-#include "pcep_utils_ordered_list.h"
 #include "pcep_utils_queue.h"
 
 
-pcep_socket_comm_handle *socket_comm_handle_ = NULL;
+/* The socket_comm reactors used by the socket_comm_session_initialize()
+ * functions without a socket_comm reactors parameter */
+pcep_socket_comm_reactors *socket_comm_reactors_ = NULL;
+
+
+/* Internal util function, create a reactor and start its socket_comm_loop thread */
+static pcep_socket_comm_handle *initialize_socket_comm_reactor(int reactor_index, pcep_socket_comm_backend backend)
+{
+    pcep_socket_comm_handle *socket_comm_handle = malloc(sizeof(pcep_socket_comm_handle));
+    bzero(socket_comm_handle, sizeof(pcep_socket_comm_handle));
+
+    socket_comm_handle->active = true;
+    socket_comm_handle->reactor_index = reactor_index;
+    socket_comm_handle->num_active_sessions = 0;
+    socket_comm_handle->backend = backend;
+    socket_comm_registry_initialize(&(socket_comm_handle->session_registry));
+
+    if (!socket_comm_poller_initialize(socket_comm_handle))
+    {
+        pcep_log(LOG_ERR, "Cannot initialize socket_comm poller.");
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&(socket_comm_handle->socket_comm_mutex), NULL) != 0)
+    {
+        pcep_log(LOG_ERR, "Cannot initialize socket_comm mutex.");
+        return NULL;
+    }
+
+    if(pthread_create(&(socket_comm_handle->socket_comm_thread), NULL, socket_comm_loop, socket_comm_handle))
+    {
+        pcep_log(LOG_ERR, "Cannot initialize socket_comm thread.");
+        return NULL;
+    }
+
+    return socket_comm_handle;
+}
 
 
-/* simple compare method callback used by pcep_utils_ordered_list
- * for ordered list insertion. */
-int socket_fd_node_compare(void *list_entry, void *new_entry)
+/* Internal util function, stop the reactor socket_comm_loop thread and free the reactor */
+static void destroy_socket_comm_reactor(pcep_socket_comm_handle *socket_comm_handle)
 {
-    return ((pcep_socket_comm_session *) new_entry)->socket_fd - ((pcep_socket_comm_session *) list_entry)->socket_fd;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    socket_comm_handle->active = false;
+    socket_comm_wakeup_loop(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    pthread_join(socket_comm_handle->socket_comm_thread, NULL);
+    socket_comm_poller_destroy(socket_comm_handle);
+    socket_comm_registry_destroy(&(socket_comm_handle->session_registry));
+    pthread_mutex_destroy(&(socket_comm_handle->socket_comm_mutex));
+
+    free(socket_comm_handle);
 }
 
 
 bool initialize_socket_comm_loop()
 {
-    if (socket_comm_handle_ != NULL)
+    pcep_socket_comm_config config;
+    bzero(&config, sizeof(pcep_socket_comm_config));
+
+    return initialize_socket_comm_loop_with_config(&config);
+}
+
+
+pcep_socket_comm_reactors *create_socket_comm_reactors(pcep_socket_comm_config *config)
+{
+    if (config == NULL)
     {
-        /* already initialized */
-        return true;
+        pcep_log(LOG_WARNING, "Cannot initialize socket_comm_loop with NULL config");
+        return NULL;
     }
 
-    socket_comm_handle_ = malloc(sizeof(pcep_socket_comm_handle));
-    bzero(socket_comm_handle_, sizeof(pcep_socket_comm_handle));
+    int num_reactors = (config->num_reactor_threads <= 0 ? 1 : config->num_reactor_threads);
+    if (num_reactors > MAX_SOCKET_COMM_REACTORS)
+    {
+        pcep_log(LOG_WARNING, "Cannot initialize [%d] socket_comm reactors, the max is [%d]",
+                num_reactors, MAX_SOCKET_COMM_REACTORS);
+        return NULL;
+    }
 
-    socket_comm_handle_->active = true;
-    socket_comm_handle_->num_active_sessions = 0;
-    socket_comm_handle_->read_list = ordered_list_initialize(socket_fd_node_compare);
-    socket_comm_handle_->write_list = ordered_list_initialize(socket_fd_node_compare);
-    socket_comm_handle_->session_list = ordered_list_initialize(pointer_compare_function);
+    pcep_socket_comm_reactors *socket_comm_reactors = malloc(sizeof(pcep_socket_comm_reactors));
+    bzero(socket_comm_reactors, sizeof(pcep_socket_comm_reactors));
+    socket_comm_reactors->assign_policy = config->assign_policy;
+    socket_comm_reactors->reactors = malloc(sizeof(pcep_socket_comm_handle *) * num_reactors);
 
-    if (pthread_mutex_init(&(socket_comm_handle_->socket_comm_mutex), NULL) != 0)
+    int i;
+    for (i = 0; i < num_reactors; i++)
     {
-        pcep_log(LOG_ERR, "Cannot initialize socket_comm mutex.");
-        return false;
+        pcep_socket_comm_handle *socket_comm_handle = initialize_socket_comm_reactor(i, config->backend);
+        if (socket_comm_handle == NULL)
+        {
+            pcep_log(LOG_ERR, "Cannot initialize socket_comm reactor [%d].", i);
+            destroy_socket_comm_reactors(socket_comm_reactors);
+            return NULL;
+        }
+        socket_comm_reactors->reactors[i] = socket_comm_handle;
+        socket_comm_reactors->num_reactors++;
+
+        if (config->pin_reactor_threads)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(config->reactor_cpus[i], &cpu_set);
+            int result = pthread_setaffinity_np(socket_comm_handle->socket_comm_thread, sizeof(cpu_set_t), &cpu_set);
+            if (result != 0)
+            {
+                /* Not fatal, the reactor will just run on any CPU */
+                pcep_log(LOG_WARNING, "Cannot pin socket_comm reactor [%d] to CPU [%d] error [%d %s].",
+                        i, config->reactor_cpus[i], result, strerror(result));
+            }
+        }
     }
 
-    if(pthread_create(&(socket_comm_handle_->socket_comm_thread), NULL, socket_comm_loop, socket_comm_handle_))
+    return socket_comm_reactors;
+}
+
+
+bool destroy_socket_comm_reactors(pcep_socket_comm_reactors *socket_comm_reactors)
+{
+    if (socket_comm_reactors == NULL)
     {
-        pcep_log(LOG_ERR, "Cannot initialize socket_comm thread.");
+        pcep_log(LOG_WARNING, "Cannot destroy NULL socket_comm reactors");
         return false;
     }
 
+    int i;
+    for (i = 0; i < socket_comm_reactors->num_reactors; i++)
+    {
+        destroy_socket_comm_reactor(socket_comm_reactors->reactors[i]);
+    }
+
+    free(socket_comm_reactors->reactors);
+    free(socket_comm_reactors);
+
     return true;
 }
 
 
-bool destroy_socket_comm_loop()
+bool initialize_socket_comm_loop_with_config(pcep_socket_comm_config *config)
 {
-    socket_comm_handle_->active = false;
+    if (socket_comm_reactors_ != NULL)
+    {
+        /* already initialized */
+        return true;
+    }
+
+    socket_comm_reactors_ = create_socket_comm_reactors(config);
+
+    return (socket_comm_reactors_ != NULL);
+}
 
-    pthread_join(socket_comm_handle_->socket_comm_thread, NULL);
-    ordered_list_destroy(socket_comm_handle_->read_list);
-    ordered_list_destroy(socket_comm_handle_->write_list);
-    ordered_list_destroy(socket_comm_handle_->session_list);
-    pthread_mutex_destroy(&(socket_comm_handle_->socket_comm_mutex));
 
-    free(socket_comm_handle_);
-    socket_comm_handle_ = NULL;
+bool destroy_socket_comm_loop()
+{
+    if (socket_comm_reactors_ == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot destroy socket_comm_loop, it is not initialized");
+        return false;
+    }
+
+    destroy_socket_comm_reactors(socket_comm_reactors_);
+    socket_comm_reactors_ = NULL;
 
     return true;
 }
 
+
+/* Internal util function, choose the reactor a new session will be assigned to */
+static pcep_socket_comm_handle *assign_socket_comm_reactor(pcep_socket_comm_reactors *socket_comm_reactors,
+                                                           void *session_data)
+{
+    if (socket_comm_reactors->num_reactors == 1)
+    {
+        return socket_comm_reactors->reactors[0];
+    }
+
+    if (socket_comm_reactors->assign_policy == SOCKET_COMM_ASSIGN_LEAST_LOADED)
+    {
+        pcep_socket_comm_handle *least_loaded = NULL;
+        int least_num_sessions = 0;
+        int i;
+        for (i = 0; i < socket_comm_reactors->num_reactors; i++)
+        {
+            pcep_socket_comm_handle *socket_comm_handle = socket_comm_reactors->reactors[i];
+            pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+            int num_sessions = socket_comm_handle->num_active_sessions;
+            pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+            if (least_loaded == NULL || num_sessions < least_num_sessions)
+            {
+                least_loaded = socket_comm_handle;
+                least_num_sessions = num_sessions;
+            }
+        }
+
+        return least_loaded;
+    }
+
+    /* SOCKET_COMM_ASSIGN_HASH, the session_data pointer is mixed, since
+     * the low bits of allocated pointers are usually the same */
+    uint64_t hash = (uintptr_t) session_data;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    return socket_comm_reactors->reactors[hash % socket_comm_reactors->num_reactors];
+}
+
 /* Internal common init function */
 static pcep_socket_comm_session *
-socket_comm_session_initialize_pre(message_received_handler message_handler,
+socket_comm_session_initialize_pre(pcep_socket_comm_reactors *socket_comm_reactors,
+                            message_received_handler message_handler,
                             message_ready_to_read_handler message_ready_handler,
                             message_sent_notifier msg_sent_notifier,
                             connection_except_notifier notifier,
@@ -131,10 +285,9 @@ socket_comm_session_initialize_pre(message_received_handler message_handler,
         return NULL;
     }
 
-    if (!initialize_socket_comm_loop())
+    if (socket_comm_reactors == NULL)
     {
-        pcep_log(LOG_WARNING, "ERROR: cannot initialize socket_comm_loop.");
-
+        pcep_log(LOG_WARNING, "Cannot initialize a socket_comm_session with NULL socket_comm reactors.");
         return NULL;
     }
 
@@ -143,6 +296,12 @@ socket_comm_session_initialize_pre(message_received_handler message_handler,
     pcep_socket_comm_session *socket_comm_session = malloc(sizeof(pcep_socket_comm_session));
     bzero(socket_comm_session, sizeof(pcep_socket_comm_session));
 
+    pcep_socket_comm_handle *socket_comm_handle = assign_socket_comm_reactor(socket_comm_reactors, session_data);
+    socket_comm_session->socket_comm_handle = socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    socket_comm_handle->num_active_sessions++;
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
     socket_comm_session->socket_fd = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (socket_comm_session->socket_fd == -1) {
         pcep_log(LOG_WARNING, "Cannot create socket errno [%d %s].", errno, strerror(errno));
@@ -151,7 +310,6 @@ socket_comm_session_initialize_pre(message_received_handler message_handler,
         return NULL;//NOLINT(clang-analyzer-unix.Malloc)
     }
 
-    socket_comm_handle_->num_active_sessions++;
     socket_comm_session->close_after_write = false;
     socket_comm_session->session_data = session_data;
     socket_comm_session->message_handler = message_handler;
@@ -160,6 +318,7 @@ socket_comm_session_initialize_pre(message_received_handler message_handler,
     socket_comm_session->conn_except_notifier = notifier;
     socket_comm_session->message_queue = queue_initialize();
     socket_comm_session->connect_timeout_millis = connect_timeout_millis;
+    socket_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
 
     return socket_comm_session;
 }
@@ -194,10 +353,11 @@ bool socket_comm_session_initialize_post(pcep_socket_comm_session *socket_comm_s
         return false;
     }
 
-    /* Register the session as active with the Socket Comm Loop */
-    pthread_mutex_lock(&(socket_comm_handle_->socket_comm_mutex));
-    ordered_list_add_node(socket_comm_handle_->session_list, socket_comm_session);
-    pthread_mutex_unlock(&(socket_comm_handle_->socket_comm_mutex));
+    /* Register the session as active with its Socket Comm Loop reactor */
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    socket_comm_registry_add(&(socket_comm_handle->session_registry), socket_comm_session);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
 
     /* dont connect to the destination yet, since the PCE will have a timer
      * for max time between TCP connect and PCEP open. we'll connect later
@@ -249,6 +409,32 @@ socket_comm_session_initialize_with_src(message_received_handler message_handler
                             short dest_port,
                             uint32_t connect_timeout_millis,
                             void *session_data)
+{
+    if (!initialize_socket_comm_loop())
+    {
+        pcep_log(LOG_WARNING, "ERROR: cannot initialize socket_comm_loop.");
+
+        return NULL;
+    }
+
+    return socket_comm_session_initialize_with_reactors(socket_comm_reactors_,
+            message_handler, message_ready_handler, msg_sent_notifier, notifier,
+            src_ip, src_port, dest_ip, dest_port, connect_timeout_millis, session_data);
+}
+
+
+pcep_socket_comm_session *
+socket_comm_session_initialize_with_reactors(pcep_socket_comm_reactors *socket_comm_reactors,
+                            message_received_handler message_handler,
+                            message_ready_to_read_handler message_ready_handler,
+                            message_sent_notifier msg_sent_notifier,
+                            connection_except_notifier notifier,
+                            struct in_addr *src_ip,
+                            short src_port,
+                            struct in_addr *dest_ip,
+                            short dest_port,
+                            uint32_t connect_timeout_millis,
+                            void *session_data)
 {
     if (dest_ip == NULL)
     {
@@ -257,7 +443,8 @@ socket_comm_session_initialize_with_src(message_received_handler message_handler
     }
 
     pcep_socket_comm_session *socket_comm_session =
-            socket_comm_session_initialize_pre(message_handler,
+            socket_comm_session_initialize_pre(socket_comm_reactors,
+                    message_handler,
                     message_ready_handler,
                     msg_sent_notifier,
                     notifier,
@@ -310,6 +497,32 @@ socket_comm_session_initialize_with_src_ipv6(message_received_handler message_ha
                             short dest_port,
                             uint32_t connect_timeout_millis,
                             void *session_data)
+{
+    if (!initialize_socket_comm_loop())
+    {
+        pcep_log(LOG_WARNING, "ERROR: cannot initialize socket_comm_loop.");
+
+        return NULL;
+    }
+
+    return socket_comm_session_initialize_with_reactors_ipv6(socket_comm_reactors_,
+            message_handler, message_ready_handler, msg_sent_notifier, notifier,
+            src_ip, src_port, dest_ip, dest_port, connect_timeout_millis, session_data);
+}
+
+
+pcep_socket_comm_session *
+socket_comm_session_initialize_with_reactors_ipv6(pcep_socket_comm_reactors *socket_comm_reactors,
+                            message_received_handler message_handler,
+                            message_ready_to_read_handler message_ready_handler,
+                            message_sent_notifier msg_sent_notifier,
+                            connection_except_notifier notifier,
+                            struct in6_addr *src_ip,
+                            short src_port,
+                            struct in6_addr *dest_ip,
+                            short dest_port,
+                            uint32_t connect_timeout_millis,
+                            void *session_data)
 {
     if (dest_ip == NULL)
     {
@@ -318,7 +531,8 @@ socket_comm_session_initialize_with_src_ipv6(message_received_handler message_ha
     }
 
     pcep_socket_comm_session *socket_comm_session =
-            socket_comm_session_initialize_pre(message_handler,
+            socket_comm_session_initialize_pre(socket_comm_reactors,
+                    message_handler,
                     message_ready_handler,
                     msg_sent_notifier,
                     notifier,
@@ -361,27 +575,23 @@ socket_comm_session_initialize_with_src_ipv6(message_received_handler message_ha
 }
 
 
-bool socket_comm_session_connect_tcp(pcep_socket_comm_session *socket_comm_session)
+/* Internal util function, set the socket to non-blocking and start the TCP
+ * connect, returns the connect() result, with errno set if its negative */
+static int start_comm_session_connect(pcep_socket_comm_session *socket_comm_session)
 {
-    if (socket_comm_session == NULL)
-    {
-        pcep_log(LOG_WARNING, "socket_comm_session_connect_tcp NULL socket_comm_session.");
-        return NULL;
-    }
-
     /* Set the socket to non-blocking, so connect() does not block */
     int fcntl_arg;
     if ((fcntl_arg = fcntl(socket_comm_session->socket_fd, F_GETFL, NULL)) < 0 )
     {
         pcep_log(LOG_WARNING, "Error fcntl(..., F_GETFL) [%d %s]", errno, strerror(errno));
-        return false;
+        return -1;
     }
 
     fcntl_arg |= O_NONBLOCK;
     if (fcntl(socket_comm_session->socket_fd, F_SETFL, fcntl_arg) < 0)
     {
         pcep_log(LOG_WARNING, "Error fcntl(..., F_SETFL) [%d %s]", errno, strerror(errno));
-        return false;
+        return -1;
     }
 
     int connect_result = 0;
@@ -398,6 +608,19 @@ bool socket_comm_session_connect_tcp(pcep_socket_comm_session *socket_comm_sessi
                 sizeof(socket_comm_session->dest_sock_addr.dest_sock_addr_ipv4));
     }
 
+    return connect_result;
+}
+
+
+bool socket_comm_session_connect_tcp(pcep_socket_comm_session *socket_comm_session)
+{
+    if (socket_comm_session == NULL)
+    {
+        pcep_log(LOG_WARNING, "socket_comm_session_connect_tcp NULL socket_comm_session.");
+        return NULL;
+    }
+
+    int connect_result = start_comm_session_connect(socket_comm_session);
     if (connect_result < 0)
     {
         if (errno == EINPROGRESS)
@@ -447,10 +670,46 @@ bool socket_comm_session_connect_tcp(pcep_socket_comm_session *socket_comm_sessi
         }
     }
 
-    pthread_mutex_lock(&(socket_comm_handle_->socket_comm_mutex));
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
     /* once the TCP connection is open, we should be ready to read at any time */
-    ordered_list_add_node(socket_comm_handle_->read_list, socket_comm_session);
-    pthread_mutex_unlock(&(socket_comm_handle_->socket_comm_mutex));
+    socket_comm_add_read_interest(socket_comm_handle, socket_comm_session);
+    socket_comm_wakeup_loop(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    return true;
+}
+
+
+bool socket_comm_session_connect_tcp_async(pcep_socket_comm_session *socket_comm_session,
+                                           connection_complete_notifier notifier)
+{
+    if (socket_comm_session == NULL)
+    {
+        pcep_log(LOG_WARNING, "socket_comm_session_connect_tcp_async NULL socket_comm_session.");
+        return false;
+    }
+
+    int connect_result = start_comm_session_connect(socket_comm_session);
+    if (connect_result < 0 && errno != EINPROGRESS)
+    {
+        pcep_log(LOG_WARNING, "TCP connect, error connecting on socket_fd [%d] errno [%d %s]",
+                socket_comm_session->socket_fd, errno, strerror(errno));
+        return false;
+    }
+
+    /* Even if the connect already completed, its reported from the
+     * socket_comm_loop, so the notifier is always called the same way */
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    socket_comm_session->connect_complete_notifier = notifier;
+    socket_comm_session->connect_in_progress = true;
+    socket_comm_session->connect_deadline_millis =
+            socket_comm_get_monotonic_millis() + socket_comm_session->connect_timeout_millis;
+    socket_comm_connect_list_add(socket_comm_handle, socket_comm_session);
+    socket_comm_add_connect_interest(socket_comm_handle, socket_comm_session);
+    socket_comm_wakeup_loop(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
 
     return true;
 }
@@ -464,12 +723,18 @@ bool socket_comm_session_close_tcp(pcep_socket_comm_session *socket_comm_session
         return false;
     }
 
-    pthread_mutex_lock(&(socket_comm_handle_->socket_comm_mutex));
-    ordered_list_remove_first_node_equals(socket_comm_handle_->read_list, socket_comm_session);
-    ordered_list_remove_first_node_equals(socket_comm_handle_->write_list, socket_comm_session);
-    // TODO should it be close() or shutdown()??
-    close(socket_comm_session->socket_fd);
-    pthread_mutex_unlock(&(socket_comm_handle_->socket_comm_mutex));
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    socket_comm_remove_interest(socket_comm_handle, socket_comm_session);
+    /* The socket_fd may have already been closed after writing */
+    if (!socket_comm_session->closed)
+    {
+        // TODO should it be close() or shutdown()??
+        close(socket_comm_session->socket_fd);
+        socket_comm_session->closed = true;
+    }
+    socket_comm_wakeup_loop(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
 
     return true;
 }
@@ -483,9 +748,23 @@ bool socket_comm_session_close_tcp_after_write(pcep_socket_comm_session *socket_
         return false;
     }
 
-    pthread_mutex_lock(&(socket_comm_handle_->socket_comm_mutex));
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    if (socket_comm_session->closed)
+    {
+        /* The message_sent_notifier wont be called for a closed socket */
+        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+        return false;
+    }
+
     socket_comm_session->close_after_write = true;
-    pthread_mutex_unlock(&(socket_comm_handle_->socket_comm_mutex));
+    /* The socket will be closed the next time it is checked to be writeable */
+    if (!socket_comm_session->write_interest)
+    {
+        socket_comm_set_write_interest(socket_comm_handle, socket_comm_session, true);
+        socket_comm_wakeup_loop(socket_comm_handle);
+    }
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
 
     return true;
 }
@@ -493,41 +772,54 @@ bool socket_comm_session_close_tcp_after_write(pcep_socket_comm_session *socket_
 
 bool socket_comm_session_teardown(pcep_socket_comm_session *socket_comm_session)
 {
-    if (socket_comm_handle_ == NULL)
+    if (socket_comm_session == NULL)
     {
-        pcep_log(LOG_WARNING, "Cannot teardown NULL socket_comm_handle");
+        pcep_log(LOG_WARNING, "Cannot teardown NULL session");
         return false;
     }
 
-    if (socket_comm_session == NULL)
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    if (socket_comm_handle == NULL)
     {
-        pcep_log(LOG_WARNING, "Cannot teardown NULL session");
+        pcep_log(LOG_WARNING, "Cannot teardown NULL socket_comm_handle");
         return false;
     }
 
-    if (socket_comm_session->socket_fd > 0)
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    /* Must be removed from the poller before the socket_fd is closed, and
+     * before the queued messages are freed, since io_uring may be writing them */
+    socket_comm_remove_interest(socket_comm_handle, socket_comm_session);
+    /* free any messages that could not be written */
+    pcep_socket_comm_queued_message *queued_message;
+    while (socket_comm_session->message_queue != NULL &&
+            (queued_message = queue_dequeue(socket_comm_session->message_queue)) != NULL)
+    {
+        free_queued_message(queued_message);
+    }
+    queue_destroy(socket_comm_session->message_queue);
+    free(socket_comm_session->write_iov);
+    socket_comm_registry_remove(&(socket_comm_handle->session_registry), socket_comm_session);
+    int num_active_sessions = --socket_comm_handle->num_active_sessions;
+    bool closed = socket_comm_session->closed;
+    socket_comm_wakeup_loop(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    /* The socket_fd number may have been reused since it was closed */
+    if (!closed && socket_comm_session->socket_fd > 0)
     {
         shutdown(socket_comm_session->socket_fd, SHUT_RDWR);
         close(socket_comm_session->socket_fd);
     }
 
-    pthread_mutex_lock(&(socket_comm_handle_->socket_comm_mutex));
-    queue_destroy(socket_comm_session->message_queue);
-    ordered_list_remove_first_node_equals(socket_comm_handle_->session_list, socket_comm_session);
-    ordered_list_remove_first_node_equals(socket_comm_handle_->read_list, socket_comm_session);
-    ordered_list_remove_first_node_equals(socket_comm_handle_->write_list, socket_comm_session);
-    socket_comm_handle_->num_active_sessions--;
-    pthread_mutex_unlock(&(socket_comm_handle_->socket_comm_mutex));
-
     pcep_log(LOG_INFO, "[%ld-%ld] socket_comm_session [%d] destroyed, [%d] sessions remaining",
             time(NULL), pthread_self(),
             socket_comm_session->socket_fd,
-            socket_comm_handle_->num_active_sessions);
+            num_active_sessions);
 
     free(socket_comm_session);
 
     /* It would be nice to call destroy_socket_comm_loop() here if
-     * socket_comm_handle_->num_active_sessions == 0, but this function
+     * there are no active sessions left, but this function
      * will usually be called from the message_sent_notifier callback,
      * which gets called in the middle of the socket_comm_loop, and that
      * is dangerous, so destroy_socket_comm_loop() must be called upon
@@ -537,24 +829,176 @@ bool socket_comm_session_teardown(pcep_socket_comm_session *socket_comm_session)
 }
 
 
-void socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_session,
+/* Internal util function, returns the queue node the message with the
+ * priority should be inserted after, or NULL to insert it at the head.
+ * Must be called with the socket_comm_mutex locked. */
+static queue_node *get_priority_insert_node(pcep_socket_comm_session *socket_comm_session,
+                                            pcep_socket_comm_priority priority)
+{
+    queue_handle *message_queue = socket_comm_session->message_queue;
+    if (priority == SOCKET_COMM_PRIORITY_BULK)
+    {
+        return message_queue->tail;
+    }
+
+    /* The messages being written cant be overtaken: the batch in flight with
+     * io_uring, or the head message if it was partially written */
+    int num_pinned_messages = 0;
+    if (socket_comm_session->write_in_flight)
+    {
+        num_pinned_messages = socket_comm_session->write_iov_count;
+    }
+    else if (socket_comm_session->flushed_bytes > 0)
+    {
+        num_pinned_messages = 1;
+    }
+
+    queue_node *prev_node = NULL;
+    queue_node *node = message_queue->head;
+    for (; node != NULL && num_pinned_messages > 0; num_pinned_messages--)
+    {
+        prev_node = node;
+        node = node->next_node;
+    }
+
+    /* The control messages are kept in the order they were sent */
+    while (node != NULL &&
+            ((pcep_socket_comm_queued_message *) node->data)->priority == SOCKET_COMM_PRIORITY_CONTROL)
+    {
+        prev_node = node;
+        node = node->next_node;
+    }
+
+    return prev_node;
+}
+
+
+bool socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_session,
                                       char *message,
                                       unsigned int msg_length,
                                       bool free_after_send)
+{
+    return socket_comm_session_send_message_with_priority(
+            socket_comm_session, message, msg_length, free_after_send, SOCKET_COMM_PRIORITY_BULK);
+}
+
+
+/* Internal util function to queue the message to be written by the socket_comm_loop,
+ * returns false if the session is closed, in which case the message is freed */
+static bool enqueue_message(pcep_socket_comm_session *socket_comm_session,
+                            pcep_socket_comm_queued_message *queued_message)
+{
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_session->socket_comm_handle;
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    if (socket_comm_session->closed)
+    {
+        /* The socket_comm_loop no longer writes to this socket, which
+         * may be torn down at any time, so the message is dropped */
+        pcep_log(LOG_INFO, "socket_comm_session [%d] is closed, dropping message of length [%d]",
+                socket_comm_session->socket_fd, queued_message->msg_length);
+        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+        free_queued_message(queued_message);
+        return false;
+    }
+
+    queue_enqueue_after(socket_comm_session->message_queue,
+            get_priority_insert_node(socket_comm_session, queued_message->priority), queued_message);
+    socket_comm_session->num_bytes_pending += queued_message->msg_length;
+    /* Only the first message queued since the last write needs to wake up
+     * the socket_comm_loop, the rest will be written along with it */
+    if (!socket_comm_session->write_interest)
+    {
+        socket_comm_set_write_interest(socket_comm_handle, socket_comm_session, true);
+        socket_comm_wakeup_loop(socket_comm_handle);
+    }
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    return true;
+}
+
+
+bool socket_comm_session_send_message_with_priority(pcep_socket_comm_session *socket_comm_session,
+                                                    char *message,
+                                                    unsigned int msg_length,
+                                                    bool free_after_send,
+                                                    pcep_socket_comm_priority priority)
 {
     if (socket_comm_session == NULL)
     {
         pcep_log(LOG_WARNING, "socket_comm_session_send_message NULL socket_comm_session.");
-        return;
+        if (free_after_send)
+        {
+            free(message);
+        }
+        return false;
     }
 
-    pcep_socket_comm_queued_message *queued_message = malloc(sizeof(pcep_socket_comm_queued_message));
+    pcep_socket_comm_queued_message *queued_message = alloc_queued_message();
     queued_message->unmarshalled_message = message;
     queued_message->msg_length = msg_length;
     queued_message->free_after_send = free_after_send;
+    queued_message->priority = priority;
+    queued_message->shared_message = NULL;
+
+    return enqueue_message(socket_comm_session, queued_message);
+}
+
+
+pcep_socket_comm_shared_message *socket_comm_shared_message_create(char *unmarshalled_message,
+                                                                   unsigned int msg_length)
+{
+    if (unmarshalled_message == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot create a shared message with a NULL message");
+        return NULL;
+    }
+
+    pcep_socket_comm_shared_message *shared_message = malloc(sizeof(pcep_socket_comm_shared_message));
+    bzero(shared_message, sizeof(pcep_socket_comm_shared_message));
+    shared_message->unmarshalled_message = unmarshalled_message;
+    shared_message->msg_length = msg_length;
+    shared_message->ref_count = 1;
+
+    return shared_message;
+}
+
+
+void socket_comm_shared_message_ref(pcep_socket_comm_shared_message *shared_message)
+{
+    __atomic_fetch_add(&shared_message->ref_count, 1, __ATOMIC_RELAXED);
+}
+
+
+void socket_comm_shared_message_unref(pcep_socket_comm_shared_message *shared_message)
+{
+    /* The last reference may be released by any of the socket_comm_loop
+     * threads writing the message, or by the thread that created it */
+    if (__atomic_sub_fetch(&shared_message->ref_count, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        free(shared_message->unmarshalled_message);
+        free(shared_message);
+    }
+}
+
+
+bool socket_comm_session_send_shared_message(pcep_socket_comm_session *socket_comm_session,
+                                             pcep_socket_comm_shared_message *shared_message,
+                                             pcep_socket_comm_priority priority)
+{
+    if (socket_comm_session == NULL || shared_message == NULL)
+    {
+        pcep_log(LOG_WARNING, "socket_comm_session_send_shared_message NULL parameters.");
+        return false;
+    }
+
+    socket_comm_shared_message_ref(shared_message);
+
+    pcep_socket_comm_queued_message *queued_message = alloc_queued_message();
+    queued_message->unmarshalled_message = shared_message->unmarshalled_message;
+    queued_message->msg_length = shared_message->msg_length;
+    queued_message->free_after_send = false;
+    queued_message->priority = priority;
+    queued_message->shared_message = shared_message;
 
-    pthread_mutex_lock(&(socket_comm_handle_->socket_comm_mutex));
-    queue_enqueue(socket_comm_session->message_queue, queued_message);
-    ordered_list_add_node(socket_comm_handle_->write_list, socket_comm_session);
-    pthread_mutex_unlock(&(socket_comm_handle_->socket_comm_mutex));
+    return enqueue_message(socket_comm_session, queued_message);
 }
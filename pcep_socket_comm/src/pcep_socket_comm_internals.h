@@ -26,41 +26,268 @@
 #ifndef SRC_PCEPSOCKETCOMMINTERNALS_H_
 #define SRC_PCEPSOCKETCOMMINTERNALS_H_
 
+#include <limits.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/* The socket_comm loop uses epoll by default, which has no limit on the
+ * socket_fd values and only reports the sessions that are ready. Define
+ * PCEP_SOCKET_COMM_USE_SELECT at compile time to fall back to select(),
+ * which is limited to socket_fd values less than FD_SETSIZE. */
+#if !defined(PCEP_SOCKET_COMM_USE_SELECT) && !defined(__linux__)
+#define PCEP_SOCKET_COMM_USE_SELECT
+#endif
+
+#ifdef PCEP_SOCKET_COMM_USE_SELECT
+#include <sys/select.h>
+#else
+#include <sys/epoll.h>
+#include <linux/io_uring.h>
+/* The io_uring backend needs the kernel headers to support multishot recv,
+ * and can then be selected at runtime with the pcep_socket_comm_config */
+#ifdef IORING_RECV_MULTISHOT
+#define PCEP_SOCKET_COMM_HAVE_IO_URING
+#endif
+#endif
 
-#include "pcep_utils_ordered_list.h"
 #include "pcep_socket_comm.h"
 
+/* Max number of ready sessions handled by each socket_comm_loop iteration */
+#ifdef PCEP_SOCKET_COMM_USE_SELECT
+/* With select, a session may be ready to both read and write */
+#define MAX_SOCKET_COMM_READY_EVENTS (2 * FD_SETSIZE)
+#else
+#define MAX_SOCKET_COMM_READY_EVENTS 256
+#endif
+
+/* Max number of queued messages written with each writev() call */
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define MAX_WRITE_BATCH_IOVECS IOV_MAX
+#else
+#define MAX_WRITE_BATCH_IOVECS 1024
+#endif
+
+/* Max number of bytes read from a session with a message_handler each time
+ * the poller reports it as readable, whats left is read in the next
+ * socket_comm_loop iteration, since the socket is still reported as readable */
+#define SOCKET_COMM_READ_BUDGET 65536
+
+/* The ready_flags of a pcep_socket_comm_ready_event */
+#define SOCKET_COMM_READY_READ  0x01
+#define SOCKET_COMM_READY_WRITE 0x02
+/* io_uring received data in a provided buffer */
+#define SOCKET_COMM_READY_RECV  0x04
+
+/* The registry_key used for the wakeup fd, which never matches a session */
+#define SOCKET_COMM_WAKEUP_KEY UINT64_MAX
+
+#define REGISTRY_NO_SLOT UINT32_MAX
+
+/* The queued messages pool keeps at most this many free messages per shard */
+#define QUEUED_MESSAGE_POOL_MAX_FREE_MESSAGES 1024
+
+
+typedef struct pcep_socket_comm_registry_entry_
+{
+    pcep_socket_comm_session *session;
+    uint32_t generation;
+    uint32_t next_free_slot;
+
+} pcep_socket_comm_registry_entry;
+
+
+/* Registry of the active sessions, implemented in pcep_socket_comm_registry.c.
+ * All operations are O(1), sessions are found either by pointer with the
+ * hash_buckets, or by registry_key with the entries slots. */
+typedef struct pcep_socket_comm_registry_
+{
+    pcep_socket_comm_registry_entry *entries;
+    uint32_t num_entries_allocated;
+    uint32_t free_slot_head;
+    uint32_t next_generation;
+    /* Open addressing hash of the registered session pointers */
+    pcep_socket_comm_session **hash_buckets;
+    uint32_t hash_size;
+    uint32_t num_sessions;
 
+} pcep_socket_comm_registry;
+
+
+/* A session the poller reported as ready, referred to by its registry_key,
+ * since the session may be destroyed before the event is handled */
+typedef struct pcep_socket_comm_ready_event_
+{
+    uint64_t registry_key;
+    uint32_t ready_flags;
+    /* Only used by the io_uring backend, the result of the completed
+     * recv or write, and the provided buffer the data was received in */
+    int32_t result;
+    uint16_t buffer_id;
+
+} pcep_socket_comm_ready_event;
+
+struct pcep_socket_comm_io_uring_;
+
+
+/* Each socket_comm reactor thread has its own pcep_socket_comm_handle, with
+ * its own poller, session registry and mutex, so the sessions assigned to
+ * different reactors never contend with each other. */
 typedef struct pcep_socket_comm_handle_
 {
     bool active;
+    int reactor_index;
     pthread_t socket_comm_thread;
     pthread_mutex_t socket_comm_mutex;
+    /* intrusive lists linked with the session read_list_prev/next and
+     * write_list_prev/next. With select these are the sessions to read
+     * from and write to, with io_uring these are the sessions waiting for
+     * a recv or write to be submitted. Not used with epoll. */
+    pcep_socket_comm_session *read_list_head;
+    pcep_socket_comm_session *write_list_head;
+    /* The sessions with an asynchronous TCP connect in progress, linked
+     * with the session connect_list_prev/next, checked for timeouts */
+    pcep_socket_comm_session *connect_list_head;
+    /* The backend actually used, io_uring falls back to epoll
+     * if its not supported by the kernel or by the build */
+    pcep_socket_comm_backend backend;
+#ifdef PCEP_SOCKET_COMM_USE_SELECT
     fd_set read_master_set;
     fd_set write_master_set;
     fd_set except_master_set;
-    /* ordered_list of socket_descriptors to read from */
-    ordered_list_handle *read_list;
-    /* ordered_list of socket_descriptors to write to */
-    ordered_list_handle *write_list;
-    ordered_list_handle *session_list;
+#else
+    int epoll_fd;
+    /* The epoll_event data.u64 is the session registry_key */
+    struct epoll_event epoll_events[MAX_SOCKET_COMM_READY_EVENTS];
+    struct pcep_socket_comm_io_uring_ *io_uring;
+#endif
+    /* The sessions reported as ready by the last wait_for_ready_sessions() */
+    pcep_socket_comm_ready_event ready_events[MAX_SOCKET_COMM_READY_EVENTS];
+    int num_ready_events;
+    /* Used to wake up the socket_comm_loop when it is blocked waiting for
+     * the sessions to be ready. With epoll both fds are the same eventfd,
+     * with select they are the read and write ends of a pipe. */
+    int wakeup_read_fd;
+    int wakeup_write_fd;
+    /* Set when the wakeup fd has been written and not yet drained, so
+     * consecutive wakeups only cost one write() */
+    bool wakeup_pending;
+    pcep_socket_comm_registry session_registry;
     int num_active_sessions;
+    /* Number of syscalls used to wait for the sessions to be ready,
+     * and to read from the sessions with a message_handler */
+    uint64_t num_poller_syscalls;
+    uint64_t num_read_syscalls;
 
 } pcep_socket_comm_handle;
 
 
+/* The socket_comm reactors, created by create_socket_comm_reactors() */
+typedef struct pcep_socket_comm_reactors_
+{
+    pcep_socket_comm_handle **reactors;
+    int num_reactors;
+    pcep_socket_comm_assign_policy assign_policy;
+
+} pcep_socket_comm_reactors;
+
+
 typedef struct pcep_socket_comm_queued_message_
 {
     char *unmarshalled_message;
     int msg_length;
     bool free_after_send;
+    pcep_socket_comm_priority priority;
+    /* Set if the unmarshalled_message belongs to a shared message, which
+     * is unreferenced instead of freeing the unmarshalled_message */
+    pcep_socket_comm_shared_message *shared_message;
 
 } pcep_socket_comm_queued_message;
 
 
+/* Functions implemented in pcep_socket_comm_registry.c, these must be
+ * called with the socket_comm_mutex locked. */
+bool socket_comm_registry_initialize(pcep_socket_comm_registry *registry);
+void socket_comm_registry_destroy(pcep_socket_comm_registry *registry);
+bool socket_comm_registry_add(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session);
+bool socket_comm_registry_remove(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session);
+/* Check if the session is registered, without dereferencing it */
+bool socket_comm_registry_contains(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session);
+/* Returns NULL if the session with the registry_key has been removed */
+pcep_socket_comm_session *socket_comm_registry_find(pcep_socket_comm_registry *registry, uint64_t registry_key);
+
 /* Functions implemented in pcep_socket_comm_loop.c */
 void *socket_comm_loop(void *data);
+/* The queued messages are allocated from a pool */
+pcep_socket_comm_queued_message *alloc_queued_message();
+void free_queued_message(pcep_socket_comm_queued_message *queued_message);
+void handle_read_result(pcep_socket_comm_handle *socket_comm_handle,
+                        pcep_socket_comm_session *comm_session,
+                        uint64_t registry_key,
+                        int received_bytes);
+int build_write_batch(pcep_socket_comm_session *comm_session, struct iovec *iov, int max_iovecs);
+bool complete_write_batch(pcep_socket_comm_session *comm_session, struct iovec *iov, int iov_count, ssize_t bytes_sent);
+void finish_comm_session_writes(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+/* The intrusive read_list and write_list, these must be
+ * called with the socket_comm_mutex locked. */
+void socket_comm_read_list_add(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+void socket_comm_read_list_remove(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+void socket_comm_write_list_add(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+void socket_comm_write_list_remove(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+void socket_comm_connect_list_add(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+void socket_comm_connect_list_remove(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session);
+/* Returns the CLOCK_MONOTONIC time used for the connect deadlines */
+uint64_t socket_comm_get_monotonic_millis();
+/* Check the asynchronous TCP connects that completed or timed-out,
+ * these must be called with the socket_comm_mutex locked. */
+void finish_comm_session_connect(pcep_socket_comm_handle *socket_comm_handle,
+                                 pcep_socket_comm_session *comm_session,
+                                 bool timed_out);
+void handle_connect_timeouts(pcep_socket_comm_handle *socket_comm_handle);
+
+/* Functions to register the socket_fd interest with the poller used
+ * by the socket_comm_loop. These must be called with the
+ * socket_comm_mutex locked. */
+bool socket_comm_poller_initialize(pcep_socket_comm_handle *socket_comm_handle);
+void socket_comm_poller_destroy(pcep_socket_comm_handle *socket_comm_handle);
+void socket_comm_add_read_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                   pcep_socket_comm_session *socket_comm_session);
+void socket_comm_set_write_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                    pcep_socket_comm_session *socket_comm_session,
+                                    bool write_interest);
+/* Wait for an asynchronous TCP connect to complete, the socket_fd must not
+ * have any other interest registered */
+void socket_comm_add_connect_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                      pcep_socket_comm_session *socket_comm_session);
+void socket_comm_remove_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                 pcep_socket_comm_session *socket_comm_session);
+/* Wake up the socket_comm_loop so the sessions and their interests are
+ * checked immediately. This must be called with the socket_comm_mutex locked. */
+void socket_comm_wakeup_loop(pcep_socket_comm_handle *socket_comm_handle);
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+/* Functions implemented in pcep_socket_comm_io_uring.c, used by the
+ * poller functions when the io_uring backend is selected. These must
+ * be called with the socket_comm_mutex locked, except for
+ * socket_comm_io_uring_wait_for_ready_sessions() and
+ * socket_comm_io_uring_handle_recv(). */
+bool socket_comm_io_uring_initialize(pcep_socket_comm_handle *socket_comm_handle);
+void socket_comm_io_uring_destroy(pcep_socket_comm_handle *socket_comm_handle);
+void socket_comm_io_uring_add_read_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                            pcep_socket_comm_session *socket_comm_session);
+void socket_comm_io_uring_set_write_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                             pcep_socket_comm_session *socket_comm_session,
+                                             bool write_interest);
+void socket_comm_io_uring_remove_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                          pcep_socket_comm_session *socket_comm_session);
+void socket_comm_io_uring_wait_for_ready_sessions(pcep_socket_comm_handle *socket_comm_handle, int timeout_millis);
+void socket_comm_io_uring_handle_recv(pcep_socket_comm_handle *socket_comm_handle,
+                                      pcep_socket_comm_ready_event *ready_event);
+void socket_comm_io_uring_write_completed(pcep_socket_comm_handle *socket_comm_handle,
+                                          pcep_socket_comm_session *socket_comm_session,
+                                          pcep_socket_comm_ready_event *ready_event);
+#endif
 
 #endif /* SRC_PCEPSOCKETCOMMINTERNALS_H_ */
@@ -0,0 +1,790 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+/*
+ *  io_uring backend for the socket_comm_loop.
+ *
+ *  Instead of waiting for the sockets to be ready and then reading and
+ *  writing them with 1 syscall each, the reads and writes are submitted
+ *  to io_uring, and the socket_comm_loop only waits for their completions,
+ *  so each loop iteration only needs 1 or 2 io_uring_enter() syscalls:
+ *  - sessions with a message_handler use a multishot recv, which receives
+ *    the data into a provided buffer ring without any read() syscall.
+ *  - sessions with a message_ready_to_read_handler read the socket
+ *    themselves, so a one-shot poll is used and re-armed after each read.
+ *  - the queued messages are written with a writev submission per batch.
+ *  - an asynchronous TCP connect uses a one-shot POLLOUT poll.
+ *
+ *  The SQEs are only prepared and submitted by the socket_comm_loop thread,
+ *  the other threads put the sessions in the socket_comm_handle read_list
+ *  and write_list, and wake up the socket_comm_loop. When the interest is
+ *  removed, the requests in flight are canceled synchronously, so the
+ *  session and its queued messages can be freed right after.
+ */
+
+#include <errno.h>
+#include <malloc.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "pcep_socket_comm_internals.h"
+#include "pcep_utils_logging.h"
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+
+#define IO_URING_NUM_SQ_ENTRIES 256
+#define IO_URING_NUM_CQ_ENTRIES 1024
+/* The number of provided recv buffers must be a power of 2 */
+#define IO_URING_NUM_RECV_BUFFERS 256
+/* The multishot recv keeps posting completions until the socket is drained,
+ * so the data received is not limited by the size of each buffer */
+#define IO_URING_RECV_BUFFER_SIZE MAX_RECVD_MSG_SIZE
+#define IO_URING_RECV_BUFFER_GROUP 0
+#define IO_URING_NO_BUFFER UINT16_MAX
+/* Max number of queued messages written by each writev submission */
+#define IO_URING_WRITE_BATCH_IOVECS 64
+
+/* The SQE user_data is the session registry_key with the operation stored
+ * in the top bits of the registry slot, which are never used */
+#define IO_URING_OP_SHIFT 28
+#define IO_URING_OP_MASK (0xfULL << IO_URING_OP_SHIFT)
+#define IO_URING_OP_POLL    1
+#define IO_URING_OP_RECV    2
+#define IO_URING_OP_WRITE   3
+#define IO_URING_OP_CONNECT 4
+
+typedef struct pcep_socket_comm_io_uring_
+{
+    int ring_fd;
+    void *ring;
+    size_t ring_size;
+    /* Submission queue, sq_tail_local counts the prepared SQEs
+     * that are published to the kernel on submit */
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_ring_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sq_tail_local;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    /* Completion queue */
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_ring_mask;
+    struct io_uring_cqe *cqes;
+    /* Provided buffer ring for the multishot recvs */
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    char *recv_buffers;
+    bool wakeup_armed;
+
+} pcep_socket_comm_io_uring;
+
+
+/* Internal util functions for the io_uring syscalls, since liburing is not used */
+static int io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                          unsigned flags, void *arg, size_t arg_size)
+{
+    return (int) syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+
+static int io_uring_register(int ring_fd, unsigned opcode, void *arg, unsigned num_args)
+{
+    return (int) syscall(__NR_io_uring_register, ring_fd, opcode, arg, num_args);
+}
+
+
+static uint64_t encode_user_data(uint64_t registry_key, uint64_t op)
+{
+    return (registry_key & ~IO_URING_OP_MASK) | (op << IO_URING_OP_SHIFT);
+}
+
+
+/* Internal util function, submit the prepared SQEs without waiting */
+static void submit_sqes(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+    __atomic_store_n(io_uring->sq_tail, io_uring->sq_tail_local, __ATOMIC_RELEASE);
+    unsigned to_submit = io_uring->sq_tail_local - __atomic_load_n(io_uring->sq_head, __ATOMIC_ACQUIRE);
+    if (to_submit == 0)
+    {
+        return;
+    }
+
+    socket_comm_handle->num_poller_syscalls++;
+    if (io_uring_enter(io_uring->ring_fd, to_submit, 0, 0, NULL, 0) < 0 && errno != EINTR)
+    {
+        pcep_log(LOG_WARNING, "Cannot submit socket_comm io_uring SQEs errno [%d %s]",
+                errno, strerror(errno));
+    }
+}
+
+
+/* Internal util function, returns the next SQE to prepare, submitting
+ * the prepared SQEs if the submission queue is full */
+static struct io_uring_sqe *get_sqe(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+    if (io_uring->sq_tail_local - __atomic_load_n(io_uring->sq_head, __ATOMIC_ACQUIRE) >= io_uring->sq_entries)
+    {
+        submit_sqes(socket_comm_handle);
+        if (io_uring->sq_tail_local - __atomic_load_n(io_uring->sq_head, __ATOMIC_ACQUIRE) >= io_uring->sq_entries)
+        {
+            return NULL;
+        }
+    }
+
+    unsigned index = io_uring->sq_tail_local & *io_uring->sq_ring_mask;
+    struct io_uring_sqe *sqe = &io_uring->sqes[index];
+    bzero(sqe, sizeof(struct io_uring_sqe));
+    io_uring->sq_array[index] = index;
+    io_uring->sq_tail_local++;
+
+    return sqe;
+}
+
+
+/* Internal util function, give a provided buffer back to the kernel */
+static void recycle_recv_buffer(pcep_socket_comm_io_uring *io_uring, uint16_t buffer_id)
+{
+    struct io_uring_buf_ring *buf_ring = io_uring->buf_ring;
+    uint16_t tail = buf_ring->tail;
+    struct io_uring_buf *buf = &buf_ring->bufs[tail & (IO_URING_NUM_RECV_BUFFERS - 1)];
+    buf->addr = (uintptr_t) (io_uring->recv_buffers + (buffer_id * IO_URING_RECV_BUFFER_SIZE));
+    buf->len = IO_URING_RECV_BUFFER_SIZE;
+    buf->bid = buffer_id;
+    __atomic_store_n(&buf_ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+
+/* Internal util function, prepare the read submission of a session */
+static bool prepare_read(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    struct io_uring_sqe *sqe = get_sqe(socket_comm_handle);
+    if (sqe == NULL)
+    {
+        return false;
+    }
+
+    sqe->fd = comm_session->socket_fd;
+    if (comm_session->message_handler != NULL)
+    {
+        /* The data is received in the provided buffers, until the
+         * socket is closed or there are no buffers left */
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = IO_URING_RECV_BUFFER_GROUP;
+        sqe->user_data = encode_user_data(comm_session->registry_key, IO_URING_OP_RECV);
+    }
+    else
+    {
+        /* The message_ready_to_read_handler reads the socket itself */
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = encode_user_data(comm_session->registry_key, IO_URING_OP_POLL);
+    }
+
+    return true;
+}
+
+
+/* Internal util function, prepare a poll for the completion of an asynchronous
+ * TCP connect, which is treated as a write in flight until it completes */
+static bool prepare_connect_poll(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    struct io_uring_sqe *sqe = get_sqe(socket_comm_handle);
+    if (sqe == NULL)
+    {
+        return false;
+    }
+
+    comm_session->write_in_flight = true;
+    comm_session->write_iov_count = 0;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = comm_session->socket_fd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = encode_user_data(comm_session->registry_key, IO_URING_OP_CONNECT);
+
+    return true;
+}
+
+
+/* Internal util function, prepare the write submission of the next batch of queued messages */
+static bool prepare_write(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    struct io_uring_sqe *sqe = get_sqe(socket_comm_handle);
+    if (sqe == NULL)
+    {
+        return false;
+    }
+
+    if (comm_session->write_iov == NULL)
+    {
+        comm_session->write_iov = malloc(sizeof(struct iovec) * IO_URING_WRITE_BATCH_IOVECS);
+    }
+
+    /* The messages are only dequeued when the write completes */
+    comm_session->write_iov_count =
+            build_write_batch(comm_session, comm_session->write_iov, IO_URING_WRITE_BATCH_IOVECS);
+    comm_session->write_in_flight = true;
+
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = comm_session->socket_fd;
+    sqe->addr = (uintptr_t) comm_session->write_iov;
+    sqe->len = comm_session->write_iov_count;
+    sqe->user_data = encode_user_data(comm_session->registry_key, IO_URING_OP_WRITE);
+
+    return true;
+}
+
+
+/* Internal util function */
+static pcep_socket_comm_ready_event *add_ready_event(pcep_socket_comm_handle *socket_comm_handle,
+                                                     uint64_t registry_key,
+                                                     uint32_t ready_flags,
+                                                     int32_t result)
+{
+    pcep_socket_comm_ready_event *ready_event =
+            &(socket_comm_handle->ready_events[socket_comm_handle->num_ready_events++]);
+    ready_event->registry_key = registry_key;
+    ready_event->ready_flags = ready_flags;
+    ready_event->result = result;
+    ready_event->buffer_id = IO_URING_NO_BUFFER;
+
+    return ready_event;
+}
+
+
+/* Internal util function, re-arm the read of a session in the next loop iteration */
+static void rearm_read(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    if (comm_session->read_interest && !comm_session->read_submit_pending)
+    {
+        comm_session->read_submit_pending = true;
+        socket_comm_read_list_add(socket_comm_handle, comm_session);
+    }
+}
+
+
+/* Internal util function, prepare the SQEs for the sessions in the read_list
+ * and write_list, and submit them. Must be called with the socket_comm_mutex
+ * locked, so a session cant be freed between preparing and submitting its SQEs. */
+static void submit_pending_sessions(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+
+    if (!io_uring->wakeup_armed)
+    {
+        struct io_uring_sqe *sqe = get_sqe(socket_comm_handle);
+        if (sqe != NULL)
+        {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = socket_comm_handle->wakeup_read_fd;
+            sqe->poll32_events = POLLIN;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->user_data = SOCKET_COMM_WAKEUP_KEY;
+            io_uring->wakeup_armed = true;
+        }
+    }
+
+    while (socket_comm_handle->read_list_head != NULL)
+    {
+        pcep_socket_comm_session *comm_session = socket_comm_handle->read_list_head;
+        if (!prepare_read(socket_comm_handle, comm_session))
+        {
+            break;
+        }
+        socket_comm_read_list_remove(socket_comm_handle, comm_session);
+        comm_session->read_submit_pending = false;
+    }
+
+    while (socket_comm_handle->write_list_head != NULL)
+    {
+        pcep_socket_comm_session *comm_session = socket_comm_handle->write_list_head;
+        if (comm_session->connect_in_progress)
+        {
+            if (!prepare_connect_poll(socket_comm_handle, comm_session))
+            {
+                break;
+            }
+        }
+        else if (comm_session->message_queue->num_entries > 0)
+        {
+            if (!prepare_write(socket_comm_handle, comm_session))
+            {
+                break;
+            }
+        }
+        else
+        {
+            /* Nothing to write, but the close_after_write and the
+             * message_sent_handler are handled as if it was written */
+            if (socket_comm_handle->num_ready_events >= MAX_SOCKET_COMM_READY_EVENTS)
+            {
+                break;
+            }
+            add_ready_event(socket_comm_handle, comm_session->registry_key, SOCKET_COMM_READY_WRITE, 0);
+        }
+        socket_comm_write_list_remove(socket_comm_handle, comm_session);
+        comm_session->write_submit_pending = false;
+    }
+
+    submit_sqes(socket_comm_handle);
+}
+
+
+/* Internal util function, convert the CQEs to ready_events, must be
+ * called with the socket_comm_mutex locked */
+static void reap_completions(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+    unsigned head = *io_uring->cq_head;
+    unsigned tail = __atomic_load_n(io_uring->cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail && socket_comm_handle->num_ready_events < MAX_SOCKET_COMM_READY_EVENTS; head++)
+    {
+        struct io_uring_cqe *cqe = &io_uring->cqes[head & *io_uring->cq_ring_mask];
+
+        if (cqe->user_data == SOCKET_COMM_WAKEUP_KEY)
+        {
+            uint64_t wakeup_value;
+            socket_comm_handle->wakeup_pending = false;
+            while (read(socket_comm_handle->wakeup_read_fd, &wakeup_value, sizeof(wakeup_value)) > 0);
+            if ((cqe->flags & IORING_CQE_F_MORE) == 0)
+            {
+                io_uring->wakeup_armed = false;
+            }
+            continue;
+        }
+
+        uint64_t op = (cqe->user_data & IO_URING_OP_MASK) >> IO_URING_OP_SHIFT;
+        uint64_t registry_key = cqe->user_data & ~IO_URING_OP_MASK;
+        pcep_socket_comm_session *comm_session =
+                socket_comm_registry_find(&(socket_comm_handle->session_registry), registry_key);
+
+        if (op == IO_URING_OP_POLL)
+        {
+            if (comm_session != NULL && cqe->res > 0)
+            {
+                add_ready_event(socket_comm_handle, registry_key, SOCKET_COMM_READY_READ, cqe->res);
+                /* The poll is one-shot, so its re-armed after the read */
+                rearm_read(socket_comm_handle, comm_session);
+            }
+        }
+        else if (op == IO_URING_OP_RECV)
+        {
+            /* The buffers must always be handled, even if the session was
+             * destroyed, so they are given back to the kernel */
+            if (cqe->flags & IORING_CQE_F_BUFFER)
+            {
+                pcep_socket_comm_ready_event *ready_event =
+                        add_ready_event(socket_comm_handle, registry_key, SOCKET_COMM_READY_RECV, cqe->res);
+                ready_event->buffer_id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            }
+            else if (cqe->res != -ECANCELED && cqe->res != -ENOBUFS && comm_session != NULL)
+            {
+                /* The socket was closed, or failed */
+                add_ready_event(socket_comm_handle, registry_key, SOCKET_COMM_READY_RECV, cqe->res);
+            }
+
+            /* The multishot recv stops when there are no buffers left */
+            if ((cqe->flags & IORING_CQE_F_MORE) == 0 && comm_session != NULL &&
+                    (cqe->res > 0 || cqe->res == -ENOBUFS))
+            {
+                rearm_read(socket_comm_handle, comm_session);
+            }
+        }
+        else if (op == IO_URING_OP_WRITE || op == IO_URING_OP_CONNECT)
+        {
+            /* The connect completion is checked in handle_writes() */
+            if (comm_session != NULL && cqe->res != -ECANCELED)
+            {
+                add_ready_event(socket_comm_handle, registry_key, SOCKET_COMM_READY_WRITE, cqe->res);
+            }
+        }
+    }
+
+    __atomic_store_n(io_uring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+
+bool socket_comm_io_uring_initialize(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pcep_socket_comm_io_uring *io_uring = malloc(sizeof(pcep_socket_comm_io_uring));
+    bzero(io_uring, sizeof(pcep_socket_comm_io_uring));
+    io_uring->ring_fd = -1;
+    io_uring->ring = MAP_FAILED;
+    io_uring->sqes = MAP_FAILED;
+    io_uring->buf_ring = MAP_FAILED;
+    socket_comm_handle->io_uring = io_uring;
+    socket_comm_handle->backend = SOCKET_COMM_BACKEND_IO_URING;
+
+    struct io_uring_params params;
+    bzero(&params, sizeof(struct io_uring_params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = IO_URING_NUM_CQ_ENTRIES;
+    io_uring->ring_fd = io_uring_setup(IO_URING_NUM_SQ_ENTRIES, &params);
+    if (io_uring->ring_fd < 0)
+    {
+        pcep_log(LOG_WARNING, "Cannot create socket_comm io_uring errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+
+    /* The SQEs must be stable once submitted, and the CQEs must never be dropped */
+    uint32_t required_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP |
+            IORING_FEAT_SUBMIT_STABLE | IORING_FEAT_FAST_POLL | IORING_FEAT_EXT_ARG;
+    if ((params.features & required_features) != required_features)
+    {
+        pcep_log(LOG_WARNING, "The socket_comm io_uring features [0x%x] are not supported.",
+                required_features & ~params.features);
+        return false;
+    }
+
+    /* The submission and completion queues are mapped together */
+    size_t sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(unsigned));
+    size_t cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    io_uring->ring_size = (sq_ring_size > cq_ring_size ? sq_ring_size : cq_ring_size);
+    io_uring->ring = mmap(NULL, io_uring->ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, io_uring->ring_fd, IORING_OFF_SQ_RING);
+    io_uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    io_uring->sqes = mmap(NULL, io_uring->sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, io_uring->ring_fd, IORING_OFF_SQES);
+    if (io_uring->ring == MAP_FAILED || io_uring->sqes == MAP_FAILED)
+    {
+        pcep_log(LOG_WARNING, "Cannot map socket_comm io_uring errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+
+    char *ring = io_uring->ring;
+    io_uring->sq_head = (unsigned *) (ring + params.sq_off.head);
+    io_uring->sq_tail = (unsigned *) (ring + params.sq_off.tail);
+    io_uring->sq_ring_mask = (unsigned *) (ring + params.sq_off.ring_mask);
+    io_uring->sq_array = (unsigned *) (ring + params.sq_off.array);
+    io_uring->sq_entries = params.sq_entries;
+    io_uring->sq_tail_local = *io_uring->sq_tail;
+    io_uring->cq_head = (unsigned *) (ring + params.cq_off.head);
+    io_uring->cq_tail = (unsigned *) (ring + params.cq_off.tail);
+    io_uring->cq_ring_mask = (unsigned *) (ring + params.cq_off.ring_mask);
+    io_uring->cqes = (struct io_uring_cqe *) (ring + params.cq_off.cqes);
+
+    /* Register the provided buffer ring for the multishot recvs */
+    io_uring->buf_ring_size = IO_URING_NUM_RECV_BUFFERS * sizeof(struct io_uring_buf);
+    io_uring->buf_ring = mmap(NULL, io_uring->buf_ring_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (io_uring->buf_ring == MAP_FAILED)
+    {
+        pcep_log(LOG_WARNING, "Cannot map socket_comm io_uring buffer ring errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+
+    struct io_uring_buf_reg buf_reg;
+    bzero(&buf_reg, sizeof(struct io_uring_buf_reg));
+    buf_reg.ring_addr = (uintptr_t) io_uring->buf_ring;
+    buf_reg.ring_entries = IO_URING_NUM_RECV_BUFFERS;
+    buf_reg.bgid = IO_URING_RECV_BUFFER_GROUP;
+    if (io_uring_register(io_uring->ring_fd, IORING_REGISTER_PBUF_RING, &buf_reg, 1) < 0)
+    {
+        pcep_log(LOG_WARNING, "Cannot register socket_comm io_uring buffer ring errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+
+    io_uring->recv_buffers = malloc(IO_URING_NUM_RECV_BUFFERS * IO_URING_RECV_BUFFER_SIZE);
+    io_uring->buf_ring->tail = 0;
+    uint16_t buffer_id;
+    for (buffer_id = 0; buffer_id < IO_URING_NUM_RECV_BUFFERS; buffer_id++)
+    {
+        recycle_recv_buffer(io_uring, buffer_id);
+    }
+
+    /* The interest is removed with a synchronous cancel, which
+     * is not supported by older kernels. Nothing will be found
+     * to cancel, but it should fail with ENOENT not EINVAL. */
+    struct io_uring_sync_cancel_reg cancel_reg;
+    bzero(&cancel_reg, sizeof(struct io_uring_sync_cancel_reg));
+    cancel_reg.timeout.tv_sec = -1;
+    cancel_reg.timeout.tv_nsec = -1;
+    if (io_uring_register(io_uring->ring_fd, IORING_REGISTER_SYNC_CANCEL, &cancel_reg, 1) < 0 && errno != ENOENT)
+    {
+        pcep_log(LOG_WARNING, "The socket_comm io_uring synchronous cancel is not supported errno [%d %s].",
+                errno, strerror(errno));
+        return false;
+    }
+
+    int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd < 0)
+    {
+        pcep_log(LOG_ERR, "Cannot create socket_comm wakeup eventfd errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+    socket_comm_handle->wakeup_read_fd = wakeup_fd;
+    socket_comm_handle->wakeup_write_fd = wakeup_fd;
+
+    return true;
+}
+
+
+void socket_comm_io_uring_destroy(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+    if (io_uring == NULL)
+    {
+        return;
+    }
+
+    /* Closing the ring cancels all the requests in flight */
+    if (io_uring->ring_fd >= 0)
+    {
+        close(io_uring->ring_fd);
+    }
+    if (io_uring->ring != MAP_FAILED)
+    {
+        munmap(io_uring->ring, io_uring->ring_size);
+    }
+    if (io_uring->sqes != MAP_FAILED)
+    {
+        munmap(io_uring->sqes, io_uring->sqes_size);
+    }
+    if (io_uring->buf_ring != MAP_FAILED)
+    {
+        munmap(io_uring->buf_ring, io_uring->buf_ring_size);
+    }
+    free(io_uring->recv_buffers);
+    free(io_uring);
+    socket_comm_handle->io_uring = NULL;
+
+    if (socket_comm_handle->wakeup_read_fd >= 0)
+    {
+        close(socket_comm_handle->wakeup_read_fd);
+        socket_comm_handle->wakeup_read_fd = -1;
+        socket_comm_handle->wakeup_write_fd = -1;
+    }
+}
+
+
+void socket_comm_io_uring_add_read_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                            pcep_socket_comm_session *socket_comm_session)
+{
+    socket_comm_session->read_interest = true;
+    rearm_read(socket_comm_handle, socket_comm_session);
+}
+
+
+void socket_comm_io_uring_set_write_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                             pcep_socket_comm_session *socket_comm_session,
+                                             bool write_interest)
+{
+    socket_comm_session->write_interest = write_interest;
+    if (write_interest)
+    {
+        /* If a write is in flight, the next batch is submitted when it completes */
+        if (!socket_comm_session->write_in_flight && !socket_comm_session->write_submit_pending)
+        {
+            socket_comm_session->write_submit_pending = true;
+            socket_comm_write_list_add(socket_comm_handle, socket_comm_session);
+        }
+    }
+    else if (socket_comm_session->write_submit_pending)
+    {
+        socket_comm_session->write_submit_pending = false;
+        socket_comm_write_list_remove(socket_comm_handle, socket_comm_session);
+    }
+}
+
+
+void socket_comm_io_uring_remove_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                          pcep_socket_comm_session *socket_comm_session)
+{
+    if (socket_comm_session->read_submit_pending)
+    {
+        socket_comm_session->read_submit_pending = false;
+        socket_comm_read_list_remove(socket_comm_handle, socket_comm_session);
+    }
+
+    if (socket_comm_session->write_submit_pending)
+    {
+        socket_comm_session->write_submit_pending = false;
+        socket_comm_write_list_remove(socket_comm_handle, socket_comm_session);
+    }
+
+    /* Wait for the requests in flight on the socket_fd to be canceled,
+     * after which the kernel no longer uses the queued messages */
+    if (socket_comm_session->read_interest || socket_comm_session->write_in_flight)
+    {
+        struct io_uring_sync_cancel_reg cancel_reg;
+        bzero(&cancel_reg, sizeof(struct io_uring_sync_cancel_reg));
+        cancel_reg.fd = socket_comm_session->socket_fd;
+        cancel_reg.flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        cancel_reg.timeout.tv_sec = -1;
+        cancel_reg.timeout.tv_nsec = -1;
+        if (io_uring_register(socket_comm_handle->io_uring->ring_fd,
+                IORING_REGISTER_SYNC_CANCEL, &cancel_reg, 1) < 0 && errno != ENOENT)
+        {
+            pcep_log(LOG_WARNING, "Cannot cancel socket_fd [%d] io_uring requests errno [%d %s].",
+                    socket_comm_session->socket_fd, errno, strerror(errno));
+        }
+    }
+
+    socket_comm_session->read_interest = false;
+    socket_comm_session->write_interest = false;
+    socket_comm_session->write_in_flight = false;
+}
+
+
+/* Wait at most timeout_millis for any of the submitted reads or writes
+ * to complete, a negative timeout_millis waits until one completes or
+ * the socket_comm_loop is woken up. */
+void socket_comm_io_uring_wait_for_ready_sessions(pcep_socket_comm_handle *socket_comm_handle, int timeout_millis)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+    socket_comm_handle->num_ready_events = 0;
+
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    submit_pending_sessions(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    /* Only wait if there is nothing to handle yet */
+    if (timeout_millis != 0 && socket_comm_handle->num_ready_events == 0 &&
+            *io_uring->cq_head == __atomic_load_n(io_uring->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        struct __kernel_timespec timeout;
+        timeout.tv_sec = timeout_millis / 1000;
+        timeout.tv_nsec = (timeout_millis % 1000) * 1000000;
+        struct io_uring_getevents_arg getevents_arg;
+        bzero(&getevents_arg, sizeof(struct io_uring_getevents_arg));
+        getevents_arg.ts = (uintptr_t) &timeout;
+
+        socket_comm_handle->num_poller_syscalls++;
+        int result = (timeout_millis < 0 ?
+                io_uring_enter(io_uring->ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) :
+                io_uring_enter(io_uring->ring_fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                        &getevents_arg, sizeof(struct io_uring_getevents_arg)));
+        if (result < 0 && errno != EINTR && errno != ETIME)
+        {
+            pcep_log(LOG_WARNING, "ERROR socket_comm_loop on io_uring_enter errno [%d %s]",
+                    errno, strerror(errno));
+        }
+    }
+
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    reap_completions(socket_comm_handle);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+}
+
+
+/* Deliver the data received by a multishot recv to the message_handler,
+ * called by handle_reads() without the socket_comm_mutex locked */
+void socket_comm_io_uring_handle_recv(pcep_socket_comm_handle *socket_comm_handle,
+                                      pcep_socket_comm_ready_event *ready_event)
+{
+    pcep_socket_comm_io_uring *io_uring = socket_comm_handle->io_uring;
+
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    pcep_socket_comm_session *comm_session =
+            socket_comm_registry_find(&(socket_comm_handle->session_registry), ready_event->registry_key);
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    if (comm_session != NULL && ready_event->result > 0)
+    {
+        /* The message_handler must handle the data before returning,
+         * since the buffer is given back to the kernel right after */
+        comm_session->received_bytes = ready_event->result;
+        comm_session->message_handler(
+                comm_session->session_data,
+                io_uring->recv_buffers + (ready_event->buffer_id * IO_URING_RECV_BUFFER_SIZE),
+                ready_event->result);
+    }
+
+    if (ready_event->buffer_id != IO_URING_NO_BUFFER)
+    {
+        recycle_recv_buffer(io_uring, ready_event->buffer_id);
+    }
+
+    if (comm_session != NULL && ready_event->result <= 0)
+    {
+        errno = -ready_event->result;
+        handle_read_result(socket_comm_handle, comm_session, ready_event->registry_key,
+                (ready_event->result < 0 ? -1 : 0));
+    }
+}
+
+
+/* Dequeue the messages written by a completed writev submission, called by
+ * handle_writes() with the socket_comm_mutex locked, which is released while
+ * calling the message_sent_handler. */
+void socket_comm_io_uring_write_completed(pcep_socket_comm_handle *socket_comm_handle,
+                                          pcep_socket_comm_session *socket_comm_session,
+                                          pcep_socket_comm_ready_event *ready_event)
+{
+    if (socket_comm_session->write_in_flight)
+    {
+        socket_comm_session->write_in_flight = false;
+        if (ready_event->result < 0)
+        {
+            pcep_log(LOG_WARNING, "io_uring writev failure on socket_fd [%d] errno [%d %s]",
+                    socket_comm_session->socket_fd, -ready_event->result, strerror(-ready_event->result));
+        }
+
+        complete_write_batch(socket_comm_session,
+                socket_comm_session->write_iov,
+                socket_comm_session->write_iov_count,
+                (ready_event->result < 0 ? -1 : ready_event->result));
+
+        /* Submit the next batch in the next socket_comm_loop iteration */
+        if (socket_comm_session->message_queue->num_entries > 0 && socket_comm_session->write_interest)
+        {
+            socket_comm_session->write_submit_pending = true;
+            socket_comm_write_list_add(socket_comm_handle, socket_comm_session);
+        }
+    }
+    else if (!socket_comm_session->write_interest)
+    {
+        /* The interest was removed after the write completed */
+        return;
+    }
+
+    finish_comm_session_writes(socket_comm_handle, socket_comm_session);
+}
+
+#endif /* PCEP_SOCKET_COMM_HAVE_IO_URING */
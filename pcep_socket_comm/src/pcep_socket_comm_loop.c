@@ -23,126 +23,426 @@
  */
 
 
+
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <malloc.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <strings.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
 #include "pcep_socket_comm_internals.h"
 #include "pcep_utils_logging.h"
-#include "pcep_utils_ordered_list.h"
-#include "pcep_utils_logging.h"
+
+#ifndef PCEP_SOCKET_COMM_USE_SELECT
+#include <sys/eventfd.h>
+#endif
 
 
-bool comm_session_exists(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *socket_comm_session)
+/* Write the iovec buffers on the socket with 1 writev() call, returns the
+ * number of bytes written, which may be less than requested if the socket
+ * send buffer is full, or -1 on failure. Since the socket is non-blocking,
+ * this never waits for the socket to be writable. */
+ssize_t write_messages(int socket_fd, struct iovec *iov, int iov_count)
 {
-    if (socket_comm_handle == NULL)
+    ssize_t bytes_sent;
+    do
     {
-        return false;
+        bytes_sent = writev(socket_fd, iov, iov_count);
+    } while (bytes_sent < 0 && errno == EINTR);
+
+    pcep_log(LOG_INFO, "[%ld-%ld] socket_comm writing on socket [%d] num messages [%d] bytes sent [%zd]",
+            time(NULL), pthread_self(), socket_fd, iov_count, bytes_sent);
+
+    if (bytes_sent < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return 0;
+        }
+
+        pcep_log(LOG_WARNING, "send() failure errno [%d %s]", errno, strerror(errno));
     }
 
-    return (ordered_list_find(socket_comm_handle->session_list, socket_comm_session) != NULL);
+    return bytes_sent;
+}
+
+
+/* The queued messages of all the sessions are allocated from this pool,
+ * since they are allocated by the sending threads and freed by the
+ * socket_comm_loop for every message written */
+static object_pool_handle *queued_message_pool_ = NULL;
+static pthread_once_t queued_message_pool_once_ = PTHREAD_ONCE_INIT;
+
+/* Internal util function, called once to create the queued_message_pool_ */
+static void initialize_queued_message_pool()
+{
+    queued_message_pool_ = object_pool_initialize(
+            sizeof(pcep_socket_comm_queued_message), QUEUED_MESSAGE_POOL_MAX_FREE_MESSAGES);
 }
 
 
-bool comm_session_exists_locking(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *socket_comm_session)
+pcep_socket_comm_queued_message *alloc_queued_message()
 {
-    if (socket_comm_handle == NULL)
+    pthread_once(&queued_message_pool_once_, initialize_queued_message_pool);
+    return object_pool_alloc(queued_message_pool_);
+}
+
+
+void free_queued_message(pcep_socket_comm_queued_message *queued_message)
+{
+    if (queued_message->shared_message != NULL)
     {
-        return false;
+        socket_comm_shared_message_unref(queued_message->shared_message);
+    }
+    else if (queued_message->free_after_send)
+    {
+        free(queued_message->unmarshalled_message);
     }
+    pthread_once(&queued_message_pool_once_, initialize_queued_message_pool);
+    object_pool_free(queued_message_pool_, queued_message);
+}
+
+
+bool socket_comm_get_queued_message_pool_counters(object_pool_counters *counters)
+{
+    pthread_once(&queued_message_pool_once_, initialize_queued_message_pool);
+    return object_pool_get_counters(queued_message_pool_, counters);
+}
+
+
+/* Internal util function, dequeue and free the message at the head of the message_queue */
+static void dequeue_written_message(pcep_socket_comm_session *comm_session)
+{
+    pcep_socket_comm_queued_message *queued_message = queue_dequeue(comm_session->message_queue);
+    comm_session->num_bytes_pending -= (queued_message->msg_length - comm_session->flushed_bytes);
+    comm_session->flushed_bytes = 0;
+    free_queued_message(queued_message);
+}
+
+
+/* Read at most max_message_size bytes, returns the number of bytes read,
+ * 0 if the socket was closed, or -1 with errno set just like read() */
+int read_message(int socket_fd, char *received_message, unsigned int max_message_size)
+{
+    ssize_t bytes_read;
+    do
+    {
+        bytes_read = read(socket_fd, received_message, max_message_size);
+    } while (bytes_read < 0 && errno == EINTR);
+
+    pcep_log(LOG_INFO, "[%ld-%ld] socket_comm read message bytes_read [%d] on socket [%d]",
+            time(NULL), pthread_self(), (int) bytes_read, socket_fd);
+
+    return (int) bytes_read;
+}
+
+
+void socket_comm_wakeup_loop(pcep_socket_comm_handle *socket_comm_handle)
+{
+    if (socket_comm_handle->wakeup_pending)
+    {
+        /* The socket_comm_loop has not drained the previous wakeup yet */
+        return;
+    }
+
+    socket_comm_handle->wakeup_pending = true;
+    uint64_t wakeup_value = 1;
+    if (write(socket_comm_handle->wakeup_write_fd, &wakeup_value, sizeof(wakeup_value)) < 0
+            && errno != EAGAIN)
+    {
+        pcep_log(LOG_WARNING, "Cannot wakeup socket_comm_loop errno [%d %s].", errno, strerror(errno));
+    }
+}
+
+
+/* Internal util function, called by the socket_comm_loop when the wakeup fd is ready */
+static void drain_wakeup_fd(pcep_socket_comm_handle *socket_comm_handle)
+{
+    uint64_t wakeup_value;
 
     pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
-    bool exists = comm_session_exists(socket_comm_handle, socket_comm_session);
+    socket_comm_handle->wakeup_pending = false;
+    while (read(socket_comm_handle->wakeup_read_fd, &wakeup_value, sizeof(wakeup_value)) > 0);
     pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+}
 
-    return exists;
+
+void socket_comm_read_list_add(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    comm_session->read_list_prev = NULL;
+    comm_session->read_list_next = socket_comm_handle->read_list_head;
+    if (socket_comm_handle->read_list_head != NULL)
+    {
+        socket_comm_handle->read_list_head->read_list_prev = comm_session;
+    }
+    socket_comm_handle->read_list_head = comm_session;
 }
 
 
-void write_message(int socket_fd, const char *message, unsigned int msg_length)
+void socket_comm_read_list_remove(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
 {
-    int bytes_sent = 0;
-    unsigned int total_bytes_sent = 0;
+    if (comm_session->read_list_prev != NULL)
+    {
+        comm_session->read_list_prev->read_list_next = comm_session->read_list_next;
+    }
+    else
+    {
+        socket_comm_handle->read_list_head = comm_session->read_list_next;
+    }
 
-    while (bytes_sent < msg_length)
+    if (comm_session->read_list_next != NULL)
     {
-        bytes_sent = write(socket_fd, message + total_bytes_sent, msg_length);
+        comm_session->read_list_next->read_list_prev = comm_session->read_list_prev;
+    }
 
-        pcep_log(LOG_INFO, "[%ld-%ld] socket_comm writing on socket [%d] msg_lenth [%u] bytes sent [%d]",
-                time(NULL), pthread_self(), socket_fd, msg_length, bytes_sent);
+    comm_session->read_list_prev = NULL;
+    comm_session->read_list_next = NULL;
+}
 
-        if (bytes_sent < 0)
-        {
-              if (errno != EAGAIN && errno != EWOULDBLOCK)
-              {
-                pcep_log(LOG_WARNING, "send() failure");
 
-                return;
-              }
-        }
-        else
-        {
-            total_bytes_sent += bytes_sent;
-        }
+void socket_comm_write_list_add(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    comm_session->write_list_prev = NULL;
+    comm_session->write_list_next = socket_comm_handle->write_list_head;
+    if (socket_comm_handle->write_list_head != NULL)
+    {
+        socket_comm_handle->write_list_head->write_list_prev = comm_session;
+    }
+    socket_comm_handle->write_list_head = comm_session;
+}
+
+
+void socket_comm_write_list_remove(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    if (comm_session->write_list_prev != NULL)
+    {
+        comm_session->write_list_prev->write_list_next = comm_session->write_list_next;
+    }
+    else
+    {
+        socket_comm_handle->write_list_head = comm_session->write_list_next;
+    }
+
+    if (comm_session->write_list_next != NULL)
+    {
+        comm_session->write_list_next->write_list_prev = comm_session->write_list_prev;
+    }
+
+    comm_session->write_list_prev = NULL;
+    comm_session->write_list_next = NULL;
+}
+
+
+void socket_comm_connect_list_add(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    comm_session->connect_list_prev = NULL;
+    comm_session->connect_list_next = socket_comm_handle->connect_list_head;
+    if (socket_comm_handle->connect_list_head != NULL)
+    {
+        socket_comm_handle->connect_list_head->connect_list_prev = comm_session;
+    }
+    socket_comm_handle->connect_list_head = comm_session;
+}
+
+
+void socket_comm_connect_list_remove(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    if (comm_session->connect_list_prev != NULL)
+    {
+        comm_session->connect_list_prev->connect_list_next = comm_session->connect_list_next;
+    }
+    else
+    {
+        socket_comm_handle->connect_list_head = comm_session->connect_list_next;
+    }
+
+    if (comm_session->connect_list_next != NULL)
+    {
+        comm_session->connect_list_next->connect_list_prev = comm_session->connect_list_prev;
+    }
+
+    comm_session->connect_list_prev = NULL;
+    comm_session->connect_list_next = NULL;
+}
+
+
+uint64_t socket_comm_get_monotonic_millis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (((uint64_t) now.tv_sec) * 1000) + (now.tv_nsec / 1000000);
+}
+
+
+/* Internal util function, called by the pollers when the interest is removed */
+static void remove_connect_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                    pcep_socket_comm_session *socket_comm_session)
+{
+    if (socket_comm_session->connect_in_progress)
+    {
+        socket_comm_connect_list_remove(socket_comm_handle, socket_comm_session);
+        socket_comm_session->connect_in_progress = false;
+    }
+}
+
+
+#ifdef PCEP_SOCKET_COMM_USE_SELECT
+
+/*
+ * select() poller: the read_list and write_list are intrusive lists of the
+ * sessions to be checked, and the fd_sets are rebuilt from them on every
+ * loop iteration. After select(), the ready sessions are copied to the
+ * ready_events, so they are handled the same way as with epoll.
+ */
+
+bool socket_comm_poller_initialize(pcep_socket_comm_handle *socket_comm_handle)
+{
+    socket_comm_handle->read_list_head = NULL;
+    socket_comm_handle->write_list_head = NULL;
+    socket_comm_handle->num_ready_events = 0;
+    /* io_uring is only available with epoll */
+    socket_comm_handle->backend = SOCKET_COMM_BACKEND_DEFAULT;
+
+    int pipe_fds[2];
+    if (pipe(pipe_fds) < 0)
+    {
+        pcep_log(LOG_ERR, "Cannot create socket_comm wakeup pipe errno [%d %s].", errno, strerror(errno));
+        socket_comm_handle->wakeup_read_fd = -1;
+        socket_comm_handle->wakeup_write_fd = -1;
+        return false;
+    }
+
+    fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(pipe_fds[1], F_SETFL, fcntl(pipe_fds[1], F_GETFL) | O_NONBLOCK);
+    socket_comm_handle->wakeup_read_fd = pipe_fds[0];
+    socket_comm_handle->wakeup_write_fd = pipe_fds[1];
+    socket_comm_handle->wakeup_pending = false;
+
+    return true;
+}
+
+
+void socket_comm_poller_destroy(pcep_socket_comm_handle *socket_comm_handle)
+{
+    socket_comm_handle->read_list_head = NULL;
+    socket_comm_handle->write_list_head = NULL;
+
+    if (socket_comm_handle->wakeup_read_fd >= 0)
+    {
+        close(socket_comm_handle->wakeup_read_fd);
+        close(socket_comm_handle->wakeup_write_fd);
+        socket_comm_handle->wakeup_read_fd = -1;
+        socket_comm_handle->wakeup_write_fd = -1;
     }
 }
 
 
-unsigned int read_message(int socket_fd, char *received_message, unsigned int max_message_size)
+void socket_comm_add_read_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                   pcep_socket_comm_session *socket_comm_session)
 {
-    /* TODO what if bytes_read == max_message_size? there could be more to read */
-    unsigned int bytes_read = read(socket_fd, received_message, max_message_size);
-    pcep_log(LOG_INFO, "[%ld-%ld] socket_comm read message bytes_read [%u] on socket [%d]",
-            time(NULL), pthread_self(), bytes_read, socket_fd);
+    if (socket_comm_session->read_interest)
+    {
+        return;
+    }
 
-    return bytes_read;
+    socket_comm_session->read_interest = true;
+    socket_comm_read_list_add(socket_comm_handle, socket_comm_session);
+}
+
+
+void socket_comm_set_write_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                    pcep_socket_comm_session *socket_comm_session,
+                                    bool write_interest)
+{
+    if (socket_comm_session->write_interest == write_interest)
+    {
+        return;
+    }
+
+    socket_comm_session->write_interest = write_interest;
+    if (write_interest)
+    {
+        socket_comm_write_list_add(socket_comm_handle, socket_comm_session);
+    }
+    else
+    {
+        socket_comm_write_list_remove(socket_comm_handle, socket_comm_session);
+    }
+}
+
+
+void socket_comm_add_connect_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                      pcep_socket_comm_session *socket_comm_session)
+{
+    /* select() reports the socket as writable when the connect completes or fails */
+    socket_comm_set_write_interest(socket_comm_handle, socket_comm_session, true);
+}
+
+
+void socket_comm_remove_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                 pcep_socket_comm_session *socket_comm_session)
+{
+    if (socket_comm_session->read_interest)
+    {
+        socket_comm_read_list_remove(socket_comm_handle, socket_comm_session);
+        socket_comm_session->read_interest = false;
+    }
+
+    if (socket_comm_session->write_interest)
+    {
+        socket_comm_write_list_remove(socket_comm_handle, socket_comm_session);
+        socket_comm_session->write_interest = false;
+    }
+
+    remove_connect_interest(socket_comm_handle, socket_comm_session);
 }
 
 
 int build_fd_sets(pcep_socket_comm_handle *socket_comm_handle)
 {
-    int max_fd = 0;
+    int max_fd = socket_comm_handle->wakeup_read_fd;
 
     pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
 
     FD_ZERO(&socket_comm_handle->except_master_set);
     FD_ZERO(&socket_comm_handle->read_master_set);
-    ordered_list_node *node = socket_comm_handle->read_list->head;
-    pcep_socket_comm_session *comm_session;
-    while (node != NULL)
+    FD_SET(socket_comm_handle->wakeup_read_fd, &socket_comm_handle->read_master_set);
+    pcep_socket_comm_session *comm_session = socket_comm_handle->read_list_head;
+    while (comm_session != NULL)
     {
-        comm_session = (pcep_socket_comm_session *) node->data;
         if (comm_session->socket_fd > max_fd)
         {
             max_fd = comm_session->socket_fd;
         }
 
-        /*pcep_log(LOG_DEBUG, ld] socket_comm::build_fdSets set ready_toRead [%d]",
-                   time(NULL), comm_session->socket_fd);*/
         FD_SET(comm_session->socket_fd, &socket_comm_handle->read_master_set);
         FD_SET(comm_session->socket_fd, &socket_comm_handle->except_master_set);
-        node = node->next_node;
+        comm_session = comm_session->read_list_next;
     }
 
     FD_ZERO(&socket_comm_handle->write_master_set);
-    node = socket_comm_handle->write_list->head;
-    while (node != NULL)
+    comm_session = socket_comm_handle->write_list_head;
+    while (comm_session != NULL)
     {
-        comm_session = (pcep_socket_comm_session *) node->data;
         if (comm_session->socket_fd > max_fd)
         {
             max_fd = comm_session->socket_fd;
         }
 
-        /*pcep_log(LOG_DEBUG, "[%ld] socket_comm::build_fdSets set ready_toWrite [%d]",
-                   time(NULL), comm_session->socket_fd);*/
         FD_SET(comm_session->socket_fd, &socket_comm_handle->write_master_set);
         FD_SET(comm_session->socket_fd, &socket_comm_handle->except_master_set);
-        node = node->next_node;
+        comm_session = comm_session->write_list_next;
     }
 
     pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
@@ -151,183 +451,829 @@ int build_fd_sets(pcep_socket_comm_handle *socket_comm_handle)
 }
 
 
-void handle_reads(pcep_socket_comm_handle *socket_comm_handle)
+/* Internal util function, copy the sessions select() reported as ready
+ * to the ready_events, must be called with the socket_comm_mutex locked */
+static void build_ready_events(pcep_socket_comm_handle *socket_comm_handle)
 {
+    socket_comm_handle->num_ready_events = 0;
+
+    pcep_socket_comm_session *comm_session = socket_comm_handle->read_list_head;
+    while (comm_session != NULL
+            && socket_comm_handle->num_ready_events < MAX_SOCKET_COMM_READY_EVENTS)
+    {
+        if (FD_ISSET(comm_session->socket_fd, &socket_comm_handle->read_master_set)
+                || FD_ISSET(comm_session->socket_fd, &socket_comm_handle->except_master_set))
+        {
+            pcep_socket_comm_ready_event *ready_event =
+                    &(socket_comm_handle->ready_events[socket_comm_handle->num_ready_events++]);
+            ready_event->registry_key = comm_session->registry_key;
+            ready_event->ready_flags = SOCKET_COMM_READY_READ;
+        }
+        comm_session = comm_session->read_list_next;
+    }
+
+    comm_session = socket_comm_handle->write_list_head;
+    while (comm_session != NULL
+            && socket_comm_handle->num_ready_events < MAX_SOCKET_COMM_READY_EVENTS)
+    {
+        if (FD_ISSET(comm_session->socket_fd, &socket_comm_handle->write_master_set))
+        {
+            pcep_socket_comm_ready_event *ready_event =
+                    &(socket_comm_handle->ready_events[socket_comm_handle->num_ready_events++]);
+            ready_event->registry_key = comm_session->registry_key;
+            ready_event->ready_flags = SOCKET_COMM_READY_WRITE;
+        }
+        comm_session = comm_session->write_list_next;
+    }
+}
 
-    /*
-     * iterate all the socket_fd's in the read_list. it may be that not
-     * all of them have something to read. dont remove the socket_fd
-     * from the read_list since messages could come at any time.
-     */
 
-    /* Notice: Only locking the mutex when accessing the read_list,
-     * since the read callbacks may end up calling back into the socket
-     * comm module to write messages which could be a deadlock. */
+/* Wait at most timeout_millis for any of the sessions to be ready,
+ * a negative timeout_millis waits until a session is ready or the
+ * socket_comm_loop is woken up. */
+void wait_for_ready_sessions(pcep_socket_comm_handle *socket_comm_handle, int timeout_millis)
+{
+    struct timeval timer;
+    timer.tv_sec = timeout_millis / 1000;
+    timer.tv_usec = (timeout_millis % 1000) * 1000;
+    int max_fd = build_fd_sets(socket_comm_handle);
+
+    socket_comm_handle->num_poller_syscalls++;
+    if (select(max_fd,
+            &(socket_comm_handle->read_master_set),
+            &(socket_comm_handle->write_master_set),
+            &(socket_comm_handle->except_master_set),
+            (timeout_millis < 0 ? NULL : &timer)) < 0)
+    {
+        /* The fd_sets are undefined after an error, dont handle any of them */
+        if (errno != EINTR)
+        {
+            pcep_log(LOG_WARNING, "ERROR socket_comm_loop on select errno [%d %s]",
+                    errno, strerror(errno));
+        }
+        socket_comm_handle->num_ready_events = 0;
+        return;
+    }
+
+    if (FD_ISSET(socket_comm_handle->wakeup_read_fd, &socket_comm_handle->read_master_set))
+    {
+        drain_wakeup_fd(socket_comm_handle);
+    }
+
+    /* The sessions may have been removed from the lists while select()
+     * was waiting, which is why the lists are iterated and not the fd_sets */
     pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
-    ordered_list_node *node = socket_comm_handle->read_list->head;
+    build_ready_events(socket_comm_handle);
     pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+}
+
+#else
 
-    while (node != NULL)
+/*
+ * epoll() poller: each socket_fd is registered once when the TCP connection
+ * is established, and the write interest is only enabled while there are
+ * messages queued, so epoll_wait() only returns the sessions that are ready.
+ */
+
+bool socket_comm_poller_initialize(pcep_socket_comm_handle *socket_comm_handle)
+{
+    socket_comm_handle->num_ready_events = 0;
+    socket_comm_handle->wakeup_read_fd = -1;
+    socket_comm_handle->wakeup_write_fd = -1;
+    socket_comm_handle->wakeup_pending = false;
+    socket_comm_handle->epoll_fd = -1;
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
     {
-        pcep_socket_comm_session *comm_session = (pcep_socket_comm_session *) node->data;
+        if (socket_comm_io_uring_initialize(socket_comm_handle))
+        {
+            return true;
+        }
 
-        pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
-        node = node->next_node;
-        if (!comm_session_exists(socket_comm_handle, comm_session))
+        pcep_log(LOG_NOTICE, "io_uring is not supported, falling back to epoll");
+        socket_comm_io_uring_destroy(socket_comm_handle);
+    }
+#endif
+    socket_comm_handle->backend = SOCKET_COMM_BACKEND_DEFAULT;
+
+    socket_comm_handle->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (socket_comm_handle->epoll_fd < 0)
+    {
+        pcep_log(LOG_ERR, "Cannot create socket_comm epoll fd errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+
+    int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd < 0)
+    {
+        pcep_log(LOG_ERR, "Cannot create socket_comm wakeup eventfd errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+    socket_comm_handle->wakeup_read_fd = wakeup_fd;
+    socket_comm_handle->wakeup_write_fd = wakeup_fd;
+
+    /* The wakeup fd is identified by its data.u64 SOCKET_COMM_WAKEUP_KEY */
+    struct epoll_event event;
+    bzero(&event, sizeof(struct epoll_event));
+    event.events = EPOLLIN;
+    event.data.u64 = SOCKET_COMM_WAKEUP_KEY;
+    if (epoll_ctl(socket_comm_handle->epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event) < 0)
+    {
+        pcep_log(LOG_ERR, "Cannot add socket_comm wakeup eventfd to epoll errno [%d %s].", errno, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+
+void socket_comm_poller_destroy(pcep_socket_comm_handle *socket_comm_handle)
+{
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        socket_comm_io_uring_destroy(socket_comm_handle);
+        return;
+    }
+#endif
+
+    if (socket_comm_handle->wakeup_read_fd >= 0)
+    {
+        close(socket_comm_handle->wakeup_read_fd);
+        socket_comm_handle->wakeup_read_fd = -1;
+        socket_comm_handle->wakeup_write_fd = -1;
+    }
+
+    if (socket_comm_handle->epoll_fd >= 0)
+    {
+        close(socket_comm_handle->epoll_fd);
+        socket_comm_handle->epoll_fd = -1;
+    }
+}
+
+
+/* Internal util function */
+static uint32_t get_epoll_interest(pcep_socket_comm_session *socket_comm_session)
+{
+    /* The read interest is level-triggered, since the message_ready_to_read_handler
+     * may not read everything available on the socket in one call */
+    return (socket_comm_session->write_interest ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+}
+
+
+void socket_comm_add_read_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                   pcep_socket_comm_session *socket_comm_session)
+{
+    if (socket_comm_session->read_interest)
+    {
+        return;
+    }
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        socket_comm_io_uring_add_read_interest(socket_comm_handle, socket_comm_session);
+        return;
+    }
+#endif
+
+    /* The sessions are referred to by their registry_key, so an event
+     * for a session that has been destroyed is never dereferenced */
+    struct epoll_event event;
+    bzero(&event, sizeof(struct epoll_event));
+    event.events = get_epoll_interest(socket_comm_session);
+    event.data.u64 = socket_comm_session->registry_key;
+
+    socket_comm_session->read_interest = true;
+    if (epoll_ctl(socket_comm_handle->epoll_fd, EPOLL_CTL_ADD, socket_comm_session->socket_fd, &event) < 0)
+    {
+        pcep_log(LOG_WARNING, "Cannot add socket_fd [%d] to epoll errno [%d %s].",
+                socket_comm_session->socket_fd, errno, strerror(errno));
+    }
+}
+
+
+void socket_comm_set_write_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                    pcep_socket_comm_session *socket_comm_session,
+                                    bool write_interest)
+{
+    if (socket_comm_session->write_interest == write_interest)
+    {
+        return;
+    }
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        socket_comm_io_uring_set_write_interest(socket_comm_handle, socket_comm_session, write_interest);
+        return;
+    }
+#endif
+
+    socket_comm_session->write_interest = write_interest;
+
+    struct epoll_event event;
+    bzero(&event, sizeof(struct epoll_event));
+    event.events = get_epoll_interest(socket_comm_session);
+    event.data.u64 = socket_comm_session->registry_key;
+
+    /* If the TCP connection has not been established yet, the socket_fd is
+     * not registered and will be added with the write interest when it is. */
+    if (epoll_ctl(socket_comm_handle->epoll_fd, EPOLL_CTL_MOD, socket_comm_session->socket_fd, &event) < 0
+            && errno != ENOENT)
+    {
+        pcep_log(LOG_WARNING, "Cannot modify socket_fd [%d] epoll interest errno [%d %s].",
+                socket_comm_session->socket_fd, errno, strerror(errno));
+    }
+}
+
+
+void socket_comm_add_connect_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                      pcep_socket_comm_session *socket_comm_session)
+{
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        socket_comm_io_uring_set_write_interest(socket_comm_handle, socket_comm_session, true);
+        return;
+    }
+#endif
+
+    /* The socket_fd is registered with only the write interest, which
+     * is reported when the connect completes or fails */
+    struct epoll_event event;
+    bzero(&event, sizeof(struct epoll_event));
+    event.events = EPOLLOUT;
+    event.data.u64 = socket_comm_session->registry_key;
+
+    socket_comm_session->write_interest = true;
+    if (epoll_ctl(socket_comm_handle->epoll_fd, EPOLL_CTL_ADD, socket_comm_session->socket_fd, &event) < 0)
+    {
+        pcep_log(LOG_WARNING, "Cannot add connecting socket_fd [%d] to epoll errno [%d %s].",
+                socket_comm_session->socket_fd, errno, strerror(errno));
+    }
+}
+
+
+void socket_comm_remove_interest(pcep_socket_comm_handle *socket_comm_handle,
+                                 pcep_socket_comm_session *socket_comm_session)
+{
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        socket_comm_io_uring_remove_interest(socket_comm_handle, socket_comm_session);
+        remove_connect_interest(socket_comm_handle, socket_comm_session);
+        return;
+    }
+#endif
+
+    socket_comm_session->read_interest = false;
+    socket_comm_session->write_interest = false;
+    remove_connect_interest(socket_comm_handle, socket_comm_session);
+
+    /* The socket_fd may not be registered if it was never connected */
+    epoll_ctl(socket_comm_handle->epoll_fd, EPOLL_CTL_DEL, socket_comm_session->socket_fd, NULL);
+
+    /* The session may still be referenced by the ready_events, which is
+     * handled by looking up its registry_key before using it. */
+}
+
+
+/* Wait at most timeout_millis for any of the sessions to be ready,
+ * a negative timeout_millis waits until a session is ready or the
+ * socket_comm_loop is woken up. */
+void wait_for_ready_sessions(pcep_socket_comm_handle *socket_comm_handle, int timeout_millis)
+{
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        socket_comm_io_uring_wait_for_ready_sessions(socket_comm_handle, timeout_millis);
+        return;
+    }
+#endif
+
+    socket_comm_handle->num_ready_events = 0;
+    socket_comm_handle->num_poller_syscalls++;
+    int num_epoll_events =
+            epoll_wait(socket_comm_handle->epoll_fd,
+                       socket_comm_handle->epoll_events,
+                       MAX_SOCKET_COMM_READY_EVENTS,
+                       timeout_millis);
+    if (num_epoll_events < 0)
+    {
+        if (errno != EINTR)
         {
-            /* This comm_session has been deleted, move on to the next one */
-            pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+            pcep_log(LOG_WARNING, "ERROR socket_comm_loop on epoll_wait errno [%d %s]",
+                    errno, strerror(errno));
+        }
+        return;
+    }
+
+    /* Drain the wakeup fd and copy the sessions to the ready_events. A
+     * hangup or error is handled as a read, which will detect the socket
+     * was closed. */
+    int i;
+    for (i = 0; i < num_epoll_events; i++)
+    {
+        struct epoll_event *event = &(socket_comm_handle->epoll_events[i]);
+        if (event->data.u64 == SOCKET_COMM_WAKEUP_KEY)
+        {
+            drain_wakeup_fd(socket_comm_handle);
             continue;
         }
 
-        int is_set = FD_ISSET(comm_session->socket_fd, &(socket_comm_handle->read_master_set));
-        /* Upon read failure, the comm_session might be free'd, so we cant store the
-         * received_bytes in the comm_session, until we know the read was successful. */
-        int received_bytes = 0;
-        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+        pcep_socket_comm_ready_event *ready_event =
+                &(socket_comm_handle->ready_events[socket_comm_handle->num_ready_events++]);
+        ready_event->registry_key = event->data.u64;
+        ready_event->ready_flags =
+                ((event->events & (EPOLLIN | EPOLLHUP | EPOLLERR)) ? SOCKET_COMM_READY_READ : 0) |
+                ((event->events & EPOLLOUT) ? SOCKET_COMM_READY_WRITE : 0);
+    }
+}
+
+#endif /* PCEP_SOCKET_COMM_USE_SELECT */
+
+
+/* Read from a session the poller reported as ready to be read */
+void read_comm_session(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    /* Upon read failure, the comm_session might be free'd, so we cant store the
+     * received_bytes in the comm_session, until we know the read was successful. */
+    int received_bytes = 0;
+    /* The registry_key detects if the comm_session was destroyed, even
+     * if a new comm_session was allocated at the same address */
+    uint64_t registry_key = comm_session->registry_key;
 
-        if (is_set)
+    /* either read the message locally, or call the message_ready_handler to read it */
+    if (comm_session->message_handler != NULL)
+    {
+        /* The received_message is handed to the handler each time its filled,
+         * until the socket is drained or the SOCKET_COMM_READ_BUDGET is used */
+        int total_bytes_read = 0;
+        do
         {
-            /* either read the message locally, or call the message_ready_handler to read it */
-            if (comm_session->message_handler != NULL)
-            {
-                received_bytes =
-                        read_message(
-                                comm_session->socket_fd,
-                                comm_session->received_message,
-                                MAX_RECVD_MSG_SIZE);
-                if (received_bytes > 0)
-                {
-                    /* Send the received message to the handler */
-                    comm_session->received_bytes = received_bytes;
-                    comm_session->message_handler(
-                            comm_session->session_data,
+            socket_comm_handle->num_read_syscalls++;
+            received_bytes =
+                    read_message(
+                            comm_session->socket_fd,
                             comm_session->received_message,
-                            comm_session->received_bytes);
-                }
-            }
-            else
+                            MAX_RECVD_MSG_SIZE);
+            if (received_bytes > 0)
             {
-                /* Tell the handler a message is ready to be read.
-                 * The comm_session may be destroyed in this call, if
-                 * there is an error reading or if the socket is closed. */
-                received_bytes =
-                        comm_session->message_ready_to_read_handler(
-                                comm_session->session_data,
-                                comm_session->socket_fd);
+                /* Send the received message to the handler */
+                total_bytes_read += received_bytes;
+                comm_session->received_bytes = received_bytes;
+                comm_session->message_handler(
+                        comm_session->session_data,
+                        comm_session->received_message,
+                        comm_session->received_bytes);
             }
+            /* A short read means the socket has been drained */
+        } while (received_bytes == MAX_RECVD_MSG_SIZE && total_bytes_read < SOCKET_COMM_READ_BUDGET);
 
-            /* handle the read results */
-            if (received_bytes == 0)
-            {
-                if (comm_session_exists_locking(socket_comm_handle, comm_session))
-                {
-                    comm_session->received_bytes = 0;
-                    /* the socket was closed */
-                    /* TODO should we define a socket except enum? or will the only
-                     *      time we call this is when the socket is closed?? */
-                    if (comm_session->conn_except_notifier != NULL)
-                    {
-                        comm_session->conn_except_notifier(
-                                comm_session->session_data,
-                                comm_session->socket_fd);
-                    }
-
-                    /* stop reading from the socket if its closed */
-                    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
-                    ordered_list_remove_first_node_equals(socket_comm_handle->read_list, comm_session);
-                    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
-                }
-            }
-            else if (received_bytes < 0)
+        /* If something was already read, a close or error
+         * will be reported the next time the socket is read */
+        if (total_bytes_read > 0)
+        {
+            received_bytes = total_bytes_read;
+        }
+    }
+    else
+    {
+        /* Tell the handler a message is ready to be read.
+         * The comm_session may be destroyed in this call, if
+         * there is an error reading or if the socket is closed. */
+        received_bytes =
+                comm_session->message_ready_to_read_handler(
+                        comm_session->session_data,
+                        comm_session->socket_fd);
+    }
+
+    handle_read_result(socket_comm_handle, comm_session, registry_key, received_bytes);
+}
+
+
+/* Handle the number of bytes read from a comm_session, which may
+ * have been destroyed while reading if received_bytes <= 0 */
+void handle_read_result(pcep_socket_comm_handle *socket_comm_handle,
+                        pcep_socket_comm_session *comm_session,
+                        uint64_t registry_key,
+                        int received_bytes)
+{
+    if (received_bytes == 0)
+    {
+        /* the socket was closed, stop reading from it before notifying,
+         * since the comm_session may be torn down by another thread as
+         * soon as the conn_except_notifier is called */
+        connection_except_notifier conn_except_notifier = NULL;
+        void *session_data = NULL;
+        int socket_fd = -1;
+        pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+        if (socket_comm_registry_find(&(socket_comm_handle->session_registry),
+                                      registry_key) == comm_session)
+        {
+            comm_session->received_bytes = 0;
+            /* Mark the comm_session closed before unlocking, so the messages
+             * sent from now on are dropped, instead of re-arming the write
+             * interest of a comm_session that is about to be torn down */
+            comm_session->closed = true;
+            socket_comm_remove_interest(socket_comm_handle, comm_session);
+            conn_except_notifier = comm_session->conn_except_notifier;
+            session_data = comm_session->session_data;
+            socket_fd = comm_session->socket_fd;
+        }
+        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+        /* TODO should we define a socket except enum? or will the only
+         *      time we call this is when the socket is closed?? */
+        if (conn_except_notifier != NULL)
+        {
+            conn_except_notifier(session_data, socket_fd);
+        }
+    }
+    else if (received_bytes < 0)
+    {
+        /* Nothing was read if errno is EAGAIN, which is not an error */
+        int read_errno = errno;
+        if (read_errno != EAGAIN && read_errno != EWOULDBLOCK)
+        {
+            /* The comm_session may have been destroyed while reading */
+            pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+            if (socket_comm_registry_find(&(socket_comm_handle->session_registry),
+                                          registry_key) == comm_session)
             {
                 /* TODO should we call conn_except_notifier() here ? */
+                comm_session->closed = true;
                 pcep_log(LOG_WARNING, "Error on socket [%d] : errno [%d][%s]",
-                        comm_session->socket_fd, errno, strerror(errno));
-            }
-            else
-            {
-                comm_session->received_bytes = received_bytes;
+                        comm_session->socket_fd, read_errno, strerror(read_errno));
             }
+            pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
         }
     }
+    else
+    {
+        comm_session->received_bytes = received_bytes;
+    }
 }
 
 
-void handle_writes(pcep_socket_comm_handle *socket_comm_handle)
+/* Fill the iov with the next batch of queued messages to be written,
+ * limited to max_iovecs messages and the comm_session max_write_batch_bytes.
+ * Returns the number of iov entries used. */
+int build_write_batch(pcep_socket_comm_session *comm_session, struct iovec *iov, int max_iovecs)
 {
-    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    int iov_count = 0;
+    unsigned int batch_bytes = 0;
+    queue_node *node = comm_session->message_queue->head;
+    while (node != NULL && iov_count < max_iovecs)
+    {
+        pcep_socket_comm_queued_message *queued_message = node->data;
+        /* always write at least 1 message, even if its bigger than the limit */
+        if (iov_count > 0 &&
+                batch_bytes + queued_message->msg_length > comm_session->max_write_batch_bytes)
+        {
+            break;
+        }
+
+        iov[iov_count].iov_base = queued_message->unmarshalled_message;
+        iov[iov_count].iov_len = queued_message->msg_length;
+        batch_bytes += queued_message->msg_length;
+        iov_count++;
+        node = node->next_node;
+    }
+
+    if (iov_count > 0)
+    {
+        /* the head message may have been partially written previously */
+        iov[0].iov_base = ((char *) iov[0].iov_base) + comm_session->flushed_bytes;
+        iov[0].iov_len -= comm_session->flushed_bytes;
+    }
+
+    return iov_count;
+}
+
+
+/* Dequeue the messages of a batch built with build_write_batch() that
+ * were completely written. Returns true if the whole batch was written. */
+bool complete_write_batch(pcep_socket_comm_session *comm_session, struct iovec *iov, int iov_count, ssize_t bytes_sent)
+{
+    if (bytes_sent < 0)
+    {
+        /* The socket failed, drop the messages, the failure
+         * will be detected when reading from the socket */
+        while (comm_session->message_queue->num_entries > 0)
+        {
+            dequeue_written_message(comm_session);
+        }
+        return false;
+    }
+
+    /* dequeue the messages that were completely written */
+    int i;
+    for (i = 0; i < iov_count && (size_t) bytes_sent >= iov[i].iov_len; i++)
+    {
+        bytes_sent -= iov[i].iov_len;
+        dequeue_written_message(comm_session);
+        comm_session->num_messages_written++;
+    }
+
+    if (i < iov_count)
+    {
+        /* The socket send buffer is full, keep track of the partially
+         * written message and wait for the socket to be writable */
+        comm_session->flushed_bytes += bytes_sent;
+        comm_session->num_bytes_pending -= bytes_sent;
+        comm_session->num_partial_writes++;
+        return false;
+    }
+
+    return true;
+}
+
+
+/* Called after writing the comm_session messages, with the socket_comm_mutex
+ * locked, which is released while calling the message_sent_handler. */
+void finish_comm_session_writes(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    bool socket_closed = false;
+    if (comm_session->message_queue->num_entries == 0)
+    {
+        /* There is nothing else to write after this, until another
+         * message is sent with socket_comm_session_send_message() */
+        socket_comm_set_write_interest(socket_comm_handle, comm_session, false);
+
+        /* check if the socket should be closed after writing */
+        if (comm_session->close_after_write == true && !comm_session->closed)
+        {
+            socket_comm_remove_interest(socket_comm_handle, comm_session);
+            close(comm_session->socket_fd);
+            comm_session->closed = true;
+            socket_closed = true;
+        }
+    }
+
+    if (comm_session->message_sent_handler != NULL)
+    {
+        /* Unlocking to allow the message_sent_handler to make calls
+         * like destroy_socket_comm_session, the comm_session may be
+         * torn down once unlocked, so its not accessed after that */
+        message_sent_notifier message_sent_handler = comm_session->message_sent_handler;
+        void *session_data = comm_session->session_data;
+        int socket_fd = comm_session->socket_fd;
+        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+        message_sent_handler(session_data, socket_fd, socket_closed);
+        pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    }
+}
+
+
+/* Write the queued messages of a session the poller reported as ready
+ * to be written. This function is called with the socket_comm_mutex
+ * locked, which is released while calling the message_sent_handler.
+ * If the socket cant take all the queued messages, whats left is written
+ * the next time the poller reports the socket as writable. */
+void write_comm_session(pcep_socket_comm_handle *socket_comm_handle, pcep_socket_comm_session *comm_session)
+{
+    /* write the comm_session messages in batches, each batch is written
+     * with one writev() limited to MAX_WRITE_BATCH_IOVECS messages and the
+     * comm_session max_write_batch_bytes. The messages are only dequeued
+     * once they are completely written. */
+    struct iovec iov[MAX_WRITE_BATCH_IOVECS];
+    while (comm_session->message_queue->num_entries > 0)
+    {
+        int iov_count = build_write_batch(comm_session, iov, MAX_WRITE_BATCH_IOVECS);
+        ssize_t bytes_sent = write_messages(comm_session->socket_fd, iov, iov_count);
+        if (bytes_sent >= 0)
+        {
+            comm_session->num_write_syscalls++;
+        }
 
+        if (!complete_write_batch(comm_session, iov, iov_count, bytes_sent))
+        {
+            break;
+        }
+    }
+
+    finish_comm_session_writes(socket_comm_handle, comm_session);
+}
+
+
+void handle_reads(pcep_socket_comm_handle *socket_comm_handle)
+{
     /*
-     * iterate all the socket_fd's in the write_list. it may be that not
-     * all of them are ready to be written to. only remove the socket_fd
-     * from the list if it is ready to be written to.
+     * iterate only the sessions the poller reported as ready to be read.
+     * The sessions are looked up by their registry_key, since they may
+     * have been destroyed by a previous read callback.
      */
-
-    ordered_list_node *node = socket_comm_handle->write_list->head;
-    pcep_socket_comm_session *comm_session;
-    while (node != NULL)
+    int i;
+    for (i = 0; i < socket_comm_handle->num_ready_events; i++)
     {
-        comm_session = (pcep_socket_comm_session *) node->data;
-        node = node->next_node;
+        pcep_socket_comm_ready_event *ready_event = &(socket_comm_handle->ready_events[i]);
+        if ((ready_event->ready_flags & (SOCKET_COMM_READY_READ | SOCKET_COMM_READY_RECV)) == 0)
+        {
+            continue;
+        }
 
-        if (!comm_session_exists(socket_comm_handle, comm_session))
+        /* Notice: Only locking the mutex when looking up the session,
+         * since the read callbacks may end up calling back into the socket
+         * comm module to write messages which could be a deadlock. */
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+        if (ready_event->ready_flags & SOCKET_COMM_READY_RECV)
+        {
+            /* The data was already received by io_uring */
+            socket_comm_io_uring_handle_recv(socket_comm_handle, ready_event);
+            continue;
+        }
+#endif
+
+        pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+        pcep_socket_comm_session *comm_session =
+                socket_comm_registry_find(&(socket_comm_handle->session_registry), ready_event->registry_key);
+        if (comm_session != NULL && comm_session->connect_in_progress)
+        {
+            /* The connect failed, reading would clear the socket error,
+             * so its left for handle_writes() to check */
+            ready_event->ready_flags |= SOCKET_COMM_READY_WRITE;
+            comm_session = NULL;
+        }
+        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+        if (comm_session == NULL)
         {
             /* This comm_session has been deleted, move on to the next one */
-            pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
             continue;
         }
 
-        if (FD_ISSET(comm_session->socket_fd, &(socket_comm_handle->write_master_set))) {
-            /* only remove the entry from the list, if it is written to */
-            ordered_list_remove_first_node_equals(socket_comm_handle->write_list, comm_session);
+        read_comm_session(socket_comm_handle, comm_session);
+    }
+}
 
-            /* dequeue all the comm_session messages and send them */
-            pcep_socket_comm_queued_message *queued_message = queue_dequeue(comm_session->message_queue);
-            while (queued_message != NULL)
-            {
-                write_message(
-                        comm_session->socket_fd,
-                        queued_message->unmarshalled_message,
-                        queued_message->msg_length);
-                if (queued_message->free_after_send)
-                {
-                    free(queued_message->unmarshalled_message);
-                }
-                free(queued_message);
-                queued_message = queue_dequeue(comm_session->message_queue);
-            }
+
+void handle_writes(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+
+    /* iterate only the sessions the poller reported as ready to be written to */
+    int i;
+    for (i = 0; i < socket_comm_handle->num_ready_events; i++)
+    {
+        pcep_socket_comm_ready_event *ready_event = &(socket_comm_handle->ready_events[i]);
+        if ((ready_event->ready_flags & SOCKET_COMM_READY_WRITE) == 0)
+        {
+            continue;
         }
 
-        /* check if the socket should be closed after writing */
-        if (comm_session->close_after_write == true)
+        pcep_socket_comm_session *comm_session =
+                socket_comm_registry_find(&(socket_comm_handle->session_registry), ready_event->registry_key);
+        if (comm_session != NULL && comm_session->connect_in_progress)
         {
-            if (comm_session->message_queue->num_entries == 0)
+            /* The socket is writable once the connect completes or fails */
+            finish_comm_session_connect(socket_comm_handle, comm_session, false);
+            continue;
+        }
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+        if (socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+        {
+            /* The write was already completed by io_uring */
+            if (comm_session != NULL && !comm_session->closed)
             {
-                /* TODO check to make sure modifying the write_list while
-                 *      iterating it doesnt cause problems. */
-                ordered_list_remove_first_node_equals(socket_comm_handle->read_list, comm_session);
-                ordered_list_remove_first_node_equals(socket_comm_handle->write_list, comm_session);
-                close(comm_session->socket_fd);
+                socket_comm_io_uring_write_completed(socket_comm_handle, comm_session, ready_event);
             }
+            continue;
         }
+#endif
 
-        if (comm_session->message_sent_handler != NULL)
+        if (comm_session == NULL || comm_session->closed || !comm_session->write_interest)
         {
-            /* Unlocking to allow the message_sent_handler to
-             * make calls like destroy_socket_comm_session */
-            pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
-            comm_session->message_sent_handler(
-                    comm_session->session_data, comm_session->socket_fd);
-            pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+            /* This comm_session has been deleted, closed, or has nothing to write */
+            continue;
         }
 
+        write_comm_session(socket_comm_handle, comm_session);
     }
 
     pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
 }
 
 
+/* Complete the asynchronous TCP connect of a session, which is called
+ * with the socket_comm_mutex locked, and released while calling the
+ * connect_complete_notifier. */
+void finish_comm_session_connect(pcep_socket_comm_handle *socket_comm_handle,
+                                 pcep_socket_comm_session *comm_session,
+                                 bool timed_out)
+{
+    bool connected = false;
+    if (timed_out)
+    {
+        pcep_log(LOG_WARNING, "TCP connect timed-out on socket_fd [%d].", comm_session->socket_fd);
+    }
+    else
+    {
+        int so_error = 0;
+        socklen_t len = sizeof(so_error);
+        if (getsockopt(comm_session->socket_fd, SOL_SOCKET, SO_ERROR, &so_error, &len) < 0)
+        {
+            so_error = errno;
+        }
+
+        connected = (so_error == 0);
+        if (!connected)
+        {
+            pcep_log(LOG_WARNING, "TCP connect failed on socket_fd [%d] errno [%d %s].",
+                    comm_session->socket_fd, so_error, strerror(so_error));
+        }
+    }
+
+    /* Removing the connect interest also removes the session from the connect_list */
+    socket_comm_remove_interest(socket_comm_handle, comm_session);
+    if (connected)
+    {
+        /* once the TCP connection is open, we should be ready to read at any time,
+         * and the messages queued while connecting can be written */
+        socket_comm_add_read_interest(socket_comm_handle, comm_session);
+        if (comm_session->message_queue->num_entries > 0)
+        {
+            socket_comm_set_write_interest(socket_comm_handle, comm_session, true);
+        }
+    }
+
+    if (comm_session->connect_complete_notifier != NULL)
+    {
+        /* Unlocking to allow the connect_complete_notifier to make calls
+         * like socket_comm_session_send_message, the comm_session may
+         * be torn down once unlocked, so its not accessed after that */
+        connection_complete_notifier notifier = comm_session->connect_complete_notifier;
+        void *session_data = comm_session->session_data;
+        int socket_fd = comm_session->socket_fd;
+        pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+        notifier(session_data, socket_fd, connected);
+        pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    }
+}
+
+
+/* Fail the asynchronous TCP connects whose deadline has passed */
+void handle_connect_timeouts(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+
+    uint64_t now_millis = socket_comm_get_monotonic_millis();
+    pcep_socket_comm_session *comm_session = socket_comm_handle->connect_list_head;
+    while (comm_session != NULL)
+    {
+        if (comm_session->connect_deadline_millis > now_millis)
+        {
+            comm_session = comm_session->connect_list_next;
+            continue;
+        }
+
+        /* The connect_list may change while the notifier is called
+         * without the mutex, so start again from the head */
+        finish_comm_session_connect(socket_comm_handle, comm_session, true);
+        comm_session = socket_comm_handle->connect_list_head;
+    }
+
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+}
+
+
+/* Internal util function, returns how long the socket_comm_loop can wait
+ * before the next connect deadline, or -1 if there are no connects pending */
+static int get_connect_timeout_millis(pcep_socket_comm_handle *socket_comm_handle)
+{
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+
+    uint64_t next_deadline_millis = UINT64_MAX;
+    pcep_socket_comm_session *comm_session = socket_comm_handle->connect_list_head;
+    for (; comm_session != NULL; comm_session = comm_session->connect_list_next)
+    {
+        if (comm_session->connect_deadline_millis < next_deadline_millis)
+        {
+            next_deadline_millis = comm_session->connect_deadline_millis;
+        }
+    }
+
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    if (next_deadline_millis == UINT64_MAX)
+    {
+        return -1;
+    }
+
+    uint64_t now_millis = socket_comm_get_monotonic_millis();
+    if (next_deadline_millis <= now_millis)
+    {
+        return 0;
+    }
+
+    uint64_t timeout_millis = next_deadline_millis - now_millis;
+    return (timeout_millis > INT_MAX ? INT_MAX : (int) timeout_millis);
+}
+
+
 void handle_excepts(pcep_socket_comm_handle *socket_comm_handle)
 {
     /* TODO finish this */
@@ -343,32 +1289,21 @@ void *socket_comm_loop(void *data)
         return NULL;
     }
 
-    pcep_log(LOG_NOTICE, "[%ld-%ld] Starting socket_comm_loop thread", time(NULL), pthread_self());
-
     pcep_socket_comm_handle *socket_comm_handle = (pcep_socket_comm_handle *) data;
-    struct timeval timer;
-    int max_fd;
+    pcep_log(LOG_NOTICE, "[%ld-%ld] Starting socket_comm_loop thread for reactor [%d]",
+            time(NULL), pthread_self(), socket_comm_handle->reactor_index);
 
     while (socket_comm_handle->active)
     {
-        /* check the FD's every 1/4 sec, 250 milliseconds */
-        timer.tv_sec = 0;
-        timer.tv_usec = 250000;
-        max_fd = build_fd_sets(socket_comm_handle);
-
-        if (select(max_fd,
-                &(socket_comm_handle->read_master_set),
-                &(socket_comm_handle->write_master_set),
-                &(socket_comm_handle->except_master_set),
-                &timer) < 0)
-        {
-            /* TODO handle the error */
-            pcep_log(LOG_WARNING, "ERROR socket_comm_loop on select");
-        }
+        /* Only the asynchronous TCP connects are time based, if there are
+         * none, block until a session is ready or the loop is woken up by
+         * socket_comm_wakeup_loop() */
+        wait_for_ready_sessions(socket_comm_handle, get_connect_timeout_millis(socket_comm_handle));
 
         handle_reads(socket_comm_handle);
         handle_writes(socket_comm_handle);
         handle_excepts(socket_comm_handle);
+        handle_connect_timeouts(socket_comm_handle);
     }
 
     pcep_log(LOG_NOTICE, "[%ld-%ld] Finished socket_comm_loop thread", time(NULL), pthread_self());
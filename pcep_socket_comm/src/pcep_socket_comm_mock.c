@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include <CUnit/CUnit.h>
 
@@ -49,6 +50,9 @@ void setup_mock_socket_comm_info()
     mock_socket_metadata.socket_comm_session_initialize_src_times_called = 0;
     mock_socket_metadata.socket_comm_session_teardown_times_called = 0;
     mock_socket_metadata.socket_comm_session_connect_tcp_times_called = 0;
+    mock_socket_metadata.socket_comm_session_connect_tcp_async_times_called = 0;
+    mock_socket_metadata.connect_complete_notifier = NULL;
+    mock_socket_metadata.last_sent_message_priority = SOCKET_COMM_PRIORITY_BULK;
     mock_socket_metadata.socket_comm_session_send_message_times_called = 0;
     mock_socket_metadata.socket_comm_session_close_tcp_after_write_times_called = 0;
     mock_socket_metadata.socket_comm_session_close_tcp_times_called = 0;
@@ -240,6 +244,68 @@ socket_comm_session_initialize_with_src_ipv6(message_received_handler msg_rcv_ha
     return comm_session;
 }
 
+/* The mock socket_comm reactors are never dereferenced */
+static char mock_socket_comm_reactors;
+
+struct pcep_socket_comm_reactors_ *create_socket_comm_reactors(pcep_socket_comm_config *config)
+{
+    return (struct pcep_socket_comm_reactors_ *) &mock_socket_comm_reactors;
+}
+
+bool destroy_socket_comm_reactors(struct pcep_socket_comm_reactors_ *socket_comm_reactors)
+{
+    mock_socket_metadata.destroy_socket_comm_loop_times_called++;
+
+    return true;
+}
+
+bool socket_comm_get_queued_message_pool_counters(object_pool_counters *counters)
+{
+    if (counters == NULL)
+    {
+        return false;
+    }
+
+    /* The mock does not queue any messages */
+    bzero(counters, sizeof(object_pool_counters));
+
+    return true;
+}
+
+pcep_socket_comm_session *
+socket_comm_session_initialize_with_reactors(struct pcep_socket_comm_reactors_ *socket_comm_reactors,
+                            message_received_handler msg_rcv_handler,
+                            message_ready_to_read_handler msg_ready_handler,
+                            message_sent_notifier msg_sent_notifier,
+                            connection_except_notifier notifier,
+                            struct in_addr *src_ip,
+                            short src_port,
+                            struct in_addr *dst_ip,
+                            short dst_port,
+                            uint32_t connect_timeout_millis,
+                            void *session_data)
+{
+    return socket_comm_session_initialize_with_src(msg_rcv_handler, msg_ready_handler, msg_sent_notifier,
+            notifier, src_ip, src_port, dst_ip, dst_port, connect_timeout_millis, session_data);
+}
+
+pcep_socket_comm_session *
+socket_comm_session_initialize_with_reactors_ipv6(struct pcep_socket_comm_reactors_ *socket_comm_reactors,
+                            message_received_handler msg_rcv_handler,
+                            message_ready_to_read_handler msg_ready_handler,
+                            message_sent_notifier msg_sent_notifier,
+                            connection_except_notifier notifier,
+                            struct in6_addr *src_ip,
+                            short src_port,
+                            struct in6_addr *dst_ip,
+                            short dst_port,
+                            uint32_t connect_timeout_millis,
+                            void *session_data)
+{
+    return socket_comm_session_initialize_with_src_ipv6(msg_rcv_handler, msg_ready_handler, msg_sent_notifier,
+            notifier, src_ip, src_port, dst_ip, dst_port, connect_timeout_millis, session_data);
+}
+
 bool socket_comm_session_teardown(pcep_socket_comm_session *socket_comm_session)
 {
     mock_socket_metadata.socket_comm_session_teardown_times_called++;
@@ -262,12 +328,43 @@ bool socket_comm_session_connect_tcp(pcep_socket_comm_session *socket_comm_sessi
 }
 
 
-void socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_session,
+bool socket_comm_session_connect_tcp_async(pcep_socket_comm_session *socket_comm_session,
+                                           connection_complete_notifier notifier)
+{
+    mock_socket_metadata.socket_comm_session_connect_tcp_async_times_called++;
+    mock_socket_metadata.connect_complete_notifier = notifier;
+
+    return true;
+}
+
+
+bool socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_session,
                                   char *unmarshalled_message,
                                   unsigned int msg_length,
                                   bool delete_after_send)
+{
+    return socket_comm_session_send_message_with_priority(socket_comm_session, unmarshalled_message,
+            msg_length, delete_after_send, SOCKET_COMM_PRIORITY_BULK);
+}
+
+
+bool socket_comm_session_send_message_with_priority(pcep_socket_comm_session *socket_comm_session,
+                                                    char *unmarshalled_message,
+                                                    unsigned int msg_length,
+                                                    bool delete_after_send,
+                                                    pcep_socket_comm_priority priority)
 {
     mock_socket_metadata.socket_comm_session_send_message_times_called++;
+    mock_socket_metadata.last_sent_message_priority = priority;
+
+    if (socket_comm_session != NULL && socket_comm_session->closed)
+    {
+        if (delete_after_send == true)
+        {
+            free(unmarshalled_message);
+        }
+        return false;
+    }
 
     if (mock_socket_metadata.send_message_save_message == true)
     {
@@ -282,7 +379,66 @@ void socket_comm_session_send_message(pcep_socket_comm_session *socket_comm_sess
         }
     }
 
-    return;
+    return true;
+}
+
+
+pcep_socket_comm_shared_message *socket_comm_shared_message_create(char *unmarshalled_message,
+                                                                   unsigned int msg_length)
+{
+    if (unmarshalled_message == NULL)
+    {
+        return NULL;
+    }
+
+    pcep_socket_comm_shared_message *shared_message = malloc(sizeof(pcep_socket_comm_shared_message));
+    bzero(shared_message, sizeof(pcep_socket_comm_shared_message));
+    shared_message->unmarshalled_message = unmarshalled_message;
+    shared_message->msg_length = msg_length;
+    shared_message->ref_count = 1;
+
+    return shared_message;
+}
+
+
+void socket_comm_shared_message_ref(pcep_socket_comm_shared_message *shared_message)
+{
+    shared_message->ref_count++;
+}
+
+
+void socket_comm_shared_message_unref(pcep_socket_comm_shared_message *shared_message)
+{
+    if (--shared_message->ref_count == 0)
+    {
+        free(shared_message->unmarshalled_message);
+        free(shared_message);
+    }
+}
+
+
+bool socket_comm_session_send_shared_message(pcep_socket_comm_session *socket_comm_session,
+                                             pcep_socket_comm_shared_message *shared_message,
+                                             pcep_socket_comm_priority priority)
+{
+    mock_socket_metadata.socket_comm_session_send_message_times_called++;
+    if (socket_comm_session == NULL || socket_comm_session->closed)
+    {
+        return false;
+    }
+
+    mock_socket_metadata.last_sent_message_priority = priority;
+
+    /* The message is considered written immediately, so no reference is kept */
+    if (mock_socket_metadata.send_message_save_message == true)
+    {
+        /* the caller/test case is responsible for freeing the copied message */
+        char *message_copy = malloc(shared_message->msg_length);
+        memcpy(message_copy, shared_message->unmarshalled_message, shared_message->msg_length);
+        dll_append(mock_socket_metadata.sent_message_list, message_copy);
+    }
+
+    return true;
 }
 
 
@@ -290,13 +446,17 @@ bool socket_comm_session_close_tcp_after_write(pcep_socket_comm_session *socket_
 {
     mock_socket_metadata.socket_comm_session_close_tcp_after_write_times_called++;
 
-    return true;
+    return (socket_comm_session != NULL && !socket_comm_session->closed);
 }
 
 
 bool socket_comm_session_close_tcp(pcep_socket_comm_session *socket_comm_session)
 {
     mock_socket_metadata.socket_comm_session_close_tcp_times_called++;
+    if (socket_comm_session != NULL)
+    {
+        socket_comm_session->closed = true;
+    }
 
     return true;
 }
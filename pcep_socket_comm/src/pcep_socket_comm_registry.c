@@ -0,0 +1,297 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+/*
+ *  Registry of the active socket_comm sessions.
+ *
+ *  Each session is stored in a slot of the entries array, and the slot
+ *  index together with a generation counter make up the session
+ *  registry_key, which is used by the poller to refer to the session.
+ *  A registry_key from a session that has been removed will not match
+ *  the generation of the slot, even if the slot has been reused.
+ *
+ *  An open addressing hash table of the session pointers is used to check
+ *  if a session pointer is still registered, without dereferencing it.
+ */
+
+#include <malloc.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "pcep_socket_comm_internals.h"
+#include "pcep_utils_logging.h"
+
+#define REGISTRY_INITIAL_NUM_ENTRIES 16
+#define REGISTRY_INITIAL_HASH_SIZE   32
+
+
+/* Internal util function */
+static uint32_t hash_session_pointer(pcep_socket_comm_session *session, uint32_t hash_size)
+{
+    uint64_t value = (uintptr_t) session;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+
+    /* The hash_size is always a power of 2 */
+    return ((uint32_t) value) & (hash_size - 1);
+}
+
+
+/* Internal util function, returns the hash index of the session or -1 */
+static int64_t find_hash_index(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session)
+{
+    uint32_t index = hash_session_pointer(session, registry->hash_size);
+    while (registry->hash_buckets[index] != NULL)
+    {
+        if (registry->hash_buckets[index] == session)
+        {
+            return index;
+        }
+        index = (index + 1) & (registry->hash_size - 1);
+    }
+
+    return -1;
+}
+
+
+/* Internal util function, the hash must have at least 1 empty bucket */
+static void hash_insert(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session)
+{
+    uint32_t index = hash_session_pointer(session, registry->hash_size);
+    while (registry->hash_buckets[index] != NULL)
+    {
+        index = (index + 1) & (registry->hash_size - 1);
+    }
+    registry->hash_buckets[index] = session;
+}
+
+
+/* Internal util function, grow the hash when its more than half full */
+static void hash_grow(pcep_socket_comm_registry *registry)
+{
+    pcep_socket_comm_session **old_buckets = registry->hash_buckets;
+    uint32_t old_hash_size = registry->hash_size;
+
+    registry->hash_size *= 2;
+    registry->hash_buckets = malloc(sizeof(pcep_socket_comm_session *) * registry->hash_size);
+    bzero(registry->hash_buckets, sizeof(pcep_socket_comm_session *) * registry->hash_size);
+
+    uint32_t i;
+    for (i = 0; i < old_hash_size; i++)
+    {
+        if (old_buckets[i] != NULL)
+        {
+            hash_insert(registry, old_buckets[i]);
+        }
+    }
+
+    free(old_buckets);
+}
+
+
+/* Internal util function, remove the entry at the hash index by shifting
+ * back the entries that follow it, so no tombstones are needed */
+static void hash_remove(pcep_socket_comm_registry *registry, uint32_t index)
+{
+    uint32_t mask = registry->hash_size - 1;
+    uint32_t next_index = index;
+
+    for (;;)
+    {
+        next_index = (next_index + 1) & mask;
+        pcep_socket_comm_session *session = registry->hash_buckets[next_index];
+        if (session == NULL)
+        {
+            break;
+        }
+
+        /* Only move the entry if its home bucket is not between the
+         * removed index and its current position */
+        uint32_t home_index = hash_session_pointer(session, registry->hash_size);
+        bool can_move = (index <= next_index) ?
+                (home_index <= index || home_index > next_index) :
+                (home_index <= index && home_index > next_index);
+        if (can_move)
+        {
+            registry->hash_buckets[index] = session;
+            index = next_index;
+        }
+    }
+
+    registry->hash_buckets[index] = NULL;
+}
+
+
+/* Internal util function, returns the index of a free slot, growing the entries as needed */
+static uint32_t allocate_slot(pcep_socket_comm_registry *registry)
+{
+    if (registry->free_slot_head == REGISTRY_NO_SLOT)
+    {
+        uint32_t old_num_entries = registry->num_entries_allocated;
+        registry->num_entries_allocated *= 2;
+        registry->entries = realloc(registry->entries,
+                sizeof(pcep_socket_comm_registry_entry) * registry->num_entries_allocated);
+
+        /* chain the new slots to the free list */
+        uint32_t slot;
+        for (slot = old_num_entries; slot < registry->num_entries_allocated; slot++)
+        {
+            registry->entries[slot].session = NULL;
+            registry->entries[slot].generation = 0;
+            registry->entries[slot].next_free_slot =
+                    (slot + 1 < registry->num_entries_allocated) ? slot + 1 : REGISTRY_NO_SLOT;
+        }
+        registry->free_slot_head = old_num_entries;
+    }
+
+    uint32_t slot = registry->free_slot_head;
+    registry->free_slot_head = registry->entries[slot].next_free_slot;
+
+    return slot;
+}
+
+
+bool socket_comm_registry_initialize(pcep_socket_comm_registry *registry)
+{
+    bzero(registry, sizeof(pcep_socket_comm_registry));
+
+    registry->num_entries_allocated = REGISTRY_INITIAL_NUM_ENTRIES;
+    registry->entries = malloc(sizeof(pcep_socket_comm_registry_entry) * registry->num_entries_allocated);
+    uint32_t slot;
+    for (slot = 0; slot < registry->num_entries_allocated; slot++)
+    {
+        registry->entries[slot].session = NULL;
+        registry->entries[slot].generation = 0;
+        registry->entries[slot].next_free_slot =
+                (slot + 1 < registry->num_entries_allocated) ? slot + 1 : REGISTRY_NO_SLOT;
+    }
+    registry->free_slot_head = 0;
+
+    registry->hash_size = REGISTRY_INITIAL_HASH_SIZE;
+    registry->hash_buckets = malloc(sizeof(pcep_socket_comm_session *) * registry->hash_size);
+    bzero(registry->hash_buckets, sizeof(pcep_socket_comm_session *) * registry->hash_size);
+
+    return true;
+}
+
+
+void socket_comm_registry_destroy(pcep_socket_comm_registry *registry)
+{
+    free(registry->entries);
+    free(registry->hash_buckets);
+    bzero(registry, sizeof(pcep_socket_comm_registry));
+}
+
+
+bool socket_comm_registry_add(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session)
+{
+    if (session == NULL)
+    {
+        pcep_log(LOG_WARNING, "Cannot add NULL session to the socket_comm registry");
+        return false;
+    }
+
+    if (find_hash_index(registry, session) >= 0)
+    {
+        /* already registered */
+        return true;
+    }
+
+    /* Generation 0 is never used, so a registry_key is never 0, and the
+     * max generation is reserved for SOCKET_COMM_WAKEUP_KEY */
+    registry->next_generation++;
+    if (registry->next_generation == 0 || registry->next_generation == UINT32_MAX)
+    {
+        registry->next_generation = 1;
+    }
+
+    uint32_t slot = allocate_slot(registry);
+    registry->entries[slot].session = session;
+    registry->entries[slot].generation = registry->next_generation;
+    session->registry_key = (((uint64_t) registry->next_generation) << 32) | slot;
+
+    if ((registry->num_sessions + 1) * 2 > registry->hash_size)
+    {
+        hash_grow(registry);
+    }
+    hash_insert(registry, session);
+    registry->num_sessions++;
+
+    return true;
+}
+
+
+bool socket_comm_registry_remove(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session)
+{
+    int64_t hash_index = find_hash_index(registry, session);
+    if (hash_index < 0)
+    {
+        return false;
+    }
+
+    hash_remove(registry, (uint32_t) hash_index);
+    registry->num_sessions--;
+
+    uint32_t slot = (uint32_t) (session->registry_key & UINT32_MAX);
+    registry->entries[slot].session = NULL;
+    registry->entries[slot].generation = 0;
+    registry->entries[slot].next_free_slot = registry->free_slot_head;
+    registry->free_slot_head = slot;
+
+    return true;
+}
+
+
+bool socket_comm_registry_contains(pcep_socket_comm_registry *registry, pcep_socket_comm_session *session)
+{
+    if (session == NULL)
+    {
+        return false;
+    }
+
+    return (find_hash_index(registry, session) >= 0);
+}
+
+
+pcep_socket_comm_session *socket_comm_registry_find(pcep_socket_comm_registry *registry, uint64_t registry_key)
+{
+    uint32_t slot = (uint32_t) (registry_key & UINT32_MAX);
+    uint32_t generation = (uint32_t) (registry_key >> 32);
+
+    if (slot >= registry->num_entries_allocated || generation == 0)
+    {
+        return NULL;
+    }
+
+    if (registry->entries[slot].generation != generation)
+    {
+        /* The session was removed, and the slot may have been reused */
+        return NULL;
+    }
+
+    return registry->entries[slot].session;
+}
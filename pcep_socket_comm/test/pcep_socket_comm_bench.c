@@ -0,0 +1,264 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+/*
+ *  Loopback benchmark of the socket_comm_loop backends.
+ *
+ *  A session sends messages to a local echo server, and waits for each
+ *  burst of messages to be echoed back before sending the next one. The
+ *  number of syscalls made by the socket_comm_loop per message is printed
+ *  for each backend, the wakeup writes made by the sending thread are not
+ *  counted, since they are the same for all the backends.
+ *
+ *  Usage: pcep_socket_comm_bench [num_messages] [burst_size] [message_size]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "pcep_socket_comm.h"
+#include "pcep_socket_comm_internals.h"
+#include "pcep_utils_logging.h"
+
+#define DEFAULT_NUM_MESSAGES 10000
+#define DEFAULT_BURST_SIZE 1
+#define DEFAULT_MESSAGE_SIZE 64
+#define MAX_MESSAGE_SIZE 4096
+#define ECHO_TIMEOUT_SECONDS 10
+
+extern pcep_socket_comm_reactors *socket_comm_reactors_;
+
+typedef struct bench_session_data_
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint64_t bytes_received;
+
+} bench_session_data;
+
+
+static void bench_message_received_handler(void *session_data, char *message_data, unsigned int message_length)
+{
+    bench_session_data *data = session_data;
+    pthread_mutex_lock(&data->mutex);
+    data->bytes_received += message_length;
+    pthread_cond_signal(&data->cond);
+    pthread_mutex_unlock(&data->mutex);
+}
+
+
+static void bench_connection_except_notifier(void *session_data, int socket_fd)
+{
+    fprintf(stderr, "The echo server closed the connection on socket [%d]\n", socket_fd);
+}
+
+
+/* Echo all the data received on the first accepted connection */
+static void *echo_server(void *data)
+{
+    int listen_fd = *((int *) data);
+    int socket_fd = accept(listen_fd, NULL, NULL);
+    if (socket_fd < 0)
+    {
+        return NULL;
+    }
+
+    char buffer[MAX_MESSAGE_SIZE];
+    ssize_t bytes_read;
+    while ((bytes_read = read(socket_fd, buffer, sizeof(buffer))) > 0)
+    {
+        ssize_t bytes_written = 0;
+        while (bytes_written < bytes_read)
+        {
+            ssize_t result = write(socket_fd, buffer + bytes_written, bytes_read - bytes_written);
+            if (result <= 0)
+            {
+                close(socket_fd);
+                return NULL;
+            }
+            bytes_written += result;
+        }
+    }
+
+    close(socket_fd);
+    return NULL;
+}
+
+
+static double elapsed_millis(struct timespec *start, struct timespec *end)
+{
+    return ((end->tv_sec - start->tv_sec) * 1000.0) + ((end->tv_nsec - start->tv_nsec) / 1000000.0);
+}
+
+
+static bool run_bench(pcep_socket_comm_backend backend, int num_messages, int burst_size, int message_size)
+{
+    /* Listen on an ephemeral loopback port */
+    struct sockaddr_in listen_addr;
+    bzero(&listen_addr, sizeof(struct sockaddr_in));
+    listen_addr.sin_family = AF_INET;
+    listen_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listen_addr.sin_port = 0;
+    socklen_t addr_len = sizeof(struct sockaddr_in);
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0 ||
+            bind(listen_fd, (struct sockaddr *) &listen_addr, addr_len) < 0 ||
+            listen(listen_fd, 1) < 0 ||
+            getsockname(listen_fd, (struct sockaddr *) &listen_addr, &addr_len) < 0)
+    {
+        fprintf(stderr, "Cannot listen on the loopback address\n");
+        return false;
+    }
+
+    pthread_t echo_thread;
+    pthread_create(&echo_thread, NULL, echo_server, &listen_fd);
+
+    pcep_socket_comm_config config;
+    bzero(&config, sizeof(pcep_socket_comm_config));
+    config.num_reactor_threads = 1;
+    config.backend = backend;
+    if (!initialize_socket_comm_loop_with_config(&config))
+    {
+        fprintf(stderr, "Cannot initialize the socket_comm_loop\n");
+        return false;
+    }
+    pcep_socket_comm_handle *socket_comm_handle = socket_comm_reactors_->reactors[0];
+
+    bench_session_data session_data;
+    bzero(&session_data, sizeof(bench_session_data));
+    pthread_mutex_init(&session_data.mutex, NULL);
+    pthread_cond_init(&session_data.cond, NULL);
+
+    struct in_addr dest_ip;
+    dest_ip.s_addr = htonl(INADDR_LOOPBACK);
+    pcep_socket_comm_session *socket_comm_session = socket_comm_session_initialize(
+            bench_message_received_handler, NULL, NULL, bench_connection_except_notifier,
+            &dest_ip, ntohs(listen_addr.sin_port), 1000, &session_data);
+    if (socket_comm_session == NULL || !socket_comm_session_connect_tcp(socket_comm_session))
+    {
+        fprintf(stderr, "Cannot connect to the echo server\n");
+        return false;
+    }
+
+    char *message = malloc(message_size);
+    memset(message, 'P', message_size);
+
+    /* Only count the syscalls made while sending the messages */
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    uint64_t start_syscalls = socket_comm_handle->num_poller_syscalls + socket_comm_handle->num_read_syscalls;
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    struct timespec start_time, end_time;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    bool success = true;
+    int num_sent = 0;
+    while (num_sent < num_messages && success)
+    {
+        int i;
+        for (i = 0; i < burst_size && num_sent < num_messages; i++, num_sent++)
+        {
+            socket_comm_session_send_message(socket_comm_session, message, message_size, false);
+        }
+
+        /* Wait for the burst to be echoed back */
+        uint64_t expected_bytes = ((uint64_t) num_sent) * message_size;
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += ECHO_TIMEOUT_SECONDS;
+        pthread_mutex_lock(&session_data.mutex);
+        while (session_data.bytes_received < expected_bytes && success)
+        {
+            success = (pthread_cond_timedwait(&session_data.cond, &session_data.mutex, &timeout) == 0);
+        }
+        pthread_mutex_unlock(&session_data.mutex);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    pthread_mutex_lock(&(socket_comm_handle->socket_comm_mutex));
+    uint64_t num_syscalls = socket_comm_handle->num_poller_syscalls + socket_comm_handle->num_read_syscalls +
+            socket_comm_session->num_write_syscalls - start_syscalls;
+    pcep_socket_comm_backend backend_used = socket_comm_handle->backend;
+    pthread_mutex_unlock(&(socket_comm_handle->socket_comm_mutex));
+
+    if (success)
+    {
+        printf("%-8s messages [%d] burst [%d] size [%d] loop syscalls [%lu] syscalls/message [%.3f] time [%.1f ms]\n",
+                (backend_used == SOCKET_COMM_BACKEND_IO_URING ? "io_uring" : "default"),
+                num_messages, burst_size, message_size, num_syscalls,
+                ((double) num_syscalls) / num_messages, elapsed_millis(&start_time, &end_time));
+    }
+    else
+    {
+        fprintf(stderr, "Timed out waiting for the echo server\n");
+    }
+
+    socket_comm_session_teardown(socket_comm_session);
+    destroy_socket_comm_loop();
+    pthread_join(echo_thread, NULL);
+    close(listen_fd);
+    pthread_mutex_destroy(&session_data.mutex);
+    pthread_cond_destroy(&session_data.cond);
+    free(message);
+
+    if (backend_used != backend)
+    {
+        printf("io_uring is not supported, the default backend was used\n");
+    }
+
+    return success;
+}
+
+
+int main(int argc, char **argv)
+{
+    int num_messages = (argc > 1 ? atoi(argv[1]) : DEFAULT_NUM_MESSAGES);
+    int burst_size = (argc > 2 ? atoi(argv[2]) : DEFAULT_BURST_SIZE);
+    int message_size = (argc > 3 ? atoi(argv[3]) : DEFAULT_MESSAGE_SIZE);
+    if (num_messages <= 0 || burst_size <= 0 || message_size <= 0 || message_size > MAX_MESSAGE_SIZE)
+    {
+        fprintf(stderr, "Usage: pcep_socket_comm_bench [num_messages] [burst_size] [message_size <= %d]\n",
+                MAX_MESSAGE_SIZE);
+        return 1;
+    }
+
+    /* The socket_comm INFO logs would dominate the measurements */
+    set_logging_level(LOG_WARNING);
+
+    bool success = run_bench(SOCKET_COMM_BACKEND_DEFAULT, num_messages, burst_size, message_size);
+    success &= run_bench(SOCKET_COMM_BACKEND_IO_URING, num_messages, burst_size, message_size);
+
+    return (success ? 0 : 1);
+}
@@ -23,8 +23,13 @@
  */
 
 
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
 
 #include <CUnit/CUnit.h>
 
@@ -34,12 +39,14 @@
  * Functions to be tested, implemented in pcep_socket_comm_loop.c
  */
 extern void handle_reads(pcep_socket_comm_handle *socket_comm_handle);
-extern int socket_fd_node_compare(void *list_entry, void *new_entry);
+extern void handle_writes(pcep_socket_comm_handle *socket_comm_handle);
+extern void wait_for_ready_sessions(pcep_socket_comm_handle *socket_comm_handle, int timeout_millis);
 
 typedef struct ready_to_read_handler_info_
 {
     bool handler_called;
     bool except_handler_called;
+    bool read_interest_on_except;
     void *data;
     int socket_fd;
     int bytes_read;
@@ -63,6 +70,7 @@ static int test_loop_message_ready_to_read_handler(void *session_data, int socke
 void test_loop_conn_except_notifier(void *session_data, int socket_fd)
 {
     read_handler_info.except_handler_called = true;
+    read_handler_info.read_interest_on_except = test_comm_session->read_interest;
 }
 
 
@@ -74,16 +82,15 @@ void pcep_socket_comm_loop_test_setup()
     test_socket_comm_handle = malloc(sizeof(pcep_socket_comm_handle));
     bzero(test_socket_comm_handle, sizeof(pcep_socket_comm_handle));
     test_socket_comm_handle->active = false;
-    test_socket_comm_handle->read_list = ordered_list_initialize(socket_fd_node_compare);
-    test_socket_comm_handle->write_list = ordered_list_initialize(socket_fd_node_compare);
-    test_socket_comm_handle->session_list = ordered_list_initialize(pointer_compare_function);
+    socket_comm_poller_initialize(test_socket_comm_handle);
+    socket_comm_registry_initialize(&test_socket_comm_handle->session_registry);
     pthread_mutex_init(&test_socket_comm_handle->socket_comm_mutex, NULL);
     test_socket_comm_handle->num_active_sessions = 0;
 
     test_comm_session = malloc(sizeof(pcep_socket_comm_session));
     bzero(test_comm_session, sizeof(pcep_socket_comm_session));
     test_comm_session->message_ready_to_read_handler = test_loop_message_ready_to_read_handler;
-    ordered_list_add_node(test_socket_comm_handle->session_list, test_comm_session);
+    socket_comm_registry_add(&test_socket_comm_handle->session_registry, test_comm_session);
 
     read_handler_info.handler_called = false;
     read_handler_info.except_handler_called = false;
@@ -96,9 +103,8 @@ void pcep_socket_comm_loop_test_setup()
 void pcep_socket_comm_loop_test_teardown()
 {
     pthread_mutex_destroy(&test_socket_comm_handle->socket_comm_mutex);
-    ordered_list_destroy(test_socket_comm_handle->read_list);
-    ordered_list_destroy(test_socket_comm_handle->write_list);
-    ordered_list_destroy(test_socket_comm_handle->session_list);
+    socket_comm_poller_destroy(test_socket_comm_handle);
+    socket_comm_registry_destroy(&test_socket_comm_handle->session_registry);
     free(test_socket_comm_handle);
     test_socket_comm_handle = NULL;
 
@@ -110,6 +116,30 @@ void pcep_socket_comm_loop_test_teardown()
 }
 
 
+/* Simulate the poller reporting the session as ready to be read */
+static void set_read_ready(pcep_socket_comm_session *comm_session)
+{
+#ifdef PCEP_SOCKET_COMM_USE_SELECT
+    socket_comm_add_read_interest(test_socket_comm_handle, comm_session);
+#endif
+    int index = test_socket_comm_handle->num_ready_events++;
+    test_socket_comm_handle->ready_events[index].registry_key = comm_session->registry_key;
+    test_socket_comm_handle->ready_events[index].ready_flags = SOCKET_COMM_READY_READ;
+}
+
+
+/* Returns true if the session is not registered to be read from */
+static bool read_interest_removed()
+{
+#ifdef PCEP_SOCKET_COMM_USE_SELECT
+    return (test_socket_comm_handle->read_list_head == NULL);
+#else
+    /* Deleting an unregistered socket_fd from epoll fails with ENOENT */
+    return (epoll_ctl(test_socket_comm_handle->epoll_fd, EPOLL_CTL_DEL, test_comm_session->socket_fd, NULL) < 0);
+#endif
+}
+
+
 /*
  * Test cases
  */
@@ -132,13 +162,10 @@ void test_socket_comm_loop_not_active()
 
 void test_handle_reads_no_read()
 {
-    CU_ASSERT_PTR_NULL(test_socket_comm_handle->read_list->head);
-
     handle_reads(test_socket_comm_handle);
 
     CU_ASSERT_FALSE(read_handler_info.handler_called);
     CU_ASSERT_FALSE(read_handler_info.except_handler_called);
-    CU_ASSERT_PTR_NULL(test_socket_comm_handle->read_list->head);
 }
 
 
@@ -148,8 +175,7 @@ void test_handle_reads_read_message()
      * It should read 100 bytes, which simulates a successful read */
     test_comm_session->socket_fd = 10;
     read_handler_info.bytes_read = 100;
-    FD_SET(test_comm_session->socket_fd, &test_socket_comm_handle->read_master_set);
-    ordered_list_add_node(test_socket_comm_handle->read_list, test_comm_session);
+    set_read_ready(test_comm_session);
 
     handle_reads(test_socket_comm_handle);
 
@@ -165,13 +191,633 @@ void test_handle_reads_read_message_close()
      * It should read 0 bytes, which simulates that the socket closed */
     test_comm_session->socket_fd = 11;
     read_handler_info.bytes_read = 0;
-    FD_SET(test_comm_session->socket_fd, &test_socket_comm_handle->read_master_set);
-    ordered_list_add_node(test_socket_comm_handle->read_list, test_comm_session);
+    set_read_ready(test_comm_session);
 
     handle_reads(test_socket_comm_handle);
 
     CU_ASSERT_TRUE(read_handler_info.handler_called);
     CU_ASSERT_FALSE(read_handler_info.except_handler_called);
     CU_ASSERT_EQUAL(test_comm_session->received_bytes, read_handler_info.bytes_read);
-    CU_ASSERT_PTR_NULL(test_socket_comm_handle->read_list->head);
+    CU_ASSERT_TRUE(read_interest_removed());
+
+    /* The socket is no longer read when the conn_except_notifier is
+     * called, since the comm_session may be torn down from then on */
+    test_comm_session->conn_except_notifier = test_loop_conn_except_notifier;
+    read_handler_info.handler_called = false;
+    set_read_ready(test_comm_session);
+
+    handle_reads(test_socket_comm_handle);
+
+    CU_ASSERT_TRUE(read_handler_info.handler_called);
+    CU_ASSERT_TRUE(read_handler_info.except_handler_called);
+    CU_ASSERT_FALSE(read_handler_info.read_interest_on_except);
+    CU_ASSERT_EQUAL(test_comm_session->received_bytes, read_handler_info.bytes_read);
+    CU_ASSERT_TRUE(read_interest_removed());
+}
+
+
+static int loop_num_messages_received = 0;
+static unsigned int loop_bytes_received = 0;
+
+static void test_loop_count_message_received_handler(void *session_data, char *message_data, unsigned int message_length)
+{
+    loop_num_messages_received++;
+    loop_bytes_received += message_length;
+}
+
+
+void test_handle_reads_read_message_bigger_than_buffer()
+{
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->message_ready_to_read_handler = NULL;
+    test_comm_session->message_handler = test_loop_count_message_received_handler;
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+    loop_num_messages_received = 0;
+    loop_bytes_received = 0;
+
+    /* The received data doesnt fit in the received_message buffer,
+     * so it is handed to the message_handler in 2 parts */
+    char message[MAX_RECVD_MSG_SIZE + 100];
+    memset(message, 'x', sizeof(message));
+    CU_ASSERT_EQUAL(write(socket_fds[1], message, sizeof(message)), sizeof(message));
+    CU_ASSERT_EQUAL(fcntl(socket_fds[0], F_SETFL, O_NONBLOCK), 0);
+
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_reads(test_socket_comm_handle);
+
+    CU_ASSERT_EQUAL(loop_num_messages_received, 2);
+    CU_ASSERT_EQUAL(loop_bytes_received, sizeof(message));
+    CU_ASSERT_EQUAL(test_comm_session->received_bytes, sizeof(message));
+    CU_ASSERT_EQUAL(test_comm_session->closed, false);
+
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    close(socket_fds[0]);
+    close(socket_fds[1]);
+}
+
+
+void test_handle_writes_write_interest()
+{
+    /* Use a socketpair so the poller reports a real writable socket */
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->message_queue = queue_initialize();
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+
+    /* Nothing is queued, so the session should not be reported as ready */
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+    CU_ASSERT_FALSE(test_comm_session->write_interest);
+
+    /* Queue a message and set the write interest, as socket_comm_session_send_message() does */
+    char message[] = "PCEP";
+    pcep_socket_comm_queued_message *queued_message = malloc(sizeof(pcep_socket_comm_queued_message));
+    queued_message->unmarshalled_message = message;
+    queued_message->msg_length = strlen(message);
+    queued_message->free_after_send = false;
+    queued_message->shared_message = NULL;
+    queue_enqueue(test_comm_session->message_queue, queued_message);
+    socket_comm_set_write_interest(test_socket_comm_handle, test_comm_session, true);
+    CU_ASSERT_TRUE(test_comm_session->write_interest);
+
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+
+    /* The message was written and the write interest removed */
+    CU_ASSERT_FALSE(test_comm_session->write_interest);
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    char read_buf[16];
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), strlen(message));
+
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(socket_fds[0]);
+    close(socket_fds[1]);
+}
+
+
+/* Internal util function */
+static void enqueue_test_message(char *message)
+{
+    pcep_socket_comm_queued_message *queued_message = malloc(sizeof(pcep_socket_comm_queued_message));
+    queued_message->unmarshalled_message = message;
+    queued_message->msg_length = strlen(message);
+    queued_message->free_after_send = false;
+    queued_message->shared_message = NULL;
+    queued_message->priority = SOCKET_COMM_PRIORITY_BULK;
+    queue_enqueue(test_comm_session->message_queue, queued_message);
+}
+
+
+void test_handle_writes_batch()
+{
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+
+    /* All the queued messages should be written with 1 syscall */
+    char message1[] = "PCEP1";
+    char message2[] = "PCEP22";
+    char message3[] = "PCEP333";
+    enqueue_test_message(message1);
+    enqueue_test_message(message2);
+    enqueue_test_message(message3);
+    socket_comm_set_write_interest(test_socket_comm_handle, test_comm_session, true);
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(test_comm_session->num_write_syscalls, 1);
+    CU_ASSERT_EQUAL(test_comm_session->num_messages_written, 3);
+    char read_buf[32];
+    bzero(read_buf, sizeof(read_buf));
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), 18);
+    CU_ASSERT_STRING_EQUAL(read_buf, "PCEP1PCEP22PCEP333");
+
+    /* Limit the batch size so only 2 messages fit in each syscall */
+    test_comm_session->max_write_batch_bytes = 12;
+    enqueue_test_message(message1);
+    enqueue_test_message(message2);
+    enqueue_test_message(message3);
+    socket_comm_set_write_interest(test_socket_comm_handle, test_comm_session, true);
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(test_comm_session->num_write_syscalls, 3);
+    CU_ASSERT_EQUAL(test_comm_session->num_messages_written, 6);
+    bzero(read_buf, sizeof(read_buf));
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), 18);
+    CU_ASSERT_STRING_EQUAL(read_buf, "PCEP1PCEP22PCEP333");
+
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(socket_fds[0]);
+    close(socket_fds[1]);
+}
+
+
+void test_handle_writes_priority()
+{
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->socket_comm_handle = test_socket_comm_handle;
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+
+    char bulk1[] = "BULK1";
+    char bulk2[] = "BULK2";
+    char control1[] = "CTRL1";
+    char control2[] = "CTRL2";
+    socket_comm_session_send_message(test_comm_session, bulk1, strlen(bulk1), false);
+    socket_comm_session_send_message(test_comm_session, bulk2, strlen(bulk2), false);
+
+    /* The head message was partially written, so it cant be overtaken,
+     * and the control messages are kept in the order they were sent */
+    test_comm_session->flushed_bytes = 2;
+    socket_comm_session_send_message_with_priority(
+            test_comm_session, control1, strlen(control1), false, SOCKET_COMM_PRIORITY_CONTROL);
+    socket_comm_session_send_message_with_priority(
+            test_comm_session, control2, strlen(control2), false, SOCKET_COMM_PRIORITY_CONTROL);
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 4);
+
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    char read_buf[32];
+    bzero(read_buf, sizeof(read_buf));
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), 18);
+    CU_ASSERT_STRING_EQUAL(read_buf, "LK1CTRL1CTRL2BULK2");
+
+    /* Without a partial write, the control message is written first */
+    socket_comm_session_send_message(test_comm_session, bulk1, strlen(bulk1), false);
+    socket_comm_session_send_message_with_priority(
+            test_comm_session, control1, strlen(control1), false, SOCKET_COMM_PRIORITY_CONTROL);
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+
+    bzero(read_buf, sizeof(read_buf));
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), 10);
+    CU_ASSERT_STRING_EQUAL(read_buf, "CTRL1BULK1");
+
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(socket_fds[0]);
+    close(socket_fds[1]);
+}
+
+
+void test_handle_writes_shared_message()
+{
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->socket_comm_handle = test_socket_comm_handle;
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+
+    CU_ASSERT_PTR_NULL(socket_comm_shared_message_create(NULL, 0));
+    char *message = strdup("SHARED");
+    pcep_socket_comm_shared_message *shared_message =
+            socket_comm_shared_message_create(message, strlen(message));
+    CU_ASSERT_PTR_NOT_NULL_FATAL(shared_message);
+    CU_ASSERT_EQUAL(shared_message->ref_count, 1);
+
+    /* Each queued message references the same shared message */
+    socket_comm_session_send_shared_message(test_comm_session, shared_message, SOCKET_COMM_PRIORITY_BULK);
+    socket_comm_session_send_shared_message(test_comm_session, shared_message, SOCKET_COMM_PRIORITY_BULK);
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 2);
+    CU_ASSERT_EQUAL(test_comm_session->num_bytes_pending, 2 * strlen(message));
+    CU_ASSERT_EQUAL(shared_message->ref_count, 3);
+
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+
+    /* The written messages released their references */
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(shared_message->ref_count, 1);
+    char read_buf[32];
+    bzero(read_buf, sizeof(read_buf));
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), 12);
+    CU_ASSERT_STRING_EQUAL(read_buf, "SHAREDSHARED");
+
+    /* Releasing the last reference frees the message */
+    socket_comm_shared_message_unref(shared_message);
+
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(socket_fds[0]);
+    close(socket_fds[1]);
+}
+
+
+/* Internal util function, read from the real socket like the
+ * session_logic message_ready_to_read_handler does */
+static int test_loop_read_socket_handler(void *session_data, int socket_fd)
+{
+    char read_buf[16];
+    read_handler_info.handler_called = true;
+    return read(socket_fd, read_buf, sizeof(read_buf));
+}
+
+
+static bool loop_message_sent_handler_called = false;
+
+static void test_loop_message_sent_handler(void *session_data, int socket_fd, bool socket_closed)
+{
+    loop_message_sent_handler_called = true;
+}
+
+
+void test_handle_writes_send_after_close()
+{
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->socket_comm_handle = test_socket_comm_handle;
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
+    test_comm_session->message_ready_to_read_handler = test_loop_read_socket_handler;
+    test_comm_session->message_sent_handler = test_loop_message_sent_handler;
+    test_comm_session->conn_except_notifier = test_loop_conn_except_notifier;
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+    loop_message_sent_handler_called = false;
+
+    /* The peer closes the connection, which is detected when reading */
+    close(socket_fds[1]);
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_reads(test_socket_comm_handle);
+    CU_ASSERT_TRUE(read_handler_info.handler_called);
+    CU_ASSERT_TRUE(read_handler_info.except_handler_called);
+    CU_ASSERT_TRUE(test_comm_session->closed);
+
+    /* The messages sent once the socket is closed are dropped, without
+     * setting the write interest, since the comm_session may be torn down */
+    socket_comm_session_send_message(test_comm_session, strdup("PCEP"), 4, true);
+    char *message = strdup("SHARED");
+    pcep_socket_comm_shared_message *shared_message =
+            socket_comm_shared_message_create(message, strlen(message));
+    socket_comm_session_send_shared_message(test_comm_session, shared_message, SOCKET_COMM_PRIORITY_CONTROL);
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(test_comm_session->num_bytes_pending, 0);
+    CU_ASSERT_EQUAL(shared_message->ref_count, 1);
+    CU_ASSERT_FALSE(socket_comm_session_close_tcp_after_write(test_comm_session));
+    CU_ASSERT_FALSE(test_comm_session->write_interest);
+
+    /* Even if the write interest is set, a closed session is not written */
+    test_comm_session->write_interest = true;
+    int index = test_socket_comm_handle->num_ready_events++;
+    test_socket_comm_handle->ready_events[index].registry_key = test_comm_session->registry_key;
+    test_socket_comm_handle->ready_events[index].ready_flags = SOCKET_COMM_READY_WRITE;
+    handle_writes(test_socket_comm_handle);
+    CU_ASSERT_FALSE(loop_message_sent_handler_called);
+
+    socket_comm_shared_message_unref(shared_message);
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(socket_fds[0]);
+}
+
+
+void test_handle_writes_partial_write()
+{
+    /* Use a non-blocking socket with a small send buffer,
+     * so it can only take part of a big message */
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    int send_buf_size = 4096;
+    setsockopt(socket_fds[0], SOL_SOCKET, SO_SNDBUF, &send_buf_size, sizeof(int));
+    fcntl(socket_fds[0], F_SETFL, fcntl(socket_fds[0], F_GETFL) | O_NONBLOCK);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+
+    unsigned int message_length = 512 * 1024;
+    char *message = malloc(message_length);
+    memset(message, 'P', message_length);
+    pcep_socket_comm_queued_message *queued_message = malloc(sizeof(pcep_socket_comm_queued_message));
+    queued_message->unmarshalled_message = message;
+    queued_message->msg_length = message_length;
+    queued_message->free_after_send = true;
+    queued_message->shared_message = NULL;
+    queue_enqueue(test_comm_session->message_queue, queued_message);
+    test_comm_session->num_bytes_pending = message_length;
+    socket_comm_set_write_interest(test_socket_comm_handle, test_comm_session, true);
+
+    /* Only part of the message is written, and the rest is left pending */
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    handle_writes(test_socket_comm_handle);
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 1);
+    CU_ASSERT_TRUE(test_comm_session->write_interest);
+    CU_ASSERT_EQUAL(test_comm_session->num_partial_writes, 1);
+    CU_ASSERT_EQUAL(test_comm_session->num_messages_written, 0);
+    CU_ASSERT_TRUE(test_comm_session->flushed_bytes > 0);
+    CU_ASSERT_EQUAL(test_comm_session->num_bytes_pending, message_length - test_comm_session->flushed_bytes);
+
+    /* Read from the other end, and resume writing when the socket is writable */
+    char read_buf[8192];
+    unsigned int total_bytes_read = 0;
+    int num_loops = 0;
+    while (total_bytes_read < message_length && num_loops++ < 10000)
+    {
+        ssize_t bytes_read = read(socket_fds[1], read_buf, sizeof(read_buf));
+        if (bytes_read > 0)
+        {
+            total_bytes_read += bytes_read;
+        }
+        wait_for_ready_sessions(test_socket_comm_handle, 0);
+        handle_writes(test_socket_comm_handle);
+    }
+
+    CU_ASSERT_EQUAL(total_bytes_read, message_length);
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    CU_ASSERT_FALSE(test_comm_session->write_interest);
+    CU_ASSERT_EQUAL(test_comm_session->num_messages_written, 1);
+    CU_ASSERT_EQUAL(test_comm_session->num_bytes_pending, 0);
+    CU_ASSERT_EQUAL(test_comm_session->flushed_bytes, 0);
+    CU_ASSERT_TRUE(test_comm_session->num_partial_writes > 1);
+
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(socket_fds[0]);
+    close(socket_fds[1]);
+}
+
+
+void test_socket_comm_loop_wakeup()
+{
+    /* Nothing is ready, so the poller should return without any sessions */
+    wait_for_ready_sessions(test_socket_comm_handle, 0);
+    CU_ASSERT_FALSE(test_socket_comm_handle->wakeup_pending);
+
+    /* Consecutive wakeups should be coalesced until the loop drains them */
+    socket_comm_wakeup_loop(test_socket_comm_handle);
+    CU_ASSERT_TRUE(test_socket_comm_handle->wakeup_pending);
+    socket_comm_wakeup_loop(test_socket_comm_handle);
+    CU_ASSERT_TRUE(test_socket_comm_handle->wakeup_pending);
+
+    /* Would block forever if the wakeup fd was not ready */
+    wait_for_ready_sessions(test_socket_comm_handle, -1);
+    CU_ASSERT_FALSE(test_socket_comm_handle->wakeup_pending);
+    /* The wakeup fd is not reported as a ready session */
+    CU_ASSERT_EQUAL(test_socket_comm_handle->num_ready_events, 0);
+
+    handle_reads(test_socket_comm_handle);
+    handle_writes(test_socket_comm_handle);
+    CU_ASSERT_FALSE(read_handler_info.handler_called);
+}
+
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+static char io_uring_received_message[32];
+static unsigned int io_uring_received_length = 0;
+
+static void test_loop_message_received_handler(void *session_data, char *message_data, unsigned int message_length)
+{
+    memcpy(io_uring_received_message + io_uring_received_length, message_data, message_length);
+    io_uring_received_length += message_length;
+}
+#endif
+
+
+void test_socket_comm_loop_io_uring()
+{
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    /* Restart the poller with the io_uring backend */
+    socket_comm_poller_destroy(test_socket_comm_handle);
+    test_socket_comm_handle->backend = SOCKET_COMM_BACKEND_IO_URING;
+    CU_ASSERT_TRUE(socket_comm_poller_initialize(test_socket_comm_handle));
+    if (test_socket_comm_handle->backend != SOCKET_COMM_BACKEND_IO_URING)
+    {
+        /* Not supported by this kernel, the default backend is used */
+        CU_ASSERT_EQUAL(test_socket_comm_handle->backend, SOCKET_COMM_BACKEND_DEFAULT);
+        return;
+    }
+
+    int socket_fds[2];
+    CU_ASSERT_EQUAL(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fds), 0);
+    test_comm_session->socket_fd = socket_fds[0];
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->max_write_batch_bytes = DEFAULT_MAX_WRITE_BATCH_BYTES;
+    test_comm_session->message_ready_to_read_handler = NULL;
+    test_comm_session->message_handler = test_loop_message_received_handler;
+    test_comm_session->conn_except_notifier = test_loop_conn_except_notifier;
+    io_uring_received_length = 0;
+    bzero(io_uring_received_message, sizeof(io_uring_received_message));
+
+    /* The data is received by the multishot recv, without any read() */
+    socket_comm_add_read_interest(test_socket_comm_handle, test_comm_session);
+    CU_ASSERT_EQUAL(write(socket_fds[1], "PCEP", 4), 4);
+    int num_loops = 0;
+    while (io_uring_received_length < 4 && num_loops++ < 10)
+    {
+        wait_for_ready_sessions(test_socket_comm_handle, 1000);
+        handle_reads(test_socket_comm_handle);
+    }
+    CU_ASSERT_EQUAL(io_uring_received_length, 4);
+    CU_ASSERT_STRING_EQUAL(io_uring_received_message, "PCEP");
+    CU_ASSERT_EQUAL(test_comm_session->received_bytes, 4);
+    CU_ASSERT_EQUAL(test_socket_comm_handle->num_read_syscalls, 0);
+
+    /* The queued messages are written by 1 writev submission */
+    char message1[] = "PCEP1";
+    char message2[] = "PCEP22";
+    char message3[] = "PCEP333";
+    enqueue_test_message(message1);
+    enqueue_test_message(message2);
+    enqueue_test_message(message3);
+    socket_comm_set_write_interest(test_socket_comm_handle, test_comm_session, true);
+    num_loops = 0;
+    while (test_comm_session->message_queue->num_entries > 0 && num_loops++ < 10)
+    {
+        wait_for_ready_sessions(test_socket_comm_handle, 1000);
+        handle_writes(test_socket_comm_handle);
+    }
+    CU_ASSERT_EQUAL(test_comm_session->message_queue->num_entries, 0);
+    CU_ASSERT_EQUAL(test_comm_session->num_messages_written, 3);
+    CU_ASSERT_FALSE(test_comm_session->write_interest);
+    CU_ASSERT_FALSE(test_comm_session->write_in_flight);
+    char read_buf[32];
+    bzero(read_buf, sizeof(read_buf));
+    CU_ASSERT_EQUAL(read(socket_fds[1], read_buf, sizeof(read_buf)), 18);
+    CU_ASSERT_STRING_EQUAL(read_buf, "PCEP1PCEP22PCEP333");
+
+    /* Closing the other end is notified, and the read interest removed */
+    close(socket_fds[1]);
+    num_loops = 0;
+    while (!read_handler_info.except_handler_called && num_loops++ < 10)
+    {
+        wait_for_ready_sessions(test_socket_comm_handle, 1000);
+        handle_reads(test_socket_comm_handle);
+    }
+    CU_ASSERT_TRUE(read_handler_info.except_handler_called);
+    CU_ASSERT_FALSE(test_comm_session->read_interest);
+
+    queue_destroy(test_comm_session->message_queue);
+    free(test_comm_session->write_iov);
+    close(socket_fds[0]);
+#endif
+}
+
+
+static bool connect_notifier_called = false;
+static bool connect_notifier_connected = false;
+
+static void test_loop_connect_complete_notifier(void *session_data, int socket_fd, bool connected)
+{
+    connect_notifier_called = true;
+    connect_notifier_connected = connected;
+}
+
+
+/* Internal util function, start an asynchronous connect of the test_comm_session
+ * to the port and run the loop functions until the connect completes */
+static void run_connect_async(unsigned short port)
+{
+    test_comm_session->socket_comm_handle = test_socket_comm_handle;
+    test_comm_session->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->connect_timeout_millis = 1000;
+    test_comm_session->dest_sock_addr.dest_sock_addr_ipv4.sin_family = AF_INET;
+    test_comm_session->dest_sock_addr.dest_sock_addr_ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    test_comm_session->dest_sock_addr.dest_sock_addr_ipv4.sin_port = port;
+    connect_notifier_called = false;
+    connect_notifier_connected = false;
+
+    CU_ASSERT_TRUE(socket_comm_session_connect_tcp_async(test_comm_session, test_loop_connect_complete_notifier));
+    CU_ASSERT_TRUE(test_comm_session->connect_in_progress);
+    CU_ASSERT_PTR_EQUAL(test_socket_comm_handle->connect_list_head, test_comm_session);
+
+    int num_loops = 0;
+    while (!connect_notifier_called && num_loops++ < 10)
+    {
+        wait_for_ready_sessions(test_socket_comm_handle, 1000);
+        handle_reads(test_socket_comm_handle);
+        handle_writes(test_socket_comm_handle);
+    }
+
+    CU_ASSERT_TRUE(connect_notifier_called);
+    CU_ASSERT_FALSE(test_comm_session->connect_in_progress);
+    CU_ASSERT_PTR_NULL(test_socket_comm_handle->connect_list_head);
+    CU_ASSERT_FALSE(read_handler_info.handler_called);
+}
+
+
+/* Internal util function, cleanup after run_connect_async() */
+static void cleanup_connect_async()
+{
+    socket_comm_remove_interest(test_socket_comm_handle, test_comm_session);
+    queue_destroy(test_comm_session->message_queue);
+    close(test_comm_session->socket_fd);
+}
+
+
+void test_socket_comm_loop_connect_async()
+{
+    /* Listen on an ephemeral loopback port */
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in listen_addr;
+    socklen_t listen_addr_len = sizeof(listen_addr);
+    bzero(&listen_addr, sizeof(listen_addr));
+    listen_addr.sin_family = AF_INET;
+    listen_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CU_ASSERT_EQUAL(bind(listen_fd, (struct sockaddr *) &listen_addr, sizeof(listen_addr)), 0);
+    CU_ASSERT_EQUAL(listen(listen_fd, 4), 0);
+    CU_ASSERT_EQUAL(getsockname(listen_fd, (struct sockaddr *) &listen_addr, &listen_addr_len), 0);
+
+    /* The connect completes, and the session is ready to be read */
+    run_connect_async(listen_addr.sin_port);
+    CU_ASSERT_TRUE(connect_notifier_connected);
+    CU_ASSERT_TRUE(test_comm_session->read_interest);
+    cleanup_connect_async();
+
+    /* A connect that times-out is failed by handle_connect_timeouts() */
+    test_comm_session->socket_comm_handle = test_socket_comm_handle;
+    test_comm_session->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    test_comm_session->message_queue = queue_initialize();
+    test_comm_session->dest_sock_addr.dest_sock_addr_ipv4.sin_port = listen_addr.sin_port;
+    connect_notifier_called = false;
+    connect_notifier_connected = true;
+    CU_ASSERT_TRUE(socket_comm_session_connect_tcp_async(test_comm_session, test_loop_connect_complete_notifier));
+    test_comm_session->connect_deadline_millis = 0;
+    handle_connect_timeouts(test_socket_comm_handle);
+    CU_ASSERT_TRUE(connect_notifier_called);
+    CU_ASSERT_FALSE(connect_notifier_connected);
+    CU_ASSERT_FALSE(test_comm_session->connect_in_progress);
+    CU_ASSERT_FALSE(test_comm_session->read_interest);
+    CU_ASSERT_PTR_NULL(test_socket_comm_handle->connect_list_head);
+    cleanup_connect_async();
+
+#ifdef PCEP_SOCKET_COMM_HAVE_IO_URING
+    /* Restart the poller with the io_uring backend, which polls the connect */
+    socket_comm_poller_destroy(test_socket_comm_handle);
+    test_socket_comm_handle->backend = SOCKET_COMM_BACKEND_IO_URING;
+    CU_ASSERT_TRUE(socket_comm_poller_initialize(test_socket_comm_handle));
+    if (test_socket_comm_handle->backend == SOCKET_COMM_BACKEND_IO_URING)
+    {
+        run_connect_async(listen_addr.sin_port);
+        CU_ASSERT_TRUE(connect_notifier_connected);
+        CU_ASSERT_TRUE(test_comm_session->read_interest);
+        CU_ASSERT_FALSE(test_comm_session->write_in_flight);
+        cleanup_connect_async();
+    }
+#endif
+
+    /* Nothing is listening on the port anymore, so the connect fails */
+    close(listen_fd);
+    run_connect_async(listen_addr.sin_port);
+    CU_ASSERT_FALSE(connect_notifier_connected);
+    CU_ASSERT_FALSE(test_comm_session->read_interest);
+    cleanup_connect_async();
 }
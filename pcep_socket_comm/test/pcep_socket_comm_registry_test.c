@@ -0,0 +1,141 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <strings.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep_socket_comm_internals.h"
+
+#define NUM_TEST_SESSIONS 100
+
+static pcep_socket_comm_registry test_registry;
+static pcep_socket_comm_session test_sessions[NUM_TEST_SESSIONS];
+
+
+/*
+ * Test case setup and teardown called before AND after each test.
+ */
+void pcep_socket_comm_registry_test_setup()
+{
+    bzero(test_sessions, sizeof(test_sessions));
+    socket_comm_registry_initialize(&test_registry);
+}
+
+
+void pcep_socket_comm_registry_test_teardown()
+{
+    socket_comm_registry_destroy(&test_registry);
+}
+
+
+/*
+ * Test cases
+ */
+
+void test_socket_comm_registry_add_remove()
+{
+    pcep_socket_comm_session *session = &test_sessions[0];
+
+    CU_ASSERT_FALSE(socket_comm_registry_add(&test_registry, NULL));
+    CU_ASSERT_FALSE(socket_comm_registry_contains(&test_registry, NULL));
+    CU_ASSERT_FALSE(socket_comm_registry_contains(&test_registry, session));
+    CU_ASSERT_PTR_NULL(socket_comm_registry_find(&test_registry, 0));
+    CU_ASSERT_PTR_NULL(socket_comm_registry_find(&test_registry, SOCKET_COMM_WAKEUP_KEY));
+
+    CU_ASSERT_TRUE(socket_comm_registry_add(&test_registry, session));
+    CU_ASSERT_NOT_EQUAL(session->registry_key, 0);
+    CU_ASSERT_NOT_EQUAL(session->registry_key, SOCKET_COMM_WAKEUP_KEY);
+    CU_ASSERT_TRUE(socket_comm_registry_contains(&test_registry, session));
+    CU_ASSERT_PTR_EQUAL(socket_comm_registry_find(&test_registry, session->registry_key), session);
+    CU_ASSERT_EQUAL(test_registry.num_sessions, 1);
+
+    /* Adding the same session again does not change its registry_key */
+    uint64_t registry_key = session->registry_key;
+    CU_ASSERT_TRUE(socket_comm_registry_add(&test_registry, session));
+    CU_ASSERT_EQUAL(session->registry_key, registry_key);
+    CU_ASSERT_EQUAL(test_registry.num_sessions, 1);
+
+    CU_ASSERT_TRUE(socket_comm_registry_remove(&test_registry, session));
+    CU_ASSERT_FALSE(socket_comm_registry_remove(&test_registry, session));
+    CU_ASSERT_FALSE(socket_comm_registry_contains(&test_registry, session));
+    CU_ASSERT_PTR_NULL(socket_comm_registry_find(&test_registry, registry_key));
+    CU_ASSERT_EQUAL(test_registry.num_sessions, 0);
+}
+
+
+void test_socket_comm_registry_stale_key()
+{
+    /* The slot of a removed session is reused, but its registry_key
+     * must not find the new session */
+    pcep_socket_comm_session *session1 = &test_sessions[0];
+    pcep_socket_comm_session *session2 = &test_sessions[1];
+
+    socket_comm_registry_add(&test_registry, session1);
+    uint64_t stale_key = session1->registry_key;
+    socket_comm_registry_remove(&test_registry, session1);
+    socket_comm_registry_add(&test_registry, session2);
+
+    CU_ASSERT_EQUAL(session2->registry_key & UINT32_MAX, stale_key & UINT32_MAX);
+    CU_ASSERT_NOT_EQUAL(session2->registry_key, stale_key);
+    CU_ASSERT_PTR_NULL(socket_comm_registry_find(&test_registry, stale_key));
+    CU_ASSERT_PTR_EQUAL(socket_comm_registry_find(&test_registry, session2->registry_key), session2);
+
+    /* The same session added again gets a new registry_key */
+    socket_comm_registry_add(&test_registry, session1);
+    CU_ASSERT_NOT_EQUAL(session1->registry_key, stale_key);
+    CU_ASSERT_PTR_NULL(socket_comm_registry_find(&test_registry, stale_key));
+    CU_ASSERT_PTR_EQUAL(socket_comm_registry_find(&test_registry, session1->registry_key), session1);
+}
+
+
+void test_socket_comm_registry_grow()
+{
+    /* Add more sessions than the initial registry size */
+    int i;
+    for (i = 0; i < NUM_TEST_SESSIONS; i++)
+    {
+        CU_ASSERT_TRUE(socket_comm_registry_add(&test_registry, &test_sessions[i]));
+    }
+    CU_ASSERT_EQUAL(test_registry.num_sessions, NUM_TEST_SESSIONS);
+    CU_ASSERT_TRUE(test_registry.num_entries_allocated >= NUM_TEST_SESSIONS);
+    CU_ASSERT_TRUE(test_registry.hash_size >= 2 * NUM_TEST_SESSIONS);
+
+    /* Remove every other session, the rest must still be found */
+    for (i = 0; i < NUM_TEST_SESSIONS; i += 2)
+    {
+        CU_ASSERT_TRUE(socket_comm_registry_remove(&test_registry, &test_sessions[i]));
+    }
+
+    for (i = 0; i < NUM_TEST_SESSIONS; i++)
+    {
+        bool registered = (i % 2 == 1);
+        CU_ASSERT_EQUAL(socket_comm_registry_contains(&test_registry, &test_sessions[i]), registered);
+        CU_ASSERT_EQUAL(socket_comm_registry_find(&test_registry, test_sessions[i].registry_key) != NULL, registered);
+    }
+    CU_ASSERT_EQUAL(test_registry.num_sessions, NUM_TEST_SESSIONS / 2);
+}
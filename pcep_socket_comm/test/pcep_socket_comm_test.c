@@ -24,13 +24,14 @@
 
 
 #include <netinet/in.h>
+#include <strings.h>
 
 #include <CUnit/CUnit.h>
 
 #include "pcep_socket_comm.h"
 #include "pcep_socket_comm_internals.h"
 
-extern pcep_socket_comm_handle *socket_comm_handle_;
+extern pcep_socket_comm_reactors *socket_comm_reactors_;
 
 static pcep_socket_comm_session *test_session = NULL;
 static struct in_addr test_host_ip;
@@ -59,7 +60,7 @@ static int test_message_ready_to_read_handler(void *session_data, int socket_fd)
     return 1;
 }
 
-static void test_message_sent_handler(void *session_data, int socket_fd)
+static void test_message_sent_handler(void *session_data, int socket_fd, bool socket_closed)
 {
     return;
 }
@@ -228,13 +229,124 @@ void test_pcep_socket_comm_session_destroy()
             test_connection_except_notifier,
             &test_host_ip, test_port, connect_timeout_millis, NULL);
     CU_ASSERT_PTR_NOT_NULL(test_session);
-    CU_ASSERT_PTR_NOT_NULL(socket_comm_handle_);
-    CU_ASSERT_EQUAL(socket_comm_handle_->num_active_sessions, 1);
+    CU_ASSERT_PTR_NOT_NULL(socket_comm_reactors_);
+    CU_ASSERT_EQUAL(socket_comm_reactors_->num_reactors, 1);
+    CU_ASSERT_PTR_EQUAL(test_session->socket_comm_handle, socket_comm_reactors_->reactors[0]);
+    CU_ASSERT_EQUAL(socket_comm_reactors_->reactors[0]->num_active_sessions, 1);
 
     CU_ASSERT_TRUE(socket_comm_session_teardown(test_session));
     test_session = NULL;
-    CU_ASSERT_PTR_NOT_NULL(socket_comm_handle_);
+    CU_ASSERT_PTR_NOT_NULL(socket_comm_reactors_);
+    CU_ASSERT_EQUAL(socket_comm_reactors_->reactors[0]->num_active_sessions, 0);
 
     CU_ASSERT_TRUE(destroy_socket_comm_loop());
-    CU_ASSERT_PTR_NULL(socket_comm_handle_);
+    CU_ASSERT_PTR_NULL(socket_comm_reactors_);
+}
+
+
+void test_pcep_socket_comm_reactors()
+{
+    /* The reactors can only be configured before any session is initialized */
+    if (socket_comm_reactors_ != NULL)
+    {
+        destroy_socket_comm_loop();
+    }
+
+    pcep_socket_comm_config config;
+    bzero(&config, sizeof(pcep_socket_comm_config));
+    config.num_reactor_threads = MAX_SOCKET_COMM_REACTORS + 1;
+    CU_ASSERT_FALSE(initialize_socket_comm_loop_with_config(&config));
+    CU_ASSERT_PTR_NULL(socket_comm_reactors_);
+
+    config.num_reactor_threads = 4;
+    config.assign_policy = SOCKET_COMM_ASSIGN_LEAST_LOADED;
+    config.pin_reactor_threads = true;
+    CU_ASSERT_TRUE(initialize_socket_comm_loop_with_config(&config));
+    CU_ASSERT_PTR_NOT_NULL(socket_comm_reactors_);
+    CU_ASSERT_EQUAL(socket_comm_reactors_->num_reactors, 4);
+
+    /* The least loaded policy spreads the sessions evenly */
+    pcep_socket_comm_session *sessions[8];
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        sessions[i] = socket_comm_session_initialize(
+                test_message_received_handler,
+                NULL,
+                test_message_sent_handler,
+                test_connection_except_notifier,
+                &test_host_ip, test_port, connect_timeout_millis, NULL);
+        CU_ASSERT_PTR_NOT_NULL(sessions[i]);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        pcep_socket_comm_handle *reactor = socket_comm_reactors_->reactors[i];
+        CU_ASSERT_EQUAL(reactor->reactor_index, i);
+        CU_ASSERT_EQUAL(reactor->num_active_sessions, 2);
+    }
+
+    /* Each session is only registered with the reactor it is assigned to */
+    for (i = 0; i < 8; i++)
+    {
+        pcep_socket_comm_handle *reactor = sessions[i]->socket_comm_handle;
+        CU_ASSERT_TRUE(socket_comm_registry_contains(&reactor->session_registry, sessions[i]));
+        int j;
+        for (j = 0; j < 4; j++)
+        {
+            if (socket_comm_reactors_->reactors[j] != reactor)
+            {
+                CU_ASSERT_FALSE(socket_comm_registry_contains(
+                        &socket_comm_reactors_->reactors[j]->session_registry, sessions[i]));
+            }
+        }
+        CU_ASSERT_TRUE(socket_comm_session_teardown(sessions[i]));
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        CU_ASSERT_EQUAL(socket_comm_reactors_->reactors[i]->num_active_sessions, 0);
+    }
+
+    CU_ASSERT_TRUE(destroy_socket_comm_loop());
+    CU_ASSERT_PTR_NULL(socket_comm_reactors_);
+}
+
+
+void test_pcep_socket_comm_independent_reactors()
+{
+    CU_ASSERT_PTR_NULL(create_socket_comm_reactors(NULL));
+    CU_ASSERT_FALSE(destroy_socket_comm_reactors(NULL));
+    CU_ASSERT_PTR_NULL(socket_comm_session_initialize_with_reactors(NULL,
+            test_message_received_handler, NULL, test_message_sent_handler, test_connection_except_notifier,
+            NULL, 0, &test_host_ip, test_port, connect_timeout_millis, NULL));
+
+    /* Each set of reactors is independent of the default reactors */
+    pcep_socket_comm_config config;
+    bzero(&config, sizeof(pcep_socket_comm_config));
+    pcep_socket_comm_reactors *reactors1 = create_socket_comm_reactors(&config);
+    config.num_reactor_threads = 2;
+    pcep_socket_comm_reactors *reactors2 = create_socket_comm_reactors(&config);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reactors1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reactors2);
+    CU_ASSERT_EQUAL(reactors1->num_reactors, 1);
+    CU_ASSERT_EQUAL(reactors2->num_reactors, 2);
+
+    pcep_socket_comm_session *session1 = socket_comm_session_initialize_with_reactors(reactors1,
+            test_message_received_handler, NULL, test_message_sent_handler, test_connection_except_notifier,
+            NULL, 0, &test_host_ip, test_port, connect_timeout_millis, NULL);
+    pcep_socket_comm_session *session2 = socket_comm_session_initialize_with_reactors_ipv6(reactors2,
+            test_message_received_handler, NULL, test_message_sent_handler, test_connection_except_notifier,
+            NULL, 0, &test_host_ipv6, test_port, connect_timeout_millis, NULL);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(session1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(session2);
+    CU_ASSERT_PTR_NULL(socket_comm_reactors_);
+    CU_ASSERT_PTR_EQUAL(session1->socket_comm_handle, reactors1->reactors[0]);
+    CU_ASSERT_TRUE(session2->socket_comm_handle == reactors2->reactors[0] ||
+                   session2->socket_comm_handle == reactors2->reactors[1]);
+
+    CU_ASSERT_TRUE(socket_comm_session_teardown(session1));
+    CU_ASSERT_TRUE(socket_comm_session_teardown(session2));
+    CU_ASSERT_TRUE(destroy_socket_comm_reactors(reactors1));
+    CU_ASSERT_TRUE(destroy_socket_comm_reactors(reactors2));
 }
@@ -39,6 +39,8 @@ extern void test_pcep_socket_comm_initialize_with_src_ipv6(void);
 extern void test_pcep_socket_comm_initialize_handlers(void);
 extern void test_pcep_socket_comm_session_not_initialized(void);
 extern void test_pcep_socket_comm_session_destroy(void);
+extern void test_pcep_socket_comm_reactors(void);
+extern void test_pcep_socket_comm_independent_reactors(void);
 
 /*
  * Test cases defined in pcep_socket_comm_loop_test.c
@@ -50,6 +52,25 @@ void test_socket_comm_loop_not_active(void);
 void test_handle_reads_no_read(void);
 void test_handle_reads_read_message(void);
 void test_handle_reads_read_message_close(void);
+void test_handle_reads_read_message_bigger_than_buffer(void);
+void test_handle_writes_write_interest(void);
+void test_handle_writes_batch(void);
+void test_handle_writes_priority(void);
+void test_handle_writes_shared_message(void);
+void test_handle_writes_send_after_close(void);
+void test_handle_writes_partial_write(void);
+void test_socket_comm_loop_wakeup(void);
+void test_socket_comm_loop_io_uring(void);
+void test_socket_comm_loop_connect_async(void);
+
+/*
+ * Test cases defined in pcep_socket_comm_registry_test.c
+ */
+void pcep_socket_comm_registry_test_setup(void);
+void pcep_socket_comm_registry_test_teardown(void);
+void test_socket_comm_registry_add_remove(void);
+void test_socket_comm_registry_stale_key(void);
+void test_socket_comm_registry_grow(void);
 
 
 int main(int argc, char **argv)
@@ -86,6 +107,12 @@ int main(int argc, char **argv)
     CU_add_test(test_socket_comm_suite,
                 "test_pcep_socket_comm_session_destroy",
                 test_pcep_socket_comm_session_destroy);
+    CU_add_test(test_socket_comm_suite,
+                "test_pcep_socket_comm_reactors",
+                test_pcep_socket_comm_reactors);
+    CU_add_test(test_socket_comm_suite,
+                "test_pcep_socket_comm_independent_reactors",
+                test_pcep_socket_comm_independent_reactors);
 
     /*
      * Tests defined in pcep_socket_comm_loop_test.c
@@ -111,6 +138,55 @@ int main(int argc, char **argv)
     CU_add_test(test_socket_comm_loop_suite,
                 "test_handle_reads_read_message_close",
                 test_handle_reads_read_message_close);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_reads_read_message_bigger_than_buffer",
+                test_handle_reads_read_message_bigger_than_buffer);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_writes_write_interest",
+                test_handle_writes_write_interest);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_writes_batch",
+                test_handle_writes_batch);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_writes_priority",
+                test_handle_writes_priority);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_writes_shared_message",
+                test_handle_writes_shared_message);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_writes_send_after_close",
+                test_handle_writes_send_after_close);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_handle_writes_partial_write",
+                test_handle_writes_partial_write);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_socket_comm_loop_wakeup",
+                test_socket_comm_loop_wakeup);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_socket_comm_loop_io_uring",
+                test_socket_comm_loop_io_uring);
+    CU_add_test(test_socket_comm_loop_suite,
+                "test_socket_comm_loop_connect_async",
+                test_socket_comm_loop_connect_async);
+
+    /*
+     * Tests defined in pcep_socket_comm_registry_test.c
+     */
+    CU_pSuite test_socket_comm_registry_suite = CU_add_suite_with_setup_and_teardown(
+            "PCEP Socket Comm Registry Test Suite",
+            NULL, NULL,
+            pcep_socket_comm_registry_test_setup,     // test case setup function pointer
+            pcep_socket_comm_registry_test_teardown); // test case teardown function pointer
+
+    CU_add_test(test_socket_comm_registry_suite,
+                "test_socket_comm_registry_add_remove",
+                test_socket_comm_registry_add_remove);
+    CU_add_test(test_socket_comm_registry_suite,
+                "test_socket_comm_registry_stale_key",
+                test_socket_comm_registry_stale_key);
+    CU_add_test(test_socket_comm_registry_suite,
+                "test_socket_comm_registry_grow",
+                test_socket_comm_registry_grow);
 
     /*
      * Run the tests and cleanup.
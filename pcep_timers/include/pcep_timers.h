@@ -32,9 +32,23 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 #define TIMER_ID_NOT_SET -1
 
+/* The upper bounds of the timer lateness histogram buckets, in milliseconds,
+ * the last bucket counts the timers that were later than all of them */
+#define TIMERS_LATENESS_BUCKET_LIMITS_MILLIS { 1, 2, 5, 10, 20, 50, 100, 500, 1000 }
+#define TIMERS_LATENESS_NUM_BUCKETS 10
+
+/* How late the timers expired, compared to their expire time */
+typedef struct pcep_timers_lateness_histogram_
+{
+    uint64_t num_timers[TIMERS_LATENESS_NUM_BUCKETS];
+    uint64_t max_lateness_millis;
+
+} pcep_timers_lateness_histogram;
+
 /* Function pointer to be called when timers expire.
  * Parameters:
  *    void *data - passed into create_timer
@@ -42,6 +56,37 @@
  */
 typedef void (*timer_expire_handler)(void *, int);
 
+/* An expired timer, as passed to the timer_expire_batch_handler */
+typedef struct pcep_expired_timer_
+{
+    void *data;
+    int timer_id;
+
+} pcep_expired_timer;
+
+/* Function pointer to be called with all the timers that expired at the
+ * same time. The expired_timers array is only valid during the call.
+ * Parameters:
+ *    pcep_expired_timer *expired_timers - the data and timer_id of each timer,
+ *                                         in expiration order
+ *    int num_expired_timers - the number of entries in expired_timers
+ */
+typedef void (*timer_expire_batch_handler)(pcep_expired_timer *, int);
+
+/* Same as the timer_expire_batch_handler, for the timers of a timers context.
+ * Parameters:
+ *    void *handler_data - passed into create_timers_context
+ *    pcep_expired_timer *expired_timers - as in timer_expire_batch_handler
+ *    int num_expired_timers - the number of entries in expired_timers
+ */
+typedef void (*timers_context_expire_handler)(void *, pcep_expired_timer *, int);
+
+/* Each timers context has its own thread, lock, and timer_ids, so several
+ * independent users of the timers can run in the same process. The timers
+ * API functions without a pcep_timers_context parameter use the timers
+ * context created by initialize_timers(). */
+struct pcep_timers_context_;
+
 /*
  * Initialize the timers module.
  * The timer_expire_handler function pointer will be called each time a timer expires.
@@ -49,6 +94,15 @@ typedef void (*timer_expire_handler)(void *, int);
  */
 bool initialize_timers(timer_expire_handler expire_handler);
 
+/*
+ * Initialize the timers module with a timer_expire_batch_handler, which will
+ * be called once for all the timers that expired together, instead of once
+ * per timer. The handler is called without holding any timers lock, so it
+ * may create, cancel, and reset timers.
+ * Return true for successful initialization, false otherwise.
+ */
+bool initialize_timers_with_batch_handler(timer_expire_batch_handler expire_batch_handler);
+
 /*
  * Teardown the timers module.
  */
@@ -63,6 +117,21 @@ bool teardown_timers();
  */
 int create_timer(uint16_t sleep_seconds, void *data);
 
+/*
+ * Create a new timer for "sleep_millis" milliseconds.
+ * Same as create_timer(), for timers that need sub-second resolution.
+ */
+int create_timer_millis(uint32_t sleep_millis, void *data);
+
+/*
+ * Create a new timer for "sleep_millis" milliseconds, minus a random amount
+ * of up to "jitter_millis" milliseconds, which is chosen again each time
+ * the timer is reset. Used to avoid timers created together, with the same
+ * sleep time, from always expiring together.
+ * Returns < 0 on error.
+ */
+int create_timer_with_jitter(uint32_t sleep_millis, uint32_t jitter_millis, void *data);
+
 /*
  * Cancel a timer created with create_timer().
  * Returns true if the timer was found and cancelled, false otherwise.
@@ -75,4 +144,56 @@ bool cancel_timer(int timer_id);
  */
 bool reset_timer(int timer_id);
 
+/*
+ * Set the coalescing window, so the timers expiring within the same window
+ * of "window_millis" milliseconds expire together with a single wake up,
+ * at the end of the window. Timers may expire up to window_millis late.
+ * The default window is 0, which disables the coalescing.
+ * Returns false if the timers have not been initialized.
+ */
+bool set_timers_coalescing_window(uint32_t window_millis);
+
+/*
+ * Copy the histogram of how late the timers expired since the timers were
+ * initialized, which includes the coalescing window.
+ * Returns false if the timers have not been initialized.
+ */
+bool get_timers_lateness_histogram(pcep_timers_lateness_histogram *histogram);
+
+/*
+ * Create and start a timers context, the expire_handler will be called with
+ * the handler_data and all the timers of the context that expired together.
+ * Returns NULL if the timers context cannot be created.
+ */
+struct pcep_timers_context_ *create_timers_context(timers_context_expire_handler expire_handler,
+                                                   void *handler_data);
+
+/*
+ * Stop the timers context thread, and free the context and its timers.
+ */
+bool destroy_timers_context(struct pcep_timers_context_ *timers_context);
+
+/*
+ * The same as create_timer_with_jitter(), cancel_timer(), reset_timer(),
+ * set_timers_coalescing_window(), and get_timers_lateness_histogram(), for
+ * the timers of the timers_context. The timer_ids are only valid in the
+ * timers context that created them.
+ */
+int timers_context_create_timer(struct pcep_timers_context_ *timers_context,
+                                uint32_t sleep_millis,
+                                uint32_t jitter_millis,
+                                void *data);
+bool timers_context_cancel_timer(struct pcep_timers_context_ *timers_context, int timer_id);
+bool timers_context_reset_timer(struct pcep_timers_context_ *timers_context, int timer_id);
+bool timers_context_set_coalescing_window(struct pcep_timers_context_ *timers_context,
+                                          uint32_t window_millis);
+bool timers_context_get_lateness_histogram(struct pcep_timers_context_ *timers_context,
+                                           pcep_timers_lateness_histogram *histogram);
+
+/*
+ * Returns the current CLOCK_MONOTONIC time in milliseconds, which is the
+ * clock the timers expire with.
+ */
+time_t get_timers_monotonic_millis();
+
 #endif /* PCEPTIMERS_H_ */
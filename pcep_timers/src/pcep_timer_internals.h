@@ -30,31 +30,109 @@
 #define PCEPTIMERINTERNALS_H_
 
 #include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 
-#include "pcep_utils_ordered_list.h"
 #include "pcep_timers.h"
 
+/* The timer wheel has TIMER_WHEEL_NUM_LEVELS levels of TIMER_WHEEL_NUM_SLOTS
+ * slots, each level slot covers TIMER_WHEEL_NUM_SLOTS slots of the level below */
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_NUM_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_NUM_SLOTS - 1)
+#define TIMER_WHEEL_NUM_LEVELS 5
+#define TIMER_WHEEL_INITIAL_INDEX_SIZE 64
+#define INITIAL_EXPIRED_TIMERS_SIZE 16
 
+/* The event_loop wakeup_time when there are no timers */
+#define TIMER_WAKEUP_NEVER ((time_t) INT64_MAX)
+
+
+/* The timer expire_time and the timer wheel current_time are in
+ * milliseconds of the CLOCK_MONOTONIC clock */
 typedef struct pcep_timer_
 {
     time_t expire_time;
-    uint16_t sleep_seconds;
+    uint32_t sleep_millis;
+    uint32_t jitter_millis;
     int timer_id;
     void *data;
+    /* Links in the timer wheel slot list */
+    struct pcep_timer_ *prev_timer;
+    struct pcep_timer_ *next_timer;
+    struct pcep_timer_ **slot;
+
 } pcep_timer;
 
+/* Hierarchical timing wheel, the timers are stored in the slot of the
+ * lowest level that can hold their expire_time, and are moved down a
+ * level each time the slot they are in is reached. Each timer is also
+ * indexed by its timer_id in an open addressing hash, so creating,
+ * cancelling, and resetting a timer are all O(1). */
+typedef struct pcep_timer_wheel_
+{
+    pcep_timer *slots[TIMER_WHEEL_NUM_LEVELS][TIMER_WHEEL_NUM_SLOTS];
+    /* A bit is set for each slot with timers, per level */
+    uint64_t occupied_slots[TIMER_WHEEL_NUM_LEVELS];
+    /* All the timers expiring up to and including current_time have been processed */
+    time_t current_time;
+    unsigned int num_timers;
+    pcep_timer **index_buckets;
+    unsigned int index_size;
+
+} pcep_timer_wheel;
+
 typedef struct pcep_timers_context_
 {
-    ordered_list_handle *timer_list;
+    pcep_timer_wheel timer_wheel;
     bool active;
+    /* Only one of the handlers is set, the context_expire_handler
+     * is called with the handler_data */
     timer_expire_handler expire_handler;
+    timer_expire_batch_handler expire_batch_handler;
+    timers_context_expire_handler context_expire_handler;
+    void *handler_data;
+    /* The expired timers are copied here to be dispatched after releasing
+     * the timer_list_lock, only used by the event_loop thread */
+    pcep_expired_timer *expired_timers;
+    unsigned int expired_timers_size;
     pthread_t event_loop_thread;
     pthread_mutex_t timer_list_lock;
+    /* Signalled to wake up the event_loop when a timer expires before
+     * wakeup_time, or when the timers are torn down */
+    pthread_cond_t timer_list_cond;
+    time_t wakeup_time;
+    /* The event_loop wakes up at the end of the coalescing window */
+    uint32_t coalescing_window_millis;
+    /* Used to calculate the timer jitter, protected by the timer_list_lock */
+    unsigned int jitter_seed;
+    /* Protected by the timer_list_lock */
+    int next_timer_id;
+    pcep_timers_lateness_histogram lateness_histogram;
 
 } pcep_timers_context;
 
+/* functions implemented in pcep_timers_wheel.c */
+void timer_wheel_initialize(pcep_timer_wheel *timer_wheel, time_t current_time);
+/* Frees the timers still in the timer_wheel */
+void timer_wheel_destroy(pcep_timer_wheel *timer_wheel);
+void timer_wheel_add(pcep_timer_wheel *timer_wheel, pcep_timer *timer);
+/* Remove the timer from the timer_wheel, without freeing it */
+void timer_wheel_remove(pcep_timer_wheel *timer_wheel, pcep_timer *timer);
+/* Move the timer to the slot of its updated expire_time */
+void timer_wheel_reschedule(pcep_timer_wheel *timer_wheel, pcep_timer *timer);
+/* Returns NULL if there is no timer with the timer_id */
+pcep_timer *timer_wheel_find(pcep_timer_wheel *timer_wheel, int timer_id);
+/* Advance the timer_wheel to now, and return the list of expired timers,
+ * linked with next_timer, which have been removed from the timer_wheel */
+pcep_timer *timer_wheel_advance(pcep_timer_wheel *timer_wheel, time_t now);
+/* Returns the earliest timer expire_time, or TIMER_WAKEUP_NEVER if there are no timers */
+time_t timer_wheel_get_next_expire_time(pcep_timer_wheel *timer_wheel);
+
 /* functions implemented in pcep_timers_loop.c */
 void *event_loop(void *context);
+/* Returns the time the event_loop should wake up for a timer expire_time */
+time_t get_coalesced_wakeup_time(pcep_timers_context *timers_context, time_t expire_time);
 
 
 #endif /* PCEPTIMERINTERNALS_H_ */
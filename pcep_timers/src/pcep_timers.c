@@ -32,111 +32,179 @@
 #include <pthread.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "pcep_timer_internals.h"
 #include "pcep_timers.h"
 #include "pcep_utils_logging.h"
-#include "pcep_utils_ordered_list.h"
 
-/* TODO should we just return this from initialize_timers
- *      instead of storing it globally here??
- *      I guess it just depends on if we will ever need more than one */
+/* The timers context used by the timers API functions without a
+ * pcep_timers_context parameter, created by initialize_timers() */
 pcep_timers_context *timers_context_ = NULL;
-static int timer_id_ = 0;
 
-/* simple compare method callback used by pcep_utils_ordered_list
- * for ordered list insertion. */
-int timer_list_node_compare(void *list_entry, void *new_entry)
+
+/* internal util method, starts the context event_loop thread */
+static bool start_timers_context(pcep_timers_context *timers_context)
 {
-    /* return:
-     *   < 0  if new_entry < list_entry
-     *   == 0 if new_entry == list_entry (new_entry will be inserted after list_entry)
-     *   > 0  if new_entry > list_entry */
-    return ((pcep_timer *) new_entry)->expire_time - ((pcep_timer *) list_entry)->expire_time;
-}
+    timers_context->active = true;
+    timer_wheel_initialize(&timers_context->timer_wheel, get_timers_monotonic_millis());
+    timers_context->wakeup_time = TIMER_WAKEUP_NEVER;
+    timers_context->jitter_seed = (unsigned int) (get_timers_monotonic_millis() ^ getpid() ^ (uintptr_t) timers_context);
+
+    if (pthread_mutex_init(&(timers_context->timer_list_lock), NULL) != 0)
+    {
+        pcep_log(LOG_ERR, "ERROR initializing timers, cannot initialize the mutex");
+        return false;
+    }
 
+    /* The event_loop waits on the condition with CLOCK_MONOTONIC deadlines */
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&(timers_context->timer_list_cond), &cond_attr) != 0)
+    {
+        pthread_condattr_destroy(&cond_attr);
+        pcep_log(LOG_ERR, "ERROR initializing timers, cannot initialize the condition");
+        return false;
+    }
+    pthread_condattr_destroy(&cond_attr);
 
-/* simple compare method callback used by pcep_utils_ordered_list
- * ordered_list_remove_first_node_equals2 to remove a timer based on
- * its timer_id. */
-int timer_list_node_timer_id_compare(void *list_entry, void *new_entry)
-{
-    return ((pcep_timer *) new_entry)->timer_id - ((pcep_timer *) list_entry)->timer_id;
+    if(pthread_create(&(timers_context->event_loop_thread), NULL, event_loop, timers_context))
+    {
+        pcep_log(LOG_ERR, "ERROR initializing timers, cannot initialize the thread");
+        return false;
+    }
+
+    return true;
 }
 
 
-/* internal util method */
-static pcep_timers_context *create_timers_context_()
+/* internal util method, stops the context event_loop thread and frees the context */
+static void stop_timers_context(pcep_timers_context *timers_context)
 {
-    if (timers_context_ == NULL)
+    /* Wake up the event_loop, which may be waiting without a deadline */
+    pthread_mutex_lock(&timers_context->timer_list_lock);
+    timers_context->active = false;
+    pthread_cond_signal(&timers_context->timer_list_cond);
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
+    pthread_join(timers_context->event_loop_thread, NULL);
+
+    /* TODO this doesnt buld
+     * Instead of calling pthread_join() which could block if the thread
+     * is blocked, try joining for at most 1 second.
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += 1;
+    int retval = pthread_timedjoin_np(timers_context->event_loop_thread, NULL, &ts);
+    if (retval != 0)
+    {
+        pcep_log(LOG_WARNING, "thread did not stop after 1 second waiting on it.");
+    }
+    */
+
+    /* Frees the timers that have not expired yet */
+    timer_wheel_destroy(&timers_context->timer_wheel);
+    if (timers_context->expired_timers != NULL)
+    {
+        free(timers_context->expired_timers);
+    }
+
+    if (pthread_mutex_destroy(&(timers_context->timer_list_lock)) != 0)
+    {
+        pcep_log(LOG_WARNING, "Trying to teardown the timers, cannot destroy the mutex");
+    }
+
+    if (pthread_cond_destroy(&(timers_context->timer_list_cond)) != 0)
     {
-        timers_context_ = malloc(sizeof(pcep_timers_context));
-        bzero(timers_context_, sizeof(pcep_timers_context));
-        timers_context_->active = false;
+        pcep_log(LOG_WARNING, "Trying to teardown the timers, cannot destroy the condition");
     }
 
-    return timers_context_;
+    free(timers_context);
 }
 
 
-bool initialize_timers(timer_expire_handler expire_handler)
+pcep_timers_context *create_timers_context(timers_context_expire_handler expire_handler, void *handler_data)
 {
     if (expire_handler == NULL)
     {
         /* Cannot have a NULL handler function */
-        return false;
+        return NULL;
     }
 
-    timers_context_ = create_timers_context_();
+    pcep_timers_context *timers_context = malloc(sizeof(pcep_timers_context));
+    bzero(timers_context, sizeof(pcep_timers_context));
+    timers_context->context_expire_handler = expire_handler;
+    timers_context->handler_data = handler_data;
 
-    if (timers_context_->active == true)
+    if (start_timers_context(timers_context) == false)
     {
-        /* already initialized */
-        return false;
+        timer_wheel_destroy(&timers_context->timer_wheel);
+        free(timers_context);
+        return NULL;
     }
 
-    timers_context_->active = true;
-    timers_context_->timer_list = ordered_list_initialize(timer_list_node_compare);
-    timers_context_->expire_handler = expire_handler;
+    return timers_context;
+}
+
 
-    if (pthread_mutex_init(&(timers_context_->timer_list_lock), NULL) != 0)
+bool destroy_timers_context(pcep_timers_context *timers_context)
+{
+    if (timers_context == NULL)
     {
-        pcep_log(LOG_ERR, "ERROR initializing timers, cannot initialize the mutex");
+        pcep_log(LOG_WARNING, "Trying to destroy a NULL timers context");
         return false;
     }
 
-    if(pthread_create(&(timers_context_->event_loop_thread), NULL, event_loop, timers_context_))
+    stop_timers_context(timers_context);
+
+    return true;
+}
+
+
+/* internal util method, only one of the handlers is set */
+static bool initialize_timers_common(timer_expire_handler expire_handler,
+                                     timer_expire_batch_handler expire_batch_handler)
+{
+    if (timers_context_ != NULL)
     {
-        pcep_log(LOG_ERR, "ERROR initializing timers, cannot initialize the thread");
+        /* already initialized */
         return false;
     }
 
-    return true;
+    timers_context_ = malloc(sizeof(pcep_timers_context));
+    bzero(timers_context_, sizeof(pcep_timers_context));
+    timers_context_->expire_handler = expire_handler;
+    timers_context_->expire_batch_handler = expire_batch_handler;
+
+    return start_timers_context(timers_context_);
 }
 
 
-/*
- * This function is only used to tear_down the timer data.
- * Only the timer data is deleted, not the list itself,
- * which is deleted by ordered_list_destroy().
- */
-void free_all_timers(pcep_timers_context *timers_context)
+bool initialize_timers(timer_expire_handler expire_handler)
 {
-    pthread_mutex_lock(&timers_context->timer_list_lock);
+    if (expire_handler == NULL)
+    {
+        /* Cannot have a NULL handler function */
+        return false;
+    }
+
+    return initialize_timers_common(expire_handler, NULL);
+}
 
-    ordered_list_node *timer_node = timers_context->timer_list->head;
 
-    while (timer_node != NULL)
+bool initialize_timers_with_batch_handler(timer_expire_batch_handler expire_batch_handler)
+{
+    if (expire_batch_handler == NULL)
     {
-        if (timer_node->data != NULL)
-        {
-            free(timer_node->data);
-        }
-        timer_node = timer_node->next_node;
+        /* Cannot have a NULL handler function */
+        return false;
     }
 
-    pthread_mutex_unlock(&timers_context->timer_list_lock);
+    return initialize_timers_common(NULL, expire_batch_handler);
 }
 
 
@@ -154,50 +222,67 @@ bool teardown_timers()
         return false;
     }
 
-    timers_context_->active = false;
-    pthread_join(timers_context_->event_loop_thread, NULL);
+    stop_timers_context(timers_context_);
+    timers_context_ = NULL;
 
-    /* TODO this doesnt buld
-     * Instead of calling pthread_join() which could block if the thread
-     * is blocked, try joining for at most 1 second.
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    ts.tv_sec += 1;
-    int retval = pthread_timedjoin_np(timers_context_->event_loop_thread, NULL, &ts);
-    if (retval != 0)
-    {
-        pcep_log(LOG_WARNING, "thread did not stop after 1 second waiting on it.");
-    }
-    */
+    return true;
+}
 
-    free_all_timers(timers_context_);
-    ordered_list_destroy(timers_context_->timer_list);
 
-    if (pthread_mutex_destroy(&(timers_context_->timer_list_lock)) != 0)
+time_t get_timers_monotonic_millis()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
+
+/* internal util method, called with the timer_list_lock held. The
+ * timer_ids are only unique within each timers context */
+static int get_next_timer_id(pcep_timers_context *timers_context)
+{
+    if (timers_context->next_timer_id == INT_MAX)
     {
-        pcep_log(LOG_WARNING, "Trying to teardown the timers, cannot destroy the mutex");
+        timers_context->next_timer_id = 0;
     }
 
-    free(timers_context_);
-    timers_context_ = NULL;
+    return timers_context->next_timer_id++;
+}
 
-    return true;
+/* internal util method, called with the timer_list_lock held after a timer
+ * is added or reset: wake up the event_loop if the timer expires before it
+ * would otherwise wake up */
+static void wakeup_event_loop(pcep_timers_context *timers_context, pcep_timer *timer)
+{
+    time_t wakeup_time = get_coalesced_wakeup_time(timers_context, timer->expire_time);
+    if (wakeup_time < timers_context->wakeup_time)
+    {
+        timers_context->wakeup_time = wakeup_time;
+        pthread_cond_signal(&timers_context->timer_list_cond);
+    }
 }
 
 
-int get_next_timer_id()
+/* internal util method, called with the timer_list_lock held */
+static time_t get_timer_expire_time(pcep_timers_context *timers_context, pcep_timer *timer)
 {
-    if (timer_id_ == INT_MAX)
+    time_t expire_time = get_timers_monotonic_millis() + timer->sleep_millis;
+    if (timer->jitter_millis > 0)
     {
-        timer_id_ = 0;
+        expire_time -= rand_r(&timers_context->jitter_seed) % (timer->jitter_millis + 1);
     }
 
-    return timer_id_++;
+    return expire_time;
 }
 
-int create_timer(uint16_t sleep_seconds, void *data)
+
+int timers_context_create_timer(pcep_timers_context *timers_context,
+                                uint32_t sleep_millis,
+                                uint32_t jitter_millis,
+                                void *data)
 {
-    if (timers_context_ == NULL)
+    if (timers_context == NULL)
     {
         pcep_log(LOG_WARNING, "Trying to create a timer: the timers have not been initialized");
         return -1;
@@ -206,92 +291,162 @@ int create_timer(uint16_t sleep_seconds, void *data)
     pcep_timer *timer = malloc(sizeof(pcep_timer));
     bzero(timer, sizeof(pcep_timer));
     timer->data = data;
-    timer->sleep_seconds = sleep_seconds;
-    timer->expire_time = time(NULL) + sleep_seconds;
-    timer->timer_id = get_next_timer_id();
+    timer->sleep_millis = sleep_millis;
+    timer->jitter_millis = (jitter_millis > sleep_millis) ? sleep_millis : jitter_millis;
 
-    pthread_mutex_lock(&timers_context_->timer_list_lock);
+    pthread_mutex_lock(&timers_context->timer_list_lock);
 
-    /* implemented in pcep_utils_ordered_list.c */
-    if (ordered_list_add_node(timers_context_->timer_list, timer) == NULL)
-    {
-        free(timer);
-        pthread_mutex_unlock(&timers_context_->timer_list_lock);
-        pcep_log(LOG_WARNING, "Trying to create a timer, cannot add the timer to the timer list");
+    /* The timer may expire and be freed as soon as the lock is released */
+    int timer_id = get_next_timer_id(timers_context);
+    timer->timer_id = timer_id;
+    timer->expire_time = get_timer_expire_time(timers_context, timer);
 
-        return -1;
-    }
+    /* implemented in pcep_timers_wheel.c */
+    timer_wheel_add(&timers_context->timer_wheel, timer);
+    wakeup_event_loop(timers_context, timer);
 
-    pthread_mutex_unlock(&timers_context_->timer_list_lock);
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
 
-    return timer->timer_id;
+    return timer_id;
 }
 
 
-bool cancel_timer(int timer_id)
+bool timers_context_cancel_timer(pcep_timers_context *timers_context, int timer_id)
 {
-    static pcep_timer compare_timer;
-
-    if (timers_context_ == NULL)
+    if (timers_context == NULL)
     {
         pcep_log(LOG_WARNING, "Trying to cancel a timer: the timers have not been initialized");
         return false;
     }
 
-    pthread_mutex_lock(&timers_context_->timer_list_lock);
+    pthread_mutex_lock(&timers_context->timer_list_lock);
 
-    compare_timer.timer_id = timer_id;
-    pcep_timer *timer_toRemove = ordered_list_remove_first_node_equals2(
-            timers_context_->timer_list, &compare_timer, timer_list_node_timer_id_compare);
+    pcep_timer *timer_toRemove = timer_wheel_find(&timers_context->timer_wheel, timer_id);
     if (timer_toRemove == NULL)
     {
-        pthread_mutex_unlock(&timers_context_->timer_list_lock);
+        pthread_mutex_unlock(&timers_context->timer_list_lock);
         pcep_log(LOG_WARNING, "Trying to cancel a timer [%d] that does not exist", timer_id);
         return false;
     }
+    timer_wheel_remove(&timers_context->timer_wheel, timer_toRemove);
     free(timer_toRemove);
 
-    pthread_mutex_unlock(&timers_context_->timer_list_lock);
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
 
     return true;
 }
 
-bool reset_timer(int timer_id)
-{
-    static pcep_timer compare_timer;
 
-    if (timers_context_ == NULL)
+bool timers_context_reset_timer(pcep_timers_context *timers_context, int timer_id)
+{
+    if (timers_context == NULL)
     {
         pcep_log(LOG_WARNING, "Trying to reset a timer: the timers have not been initialized");
 
         return false;
     }
 
-    pthread_mutex_lock(&timers_context_->timer_list_lock);
+    pthread_mutex_lock(&timers_context->timer_list_lock);
 
-    compare_timer.timer_id = timer_id;
-    pcep_timer *timer_toReset = ordered_list_remove_first_node_equals2(
-            timers_context_->timer_list, &compare_timer, timer_list_node_timer_id_compare);
+    pcep_timer *timer_toReset = timer_wheel_find(&timers_context->timer_wheel, timer_id);
     if (timer_toReset == NULL)
     {
-        pthread_mutex_unlock(&timers_context_->timer_list_lock);
+        pthread_mutex_unlock(&timers_context->timer_list_lock);
         pcep_log(LOG_WARNING, "Trying to reset a timer that does not exist");
 
         return false;
     }
 
-    timer_toReset->expire_time = time(NULL) + timer_toReset->sleep_seconds;
-    if (ordered_list_add_node(timers_context_->timer_list, timer_toReset) == NULL)
+    timer_toReset->expire_time = get_timer_expire_time(timers_context, timer_toReset);
+    timer_wheel_reschedule(&timers_context->timer_wheel, timer_toReset);
+    wakeup_event_loop(timers_context, timer_toReset);
+
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
+
+    return true;
+}
+
+
+bool timers_context_set_coalescing_window(pcep_timers_context *timers_context, uint32_t window_millis)
+{
+    if (timers_context == NULL)
     {
-        free(timer_toReset);
-        pthread_mutex_unlock(&timers_context_->timer_list_lock);
-        pcep_log(LOG_WARNING, "Trying to reset a timer, cannot add the timer to the timer list");
+        pcep_log(LOG_WARNING, "Trying to set the timers coalescing window: the timers have not been initialized");
+        return false;
+    }
 
+    pthread_mutex_lock(&timers_context->timer_list_lock);
+    timers_context->coalescing_window_millis = window_millis;
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
+
+    return true;
+}
+
+
+bool timers_context_get_lateness_histogram(pcep_timers_context *timers_context,
+                                           pcep_timers_lateness_histogram *histogram)
+{
+    if (timers_context == NULL)
+    {
+        pcep_log(LOG_WARNING, "Trying to get the timers lateness histogram: the timers have not been initialized");
         return false;
     }
 
-    pthread_mutex_unlock(&timers_context_->timer_list_lock);
+    if (histogram == NULL)
+    {
+        pcep_log(LOG_WARNING, "Trying to get the timers lateness histogram with a NULL histogram");
+        return false;
+    }
+
+    pthread_mutex_lock(&timers_context->timer_list_lock);
+    memcpy(histogram, &timers_context->lateness_histogram, sizeof(pcep_timers_lateness_histogram));
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
 
     return true;
 }
 
+
+/*
+ * The timers API functions using the timers_context_ created by initialize_timers()
+ */
+
+int create_timer(uint16_t sleep_seconds, void *data)
+{
+    return create_timer_millis(((uint32_t) sleep_seconds) * 1000, data);
+}
+
+
+int create_timer_millis(uint32_t sleep_millis, void *data)
+{
+    return create_timer_with_jitter(sleep_millis, 0, data);
+}
+
+
+int create_timer_with_jitter(uint32_t sleep_millis, uint32_t jitter_millis, void *data)
+{
+    return timers_context_create_timer(timers_context_, sleep_millis, jitter_millis, data);
+}
+
+
+bool cancel_timer(int timer_id)
+{
+    return timers_context_cancel_timer(timers_context_, timer_id);
+}
+
+
+bool reset_timer(int timer_id)
+{
+    return timers_context_reset_timer(timers_context_, timer_id);
+}
+
+
+bool set_timers_coalescing_window(uint32_t window_millis)
+{
+    return timers_context_set_coalescing_window(timers_context_, window_millis);
+}
+
+
+bool get_timers_lateness_histogram(pcep_timers_lateness_histogram *histogram)
+{
+    return timers_context_get_lateness_histogram(timers_context_, histogram);
+}
@@ -23,46 +23,139 @@
  */
 
 
-#include <errno.h>
 #include <malloc.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <strings.h>
-#include <sys/select.h>
+#include <time.h>
 
 #include "pcep_timer_internals.h"
-#include "pcep_utils_ordered_list.h"
 #include "pcep_utils_logging.h"
 
-/* For each expired timer: remove the timer from the list, call the
- * expire_handler, and free the timer. */
+time_t get_coalesced_wakeup_time(pcep_timers_context *timers_context, time_t expire_time)
+{
+    time_t window_millis = timers_context->coalescing_window_millis;
+    if (window_millis <= 1 || expire_time == TIMER_WAKEUP_NEVER)
+    {
+        return expire_time;
+    }
+
+    /* Round up to the end of the window */
+    return ((expire_time + window_millis - 1) / window_millis) * window_millis;
+}
+
+
+/* Internal util function, called with the timer_list_lock held */
+static void update_lateness_histogram(pcep_timers_context *timers_context, pcep_timer *timer, time_t now)
+{
+    static const time_t bucket_limits_millis[TIMERS_LATENESS_NUM_BUCKETS - 1] =
+            TIMERS_LATENESS_BUCKET_LIMITS_MILLIS;
+
+    time_t lateness_millis = (now > timer->expire_time) ? now - timer->expire_time : 0;
+    int bucket = 0;
+    while (bucket < TIMERS_LATENESS_NUM_BUCKETS - 1 && lateness_millis >= bucket_limits_millis[bucket])
+    {
+        bucket++;
+    }
+
+    timers_context->lateness_histogram.num_timers[bucket]++;
+    if ((uint64_t) lateness_millis > timers_context->lateness_histogram.max_lateness_millis)
+    {
+        timers_context->lateness_histogram.max_lateness_millis = lateness_millis;
+    }
+}
+
+
+/* Remove the expired timers from the timer wheel, and free them after
+ * copying their data and timer_id to the expired_timers array. Then, after
+ * releasing the lock, call the context_expire_handler or expire_batch_handler
+ * once with all of them, or the expire_handler for each one. */
 void walk_and_process_timers(pcep_timers_context *timers_context)
 {
     pthread_mutex_lock(&timers_context->timer_list_lock);
 
-    bool keep_walking = true;
-    ordered_list_node *timer_node = timers_context->timer_list->head;
-    time_t now = time(NULL);
-    pcep_timer *timer_data;
+    /* the expired timers are returned in expire_time order,
+     * already removed from the timer wheel */
+    time_t now = get_timers_monotonic_millis();
+    pcep_timer *timer_data = timer_wheel_advance(&timers_context->timer_wheel, now);
+    unsigned int num_expired_timers = 0;
+    while (timer_data != NULL)
+    {
+        update_lateness_histogram(timers_context, timer_data, now);
+
+        if (num_expired_timers == timers_context->expired_timers_size)
+        {
+            timers_context->expired_timers_size = (timers_context->expired_timers_size == 0) ?
+                    INITIAL_EXPIRED_TIMERS_SIZE : timers_context->expired_timers_size * 2;
+            timers_context->expired_timers = realloc(timers_context->expired_timers,
+                    sizeof(pcep_expired_timer) * timers_context->expired_timers_size);
+        }
+
+        timers_context->expired_timers[num_expired_timers].data = timer_data->data;
+        timers_context->expired_timers[num_expired_timers].timer_id = timer_data->timer_id;
+        num_expired_timers++;
+
+        pcep_timer *next_timer = timer_data->next_timer;
+        free(timer_data);
+        timer_data = next_timer;
+    }
 
-    /* the timers are sorted by expire_time, so we will only
-     * remove the top node each time through the loop */
-    while (timer_node != NULL && keep_walking)
+    pthread_mutex_unlock(&timers_context->timer_list_lock);
+
+    if (num_expired_timers == 0)
+    {
+        return;
+    }
+
+    /* call the timer expired handlers */
+    if (timers_context->context_expire_handler != NULL)
+    {
+        timers_context->context_expire_handler(
+                timers_context->handler_data, timers_context->expired_timers, num_expired_timers);
+    }
+    else if (timers_context->expire_batch_handler != NULL)
+    {
+        timers_context->expire_batch_handler(timers_context->expired_timers, num_expired_timers);
+    }
+    else
     {
-        timer_data = (pcep_timer *) timer_node->data;
-        if (timer_data->expire_time <= now)
+        unsigned int i;
+        for (i = 0; i < num_expired_timers; i++)
         {
-            timer_node = timer_node->next_node;
-            ordered_list_remove_first_node(timers_context->timer_list);
-            /* call the timer expired handler */
-            timers_context->expire_handler(timer_data->data, timer_data->timer_id);
-            free(timer_data);
+            timers_context->expire_handler(
+                    timers_context->expired_timers[i].data, timers_context->expired_timers[i].timer_id);
         }
-        else
+    }
+}
+
+
+/* Sleep until the next timer expires, or until a timer that expires earlier
+ * is created or reset, or the timers are torn down. There are no wake ups
+ * while there are no timers. */
+static void wait_for_next_timer(pcep_timers_context *timers_context)
+{
+    pthread_mutex_lock(&timers_context->timer_list_lock);
+
+    if (timers_context->active)
+    {
+        timers_context->wakeup_time = get_coalesced_wakeup_time(timers_context,
+                timer_wheel_get_next_expire_time(&timers_context->timer_wheel));
+        if (timers_context->wakeup_time == TIMER_WAKEUP_NEVER)
         {
-            keep_walking = false;
+            pthread_cond_wait(&timers_context->timer_list_cond, &timers_context->timer_list_lock);
         }
+        else if (timers_context->wakeup_time > get_timers_monotonic_millis())
+        {
+            struct timespec deadline;
+            deadline.tv_sec = timers_context->wakeup_time / 1000;
+            deadline.tv_nsec = (timers_context->wakeup_time % 1000) * 1000000;
+            pthread_cond_timedwait(&timers_context->timer_list_cond, &timers_context->timer_list_lock, &deadline);
+        }
+
+        /* Any timer created or reset from now on will be seen when
+         * the timers are processed, so there is no need to wake up */
+        timers_context->wakeup_time = 0;
     }
 
     pthread_mutex_unlock(&timers_context->timer_list_lock);
@@ -81,24 +174,11 @@ void *event_loop(void *context)
     pcep_log(LOG_NOTICE, "[%ld-%ld] Starting timers_event_loop thread", time(NULL), pthread_self());
 
     pcep_timers_context *timers_context = (pcep_timers_context *) context;
-    struct timeval timer;
-    int retval;
 
     while (timers_context->active)
     {
-        /* check the timers every half second */
-        timer.tv_sec = 0;
-        timer.tv_usec = 500000;
-
-        do
-        {
-            /* if the select() call gets interrupted, select() will set
-             * the remaining time in timer, so we need to call it again.
-             */
-            retval = select(0, NULL, NULL, NULL, &timer);
-        } while(retval != 0 && errno == EINTR);
-
         walk_and_process_timers(timers_context);
+        wait_for_next_timer(timers_context);
     }
 
     pcep_log(LOG_WARNING, "[%ld-%ld] Finished timers_event_loop thread", time(NULL), pthread_self());
@@ -0,0 +1,448 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+/*
+ *  Hierarchical timing wheel used to store the timers.
+ *
+ *  Level 0 has a slot per time unit, and each slot of level N covers
+ *  TIMER_WHEEL_NUM_SLOTS slots of level N-1. A timer is stored in the
+ *  lowest level where its expire_time is in the same slot of the next
+ *  level as the wheel current_time. When the wheel reaches the start of
+ *  a level N slot, its timers are moved down to the level N-1 slots, so
+ *  each timer is only moved at most TIMER_WHEEL_NUM_LEVELS times.
+ */
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <strings.h>
+
+#include "pcep_timer_internals.h"
+
+
+/* Internal util function, the index_size is always a power of 2 */
+static unsigned int get_index_bucket(pcep_timer_wheel *timer_wheel, int timer_id)
+{
+    /* The timer_ids are sequential, so they are mixed to avoid filling a
+     * single run of buckets, which would make each removal walk all of it */
+    uint32_t value = ((uint32_t) timer_id) * 0x9e3779b1;
+    value ^= value >> 16;
+
+    return value & (timer_wheel->index_size - 1);
+}
+
+
+/* Internal util function, the index must have at least 1 empty bucket */
+static void index_insert(pcep_timer_wheel *timer_wheel, pcep_timer *timer)
+{
+    unsigned int bucket = get_index_bucket(timer_wheel, timer->timer_id);
+    while (timer_wheel->index_buckets[bucket] != NULL)
+    {
+        bucket = (bucket + 1) & (timer_wheel->index_size - 1);
+    }
+    timer_wheel->index_buckets[bucket] = timer;
+}
+
+
+/* Internal util function, grow the index when its more than half full */
+static void index_grow(pcep_timer_wheel *timer_wheel)
+{
+    pcep_timer **old_buckets = timer_wheel->index_buckets;
+    unsigned int old_index_size = timer_wheel->index_size;
+
+    timer_wheel->index_size *= 2;
+    timer_wheel->index_buckets = malloc(sizeof(pcep_timer *) * timer_wheel->index_size);
+    bzero(timer_wheel->index_buckets, sizeof(pcep_timer *) * timer_wheel->index_size);
+
+    unsigned int i;
+    for (i = 0; i < old_index_size; i++)
+    {
+        if (old_buckets[i] != NULL)
+        {
+            index_insert(timer_wheel, old_buckets[i]);
+        }
+    }
+
+    free(old_buckets);
+}
+
+
+/* Internal util function, returns the index bucket of the timer_id or -1 */
+static int find_index_bucket(pcep_timer_wheel *timer_wheel, int timer_id)
+{
+    unsigned int bucket = get_index_bucket(timer_wheel, timer_id);
+    while (timer_wheel->index_buckets[bucket] != NULL)
+    {
+        if (timer_wheel->index_buckets[bucket]->timer_id == timer_id)
+        {
+            return bucket;
+        }
+        bucket = (bucket + 1) & (timer_wheel->index_size - 1);
+    }
+
+    return -1;
+}
+
+
+/* Internal util function, remove the entry at the index bucket by shifting
+ * back the entries that follow it, so no tombstones are needed */
+static void index_remove(pcep_timer_wheel *timer_wheel, unsigned int bucket)
+{
+    unsigned int mask = timer_wheel->index_size - 1;
+    unsigned int next_bucket = bucket;
+
+    for (;;)
+    {
+        next_bucket = (next_bucket + 1) & mask;
+        pcep_timer *timer = timer_wheel->index_buckets[next_bucket];
+        if (timer == NULL)
+        {
+            break;
+        }
+
+        /* Only move the entry if its home bucket is not between the
+         * removed bucket and its current position */
+        unsigned int home_bucket = get_index_bucket(timer_wheel, timer->timer_id);
+        bool can_move = (bucket <= next_bucket) ?
+                (home_bucket <= bucket || home_bucket > next_bucket) :
+                (home_bucket <= bucket && home_bucket > next_bucket);
+        if (can_move)
+        {
+            timer_wheel->index_buckets[bucket] = timer;
+            bucket = next_bucket;
+        }
+    }
+
+    timer_wheel->index_buckets[bucket] = NULL;
+}
+
+
+/* Internal util function, returns the slot the timer should be stored in.
+ * All the timers expiring before from_time have already been processed. */
+static pcep_timer **get_timer_slot(pcep_timer_wheel *timer_wheel, pcep_timer *timer, time_t from_time)
+{
+    time_t expire_time = (timer->expire_time < from_time) ? from_time : timer->expire_time;
+
+    int level;
+    for (level = 0; level < TIMER_WHEEL_NUM_LEVELS; level++)
+    {
+        int next_level_shift = (level + 1) * TIMER_WHEEL_SLOT_BITS;
+        if ((expire_time >> next_level_shift) == (from_time >> next_level_shift))
+        {
+            return &timer_wheel->slots[level][(expire_time >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK];
+        }
+    }
+
+    /* The timer expires after the whole wheel, it is stored in the last
+     * top level slot to be reached, and will be moved again from there */
+    level = TIMER_WHEEL_NUM_LEVELS - 1;
+    return &timer_wheel->slots[level][((from_time >> (level * TIMER_WHEEL_SLOT_BITS)) - 1) & TIMER_WHEEL_SLOT_MASK];
+}
+
+
+/* Internal util function, returns the level of a slot */
+static int get_slot_level(pcep_timer_wheel *timer_wheel, pcep_timer **slot)
+{
+    return (slot - &timer_wheel->slots[0][0]) / TIMER_WHEEL_NUM_SLOTS;
+}
+
+
+/* Internal util function, returns the index of a slot in its level */
+static int get_slot_index(pcep_timer_wheel *timer_wheel, pcep_timer **slot)
+{
+    return (slot - &timer_wheel->slots[0][0]) & TIMER_WHEEL_SLOT_MASK;
+}
+
+
+/* Internal util function */
+static void link_timer(pcep_timer_wheel *timer_wheel, pcep_timer **slot, pcep_timer *timer)
+{
+    timer->slot = slot;
+    timer->prev_timer = NULL;
+    timer->next_timer = *slot;
+    if (*slot != NULL)
+    {
+        (*slot)->prev_timer = timer;
+    }
+    *slot = timer;
+
+    timer_wheel->occupied_slots[get_slot_level(timer_wheel, slot)] |=
+            (((uint64_t) 1) << get_slot_index(timer_wheel, slot));
+}
+
+
+/* Internal util function */
+static void unlink_timer(pcep_timer_wheel *timer_wheel, pcep_timer *timer)
+{
+    if (timer->prev_timer != NULL)
+    {
+        timer->prev_timer->next_timer = timer->next_timer;
+    }
+    else
+    {
+        *(timer->slot) = timer->next_timer;
+    }
+
+    if (timer->next_timer != NULL)
+    {
+        timer->next_timer->prev_timer = timer->prev_timer;
+    }
+
+    if (*(timer->slot) == NULL)
+    {
+        timer_wheel->occupied_slots[get_slot_level(timer_wheel, timer->slot)] &=
+                ~(((uint64_t) 1) << get_slot_index(timer_wheel, timer->slot));
+    }
+
+    timer->slot = NULL;
+    timer->prev_timer = NULL;
+    timer->next_timer = NULL;
+}
+
+
+/* Internal util function, returns the slots of the level from the slot
+ * including from_time, the rest of the level slots are not reached
+ * before the end of the next level slot */
+static uint64_t get_occupied_slots_ahead(pcep_timer_wheel *timer_wheel, int level, time_t from_time)
+{
+    int index = (from_time >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+
+    return timer_wheel->occupied_slots[level] >> index;
+}
+
+
+/* Internal util function, move the timers of a level slot down to the lower levels */
+static void cascade_slot(pcep_timer_wheel *timer_wheel, int level, time_t tick)
+{
+    pcep_timer **slot = &timer_wheel->slots[level][(tick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK];
+    pcep_timer *timer = *slot;
+    *slot = NULL;
+    timer_wheel->occupied_slots[level] &= ~(((uint64_t) 1) << get_slot_index(timer_wheel, slot));
+
+    while (timer != NULL)
+    {
+        pcep_timer *next_timer = timer->next_timer;
+        link_timer(timer_wheel, get_timer_slot(timer_wheel, timer, tick), timer);
+        timer = next_timer;
+    }
+}
+
+
+void timer_wheel_initialize(pcep_timer_wheel *timer_wheel, time_t current_time)
+{
+    bzero(timer_wheel, sizeof(pcep_timer_wheel));
+    timer_wheel->current_time = current_time;
+    timer_wheel->index_size = TIMER_WHEEL_INITIAL_INDEX_SIZE;
+    timer_wheel->index_buckets = malloc(sizeof(pcep_timer *) * timer_wheel->index_size);
+    bzero(timer_wheel->index_buckets, sizeof(pcep_timer *) * timer_wheel->index_size);
+}
+
+
+void timer_wheel_destroy(pcep_timer_wheel *timer_wheel)
+{
+    int level;
+    int slot;
+    for (level = 0; level < TIMER_WHEEL_NUM_LEVELS; level++)
+    {
+        for (slot = 0; slot < TIMER_WHEEL_NUM_SLOTS; slot++)
+        {
+            pcep_timer *timer = timer_wheel->slots[level][slot];
+            while (timer != NULL)
+            {
+                pcep_timer *next_timer = timer->next_timer;
+                free(timer);
+                timer = next_timer;
+            }
+        }
+    }
+
+    free(timer_wheel->index_buckets);
+    bzero(timer_wheel, sizeof(pcep_timer_wheel));
+}
+
+
+void timer_wheel_add(pcep_timer_wheel *timer_wheel, pcep_timer *timer)
+{
+    if ((timer_wheel->num_timers + 1) * 2 > timer_wheel->index_size)
+    {
+        index_grow(timer_wheel);
+    }
+    index_insert(timer_wheel, timer);
+    timer_wheel->num_timers++;
+
+    link_timer(timer_wheel, get_timer_slot(timer_wheel, timer, timer_wheel->current_time + 1), timer);
+}
+
+
+void timer_wheel_remove(pcep_timer_wheel *timer_wheel, pcep_timer *timer)
+{
+    int bucket = find_index_bucket(timer_wheel, timer->timer_id);
+    if (bucket < 0)
+    {
+        return;
+    }
+
+    index_remove(timer_wheel, bucket);
+    timer_wheel->num_timers--;
+    unlink_timer(timer_wheel, timer);
+}
+
+
+void timer_wheel_reschedule(pcep_timer_wheel *timer_wheel, pcep_timer *timer)
+{
+    unlink_timer(timer_wheel, timer);
+    link_timer(timer_wheel, get_timer_slot(timer_wheel, timer, timer_wheel->current_time + 1), timer);
+}
+
+
+pcep_timer *timer_wheel_find(pcep_timer_wheel *timer_wheel, int timer_id)
+{
+    int bucket = find_index_bucket(timer_wheel, timer_id);
+
+    return (bucket < 0) ? NULL : timer_wheel->index_buckets[bucket];
+}
+
+
+pcep_timer *timer_wheel_advance(pcep_timer_wheel *timer_wheel, time_t now)
+{
+    pcep_timer *expired_head = NULL;
+    pcep_timer *expired_tail = NULL;
+
+    while (timer_wheel->current_time < now)
+    {
+        if (timer_wheel->num_timers == 0)
+        {
+            /* Nothing to process, jump straight to now */
+            timer_wheel->current_time = now;
+            break;
+        }
+
+        /* Skip the ticks where no timers expire or are moved down. If there
+         * are no timers ahead in the lowest levels, nothing happens until
+         * the end of the slot of the next level. */
+        time_t tick = timer_wheel->current_time + 1;
+        time_t skip_to_time = timer_wheel->current_time;
+        int level;
+        for (level = 0; level < TIMER_WHEEL_NUM_LEVELS; level++)
+        {
+            if (get_occupied_slots_ahead(timer_wheel, level, tick) != 0)
+            {
+                break;
+            }
+            skip_to_time = tick | ((((time_t) 1) << ((level + 1) * TIMER_WHEEL_SLOT_BITS)) - 1);
+        }
+
+        /* The slot with timers ahead may have to be moved down at this tick */
+        if (level < TIMER_WHEEL_NUM_LEVELS &&
+                (tick & ((((time_t) 1) << (level * TIMER_WHEEL_SLOT_BITS)) - 1)) == 0)
+        {
+            skip_to_time = timer_wheel->current_time;
+        }
+
+        if (skip_to_time > timer_wheel->current_time)
+        {
+            timer_wheel->current_time = (skip_to_time < now) ? skip_to_time : now;
+            continue;
+        }
+
+        timer_wheel->current_time = tick;
+
+        /* Move down the timers of the higher level slots starting at this
+         * tick, from the highest level, since they may be moved more than
+         * one level down */
+        int num_levels = 1;
+        while (num_levels < TIMER_WHEEL_NUM_LEVELS &&
+                (tick & ((((time_t) 1) << (num_levels * TIMER_WHEEL_SLOT_BITS)) - 1)) == 0)
+        {
+            num_levels++;
+        }
+
+        for (level = num_levels - 1; level > 0; level--)
+        {
+            cascade_slot(timer_wheel, level, tick);
+        }
+
+        /* All the timers in the level 0 slot expire at this tick */
+        pcep_timer **slot = &timer_wheel->slots[0][tick & TIMER_WHEEL_SLOT_MASK];
+        while (*slot != NULL)
+        {
+            pcep_timer *timer = *slot;
+            timer_wheel_remove(timer_wheel, timer);
+            if (expired_tail == NULL)
+            {
+                expired_head = timer;
+            }
+            else
+            {
+                expired_tail->next_timer = timer;
+            }
+            expired_tail = timer;
+        }
+    }
+
+    return expired_head;
+}
+
+
+time_t timer_wheel_get_next_expire_time(pcep_timer_wheel *timer_wheel)
+{
+    if (timer_wheel->num_timers == 0)
+    {
+        return TIMER_WAKEUP_NEVER;
+    }
+
+    /* The timers in a level all expire before the timers in the higher
+     * levels, so the earliest timer is in the first occupied slot ahead */
+    time_t from_time = timer_wheel->current_time + 1;
+    int top_level = TIMER_WHEEL_NUM_LEVELS - 1;
+    int level;
+    pcep_timer *timer = NULL;
+    for (level = 0; level < TIMER_WHEEL_NUM_LEVELS && timer == NULL; level++)
+    {
+        int index = (from_time >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+        uint64_t occupied_slots = get_occupied_slots_ahead(timer_wheel, level, from_time);
+        if (occupied_slots != 0)
+        {
+            timer = timer_wheel->slots[level][index + __builtin_ctzll(occupied_slots)];
+        }
+        else if (level == top_level && timer_wheel->occupied_slots[level] != 0)
+        {
+            /* The top level slots behind the current one are reached after wrapping */
+            timer = timer_wheel->slots[level][__builtin_ctzll(timer_wheel->occupied_slots[level])];
+        }
+    }
+
+    time_t next_expire_time = TIMER_WAKEUP_NEVER;
+    while (timer != NULL)
+    {
+        if (timer->expire_time < next_expire_time)
+        {
+            next_expire_time = timer->expire_time;
+        }
+        timer = timer->next_timer;
+    }
+
+    return next_expire_time;
+}
@@ -0,0 +1,232 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+/*
+ *  Microbenchmark of the timer store.
+ *
+ *  The same sequence of timer create, reset, and cancel operations is run
+ *  on the timer wheel, and on an ordered_list sorted by expire_time, which
+ *  is how the timers were previously stored. Each session has a keepalive
+ *  and a dead timer, which are reset for every message sent or received,
+ *  so the number of resets is a multiple of the number of timers.
+ *
+ *  Usage: pcep_timers_bench [num_timers] [resets_per_timer]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <time.h>
+
+#include "pcep_timer_internals.h"
+#include "pcep_utils_ordered_list.h"
+
+#define DEFAULT_NUM_TIMERS 10000
+#define DEFAULT_RESETS_PER_TIMER 4
+#define MAX_SLEEP_MILLIS 240000
+#define BENCH_START_TIME 1000
+
+typedef struct bench_operations_
+{
+    const char *name;
+    void (*initialize)(void);
+    void (*create)(pcep_timer *timer);
+    void (*reset)(int timer_id, time_t expire_time);
+    void (*cancel)(int timer_id);
+    void (*destroy)(void);
+
+} bench_operations;
+
+
+/*
+ * Timers stored in an ordered_list, searched by timer_id
+ */
+
+static ordered_list_handle *bench_timer_list = NULL;
+
+static int bench_expire_time_compare(void *list_entry, void *new_entry)
+{
+    return ((pcep_timer *) new_entry)->expire_time - ((pcep_timer *) list_entry)->expire_time;
+}
+
+static int bench_timer_id_compare(void *list_entry, void *new_entry)
+{
+    return ((pcep_timer *) new_entry)->timer_id - ((pcep_timer *) list_entry)->timer_id;
+}
+
+static void list_initialize()
+{
+    bench_timer_list = ordered_list_initialize(bench_expire_time_compare);
+}
+
+static void list_create(pcep_timer *timer)
+{
+    ordered_list_add_node(bench_timer_list, timer);
+}
+
+static void list_reset(int timer_id, time_t expire_time)
+{
+    pcep_timer compare_timer;
+    compare_timer.timer_id = timer_id;
+    pcep_timer *timer = ordered_list_remove_first_node_equals2(
+            bench_timer_list, &compare_timer, bench_timer_id_compare);
+    if (timer != NULL)
+    {
+        timer->expire_time = expire_time;
+        ordered_list_add_node(bench_timer_list, timer);
+    }
+}
+
+static void list_cancel(int timer_id)
+{
+    pcep_timer compare_timer;
+    compare_timer.timer_id = timer_id;
+    free(ordered_list_remove_first_node_equals2(
+            bench_timer_list, &compare_timer, bench_timer_id_compare));
+}
+
+static void list_destroy()
+{
+    ordered_list_destroy(bench_timer_list);
+    bench_timer_list = NULL;
+}
+
+
+/*
+ * Timers stored in the timer wheel
+ */
+
+static pcep_timer_wheel bench_timer_wheel;
+
+static void wheel_initialize()
+{
+    timer_wheel_initialize(&bench_timer_wheel, BENCH_START_TIME);
+}
+
+static void wheel_create(pcep_timer *timer)
+{
+    timer_wheel_add(&bench_timer_wheel, timer);
+}
+
+static void wheel_reset(int timer_id, time_t expire_time)
+{
+    pcep_timer *timer = timer_wheel_find(&bench_timer_wheel, timer_id);
+    if (timer != NULL)
+    {
+        timer->expire_time = expire_time;
+        timer_wheel_reschedule(&bench_timer_wheel, timer);
+    }
+}
+
+static void wheel_cancel(int timer_id)
+{
+    pcep_timer *timer = timer_wheel_find(&bench_timer_wheel, timer_id);
+    if (timer != NULL)
+    {
+        timer_wheel_remove(&bench_timer_wheel, timer);
+        free(timer);
+    }
+}
+
+static void wheel_destroy()
+{
+    timer_wheel_destroy(&bench_timer_wheel);
+}
+
+
+static double get_elapsed_millis(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((now.tv_sec - start->tv_sec) * 1000.0) + ((now.tv_nsec - start->tv_nsec) / 1000000.0);
+}
+
+
+static void run_bench(bench_operations *ops, int num_timers, int resets_per_timer)
+{
+    struct timespec start;
+    int i;
+
+    /* Use the same pseudo random sequence for each store */
+    srand(1);
+    ops->initialize();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < num_timers; i++)
+    {
+        pcep_timer *timer = malloc(sizeof(pcep_timer));
+        bzero(timer, sizeof(pcep_timer));
+        timer->timer_id = i;
+        timer->expire_time = BENCH_START_TIME + 1 + (rand() % MAX_SLEEP_MILLIS);
+        ops->create(timer);
+    }
+    double create_millis = get_elapsed_millis(&start);
+
+    int num_resets = num_timers * resets_per_timer;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < num_resets; i++)
+    {
+        ops->reset(rand() % num_timers, BENCH_START_TIME + 1 + (rand() % MAX_SLEEP_MILLIS));
+    }
+    double reset_millis = get_elapsed_millis(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < num_timers; i++)
+    {
+        ops->cancel(i);
+    }
+    double cancel_millis = get_elapsed_millis(&start);
+
+    ops->destroy();
+
+    printf("%-12s create %10.3f ms  reset %10.3f ms  cancel %10.3f ms  (%.1f ns/op)\n",
+            ops->name, create_millis, reset_millis, cancel_millis,
+            ((create_millis + reset_millis + cancel_millis) * 1000000.0) / (num_timers * 2 + num_resets));
+}
+
+
+int main(int argc, char **argv)
+{
+    int num_timers = (argc > 1) ? atoi(argv[1]) : DEFAULT_NUM_TIMERS;
+    int resets_per_timer = (argc > 2) ? atoi(argv[2]) : DEFAULT_RESETS_PER_TIMER;
+    if (num_timers <= 0 || resets_per_timer < 0)
+    {
+        fprintf(stderr, "Usage: %s [num_timers] [resets_per_timer]\n", argv[0]);
+        return 1;
+    }
+
+    bench_operations list_ops =
+        { "ordered_list", list_initialize, list_create, list_reset, list_cancel, list_destroy };
+    bench_operations wheel_ops =
+        { "timer_wheel", wheel_initialize, wheel_create, wheel_reset, wheel_cancel, wheel_destroy };
+
+    printf("%d timers, %d resets\n", num_timers, num_timers * resets_per_timer);
+    run_bench(&list_ops, num_timers, resets_per_timer);
+    run_bench(&wheel_ops, num_timers, resets_per_timer);
+
+    return 0;
+}
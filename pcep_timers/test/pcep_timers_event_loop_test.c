@@ -45,8 +45,6 @@ static timer_expire_handler_info expire_handler_info;
 
 /* Function being tested defined in pcep_timers_event_loop.c */
 extern void walk_and_process_timers(pcep_timers_context *timers_context);
-/* Use the same timer node compare func as the actual code, defined in pcep_timers.c */
-extern int timer_list_node_timer_id_compare(void *list_entry, void *new_entry);
 
 
 /* Called when a timer expires */
@@ -58,6 +56,31 @@ static void test_timer_expire_handler(void *data, int timerId)
 }
 
 
+static int batch_handler_times_called = 0;
+static int batch_timer_ids[3];
+static int batch_num_expired_timers = 0;
+static bool batch_lock_released = false;
+
+/* Called once with all the timers that expire together */
+static void test_timer_expire_batch_handler(pcep_expired_timer *expired_timers, int num_expired_timers)
+{
+    batch_handler_times_called++;
+    batch_num_expired_timers = num_expired_timers;
+    int i;
+    for (i = 0; i < num_expired_timers && i < 3; i++)
+    {
+        batch_timer_ids[i] = expired_timers[i].timer_id;
+    }
+
+    /* The handler should be called without holding the timer_list_lock */
+    batch_lock_released = (pthread_mutex_trylock(&test_timers_context->timer_list_lock) == 0);
+    if (batch_lock_released)
+    {
+        pthread_mutex_unlock(&test_timers_context->timer_list_lock);
+    }
+}
+
+
 /* Test case setup called before each test.
  * Declared in pcep_timers_tests.c */
 void pcep_timers_event_loop_test_setup()
@@ -70,8 +93,8 @@ void pcep_timers_event_loop_test_setup()
     }
     test_timers_context->active = false;
     test_timers_context->expire_handler = test_timer_expire_handler;
-    test_timers_context->timer_list =
-            ordered_list_initialize(timer_list_node_timer_id_compare);
+    /* Start the timer wheel in the past, so timers can be added already expired */
+    timer_wheel_initialize(&test_timers_context->timer_wheel, get_timers_monotonic_millis() - 60000);
 
     expire_handler_info.handler_called = false;
     expire_handler_info.data = NULL;
@@ -85,7 +108,11 @@ void pcep_timers_event_loop_test_teardown()
 {
     pthread_mutex_unlock(&test_timers_context->timer_list_lock);
     pthread_mutex_destroy(&(test_timers_context->timer_list_lock));
-    ordered_list_destroy(test_timers_context->timer_list);
+    timer_wheel_destroy(&test_timers_context->timer_wheel);
+    if (test_timers_context->expired_timers != NULL)
+    {
+        free(test_timers_context->expired_timers);
+    }
     free(test_timers_context);
     test_timers_context = NULL;
 }
@@ -97,32 +124,32 @@ void pcep_timers_event_loop_test_teardown()
 
 void test_walk_and_process_timers_no_timers()
 {
-    CU_ASSERT_EQUAL(test_timers_context->timer_list->num_entries, 0);
-    CU_ASSERT_PTR_NULL(test_timers_context->timer_list->head);
+    CU_ASSERT_EQUAL(test_timers_context->timer_wheel.num_timers, 0);
 
     walk_and_process_timers(test_timers_context);
 
     CU_ASSERT_FALSE(expire_handler_info.handler_called);
-    CU_ASSERT_EQUAL(test_timers_context->timer_list->num_entries, 0);
-    CU_ASSERT_PTR_NULL(test_timers_context->timer_list->head);
+    CU_ASSERT_EQUAL(test_timers_context->timer_wheel.num_timers, 0);
 }
 
 
 void test_walk_and_process_timers_timer_not_expired()
 {
-    pcep_timer timer;
-    timer.data = &timer;
+    /* We need to malloc it, since it will be free'd in timer_wheel_destroy */
+    pcep_timer *timer = malloc(sizeof(pcep_timer));
+    bzero(timer, sizeof(pcep_timer));
+    timer->data = timer;
     // Set the timer to expire 100 seconds from now
-    timer.expire_time = time(NULL) + 100;
-    timer.timer_id = TEST_EVENT_LOOP_TIMER_ID;
-    ordered_list_add_node(test_timers_context->timer_list, &timer);
+    timer->expire_time = get_timers_monotonic_millis() + 100000;
+    timer->timer_id = TEST_EVENT_LOOP_TIMER_ID;
+    timer_wheel_add(&test_timers_context->timer_wheel, timer);
 
     walk_and_process_timers(test_timers_context);
 
-    /* The timer should still be in the list, since it hasnt expired yet */
+    /* The timer should still be in the wheel, since it hasnt expired yet */
     CU_ASSERT_FALSE(expire_handler_info.handler_called);
-    CU_ASSERT_EQUAL(test_timers_context->timer_list->num_entries, 1);
-    CU_ASSERT_PTR_NOT_NULL(test_timers_context->timer_list->head);
+    CU_ASSERT_EQUAL(test_timers_context->timer_wheel.num_timers, 1);
+    CU_ASSERT_PTR_EQUAL(timer_wheel_find(&test_timers_context->timer_wheel, TEST_EVENT_LOOP_TIMER_ID), timer);
 }
 
 
@@ -130,23 +157,104 @@ void test_walk_and_process_timers_timer_expired()
 {
     /* We need to malloc it, since it will be free'd in walk_and_process_timers */
     pcep_timer *timer = malloc(sizeof(pcep_timer));
+    bzero(timer, sizeof(pcep_timer));
     timer->data = timer;
     // Set the timer to expire 10 seconds ago
-    timer->expire_time = time(NULL) - 10;
+    timer->expire_time = get_timers_monotonic_millis() - 10000;
     timer->timer_id = TEST_EVENT_LOOP_TIMER_ID;
-    ordered_list_add_node(test_timers_context->timer_list, timer);
+    timer_wheel_add(&test_timers_context->timer_wheel, timer);
 
     walk_and_process_timers(test_timers_context);
 
     /* Since the timer expired, the expire_handler should have been called
-     * and the timer should have been removed from the timer list */
+     * and the timer should have been removed from the timer wheel */
     CU_ASSERT_TRUE(expire_handler_info.handler_called);
     CU_ASSERT_PTR_EQUAL(expire_handler_info.data, timer);
     CU_ASSERT_EQUAL(expire_handler_info.timerId, TEST_EVENT_LOOP_TIMER_ID);
-    CU_ASSERT_EQUAL(test_timers_context->timer_list->num_entries, 0);
-    CU_ASSERT_PTR_NULL(test_timers_context->timer_list->head);
+    CU_ASSERT_EQUAL(test_timers_context->timer_wheel.num_timers, 0);
+    CU_ASSERT_PTR_NULL(timer_wheel_find(&test_timers_context->timer_wheel, TEST_EVENT_LOOP_TIMER_ID));
 }
 
+void test_walk_and_process_timers_batch()
+{
+    test_timers_context->expire_handler = NULL;
+    test_timers_context->expire_batch_handler = test_timer_expire_batch_handler;
+    batch_handler_times_called = 0;
+    batch_num_expired_timers = 0;
+    batch_lock_released = false;
+
+    /* More expired timers than INITIAL_EXPIRED_TIMERS_SIZE, so the
+     * expired_timers array has to grow, added in the reverse order of
+     * expiration, and 1 timer that has not expired */
+    int num_timers = INITIAL_EXPIRED_TIMERS_SIZE + 4;
+    time_t now = get_timers_monotonic_millis();
+    int i;
+    for (i = 0; i < num_timers; i++)
+    {
+        pcep_timer *timer = malloc(sizeof(pcep_timer));
+        bzero(timer, sizeof(pcep_timer));
+        timer->timer_id = TEST_EVENT_LOOP_TIMER_ID + i;
+        timer->expire_time = (i == 0) ? now + 100000 : now - 10000 - (i * 10);
+        timer_wheel_add(&test_timers_context->timer_wheel, timer);
+    }
+
+    walk_and_process_timers(test_timers_context);
+
+    /* The expired timers are passed in expiration order */
+    CU_ASSERT_EQUAL(batch_handler_times_called, 1);
+    CU_ASSERT_EQUAL(batch_num_expired_timers, num_timers - 1);
+    CU_ASSERT_EQUAL(batch_timer_ids[0], TEST_EVENT_LOOP_TIMER_ID + num_timers - 1);
+    CU_ASSERT_EQUAL(batch_timer_ids[1], TEST_EVENT_LOOP_TIMER_ID + num_timers - 2);
+    CU_ASSERT_EQUAL(batch_timer_ids[2], TEST_EVENT_LOOP_TIMER_ID + num_timers - 3);
+    CU_ASSERT_TRUE(batch_lock_released);
+    CU_ASSERT_EQUAL(test_timers_context->timer_wheel.num_timers, 1);
+
+    /* The handler is not called when no timers expire */
+    walk_and_process_timers(test_timers_context);
+    CU_ASSERT_EQUAL(batch_handler_times_called, 1);
+}
+
+
+void test_walk_and_process_timers_lateness_histogram()
+{
+    /* 1 timer expired 3 millis ago, and 1 expired 10 seconds ago */
+    time_t now = get_timers_monotonic_millis();
+    int i;
+    for (i = 0; i < 2; i++)
+    {
+        pcep_timer *timer = malloc(sizeof(pcep_timer));
+        bzero(timer, sizeof(pcep_timer));
+        timer->timer_id = TEST_EVENT_LOOP_TIMER_ID + i;
+        timer->expire_time = (i == 0) ? now - 3 : now - 10000;
+        timer_wheel_add(&test_timers_context->timer_wheel, timer);
+    }
+
+    walk_and_process_timers(test_timers_context);
+
+    /* The buckets are [0, 1), [1, 2), [2, 5), ... [1000, ) */
+    pcep_timers_lateness_histogram *histogram = &test_timers_context->lateness_histogram;
+    CU_ASSERT_EQUAL(histogram->num_timers[0] + histogram->num_timers[1], 0);
+    CU_ASSERT_EQUAL(histogram->num_timers[2] + histogram->num_timers[3], 1);
+    CU_ASSERT_EQUAL(histogram->num_timers[TIMERS_LATENESS_NUM_BUCKETS - 1], 1);
+    CU_ASSERT_TRUE(histogram->max_lateness_millis >= 10000);
+}
+
+
+void test_get_coalesced_wakeup_time()
+{
+    /* Without a coalescing window, the wakeup is at the expire_time */
+    test_timers_context->coalescing_window_millis = 0;
+    CU_ASSERT_EQUAL(get_coalesced_wakeup_time(test_timers_context, 1001), 1001);
+
+    /* With a coalescing window, the wakeup is at the end of the window */
+    test_timers_context->coalescing_window_millis = 100;
+    CU_ASSERT_EQUAL(get_coalesced_wakeup_time(test_timers_context, 1001), 1100);
+    CU_ASSERT_EQUAL(get_coalesced_wakeup_time(test_timers_context, 1099), 1100);
+    CU_ASSERT_EQUAL(get_coalesced_wakeup_time(test_timers_context, 1100), 1100);
+    CU_ASSERT_EQUAL(get_coalesced_wakeup_time(test_timers_context, TIMER_WAKEUP_NEVER), TIMER_WAKEUP_NEVER);
+}
+
+
 void test_event_loop_null_handle()
 {
     /* Verify that event_loop() correctly handles a NULL timers_context */
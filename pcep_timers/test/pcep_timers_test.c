@@ -24,9 +24,15 @@
 
 
 #include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
 #include <CUnit/CUnit.h>
 
 #include "pcep_timers.h"
+#include "pcep_timer_internals.h"
+
+extern pcep_timers_context *timers_context_;
 
 /* Test case teardown called after each test.
  * Declared in pcep_timers_tests.c */
@@ -39,6 +45,21 @@ static void test_timer_expire_handler(void *data, int timerId)
 {
 }
 
+static volatile int expired_timer_id = TIMER_ID_NOT_SET;
+
+static void test_timer_millis_expire_handler(void *data, int timerId)
+{
+    expired_timer_id = timerId;
+}
+
+static long get_elapsed_millis(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((now.tv_sec - start->tv_sec) * 1000) + ((now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
 
 void test_double_initialization(void)
 {
@@ -72,6 +93,111 @@ void test_create_timer(void)
 }
 
 
+void test_create_timer_millis(void)
+{
+    CU_ASSERT_EQUAL(initialize_timers(test_timer_millis_expire_handler), true);
+    expired_timer_id = TIMER_ID_NOT_SET;
+
+    /* The event_loop sleeps until the first timer expires, creating an
+     * earlier timer should wake it up to sleep until the new timer */
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int late_timer_id = create_timer(10, NULL);
+    CU_ASSERT_TRUE(late_timer_id > -1);
+    usleep(10000);
+    int timer_id = create_timer_millis(50, NULL);
+    CU_ASSERT_TRUE(timer_id > -1);
+
+    while (expired_timer_id == TIMER_ID_NOT_SET && get_elapsed_millis(&start) < 2000)
+    {
+        usleep(1000);
+    }
+
+    long elapsed_millis = get_elapsed_millis(&start);
+    CU_ASSERT_EQUAL(expired_timer_id, timer_id);
+    CU_ASSERT_TRUE(elapsed_millis >= 50);
+    CU_ASSERT_TRUE(elapsed_millis < 500);
+    CU_ASSERT_EQUAL(cancel_timer(late_timer_id), true);
+}
+
+
+void test_create_timer_with_jitter(void)
+{
+    CU_ASSERT_EQUAL(initialize_timers(test_timer_expire_handler), true);
+
+    /* The timers should expire between 5 and 10 seconds from now,
+     * and not all of them at the same time */
+    time_t now = get_timers_monotonic_millis();
+    time_t first_expire_time = 0;
+    bool all_equal = true;
+    int i;
+    for (i = 0; i < 20; i++)
+    {
+        int timer_id = create_timer_with_jitter(10000, 5000, NULL);
+        CU_ASSERT_TRUE(timer_id > -1);
+
+        pcep_timer *timer = timer_wheel_find(&timers_context_->timer_wheel, timer_id);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(timer);
+        CU_ASSERT_TRUE(timer->expire_time >= now + 5000);
+        CU_ASSERT_TRUE(timer->expire_time <= get_timers_monotonic_millis() + 10000);
+        if (i == 0)
+        {
+            first_expire_time = timer->expire_time;
+        }
+        else if (timer->expire_time != first_expire_time)
+        {
+            all_equal = false;
+        }
+
+        /* Resetting the timer keeps it in the jitter range */
+        CU_ASSERT_EQUAL(reset_timer(timer_id), true);
+        CU_ASSERT_TRUE(timer->expire_time >= now + 5000);
+    }
+    CU_ASSERT_FALSE(all_equal);
+
+    /* The jitter can not be more than the sleep time */
+    int timer_id = create_timer_with_jitter(100, 5000, NULL);
+    pcep_timer *timer = timer_wheel_find(&timers_context_->timer_wheel, timer_id);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(timer);
+    CU_ASSERT_EQUAL(timer->jitter_millis, 100);
+    CU_ASSERT_TRUE(timer->expire_time >= now);
+}
+
+
+void test_timers_coalescing_window(void)
+{
+    pcep_timers_lateness_histogram histogram;
+    CU_ASSERT_FALSE(set_timers_coalescing_window(100));
+    CU_ASSERT_FALSE(get_timers_lateness_histogram(&histogram));
+
+    CU_ASSERT_EQUAL(initialize_timers(test_timer_millis_expire_handler), true);
+    CU_ASSERT_TRUE(set_timers_coalescing_window(200));
+    CU_ASSERT_FALSE(get_timers_lateness_histogram(NULL));
+    expired_timer_id = TIMER_ID_NOT_SET;
+
+    /* The timer expires at the end of the 200 millis window */
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int timer_id = create_timer_millis(10, NULL);
+    while (expired_timer_id == TIMER_ID_NOT_SET && get_elapsed_millis(&start) < 2000)
+    {
+        usleep(1000);
+    }
+    CU_ASSERT_EQUAL(expired_timer_id, timer_id);
+    CU_ASSERT_TRUE(get_elapsed_millis(&start) < 1000);
+
+    CU_ASSERT_TRUE(get_timers_lateness_histogram(&histogram));
+    uint64_t num_timers = 0;
+    int i;
+    for (i = 0; i < TIMERS_LATENESS_NUM_BUCKETS; i++)
+    {
+        num_timers += histogram.num_timers[i];
+    }
+    CU_ASSERT_EQUAL(num_timers, 1);
+    CU_ASSERT_TRUE(histogram.max_lateness_millis < 200);
+}
+
+
 void test_cancel_timer(void)
 {
     CU_ASSERT_EQUAL(initialize_timers(test_timer_expire_handler), true);
@@ -106,3 +232,52 @@ void test_reset_timer_invalid(void)
     CU_ASSERT_EQUAL(initialize_timers(test_timer_expire_handler), true);
     CU_ASSERT_EQUAL(reset_timer(1), false);
 }
+
+
+static volatile int context_expired_timer_ids[2] = { TIMER_ID_NOT_SET, TIMER_ID_NOT_SET };
+
+static void test_timers_context_expire_handler(void *handler_data, pcep_expired_timer *expired_timers, int num_expired_timers)
+{
+    /* The handler_data is the index of the timers context */
+    int index = *((int *) handler_data);
+    context_expired_timer_ids[index] = expired_timers[num_expired_timers - 1].timer_id;
+}
+
+
+void test_timers_contexts(void)
+{
+    static int context_indexes[2] = { 0, 1 };
+    CU_ASSERT_PTR_NULL(create_timers_context(NULL, NULL));
+    CU_ASSERT_FALSE(destroy_timers_context(NULL));
+
+    /* The timers contexts are independent of each other, and of the
+     * timers context used by create_timer() */
+    pcep_timers_context *timers_context1 = create_timers_context(test_timers_context_expire_handler, &context_indexes[0]);
+    pcep_timers_context *timers_context2 = create_timers_context(test_timers_context_expire_handler, &context_indexes[1]);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(timers_context1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(timers_context2);
+    CU_ASSERT_EQUAL(create_timer(5, NULL), -1);
+
+    /* Each timers context has its own timer_ids */
+    int long_timer_id = timers_context_create_timer(timers_context1, 10000, 0, NULL);
+    int timer_id1 = timers_context_create_timer(timers_context1, 10, 0, NULL);
+    int timer_id2 = timers_context_create_timer(timers_context2, 10, 0, NULL);
+    CU_ASSERT_EQUAL(long_timer_id, 0);
+    CU_ASSERT_EQUAL(timer_id1, 1);
+    CU_ASSERT_EQUAL(timer_id2, 0);
+    CU_ASSERT_FALSE(timers_context_reset_timer(timers_context2, timer_id1));
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((context_expired_timer_ids[0] == TIMER_ID_NOT_SET || context_expired_timer_ids[1] == TIMER_ID_NOT_SET) &&
+            get_elapsed_millis(&start) < 2000)
+    {
+        usleep(1000);
+    }
+    CU_ASSERT_EQUAL(context_expired_timer_ids[0], timer_id1);
+    CU_ASSERT_EQUAL(context_expired_timer_ids[1], timer_id2);
+
+    /* Destroying a timers context frees its timers that have not expired */
+    CU_ASSERT_TRUE(destroy_timers_context(timers_context1));
+    CU_ASSERT_TRUE(destroy_timers_context(timers_context2));
+}
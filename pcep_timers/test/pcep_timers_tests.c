@@ -33,10 +33,14 @@ extern void test_double_initialization(void);
 extern void test_initialization_null_callback(void);
 extern void test_not_initialized(void);
 extern void test_create_timer(void);
+extern void test_create_timer_millis(void);
+extern void test_create_timer_with_jitter(void);
+extern void test_timers_coalescing_window(void);
 extern void test_cancel_timer(void);
 extern void test_cancel_timer_invalid(void);
 extern void test_reset_timer(void);
 extern void test_reset_timer_invalid(void);
+extern void test_timers_contexts(void);
 
 /* Functions defined in pcep_timers_event_loop_test.c */
 void pcep_timers_event_loop_test_setup(void);
@@ -44,9 +48,23 @@ void pcep_timers_event_loop_test_teardown(void);
 void test_walk_and_process_timers_no_timers(void);
 void test_walk_and_process_timers_timer_not_expired(void);
 void test_walk_and_process_timers_timer_expired(void);
+void test_walk_and_process_timers_batch(void);
+void test_walk_and_process_timers_lateness_histogram(void);
+void test_get_coalesced_wakeup_time(void);
 void test_event_loop_null_handle(void);
 void test_event_loop_not_active(void);
 
+/* Functions defined in pcep_timers_wheel_test.c */
+void pcep_timers_wheel_test_setup(void);
+void pcep_timers_wheel_test_teardown(void);
+void test_timer_wheel_add_find_remove(void);
+void test_timer_wheel_advance_no_timers(void);
+void test_timer_wheel_advance_cascade(void);
+void test_timer_wheel_next_expire_time(void);
+void test_timer_wheel_advance_order(void);
+void test_timer_wheel_reschedule(void);
+void test_timer_wheel_far_future(void);
+
 
 int main(int argc, char **argv)
 {
@@ -71,6 +89,15 @@ int main(int argc, char **argv)
     CU_add_test(test_timers_suite,
                 "test_create_timer",
                 test_create_timer);
+    CU_add_test(test_timers_suite,
+                "test_create_timer_millis",
+                test_create_timer_millis);
+    CU_add_test(test_timers_suite,
+                "test_create_timer_with_jitter",
+                test_create_timer_with_jitter);
+    CU_add_test(test_timers_suite,
+                "test_timers_coalescing_window",
+                test_timers_coalescing_window);
     CU_add_test(test_timers_suite,
                 "test_cancel_timer",
                 test_cancel_timer);
@@ -83,6 +110,9 @@ int main(int argc, char **argv)
     CU_add_test(test_timers_suite,
                 "test_reset_timer_invalid",
                 test_reset_timer_invalid);
+    CU_add_test(test_timers_suite,
+                "test_timers_contexts",
+                test_timers_contexts);
 
     /*
      * Tests defined in pcep_timers_event_loop_test.c
@@ -101,6 +131,15 @@ int main(int argc, char **argv)
     CU_add_test(test_timers_event_loop_suite,
                 "test_walk_and_process_timers_timer_expired",
                 test_walk_and_process_timers_timer_expired);
+    CU_add_test(test_timers_event_loop_suite,
+                "test_walk_and_process_timers_batch",
+                test_walk_and_process_timers_batch);
+    CU_add_test(test_timers_event_loop_suite,
+                "test_walk_and_process_timers_lateness_histogram",
+                test_walk_and_process_timers_lateness_histogram);
+    CU_add_test(test_timers_event_loop_suite,
+                "test_get_coalesced_wakeup_time",
+                test_get_coalesced_wakeup_time);
     CU_add_test(test_timers_event_loop_suite,
                 "test_event_loop_null_handle",
                 test_event_loop_null_handle);
@@ -108,6 +147,36 @@ int main(int argc, char **argv)
                 "test_event_loop_not_active",
                 test_event_loop_not_active);
 
+    /*
+     * Tests defined in pcep_timers_wheel_test.c
+     */
+    CU_pSuite test_timers_wheel_suite = CU_add_suite_with_setup_and_teardown(
+            "PCEP Timers Wheel Test Suite",
+            NULL, NULL, // suite setup and cleanup function pointers
+            pcep_timers_wheel_test_setup,     // test case setup function pointer
+            pcep_timers_wheel_test_teardown); // test case teardown function pointer
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_add_find_remove",
+                test_timer_wheel_add_find_remove);
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_advance_no_timers",
+                test_timer_wheel_advance_no_timers);
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_advance_cascade",
+                test_timer_wheel_advance_cascade);
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_next_expire_time",
+                test_timer_wheel_next_expire_time);
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_advance_order",
+                test_timer_wheel_advance_order);
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_reschedule",
+                test_timer_wheel_reschedule);
+    CU_add_test(test_timers_wheel_suite,
+                "test_timer_wheel_far_future",
+                test_timer_wheel_far_future);
+
     /*
      * Run the tests and cleanup.
      */
@@ -0,0 +1,268 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <stdlib.h>
+#include <strings.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep_timer_internals.h"
+
+#define TEST_WHEEL_START_TIME 1000
+
+static pcep_timer_wheel test_timer_wheel;
+
+
+/* Test case setup called before each test.
+ * Declared in pcep_timers_tests.c */
+void pcep_timers_wheel_test_setup()
+{
+    timer_wheel_initialize(&test_timer_wheel, TEST_WHEEL_START_TIME);
+}
+
+
+/* Test case teardown called after each test.
+ * Declared in pcep_timers_tests.c */
+void pcep_timers_wheel_test_teardown()
+{
+    timer_wheel_destroy(&test_timer_wheel);
+}
+
+
+static pcep_timer *create_test_timer(int timer_id, time_t expire_time)
+{
+    pcep_timer *timer = malloc(sizeof(pcep_timer));
+    bzero(timer, sizeof(pcep_timer));
+    timer->timer_id = timer_id;
+    timer->expire_time = expire_time;
+    timer_wheel_add(&test_timer_wheel, timer);
+
+    return timer;
+}
+
+
+/*
+ * Test functions
+ */
+
+void test_timer_wheel_add_find_remove()
+{
+    /* Add enough timers for the index to grow */
+    pcep_timer *timers[200];
+    int i;
+    for (i = 0; i < 200; i++)
+    {
+        timers[i] = create_test_timer(i, TEST_WHEEL_START_TIME + 1 + (i * 37));
+    }
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 200);
+    CU_ASSERT_TRUE(test_timer_wheel.index_size > TIMER_WHEEL_INITIAL_INDEX_SIZE);
+
+    for (i = 0; i < 200; i++)
+    {
+        CU_ASSERT_PTR_EQUAL(timer_wheel_find(&test_timer_wheel, i), timers[i]);
+    }
+    CU_ASSERT_PTR_NULL(timer_wheel_find(&test_timer_wheel, 200));
+
+    /* Remove every other timer, the rest should still be found */
+    for (i = 0; i < 200; i += 2)
+    {
+        timer_wheel_remove(&test_timer_wheel, timers[i]);
+        free(timers[i]);
+    }
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 100);
+
+    for (i = 0; i < 200; i++)
+    {
+        if (i % 2 == 0)
+        {
+            CU_ASSERT_PTR_NULL(timer_wheel_find(&test_timer_wheel, i));
+        }
+        else
+        {
+            CU_ASSERT_PTR_EQUAL(timer_wheel_find(&test_timer_wheel, i), timers[i]);
+        }
+    }
+}
+
+
+void test_timer_wheel_advance_no_timers()
+{
+    CU_ASSERT_PTR_NULL(timer_wheel_advance(&test_timer_wheel, TEST_WHEEL_START_TIME + 100000));
+    CU_ASSERT_EQUAL(test_timer_wheel.current_time, TEST_WHEEL_START_TIME + 100000);
+
+    /* Advancing to an earlier time does nothing */
+    CU_ASSERT_PTR_NULL(timer_wheel_advance(&test_timer_wheel, TEST_WHEEL_START_TIME));
+    CU_ASSERT_EQUAL(test_timer_wheel.current_time, TEST_WHEEL_START_TIME + 100000);
+}
+
+
+void test_timer_wheel_advance_cascade()
+{
+    /* Timers stored in each of the first 4 levels, they should
+     * each expire exactly at their expire_time */
+    time_t offsets[] = { 5, 63, 64, 70, 4095, 4100, 5000, 262143, 262200, 300000 };
+    int num_timers = sizeof(offsets) / sizeof(time_t);
+    int i;
+    for (i = 0; i < num_timers; i++)
+    {
+        create_test_timer(i, TEST_WHEEL_START_TIME + offsets[i]);
+    }
+    /* A timer already expired when added will expire on the next advance */
+    create_test_timer(num_timers, TEST_WHEEL_START_TIME - 10);
+
+    int num_expired = 0;
+    time_t now;
+    for (now = TEST_WHEEL_START_TIME + 1; now <= TEST_WHEEL_START_TIME + 300000; now++)
+    {
+        pcep_timer *timer = timer_wheel_advance(&test_timer_wheel, now);
+        while (timer != NULL)
+        {
+            pcep_timer *next_timer = timer->next_timer;
+            if (timer->timer_id == num_timers)
+            {
+                CU_ASSERT_EQUAL(now, TEST_WHEEL_START_TIME + 1);
+            }
+            else
+            {
+                CU_ASSERT_EQUAL(timer->expire_time, now);
+            }
+            num_expired++;
+            free(timer);
+            timer = next_timer;
+        }
+    }
+
+    CU_ASSERT_EQUAL(num_expired, num_timers + 1);
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 0);
+}
+
+
+void test_timer_wheel_next_expire_time()
+{
+    CU_ASSERT_EQUAL(timer_wheel_get_next_expire_time(&test_timer_wheel), TIMER_WAKEUP_NEVER);
+
+    /* Timers on the level slot boundaries, added out of order */
+    time_t expire_times[] = { 262145, 4096, 300000, 1005, 8192, 4097, 262144 };
+    time_t sorted_expire_times[] = { 1005, 4096, 4097, 8192, 262144, 262145, 300000 };
+    int num_timers = sizeof(expire_times) / sizeof(time_t);
+    int i;
+    for (i = 0; i < num_timers; i++)
+    {
+        create_test_timer(i, expire_times[i]);
+    }
+
+    /* Advancing straight to each expire_time skips the ticks in between,
+     * but should still move the timers down on the way */
+    for (i = 0; i < num_timers; i++)
+    {
+        time_t next_expire_time = timer_wheel_get_next_expire_time(&test_timer_wheel);
+        CU_ASSERT_EQUAL(next_expire_time, sorted_expire_times[i]);
+        CU_ASSERT_PTR_NULL(timer_wheel_advance(&test_timer_wheel, next_expire_time - 1));
+
+        pcep_timer *timer = timer_wheel_advance(&test_timer_wheel, next_expire_time);
+        CU_ASSERT_PTR_NOT_NULL(timer);
+        if (timer != NULL)
+        {
+            CU_ASSERT_EQUAL(timer->expire_time, sorted_expire_times[i]);
+            CU_ASSERT_PTR_NULL(timer->next_timer);
+            free(timer);
+        }
+    }
+
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 0);
+    CU_ASSERT_EQUAL(timer_wheel_get_next_expire_time(&test_timer_wheel), TIMER_WAKEUP_NEVER);
+}
+
+
+void test_timer_wheel_advance_order()
+{
+    /* Advancing several ticks at once returns the timers in expire_time order */
+    create_test_timer(1, TEST_WHEEL_START_TIME + 90);
+    create_test_timer(2, TEST_WHEEL_START_TIME + 10);
+    create_test_timer(3, TEST_WHEEL_START_TIME + 50);
+    create_test_timer(4, TEST_WHEEL_START_TIME + 500);
+
+    pcep_timer *timer = timer_wheel_advance(&test_timer_wheel, TEST_WHEEL_START_TIME + 100);
+    int expected_ids[] = { 2, 3, 1 };
+    int i = 0;
+    while (timer != NULL)
+    {
+        pcep_timer *next_timer = timer->next_timer;
+        CU_ASSERT_TRUE(i < 3);
+        if (i < 3)
+        {
+            CU_ASSERT_EQUAL(timer->timer_id, expected_ids[i]);
+        }
+        i++;
+        free(timer);
+        timer = next_timer;
+    }
+    CU_ASSERT_EQUAL(i, 3);
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 1);
+    CU_ASSERT_PTR_NOT_NULL(timer_wheel_find(&test_timer_wheel, 4));
+}
+
+
+void test_timer_wheel_reschedule()
+{
+    pcep_timer *timer = create_test_timer(1, TEST_WHEEL_START_TIME + 10);
+    create_test_timer(2, TEST_WHEEL_START_TIME + 10);
+
+    timer->expire_time = TEST_WHEEL_START_TIME + 5000;
+    timer_wheel_reschedule(&test_timer_wheel, timer);
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 2);
+
+    /* Only the timer that was not rescheduled expires */
+    pcep_timer *expired = timer_wheel_advance(&test_timer_wheel, TEST_WHEEL_START_TIME + 4999);
+    CU_ASSERT_PTR_NOT_NULL(expired);
+    if (expired != NULL)
+    {
+        CU_ASSERT_EQUAL(expired->timer_id, 2);
+        CU_ASSERT_PTR_NULL(expired->next_timer);
+        free(expired);
+    }
+
+    expired = timer_wheel_advance(&test_timer_wheel, TEST_WHEEL_START_TIME + 5000);
+    CU_ASSERT_PTR_EQUAL(expired, timer);
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 0);
+    free(expired);
+}
+
+
+void test_timer_wheel_far_future()
+{
+    /* A timer after the whole wheel span is still stored and removable */
+    pcep_timer *timer = create_test_timer(1, TEST_WHEEL_START_TIME +
+            (((time_t) 1) << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_NUM_LEVELS)) * 2);
+    CU_ASSERT_PTR_NOT_NULL(timer->slot);
+    CU_ASSERT_PTR_NULL(timer_wheel_advance(&test_timer_wheel, TEST_WHEEL_START_TIME + 100));
+    CU_ASSERT_PTR_EQUAL(timer_wheel_find(&test_timer_wheel, 1), timer);
+
+    timer_wheel_remove(&test_timer_wheel, timer);
+    CU_ASSERT_PTR_NULL(timer->slot);
+    CU_ASSERT_EQUAL(test_timer_wheel.num_timers, 0);
+    free(timer);
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+/*
+ * Growable arena to allocate many small objects that are all released at
+ * once, for example a decoded PCEP message and all its objects and TLVs.
+ *
+ * The memory is allocated from chunks, and a new chunk is only allocated
+ * when the current one is full. The arena handle is stored in its first
+ * chunk, so an arena whose allocations fit in the first chunk costs one
+ * malloc(). The arenas created with arena_initialize_cached() take their
+ * first chunk from a pool shared by all the threads, so they are recycled
+ * instead of being allocated and freed for each use.
+ *
+ * The memory allocated from an arena cannot be released with free().
+ */
+
+#ifndef INCLUDE_PCEPUTILSARENA_H_
+#define INCLUDE_PCEPUTILSARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pcep_utils_object_pool.h"
+
+#define ARENA_DEFAULT_CHUNK_SIZE 4096
+/* The arena allocations are aligned to this many bytes */
+#define ARENA_ALIGNMENT 16
+/* The arena cache keeps at most this many free first chunks per shard */
+#define ARENA_CACHE_MAX_FREE_CHUNKS 256
+
+typedef struct arena_chunk_
+{
+    struct arena_chunk_ *next_chunk;
+    uint32_t chunk_size;
+    uint32_t bytes_used;
+    /* The chunk memory follows, aligned to ARENA_ALIGNMENT */
+
+} arena_chunk;
+
+typedef struct arena_handle_
+{
+    /* The chunk being allocated from is always the first one */
+    arena_chunk *chunks;
+    uint32_t chunk_size;
+    uint32_t num_chunks;
+    /* The first chunk was taken from the arena cache */
+    bool cached;
+
+} arena_handle;
+
+/* The chunk_size is the size of each chunk, bigger allocations
+ * are allocated in a chunk of their own */
+arena_handle *arena_initialize(uint32_t chunk_size);
+/* Same as arena_initialize() with ARENA_DEFAULT_CHUNK_SIZE, with the first
+ * chunk taken from the arena cache and returned to it by arena_destroy() */
+arena_handle *arena_initialize_cached();
+/* Releases all the memory allocated from the arena, including the handle */
+void arena_destroy(arena_handle *handle);
+/* The memory is not initialized */
+void *arena_alloc(arena_handle *handle, size_t size);
+/* The hit and miss counters of the first chunks cache */
+bool arena_get_cache_counters(object_pool_counters *counters);
+
+#endif /* INCLUDE_PCEPUTILSARENA_H_ */
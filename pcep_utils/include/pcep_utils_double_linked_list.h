@@ -26,6 +26,8 @@
 #ifndef PCEP_UTILS_INCLUDE_PCEP_UTILS_DOUBLE_LINKED_LIST_H_
 #define PCEP_UTILS_INCLUDE_PCEP_UTILS_DOUBLE_LINKED_LIST_H_
 
+#include "pcep_utils_arena.h"
+
 typedef struct double_linked_list_node_
 {
     struct double_linked_list_node_ *prev_node;
@@ -40,12 +42,18 @@ typedef struct double_linked_list_
     double_linked_list_node *head;
     double_linked_list_node *tail;
     unsigned int num_entries;
+    /* If set, the handle and nodes are allocated from this arena,
+     * and are released when the arena is destroyed */
+    arena_handle *arena;
 
 } double_linked_list;
 
 
 /* Initialize a double linked list */
 double_linked_list *dll_initialize();
+/* Initialize a double linked list allocated from the arena. Destroying
+ * the list does not free anything, not even the user data. */
+double_linked_list *dll_initialize_in_arena(arena_handle *arena);
 
 /* Destroy a double linked list, by freeing the handle and nodes,
  * user data will not be freed, and may be leaked if not handled
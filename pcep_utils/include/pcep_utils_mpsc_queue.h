@@ -0,0 +1,70 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+/*
+ * Lock-free intrusive Multi-Producer Single-Consumer queue.
+ *
+ * Any number of threads may enqueue at the same time without locking, the
+ * nodes are embedded in the enqueued data, so enqueuing never allocates.
+ * Only one thread at a time may dequeue, and mpsc_queue_is_empty() may
+ * only be called by the dequeuing thread.
+ */
+
+#ifndef INCLUDE_PCEPUTILSMPSCQUEUE_H_
+#define INCLUDE_PCEPUTILSMPSCQUEUE_H_
+
+#include <stdbool.h>
+
+typedef struct mpsc_queue_node_
+{
+    struct mpsc_queue_node_ *next_node;
+
+} mpsc_queue_node;
+
+typedef struct mpsc_queue_handle_
+{
+    /* The last enqueued node, swapped by the producers */
+    mpsc_queue_node *head;
+    /* The next node to dequeue, only used by the consumer */
+    mpsc_queue_node *tail;
+    /* Kept in the queue when all the nodes have been dequeued */
+    mpsc_queue_node stub;
+
+} mpsc_queue_handle;
+
+void mpsc_queue_initialize(mpsc_queue_handle *handle);
+void mpsc_queue_enqueue(mpsc_queue_handle *handle, mpsc_queue_node *node);
+/* Returns NULL if the queue is empty, or if a producer has not yet finished
+ * linking the next node, which will be dequeued on a later call */
+mpsc_queue_node *mpsc_queue_dequeue(mpsc_queue_handle *handle);
+bool mpsc_queue_is_empty(mpsc_queue_handle *handle);
+/* Returns the node enqueued last, which the producers that already enqueued
+ * are linked before, so the consumer may dequeue until it gets this node to
+ * dequeue all of them. Returns NULL if the stub was enqueued last, in which
+ * case the nodes before it are already linked. May only be called by the
+ * dequeuing thread. */
+mpsc_queue_node *mpsc_queue_get_last_node(mpsc_queue_handle *handle);
+
+#endif /* INCLUDE_PCEPUTILSMPSCQUEUE_H_ */
@@ -0,0 +1,94 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+/*
+ * Thread aware pool of fixed size objects.
+ *
+ * The freed objects are kept on free lists to be reused by the next
+ * allocations instead of calling malloc() and free(). Each thread uses
+ * its own shard of the pool, so threads allocating and freeing at the
+ * same time dont contend on a lock. When the shard of a thread is empty,
+ * a batch of objects is taken from another shard, since objects are often
+ * allocated on one thread and freed on another.
+ *
+ * The objects are allocated individually with malloc(), so an object
+ * allocated from a pool may also be released with free().
+ */
+
+#ifndef INCLUDE_PCEPUTILSOBJECTPOOL_H_
+#define INCLUDE_PCEPUTILSOBJECTPOOL_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OBJECT_POOL_NUM_SHARDS 16
+/* Number of objects moved at once from another shard to an empty one */
+#define OBJECT_POOL_REFILL_BATCH 32
+
+typedef struct object_pool_counters_
+{
+    /* Allocations served from the pool */
+    uint64_t num_alloc_hits;
+    /* Allocations that called malloc() */
+    uint64_t num_alloc_misses;
+    /* Freed objects kept in the pool */
+    uint64_t num_free_pooled;
+    /* Freed objects released with free(), since the shard was full */
+    uint64_t num_free_released;
+    /* Objects currently in the pool */
+    uint64_t num_free_objects;
+
+} object_pool_counters;
+
+typedef struct object_pool_shard_
+{
+    pthread_mutex_t shard_mutex;
+    /* The free objects are linked through their first pointer */
+    void *free_list;
+    unsigned int num_free_objects;
+    object_pool_counters counters;
+
+} object_pool_shard;
+
+typedef struct object_pool_handle_
+{
+    unsigned int object_size;
+    /* The max number of free objects kept by each shard */
+    unsigned int max_free_objects;
+    object_pool_shard shards[OBJECT_POOL_NUM_SHARDS];
+
+} object_pool_handle;
+
+object_pool_handle *object_pool_initialize(unsigned int object_size, unsigned int max_free_objects);
+/* Releases the free objects, the allocated objects are not released */
+void object_pool_destroy(object_pool_handle *handle);
+/* The object contents are not initialized */
+void *object_pool_alloc(object_pool_handle *handle);
+void object_pool_free(object_pool_handle *handle, void *object);
+/* Sums the counters of all the shards */
+bool object_pool_get_counters(object_pool_handle *handle, object_pool_counters *counters);
+
+#endif /* INCLUDE_PCEPUTILSOBJECTPOOL_H_ */
@@ -26,6 +26,13 @@
 #ifndef INCLUDE_PCEPUTILSQUEUE_H_
 #define INCLUDE_PCEPUTILSQUEUE_H_
 
+#include <stdbool.h>
+
+#include "pcep_utils_object_pool.h"
+
+/* The max number of free queue_nodes kept by each shard of the node pool */
+#define QUEUE_NODE_POOL_MAX_FREE_NODES 1024
+
 typedef struct queue_node_
 {
     struct queue_node_ *next_node;
@@ -48,6 +55,10 @@ queue_handle *queue_initialize_with_size(unsigned int max_entries);
 void queue_destroy(queue_handle *handle);
 void queue_destroy_with_data(queue_handle *handle);
 queue_node *queue_enqueue(queue_handle *handle, void *data);
+/* Insert the data after prev_node, or at the head of the queue if prev_node is NULL */
+queue_node *queue_enqueue_after(queue_handle *handle, queue_node *prev_node, void *data);
 void *queue_dequeue(queue_handle *handle);
+/* The queue_nodes are allocated from a pool shared by all the queues */
+bool queue_get_node_pool_counters(object_pool_counters *counters);
 
 #endif /* INCLUDE_PCEPUTILSQUEUE_H_ */
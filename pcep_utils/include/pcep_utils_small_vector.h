@@ -0,0 +1,83 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+/*
+ * Array backed vector of pointers, with room for the first
+ * SMALL_VECTOR_INLINE_CAPACITY entries in the vector itself.
+ *
+ * Unlike the double_linked_list, appending to a vector that has not outgrown
+ * its inline entries does not allocate anything, and iterating it is a linear
+ * scan of contiguous memory. When the inline entries are full, the entries are
+ * moved to an array allocated with twice the capacity.
+ */
+
+#ifndef INCLUDE_PCEPUTILSSMALLVECTOR_H_
+#define INCLUDE_PCEPUTILSSMALLVECTOR_H_
+
+#include <stdbool.h>
+
+#include "pcep_utils_arena.h"
+
+#define SMALL_VECTOR_INLINE_CAPACITY 8
+
+typedef struct small_vector_
+{
+    /* Points to the inline_entries, until the vector outgrows them */
+    void **entries;
+    unsigned int num_entries;
+    unsigned int capacity;
+    /* If set, the vector and its entries array are allocated from this
+     * arena, and are released when the arena is destroyed */
+    arena_handle *arena;
+    void *inline_entries[SMALL_VECTOR_INLINE_CAPACITY];
+
+} small_vector;
+
+/* Initialize a small vector */
+small_vector *small_vector_initialize();
+/* Initialize a small vector allocated from the arena. Destroying
+ * the vector does not free anything, not even the user data. */
+small_vector *small_vector_initialize_in_arena(arena_handle *arena);
+
+/* Destroy a small vector, user data will not be freed, and
+ * may be leaked if not handled externally. */
+void small_vector_destroy(small_vector *vector);
+/* Destroy a small vector and free the user data. */
+void small_vector_destroy_with_data(small_vector *vector);
+
+/* Adds the data as the last entry in the vector */
+bool small_vector_append(small_vector *vector, void *data);
+
+/* Return the data at the index, or NULL if the index is out of range */
+void *small_vector_get(small_vector *vector, unsigned int index);
+
+/* Delete the entry at the index, moving the following entries
+ * down by one, and return the data */
+void *small_vector_delete_index(small_vector *vector, unsigned int index);
+
+/* Delete the first entry with the data, and return the data, or NULL if not found */
+void *small_vector_delete_data(small_vector *vector, void *data);
+
+#endif /* INCLUDE_PCEPUTILSSMALLVECTOR_H_ */
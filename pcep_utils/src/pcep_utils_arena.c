@@ -0,0 +1,178 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <strings.h>
+
+#include "pcep_utils_arena.h"
+#include "pcep_utils_logging.h"
+
+#define ARENA_ALIGN(size) (((size) + (ARENA_ALIGNMENT - 1)) & ~((size_t) ARENA_ALIGNMENT - 1))
+#define ARENA_CHUNK_HEADER_SIZE ARENA_ALIGN(sizeof(arena_chunk))
+
+/* The first chunks of the cached arenas, since the arenas are often
+ * released on another thread than the one that created them */
+static object_pool_handle *arena_cache_ = NULL;
+static pthread_once_t arena_cache_once_ = PTHREAD_ONCE_INIT;
+
+/* Internal util function, called once to create the arena_cache_ */
+static void initialize_arena_cache()
+{
+    arena_cache_ = object_pool_initialize(
+            ARENA_CHUNK_HEADER_SIZE + ARENA_DEFAULT_CHUNK_SIZE, ARENA_CACHE_MAX_FREE_CHUNKS);
+}
+
+
+/* Internal util function, the usable memory of a chunk */
+static inline uint8_t *get_chunk_memory(arena_chunk *chunk)
+{
+    return ((uint8_t *) chunk) + ARENA_CHUNK_HEADER_SIZE;
+}
+
+
+/* Internal util function, stores the arena handle in the first chunk */
+static arena_handle *initialize_arena_in_chunk(arena_chunk *chunk, uint32_t chunk_size, bool cached)
+{
+    chunk->next_chunk = NULL;
+    chunk->chunk_size = chunk_size;
+    chunk->bytes_used = ARENA_ALIGN(sizeof(arena_handle));
+
+    arena_handle *handle = (arena_handle *) get_chunk_memory(chunk);
+    bzero(handle, sizeof(arena_handle));
+    handle->chunks = chunk;
+    handle->chunk_size = chunk_size;
+    handle->num_chunks = 1;
+    handle->cached = cached;
+
+    return handle;
+}
+
+
+arena_handle *arena_initialize(uint32_t chunk_size)
+{
+    if (chunk_size < ARENA_ALIGN(sizeof(arena_handle)))
+    {
+        pcep_log(LOG_WARNING, "arena_initialize, the chunk_size [%d] is too small", chunk_size);
+        return NULL;
+    }
+
+    chunk_size = ARENA_ALIGN(chunk_size);
+    arena_chunk *chunk = malloc(ARENA_CHUNK_HEADER_SIZE + chunk_size);
+    if (chunk == NULL)
+    {
+        pcep_log(LOG_WARNING, "arena_initialize, cannot allocate memory for the chunk");
+        return NULL;
+    }
+
+    return initialize_arena_in_chunk(chunk, chunk_size, false);
+}
+
+
+arena_handle *arena_initialize_cached()
+{
+    pthread_once(&arena_cache_once_, initialize_arena_cache);
+    arena_chunk *chunk = object_pool_alloc(arena_cache_);
+    if (chunk == NULL)
+    {
+        pcep_log(LOG_WARNING, "arena_initialize_cached, cannot allocate memory for the chunk");
+        return NULL;
+    }
+
+    return initialize_arena_in_chunk(chunk, ARENA_DEFAULT_CHUNK_SIZE, true);
+}
+
+
+void arena_destroy(arena_handle *handle)
+{
+    if (handle == NULL)
+    {
+        return;
+    }
+
+    /* The handle is stored in the first chunk, which is the last one in the list */
+    bool cached = handle->cached;
+    arena_chunk *chunk = handle->chunks;
+    while (chunk->next_chunk != NULL)
+    {
+        arena_chunk *next_chunk = chunk->next_chunk;
+        free(chunk);
+        chunk = next_chunk;
+    }
+
+    if (cached)
+    {
+        object_pool_free(arena_cache_, chunk);
+    }
+    else
+    {
+        free(chunk);
+    }
+}
+
+
+void *arena_alloc(arena_handle *handle, size_t size)
+{
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "arena_alloc, cannot allocate from a NULL arena");
+        return NULL;
+    }
+
+    size = ARENA_ALIGN(size == 0 ? 1 : size);
+    arena_chunk *chunk = handle->chunks;
+    if (size > (chunk->chunk_size - chunk->bytes_used))
+    {
+        /* The current chunk is not used anymore, even if there is some room
+         * left in it, so the allocations are always from the first chunk */
+        uint32_t chunk_size = (size > handle->chunk_size) ? size : handle->chunk_size;
+        chunk = malloc(ARENA_CHUNK_HEADER_SIZE + chunk_size);
+        if (chunk == NULL)
+        {
+            pcep_log(LOG_WARNING, "arena_alloc, cannot allocate memory for a chunk of [%d] bytes", chunk_size);
+            return NULL;
+        }
+
+        chunk->chunk_size = chunk_size;
+        chunk->bytes_used = 0;
+        chunk->next_chunk = handle->chunks;
+        handle->chunks = chunk;
+        handle->num_chunks++;
+    }
+
+    void *memory = get_chunk_memory(chunk) + chunk->bytes_used;
+    chunk->bytes_used += size;
+
+    return memory;
+}
+
+
+bool arena_get_cache_counters(object_pool_counters *counters)
+{
+    pthread_once(&arena_cache_once_, initialize_arena_cache);
+    return object_pool_get_counters(arena_cache_, counters);
+}
@@ -49,6 +49,45 @@ double_linked_list *dll_initialize()
 }
 
 
+double_linked_list *dll_initialize_in_arena(arena_handle *arena)
+{
+    double_linked_list *handle = arena_alloc(arena, sizeof(double_linked_list));
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "dll_initialize_in_arena cannot allocate memory for handle");
+        return NULL;
+    }
+
+    bzero(handle, sizeof(double_linked_list));
+    handle->arena = arena;
+
+    return handle;
+}
+
+
+/* Internal util function, allocates the nodes from the list arena, if any */
+static double_linked_list_node *create_node(double_linked_list *handle, void *data)
+{
+    double_linked_list_node *new_node = (handle->arena == NULL) ?
+            malloc(sizeof(double_linked_list_node)) :
+            arena_alloc(handle->arena, sizeof(double_linked_list_node));
+    bzero(new_node, sizeof(double_linked_list_node));
+    new_node->data = data;
+
+    return new_node;
+}
+
+
+/* Internal util function, the arena nodes are released with the arena */
+static void free_node(double_linked_list *handle, double_linked_list_node *node)
+{
+    if (handle->arena == NULL)
+    {
+        free(node);
+    }
+}
+
+
 void dll_destroy(double_linked_list *handle)
 {
     if (handle == NULL)
@@ -57,6 +96,11 @@ void dll_destroy(double_linked_list *handle)
         return;
     }
 
+    if (handle->arena != NULL)
+    {
+        return;
+    }
+
     double_linked_list_node *node = handle->head;
     while(node != NULL)
     {
@@ -77,6 +121,11 @@ void dll_destroy_with_data(double_linked_list *handle)
         return;
     }
 
+    if (handle->arena != NULL)
+    {
+        return;
+    }
+
     double_linked_list_node *node = handle->head;
     while(node != NULL)
     {
@@ -100,9 +149,7 @@ double_linked_list_node *dll_prepend(double_linked_list *handle, void *data)
     }
 
     /* Create the new node */
-    double_linked_list_node *new_node = malloc(sizeof(double_linked_list_node));
-    bzero(new_node, sizeof(double_linked_list_node));
-    new_node->data = data;
+    double_linked_list_node *new_node = create_node(handle, data);
 
     if (handle->head == NULL)
     {
@@ -132,9 +179,7 @@ double_linked_list_node *dll_append(double_linked_list *handle, void *data)
     }
 
     /* Create the new node */
-    double_linked_list_node *new_node = malloc(sizeof(double_linked_list_node));
-    bzero(new_node, sizeof(double_linked_list_node));
-    new_node->data = data;
+    double_linked_list_node *new_node = create_node(handle, data);
 
     if (handle->head == NULL)
     {
@@ -183,7 +228,7 @@ void *dll_delete_first_node(double_linked_list *handle)
         handle->head->prev_node = NULL;
     }
 
-    free(delete_node);
+    free_node(handle, delete_node);
     (handle->num_entries)--;
 
     return data;
@@ -219,7 +264,7 @@ void *dll_delete_last_node(double_linked_list *handle)
         handle->tail->next_node = NULL;
     }
 
-    free(delete_node);
+    free_node(handle, delete_node);
     (handle->num_entries)--;
 
     return data;
@@ -270,7 +315,7 @@ void *dll_delete_node(double_linked_list *handle, double_linked_list_node *node)
         node->prev_node->next_node = node->next_node;
     }
 
-    free(node);
+    free_node(handle, node);
     (handle->num_entries)--;
 
     return data;
@@ -0,0 +1,137 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <strings.h>
+
+#include "pcep_utils_logging.h"
+#include "pcep_utils_mpsc_queue.h"
+
+void mpsc_queue_initialize(mpsc_queue_handle *handle)
+{
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "mpsc_queue_initialize, cannot initialize a NULL queue");
+        return;
+    }
+
+    bzero(handle, sizeof(mpsc_queue_handle));
+    handle->head = &handle->stub;
+    handle->tail = &handle->stub;
+}
+
+
+void mpsc_queue_enqueue(mpsc_queue_handle *handle, mpsc_queue_node *node)
+{
+    if (handle == NULL || node == NULL)
+    {
+        pcep_log(LOG_WARNING, "mpsc_queue_enqueue, the queue and node cannot be NULL");
+        return;
+    }
+
+    /* Swapping the head orders the producers, the previous head is then
+     * linked to the node, until then the consumer sees the queue end at
+     * the previous head */
+    __atomic_store_n(&node->next_node, NULL, __ATOMIC_RELAXED);
+    mpsc_queue_node *prev_node = __atomic_exchange_n(&handle->head, node, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&prev_node->next_node, node, __ATOMIC_RELEASE);
+}
+
+
+mpsc_queue_node *mpsc_queue_dequeue(mpsc_queue_handle *handle)
+{
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "mpsc_queue_dequeue, the queue has not been initialized");
+        return NULL;
+    }
+
+    mpsc_queue_node *tail = handle->tail;
+    mpsc_queue_node *next = __atomic_load_n(&tail->next_node, __ATOMIC_ACQUIRE);
+
+    /* Skip over the stub */
+    if (tail == &handle->stub)
+    {
+        if (next == NULL)
+        {
+            return NULL;
+        }
+
+        handle->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next_node, __ATOMIC_ACQUIRE);
+    }
+
+    if (next != NULL)
+    {
+        handle->tail = next;
+        return tail;
+    }
+
+    /* The tail is the last node, unless a producer is still linking it to
+     * the next one. The stub is enqueued so the last node can be dequeued. */
+    if (tail != __atomic_load_n(&handle->head, __ATOMIC_ACQUIRE))
+    {
+        return NULL;
+    }
+
+    mpsc_queue_enqueue(handle, &handle->stub);
+    next = __atomic_load_n(&tail->next_node, __ATOMIC_ACQUIRE);
+    if (next != NULL)
+    {
+        handle->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+
+bool mpsc_queue_is_empty(mpsc_queue_handle *handle)
+{
+    if (handle == NULL)
+    {
+        return true;
+    }
+
+    return (handle->tail == &handle->stub &&
+            __atomic_load_n(&handle->head, __ATOMIC_SEQ_CST) == &handle->stub);
+}
+
+
+mpsc_queue_node *mpsc_queue_get_last_node(mpsc_queue_handle *handle)
+{
+    if (handle == NULL)
+    {
+        return NULL;
+    }
+
+    /* Only the consumer enqueues the stub, after the last node it dequeues
+     * from, so the nodes enqueued before the stub are always linked */
+    mpsc_queue_node *last_node = __atomic_load_n(&handle->head, __ATOMIC_SEQ_CST);
+    return (last_node == &handle->stub) ? NULL : last_node;
+}
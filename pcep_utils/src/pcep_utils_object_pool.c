@@ -0,0 +1,219 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <strings.h>
+
+#include "pcep_utils_logging.h"
+#include "pcep_utils_object_pool.h"
+
+/* The threads are assigned to the shards in round robin order */
+static unsigned int next_thread_shard_ = 0;
+static __thread int thread_shard_ = -1;
+
+/* Internal util function, the shard of the calling thread */
+static object_pool_shard *get_thread_shard(object_pool_handle *handle)
+{
+    if (thread_shard_ < 0)
+    {
+        thread_shard_ = __atomic_fetch_add(&next_thread_shard_, 1, __ATOMIC_RELAXED) % OBJECT_POOL_NUM_SHARDS;
+    }
+
+    return &handle->shards[thread_shard_];
+}
+
+
+object_pool_handle *object_pool_initialize(unsigned int object_size, unsigned int max_free_objects)
+{
+    if (object_size == 0)
+    {
+        pcep_log(LOG_WARNING, "object_pool_initialize, cannot initialize a pool of 0 size objects");
+        return NULL;
+    }
+
+    object_pool_handle *handle = malloc(sizeof(object_pool_handle));
+    bzero(handle, sizeof(object_pool_handle));
+    /* The free objects must be big enough to be linked */
+    handle->object_size = (object_size < sizeof(void *)) ? sizeof(void *) : object_size;
+    handle->max_free_objects = max_free_objects;
+
+    int i;
+    for (i = 0; i < OBJECT_POOL_NUM_SHARDS; i++)
+    {
+        pthread_mutex_init(&(handle->shards[i].shard_mutex), NULL);
+    }
+
+    return handle;
+}
+
+
+void object_pool_destroy(object_pool_handle *handle)
+{
+    if (handle == NULL)
+    {
+        return;
+    }
+
+    int i;
+    for (i = 0; i < OBJECT_POOL_NUM_SHARDS; i++)
+    {
+        object_pool_shard *shard = &handle->shards[i];
+        while (shard->free_list != NULL)
+        {
+            void *object = shard->free_list;
+            shard->free_list = *((void **) object);
+            free(object);
+        }
+        pthread_mutex_destroy(&(shard->shard_mutex));
+    }
+
+    free(handle);
+}
+
+
+/* Internal util function, move a batch of free objects from another
+ * shard to the empty shard, whose mutex is locked. The other shards
+ * are only tried, so no thread waits for another. */
+static bool refill_shard(object_pool_handle *handle, object_pool_shard *empty_shard)
+{
+    int i;
+    for (i = 0; i < OBJECT_POOL_NUM_SHARDS; i++)
+    {
+        object_pool_shard *shard = &handle->shards[i];
+        if (shard == empty_shard || pthread_mutex_trylock(&(shard->shard_mutex)) != 0)
+        {
+            continue;
+        }
+
+        int num_moved = 0;
+        while (shard->free_list != NULL && num_moved < OBJECT_POOL_REFILL_BATCH)
+        {
+            void *object = shard->free_list;
+            shard->free_list = *((void **) object);
+            *((void **) object) = empty_shard->free_list;
+            empty_shard->free_list = object;
+            num_moved++;
+        }
+        shard->num_free_objects -= num_moved;
+        empty_shard->num_free_objects += num_moved;
+        pthread_mutex_unlock(&(shard->shard_mutex));
+
+        if (num_moved > 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void *object_pool_alloc(object_pool_handle *handle)
+{
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "object_pool_alloc, the pool has not been initialized");
+        return NULL;
+    }
+
+    object_pool_shard *shard = get_thread_shard(handle);
+    pthread_mutex_lock(&(shard->shard_mutex));
+    if (shard->free_list == NULL && refill_shard(handle, shard) == false)
+    {
+        shard->counters.num_alloc_misses++;
+        pthread_mutex_unlock(&(shard->shard_mutex));
+
+        return malloc(handle->object_size);
+    }
+
+    void *object = shard->free_list;
+    shard->free_list = *((void **) object);
+    shard->num_free_objects--;
+    shard->counters.num_alloc_hits++;
+    pthread_mutex_unlock(&(shard->shard_mutex));
+
+    return object;
+}
+
+
+void object_pool_free(object_pool_handle *handle, void *object)
+{
+    if (object == NULL)
+    {
+        return;
+    }
+
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "object_pool_free, the pool has not been initialized");
+        free(object);
+        return;
+    }
+
+    object_pool_shard *shard = get_thread_shard(handle);
+    pthread_mutex_lock(&(shard->shard_mutex));
+    if (shard->num_free_objects >= handle->max_free_objects)
+    {
+        shard->counters.num_free_released++;
+        pthread_mutex_unlock(&(shard->shard_mutex));
+        free(object);
+        return;
+    }
+
+    *((void **) object) = shard->free_list;
+    shard->free_list = object;
+    shard->num_free_objects++;
+    shard->counters.num_free_pooled++;
+    pthread_mutex_unlock(&(shard->shard_mutex));
+}
+
+
+bool object_pool_get_counters(object_pool_handle *handle, object_pool_counters *counters)
+{
+    if (handle == NULL || counters == NULL)
+    {
+        pcep_log(LOG_WARNING, "object_pool_get_counters, the pool and counters cannot be NULL");
+        return false;
+    }
+
+    bzero(counters, sizeof(object_pool_counters));
+    int i;
+    for (i = 0; i < OBJECT_POOL_NUM_SHARDS; i++)
+    {
+        object_pool_shard *shard = &handle->shards[i];
+        pthread_mutex_lock(&(shard->shard_mutex));
+        counters->num_alloc_hits += shard->counters.num_alloc_hits;
+        counters->num_alloc_misses += shard->counters.num_alloc_misses;
+        counters->num_free_pooled += shard->counters.num_free_pooled;
+        counters->num_free_released += shard->counters.num_free_released;
+        counters->num_free_objects += shard->num_free_objects;
+        pthread_mutex_unlock(&(shard->shard_mutex));
+    }
+
+    return true;
+}
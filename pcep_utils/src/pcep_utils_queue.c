@@ -24,13 +24,39 @@
 
 
 #include <malloc.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <strings.h>
 
 #include "pcep_utils_logging.h"
+#include "pcep_utils_object_pool.h"
 #include "pcep_utils_queue.h"
 
+/* The queue_nodes of all the queues are allocated from this pool, since
+ * they are enqueued and dequeued for every event and message */
+static object_pool_handle *queue_node_pool_ = NULL;
+static pthread_once_t queue_node_pool_once_ = PTHREAD_ONCE_INIT;
+
+/* Internal util function, called once to create the queue_node_pool_ */
+static void initialize_queue_node_pool()
+{
+    queue_node_pool_ = object_pool_initialize(sizeof(queue_node), QUEUE_NODE_POOL_MAX_FREE_NODES);
+}
+
+/* Internal util function to allocate a queue_node from the pool */
+static queue_node *alloc_queue_node()
+{
+    pthread_once(&queue_node_pool_once_, initialize_queue_node_pool);
+    return object_pool_alloc(queue_node_pool_);
+}
+
+bool queue_get_node_pool_counters(object_pool_counters *counters)
+{
+    pthread_once(&queue_node_pool_once_, initialize_queue_node_pool);
+    return object_pool_get_counters(queue_node_pool_, counters);
+}
+
 queue_handle *queue_initialize()
 {
     /* Set the max_entries to 0 to disable it */
@@ -82,7 +108,7 @@ queue_node *queue_enqueue(queue_handle *handle, void *data)
         return NULL;
     }
 
-    queue_node *new_node = malloc(sizeof(queue_node));
+    queue_node *new_node = alloc_queue_node();
     new_node->data = data;
     new_node->next_node = NULL;
 
@@ -103,6 +129,50 @@ queue_node *queue_enqueue(queue_handle *handle, void *data)
 }
 
 
+queue_node *queue_enqueue_after(queue_handle *handle, queue_node *prev_node, void *data)
+{
+    if (handle == NULL)
+    {
+        pcep_log(LOG_WARNING, "queue_enqueue_after, the queue has not been initialized");
+        return NULL;
+    }
+
+    if (prev_node != NULL && prev_node == handle->tail)
+    {
+        return queue_enqueue(handle, data);
+    }
+
+    if (handle->max_entries > 0 && handle->num_entries >= handle->max_entries)
+    {
+        pcep_log(LOG_WARNING, "queue_enqueue_after, cannot enqueue: max entries hit [%u]",
+                handle->num_entries);
+        return NULL;
+    }
+
+    queue_node *new_node = alloc_queue_node();
+    new_node->data = data;
+
+    (handle->num_entries)++;
+    if (prev_node == NULL)
+    {
+        new_node->next_node = handle->head;
+        handle->head = new_node;
+        if (handle->tail == NULL)
+        {
+            /* its the first entry in the queue */
+            handle->tail = new_node;
+        }
+    }
+    else
+    {
+        new_node->next_node = prev_node->next_node;
+        prev_node->next_node = new_node;
+    }
+
+    return new_node;
+}
+
+
 void *queue_dequeue(queue_handle *handle)
 {
     if (handle == NULL)
@@ -129,7 +199,7 @@ void *queue_dequeue(queue_handle *handle)
         handle->head = node->next_node;
     }
 
-    free(node);
+    object_pool_free(queue_node_pool_, node);
 
     return node_data;
 }
@@ -0,0 +1,209 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <malloc.h>
+#include <string.h>
+#include <strings.h>
+
+#include "pcep_utils_logging.h"
+#include "pcep_utils_small_vector.h"
+
+/* Internal util function to initialize the vector with its inline entries */
+static void initialize_vector(small_vector *vector, arena_handle *arena)
+{
+    bzero(vector, sizeof(small_vector));
+    vector->entries = vector->inline_entries;
+    vector->capacity = SMALL_VECTOR_INLINE_CAPACITY;
+    vector->arena = arena;
+}
+
+
+small_vector *small_vector_initialize()
+{
+    small_vector *vector = malloc(sizeof(small_vector));
+    if (vector == NULL)
+    {
+        pcep_log(LOG_WARNING, "small_vector_initialize cannot allocate memory for vector");
+        return NULL;
+    }
+
+    initialize_vector(vector, NULL);
+
+    return vector;
+}
+
+
+small_vector *small_vector_initialize_in_arena(arena_handle *arena)
+{
+    small_vector *vector = arena_alloc(arena, sizeof(small_vector));
+    if (vector == NULL)
+    {
+        pcep_log(LOG_WARNING, "small_vector_initialize_in_arena cannot allocate memory for vector");
+        return NULL;
+    }
+
+    initialize_vector(vector, arena);
+
+    return vector;
+}
+
+
+void small_vector_destroy(small_vector *vector)
+{
+    if (vector == NULL)
+    {
+        pcep_log(LOG_WARNING, "small_vector_destroy cannot destroy NULL vector");
+        return;
+    }
+
+    if (vector->arena != NULL)
+    {
+        return;
+    }
+
+    if (vector->entries != vector->inline_entries)
+    {
+        free(vector->entries);
+    }
+
+    free(vector);
+}
+
+
+void small_vector_destroy_with_data(small_vector *vector)
+{
+    if (vector == NULL)
+    {
+        pcep_log(LOG_WARNING, "small_vector_destroy_with_data cannot destroy NULL vector");
+        return;
+    }
+
+    if (vector->arena != NULL)
+    {
+        return;
+    }
+
+    unsigned int index;
+    for (index = 0; index < vector->num_entries; index++)
+    {
+        free(vector->entries[index]);
+    }
+
+    small_vector_destroy(vector);
+}
+
+
+/* Internal util function to move the entries to an array twice as big,
+ * allocated from the vector arena, if any */
+static bool grow_vector(small_vector *vector)
+{
+    unsigned int new_capacity = vector->capacity * 2;
+    void **new_entries = (vector->arena == NULL) ?
+            malloc(new_capacity * sizeof(void *)) :
+            arena_alloc(vector->arena, new_capacity * sizeof(void *));
+    if (new_entries == NULL)
+    {
+        pcep_log(LOG_WARNING, "small_vector cannot allocate memory for [%d] entries", new_capacity);
+        return false;
+    }
+
+    memcpy(new_entries, vector->entries, vector->num_entries * sizeof(void *));
+    /* The arena entries are released with the arena */
+    if (vector->entries != vector->inline_entries && vector->arena == NULL)
+    {
+        free(vector->entries);
+    }
+    vector->entries = new_entries;
+    vector->capacity = new_capacity;
+
+    return true;
+}
+
+
+bool small_vector_append(small_vector *vector, void *data)
+{
+    if (vector == NULL)
+    {
+        pcep_log(LOG_WARNING, "small_vector_append NULL vector");
+        return false;
+    }
+
+    if (vector->num_entries == vector->capacity && grow_vector(vector) == false)
+    {
+        return false;
+    }
+
+    vector->entries[vector->num_entries++] = data;
+
+    return true;
+}
+
+
+void *small_vector_get(small_vector *vector, unsigned int index)
+{
+    if (vector == NULL || index >= vector->num_entries)
+    {
+        return NULL;
+    }
+
+    return vector->entries[index];
+}
+
+
+void *small_vector_delete_index(small_vector *vector, unsigned int index)
+{
+    if (vector == NULL || index >= vector->num_entries)
+    {
+        return NULL;
+    }
+
+    void *data = vector->entries[index];
+    vector->num_entries--;
+    memmove(vector->entries + index, vector->entries + index + 1,
+            (vector->num_entries - index) * sizeof(void *));
+
+    return data;
+}
+
+
+void *small_vector_delete_data(small_vector *vector, void *data)
+{
+    if (vector == NULL)
+    {
+        return NULL;
+    }
+
+    unsigned int index;
+    for (index = 0; index < vector->num_entries; index++)
+    {
+        if (vector->entries[index] == data)
+        {
+            return small_vector_delete_index(vector, index);
+        }
+    }
+
+    return NULL;
+}
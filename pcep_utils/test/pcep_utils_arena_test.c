@@ -0,0 +1,132 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep_utils_arena.h"
+#include "pcep_utils_double_linked_list.h"
+
+
+void test_arena_null_handle()
+{
+    /* test each method handles a NULL handle without crashing */
+    CU_ASSERT_PTR_NULL(arena_initialize(0));
+    CU_ASSERT_PTR_NULL(arena_alloc(NULL, 10));
+    arena_destroy(NULL);
+}
+
+
+void test_arena_alloc()
+{
+    arena_handle *arena = arena_initialize(256);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    CU_ASSERT_EQUAL(arena->num_chunks, 1);
+    CU_ASSERT_FALSE(arena->cached);
+
+    /* The allocations are aligned and fit in the first chunk */
+    uint8_t *memory1 = arena_alloc(arena, 1);
+    uint8_t *memory2 = arena_alloc(arena, 20);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(memory1);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(memory2);
+    CU_ASSERT_EQUAL(((uintptr_t) memory1) % ARENA_ALIGNMENT, 0);
+    CU_ASSERT_EQUAL(((uintptr_t) memory2) % ARENA_ALIGNMENT, 0);
+    CU_ASSERT_EQUAL(memory2 - memory1, ARENA_ALIGNMENT);
+    memset(memory2, 0xff, 20);
+    CU_ASSERT_EQUAL(arena->num_chunks, 1);
+
+    /* When the chunk is full, another one is allocated */
+    uint8_t *memory3 = arena_alloc(arena, 200);
+    CU_ASSERT_PTR_NOT_NULL(memory3);
+    memset(memory3, 0xff, 200);
+    CU_ASSERT_EQUAL(arena->num_chunks, 2);
+
+    /* Bigger allocations than the chunk_size get their own chunk */
+    uint8_t *memory4 = arena_alloc(arena, 1000);
+    CU_ASSERT_PTR_NOT_NULL(memory4);
+    memset(memory4, 0xff, 1000);
+    CU_ASSERT_EQUAL(arena->num_chunks, 3);
+
+    arena_destroy(arena);
+}
+
+
+void test_arena_cached()
+{
+    object_pool_counters counters_before;
+    object_pool_counters counters_after;
+    CU_ASSERT_FALSE(arena_get_cache_counters(NULL));
+    CU_ASSERT_TRUE(arena_get_cache_counters(&counters_before));
+
+    arena_handle *arena = arena_initialize_cached();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    CU_ASSERT_TRUE(arena->cached);
+    CU_ASSERT_EQUAL(arena->chunk_size, ARENA_DEFAULT_CHUNK_SIZE);
+    CU_ASSERT_PTR_NOT_NULL(arena_alloc(arena, ARENA_DEFAULT_CHUNK_SIZE));
+    CU_ASSERT_EQUAL(arena->num_chunks, 2);
+    arena_destroy(arena);
+
+    /* The first chunk is returned to the cache, and reused by the next arena */
+    CU_ASSERT_TRUE(arena_get_cache_counters(&counters_after));
+    CU_ASSERT_EQUAL(counters_after.num_free_pooled, counters_before.num_free_pooled + 1);
+
+    arena = arena_initialize_cached();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+    CU_ASSERT_TRUE(arena_get_cache_counters(&counters_after));
+    CU_ASSERT_EQUAL(counters_after.num_alloc_hits, counters_before.num_alloc_hits + 1);
+    arena_destroy(arena);
+}
+
+
+void test_arena_double_linked_list()
+{
+    arena_handle *arena = arena_initialize(ARENA_DEFAULT_CHUNK_SIZE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+
+    double_linked_list *list = dll_initialize_in_arena(arena);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(list);
+    CU_ASSERT_PTR_EQUAL(list->arena, arena);
+
+    int data1 = 1;
+    int data2 = 2;
+    int data3 = 3;
+    dll_append(list, &data2);
+    dll_append(list, &data3);
+    dll_prepend(list, &data1);
+    CU_ASSERT_EQUAL(list->num_entries, 3);
+    CU_ASSERT_PTR_EQUAL(dll_delete_first_node(list), &data1);
+    CU_ASSERT_PTR_EQUAL(dll_delete_last_node(list), &data3);
+    CU_ASSERT_PTR_EQUAL(dll_delete_node(list, list->head), &data2);
+    CU_ASSERT_EQUAL(list->num_entries, 0);
+
+    /* The list and its nodes are all released with the arena */
+    dll_append(list, &data1);
+    CU_ASSERT_EQUAL(arena->num_chunks, 1);
+    dll_destroy(list);
+    arena_destroy(arena);
+}
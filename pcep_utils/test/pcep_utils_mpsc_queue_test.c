@@ -0,0 +1,197 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep_utils_mpsc_queue.h"
+
+#define NUM_PRODUCERS 4
+#define NUM_NODES_PER_PRODUCER 10000
+
+typedef struct mpsc_node_data_
+{
+    mpsc_queue_node queue_node;
+    int producer;
+    int int_data;
+
+} mpsc_node_data;
+
+typedef struct mpsc_producer_data_
+{
+    mpsc_queue_handle *handle;
+    mpsc_node_data *nodes;
+
+} mpsc_producer_data;
+
+
+void test_empty_mpsc_queue()
+{
+    mpsc_queue_handle handle;
+    mpsc_queue_initialize(&handle);
+
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&handle));
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(&handle));
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&handle));
+}
+
+
+void test_null_mpsc_queue_handle()
+{
+    /* test each method handles a NULL handle without crashing */
+    mpsc_node_data data;
+    mpsc_queue_initialize(NULL);
+    mpsc_queue_enqueue(NULL, &data.queue_node);
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(NULL));
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(NULL));
+}
+
+
+void test_mpsc_enqueue_dequeue()
+{
+    mpsc_node_data data1, data2, data3;
+    mpsc_queue_handle handle;
+    mpsc_queue_initialize(&handle);
+
+    mpsc_queue_enqueue(&handle, &data1.queue_node);
+    CU_ASSERT_FALSE(mpsc_queue_is_empty(&handle));
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data1.queue_node);
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&handle));
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(&handle));
+
+    /* The nodes are dequeued in the order they were enqueued, and may
+     * be enqueued again once dequeued */
+    mpsc_queue_enqueue(&handle, &data1.queue_node);
+    mpsc_queue_enqueue(&handle, &data2.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data1.queue_node);
+    mpsc_queue_enqueue(&handle, &data3.queue_node);
+    mpsc_queue_enqueue(&handle, &data1.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data2.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data3.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data1.queue_node);
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(&handle));
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&handle));
+}
+
+
+
+void test_mpsc_get_last_node()
+{
+    mpsc_node_data data1, data2, data3;
+    mpsc_queue_handle handle;
+    mpsc_queue_initialize(&handle);
+
+    CU_ASSERT_PTR_NULL(mpsc_queue_get_last_node(NULL));
+    CU_ASSERT_PTR_NULL(mpsc_queue_get_last_node(&handle));
+    mpsc_queue_enqueue(&handle, &data1.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_get_last_node(&handle), &data1.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data1.queue_node);
+    CU_ASSERT_PTR_NULL(mpsc_queue_get_last_node(&handle));
+
+    /* A producer swapped the head to data2 but has not linked it yet, so
+     * data3 enqueued after it can not be dequeued, but is the last node */
+    data2.queue_node.next_node = NULL;
+    mpsc_queue_node *prev_node = __atomic_exchange_n(&handle.head, &data2.queue_node, __ATOMIC_SEQ_CST);
+    mpsc_queue_enqueue(&handle, &data3.queue_node);
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(&handle));
+    CU_ASSERT_FALSE(mpsc_queue_is_empty(&handle));
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_get_last_node(&handle), &data3.queue_node);
+
+    prev_node->next_node = &data2.queue_node;
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data2.queue_node);
+    CU_ASSERT_PTR_EQUAL(mpsc_queue_dequeue(&handle), &data3.queue_node);
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(&handle));
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&handle));
+    CU_ASSERT_PTR_NULL(mpsc_queue_get_last_node(&handle));
+}
+
+static void *mpsc_producer_thread(void *data)
+{
+    mpsc_producer_data *producer_data = (mpsc_producer_data *) data;
+    int i;
+    for (i = 0; i < NUM_NODES_PER_PRODUCER; i++)
+    {
+        mpsc_queue_enqueue(producer_data->handle, &producer_data->nodes[i].queue_node);
+    }
+
+    return NULL;
+}
+
+
+void test_mpsc_multiple_producers()
+{
+    static mpsc_node_data nodes[NUM_PRODUCERS][NUM_NODES_PER_PRODUCER];
+    mpsc_producer_data producer_data[NUM_PRODUCERS];
+    pthread_t producer_threads[NUM_PRODUCERS];
+    int next_int_data[NUM_PRODUCERS];
+    mpsc_queue_handle handle;
+    mpsc_queue_initialize(&handle);
+
+    int i, j;
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        for (j = 0; j < NUM_NODES_PER_PRODUCER; j++)
+        {
+            nodes[i][j].producer = i;
+            nodes[i][j].int_data = j;
+        }
+        next_int_data[i] = 0;
+        producer_data[i].handle = &handle;
+        producer_data[i].nodes = nodes[i];
+        pthread_create(&producer_threads[i], NULL, mpsc_producer_thread, &producer_data[i]);
+    }
+
+    /* Consume while producing, the nodes of each producer are dequeued
+     * in the order that producer enqueued them */
+    int num_dequeued = 0;
+    bool in_order = true;
+    while (num_dequeued < NUM_PRODUCERS * NUM_NODES_PER_PRODUCER)
+    {
+        mpsc_node_data *data = (mpsc_node_data *) mpsc_queue_dequeue(&handle);
+        if (data == NULL)
+        {
+            continue;
+        }
+
+        if (data->int_data != next_int_data[data->producer])
+        {
+            in_order = false;
+        }
+        next_int_data[data->producer] = data->int_data + 1;
+        num_dequeued++;
+    }
+
+    for (i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_join(producer_threads[i], NULL);
+    }
+
+    CU_ASSERT_TRUE(in_order);
+    CU_ASSERT_PTR_NULL(mpsc_queue_dequeue(&handle));
+    CU_ASSERT_TRUE(mpsc_queue_is_empty(&handle));
+}
@@ -0,0 +1,147 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep_utils_object_pool.h"
+
+#define NUM_POOL_OBJECTS 100
+
+typedef struct pool_object_
+{
+    int int_data;
+    char char_data[20];
+
+} pool_object;
+
+
+void test_object_pool_null_handle()
+{
+    /* test each method handles a NULL handle without crashing */
+    object_pool_counters counters;
+    CU_ASSERT_PTR_NULL(object_pool_initialize(0, 10));
+    CU_ASSERT_PTR_NULL(object_pool_alloc(NULL));
+    object_pool_free(NULL, malloc(sizeof(pool_object)));
+    object_pool_free(NULL, NULL);
+    object_pool_destroy(NULL);
+    CU_ASSERT_FALSE(object_pool_get_counters(NULL, &counters));
+}
+
+
+void test_object_pool_alloc_free()
+{
+    object_pool_counters counters;
+    object_pool_handle *handle = object_pool_initialize(sizeof(pool_object), 2);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(handle);
+    CU_ASSERT_FALSE(object_pool_get_counters(handle, NULL));
+
+    /* The first allocations miss, since the pool is empty */
+    pool_object *object1 = object_pool_alloc(handle);
+    pool_object *object2 = object_pool_alloc(handle);
+    pool_object *object3 = object_pool_alloc(handle);
+    CU_ASSERT_PTR_NOT_NULL(object1);
+    CU_ASSERT_PTR_NOT_NULL(object2);
+    CU_ASSERT_PTR_NOT_NULL(object3);
+    CU_ASSERT_TRUE(object_pool_get_counters(handle, &counters));
+    CU_ASSERT_EQUAL(counters.num_alloc_hits, 0);
+    CU_ASSERT_EQUAL(counters.num_alloc_misses, 3);
+
+    /* Only max_free_objects are kept in the pool */
+    object_pool_free(handle, object1);
+    object_pool_free(handle, object2);
+    object_pool_free(handle, object3);
+    CU_ASSERT_TRUE(object_pool_get_counters(handle, &counters));
+    CU_ASSERT_EQUAL(counters.num_free_pooled, 2);
+    CU_ASSERT_EQUAL(counters.num_free_released, 1);
+    CU_ASSERT_EQUAL(counters.num_free_objects, 2);
+
+    /* The pooled objects are reused, the last freed first */
+    CU_ASSERT_PTR_EQUAL(object_pool_alloc(handle), object2);
+    CU_ASSERT_PTR_EQUAL(object_pool_alloc(handle), object1);
+    CU_ASSERT_TRUE(object_pool_get_counters(handle, &counters));
+    CU_ASSERT_EQUAL(counters.num_alloc_hits, 2);
+    CU_ASSERT_EQUAL(counters.num_alloc_misses, 3);
+    CU_ASSERT_EQUAL(counters.num_free_objects, 0);
+
+    /* An object allocated from the pool may also be released with free() */
+    free(object1);
+    object_pool_free(handle, object2);
+    object_pool_destroy(handle);
+}
+
+
+static void *object_pool_free_thread(void *data)
+{
+    object_pool_handle *handle = ((void **) data)[0];
+    pool_object **objects = ((void **) data)[1];
+    int i;
+    for (i = 0; i < NUM_POOL_OBJECTS; i++)
+    {
+        object_pool_free(handle, objects[i]);
+    }
+
+    return NULL;
+}
+
+
+void test_object_pool_other_thread_free()
+{
+    object_pool_counters counters;
+    object_pool_handle *handle = object_pool_initialize(sizeof(pool_object), NUM_POOL_OBJECTS);
+    pool_object *objects[NUM_POOL_OBJECTS];
+    int i;
+    for (i = 0; i < NUM_POOL_OBJECTS; i++)
+    {
+        objects[i] = object_pool_alloc(handle);
+    }
+
+    /* The objects freed on another thread are pooled in its shard */
+    void *thread_data[2] = { handle, objects };
+    pthread_t free_thread;
+    pthread_create(&free_thread, NULL, object_pool_free_thread, thread_data);
+    pthread_join(free_thread, NULL);
+    CU_ASSERT_TRUE(object_pool_get_counters(handle, &counters));
+    CU_ASSERT_EQUAL(counters.num_free_pooled, NUM_POOL_OBJECTS);
+
+    /* This thread takes them from the other shard in batches */
+    for (i = 0; i < NUM_POOL_OBJECTS; i++)
+    {
+        objects[i] = object_pool_alloc(handle);
+    }
+    CU_ASSERT_TRUE(object_pool_get_counters(handle, &counters));
+    CU_ASSERT_EQUAL(counters.num_alloc_hits, NUM_POOL_OBJECTS);
+    CU_ASSERT_EQUAL(counters.num_alloc_misses, NUM_POOL_OBJECTS);
+    CU_ASSERT_EQUAL(counters.num_free_objects, 0);
+
+    for (i = 0; i < NUM_POOL_OBJECTS; i++)
+    {
+        object_pool_free(handle, objects[i]);
+    }
+    object_pool_destroy(handle);
+}
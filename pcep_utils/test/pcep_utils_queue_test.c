@@ -157,3 +157,61 @@ void test_dequeue()
 
     queue_destroy(handle);
 }
+
+
+void test_enqueue_after()
+{
+    node_data data1, data2, data3, data4;
+    data1.int_data = 1;
+    data2.int_data = 2;
+    data3.int_data = 3;
+    data4.int_data = 4;
+
+    queue_handle *handle = queue_initialize();
+    CU_ASSERT_PTR_NULL(queue_enqueue_after(NULL, NULL, &data1));
+
+    /* Inserting at the head of an empty queue */
+    queue_node *node2 = queue_enqueue_after(handle, NULL, &data2);
+    CU_ASSERT_PTR_NOT_NULL(node2);
+    CU_ASSERT_PTR_EQUAL(handle->head, node2);
+    CU_ASSERT_PTR_EQUAL(handle->tail, node2);
+
+    /* Inserting after the tail, at the head, and in the middle */
+    queue_node *node4 = queue_enqueue_after(handle, node2, &data4);
+    CU_ASSERT_PTR_EQUAL(handle->tail, node4);
+    queue_enqueue_after(handle, NULL, &data1);
+    queue_enqueue_after(handle, node2, &data3);
+    CU_ASSERT_EQUAL(handle->num_entries, 4);
+    CU_ASSERT_PTR_EQUAL(handle->tail, node4);
+
+    CU_ASSERT_PTR_EQUAL(queue_dequeue(handle), &data1);
+    CU_ASSERT_PTR_EQUAL(queue_dequeue(handle), &data2);
+    CU_ASSERT_PTR_EQUAL(queue_dequeue(handle), &data3);
+    CU_ASSERT_PTR_EQUAL(queue_dequeue(handle), &data4);
+    CU_ASSERT_EQUAL(handle->num_entries, 0);
+
+    queue_destroy(handle);
+}
+
+
+void test_queue_node_pool()
+{
+    node_data data1, data2;
+    object_pool_counters counters_before;
+    object_pool_counters counters_after;
+    queue_handle *handle = queue_initialize();
+
+    /* The dequeued nodes are reused by the next enqueues */
+    queue_enqueue(handle, &data1);
+    queue_enqueue(handle, &data2);
+    queue_dequeue(handle);
+    queue_dequeue(handle);
+    CU_ASSERT_TRUE(queue_get_node_pool_counters(&counters_before));
+    queue_enqueue(handle, &data1);
+    queue_enqueue(handle, &data2);
+    CU_ASSERT_TRUE(queue_get_node_pool_counters(&counters_after));
+    CU_ASSERT_EQUAL(counters_after.num_alloc_hits, counters_before.num_alloc_hits + 2);
+    CU_ASSERT_EQUAL(counters_after.num_alloc_misses, counters_before.num_alloc_misses);
+
+    queue_destroy(handle);
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the PCEPlib, a PCEP protocol library.
+ *
+ * Copyright (C) 2020 Volta Networks https://voltanet.io/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ * Author : Brady Johnson <brady@voltanet.io>
+ *
+ */
+
+
+
+#include <stdlib.h>
+
+#include <CUnit/CUnit.h>
+
+#include "pcep_utils_small_vector.h"
+
+void test_small_vector_null_handle()
+{
+    small_vector_destroy(NULL);
+    small_vector_destroy_with_data(NULL);
+    CU_ASSERT_FALSE(small_vector_append(NULL, NULL));
+    CU_ASSERT_PTR_NULL(small_vector_get(NULL, 0));
+    CU_ASSERT_PTR_NULL(small_vector_delete_index(NULL, 0));
+    CU_ASSERT_PTR_NULL(small_vector_delete_data(NULL, NULL));
+}
+
+void test_small_vector_append()
+{
+    small_vector *vector = small_vector_initialize();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(vector);
+    CU_ASSERT_EQUAL(vector->num_entries, 0);
+    CU_ASSERT_PTR_NULL(small_vector_get(vector, 0));
+
+    /* The first entries are stored inline */
+    int data[SMALL_VECTOR_INLINE_CAPACITY * 3];
+    int i;
+    for (i = 0; i < SMALL_VECTOR_INLINE_CAPACITY; i++)
+    {
+        CU_ASSERT_TRUE(small_vector_append(vector, &data[i]));
+    }
+    CU_ASSERT_PTR_EQUAL(vector->entries, vector->inline_entries);
+    CU_ASSERT_EQUAL(vector->num_entries, SMALL_VECTOR_INLINE_CAPACITY);
+
+    /* Then the vector grows out of its inline entries */
+    for (; i < SMALL_VECTOR_INLINE_CAPACITY * 3; i++)
+    {
+        CU_ASSERT_TRUE(small_vector_append(vector, &data[i]));
+    }
+    CU_ASSERT(vector->entries != vector->inline_entries);
+    CU_ASSERT_EQUAL(vector->num_entries, SMALL_VECTOR_INLINE_CAPACITY * 3);
+    CU_ASSERT_EQUAL(vector->capacity, SMALL_VECTOR_INLINE_CAPACITY * 4);
+
+    for (i = 0; i < SMALL_VECTOR_INLINE_CAPACITY * 3; i++)
+    {
+        CU_ASSERT_PTR_EQUAL(small_vector_get(vector, i), &data[i]);
+    }
+    CU_ASSERT_PTR_NULL(small_vector_get(vector, i));
+
+    small_vector_destroy(vector);
+}
+
+void test_small_vector_delete()
+{
+    small_vector *vector = small_vector_initialize();
+    CU_ASSERT_PTR_NOT_NULL_FATAL(vector);
+
+    int data1 = 1;
+    int data2 = 2;
+    int data3 = 3;
+    int data4 = 4;
+    small_vector_append(vector, &data1);
+    small_vector_append(vector, &data2);
+    small_vector_append(vector, &data3);
+    small_vector_append(vector, &data4);
+
+    CU_ASSERT_PTR_NULL(small_vector_delete_index(vector, 4));
+    CU_ASSERT_PTR_NULL(small_vector_delete_data(vector, NULL));
+
+    /* The following entries are moved down */
+    CU_ASSERT_PTR_EQUAL(small_vector_delete_index(vector, 1), &data2);
+    CU_ASSERT_EQUAL(vector->num_entries, 3);
+    CU_ASSERT_PTR_EQUAL(small_vector_get(vector, 0), &data1);
+    CU_ASSERT_PTR_EQUAL(small_vector_get(vector, 1), &data3);
+    CU_ASSERT_PTR_EQUAL(small_vector_get(vector, 2), &data4);
+
+    CU_ASSERT_PTR_EQUAL(small_vector_delete_data(vector, &data4), &data4);
+    CU_ASSERT_PTR_EQUAL(small_vector_delete_index(vector, 0), &data1);
+    CU_ASSERT_EQUAL(vector->num_entries, 1);
+    CU_ASSERT_PTR_EQUAL(small_vector_get(vector, 0), &data3);
+
+    small_vector_destroy(vector);
+
+    /* The data is freed along with the vector */
+    vector = small_vector_initialize();
+    small_vector_append(vector, malloc(sizeof(int)));
+    small_vector_append(vector, malloc(sizeof(int)));
+    small_vector_destroy_with_data(vector);
+}
+
+void test_small_vector_in_arena()
+{
+    arena_handle *arena = arena_initialize(ARENA_DEFAULT_CHUNK_SIZE);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(arena);
+
+    small_vector *vector = small_vector_initialize_in_arena(arena);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(vector);
+    CU_ASSERT_PTR_EQUAL(vector->arena, arena);
+
+    int data[SMALL_VECTOR_INLINE_CAPACITY * 2];
+    int i;
+    for (i = 0; i < SMALL_VECTOR_INLINE_CAPACITY * 2; i++)
+    {
+        CU_ASSERT_TRUE(small_vector_append(vector, &data[i]));
+    }
+    CU_ASSERT(vector->entries != vector->inline_entries);
+    for (i = 0; i < SMALL_VECTOR_INLINE_CAPACITY * 2; i++)
+    {
+        CU_ASSERT_PTR_EQUAL(small_vector_get(vector, i), &data[i]);
+    }
+
+    /* The vector and its entries are all released with the arena */
+    CU_ASSERT_EQUAL(arena->num_chunks, 1);
+    small_vector_destroy(vector);
+    arena_destroy(arena);
+}
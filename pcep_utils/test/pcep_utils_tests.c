@@ -32,6 +32,24 @@ extern void test_null_queue_handle(void);
 extern void test_enqueue(void);
 extern void test_enqueue_with_limit(void);
 extern void test_dequeue(void);
+extern void test_enqueue_after(void);
+extern void test_queue_node_pool(void);
+extern void test_empty_mpsc_queue(void);
+extern void test_null_mpsc_queue_handle(void);
+extern void test_mpsc_enqueue_dequeue(void);
+extern void test_mpsc_get_last_node(void);
+extern void test_mpsc_multiple_producers(void);
+extern void test_object_pool_null_handle(void);
+extern void test_object_pool_alloc_free(void);
+extern void test_object_pool_other_thread_free(void);
+extern void test_arena_null_handle(void);
+extern void test_arena_alloc(void);
+extern void test_arena_cached(void);
+extern void test_arena_double_linked_list(void);
+extern void test_small_vector_null_handle(void);
+extern void test_small_vector_append(void);
+extern void test_small_vector_delete(void);
+extern void test_small_vector_in_arena(void);
 
 extern void test_empty_list(void);
 extern void test_null_list_handle(void);
@@ -72,6 +90,32 @@ int main(int argc, char **argv)
     CU_add_test(test_queue_suite, "test_enqueue", test_enqueue);
     CU_add_test(test_queue_suite, "test_enqueue_with_limit", test_enqueue_with_limit);
     CU_add_test(test_queue_suite, "test_dequeue", test_dequeue);
+    CU_add_test(test_queue_suite, "test_enqueue_after", test_enqueue_after);
+    CU_add_test(test_queue_suite, "test_queue_node_pool", test_queue_node_pool);
+
+    CU_pSuite test_mpsc_queue_suite = CU_add_suite("PCEP Utils MPSC Queue Test Suite", NULL, NULL);
+    CU_add_test(test_mpsc_queue_suite, "test_empty_mpsc_queue", test_empty_mpsc_queue);
+    CU_add_test(test_mpsc_queue_suite, "test_null_mpsc_queue_handle", test_null_mpsc_queue_handle);
+    CU_add_test(test_mpsc_queue_suite, "test_mpsc_enqueue_dequeue", test_mpsc_enqueue_dequeue);
+    CU_add_test(test_mpsc_queue_suite, "test_mpsc_get_last_node", test_mpsc_get_last_node);
+    CU_add_test(test_mpsc_queue_suite, "test_mpsc_multiple_producers", test_mpsc_multiple_producers);
+
+    CU_pSuite test_object_pool_suite = CU_add_suite("PCEP Utils Object Pool Test Suite", NULL, NULL);
+    CU_add_test(test_object_pool_suite, "test_object_pool_null_handle", test_object_pool_null_handle);
+    CU_add_test(test_object_pool_suite, "test_object_pool_alloc_free", test_object_pool_alloc_free);
+    CU_add_test(test_object_pool_suite, "test_object_pool_other_thread_free", test_object_pool_other_thread_free);
+
+    CU_pSuite test_arena_suite = CU_add_suite("PCEP Utils Arena Test Suite", NULL, NULL);
+    CU_add_test(test_arena_suite, "test_arena_null_handle", test_arena_null_handle);
+    CU_add_test(test_arena_suite, "test_arena_alloc", test_arena_alloc);
+    CU_add_test(test_arena_suite, "test_arena_cached", test_arena_cached);
+    CU_add_test(test_arena_suite, "test_arena_double_linked_list", test_arena_double_linked_list);
+
+    CU_pSuite test_small_vector_suite = CU_add_suite("PCEP Utils Small Vector Test Suite", NULL, NULL);
+    CU_add_test(test_small_vector_suite, "test_small_vector_null_handle", test_small_vector_null_handle);
+    CU_add_test(test_small_vector_suite, "test_small_vector_append", test_small_vector_append);
+    CU_add_test(test_small_vector_suite, "test_small_vector_delete", test_small_vector_delete);
+    CU_add_test(test_small_vector_suite, "test_small_vector_in_arena", test_small_vector_in_arena);
 
     CU_pSuite test_list_suite = CU_add_suite("PCEP Utils Ordered List Test Suite", NULL, NULL);
     CU_add_test(test_list_suite, "test_empty_list", test_empty_list);